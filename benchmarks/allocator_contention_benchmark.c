@@ -0,0 +1,187 @@
+/* gstreamer-imx: GStreamer plugins for the i.MX SoCs
+ * Copyright (C) 2026  agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/* Contention benchmark for the DMA-BUF allocators.
+ *
+ * N threads allocate memory blocks from one shared memfd allocator, look
+ * up their physical addresses (the same path the blitters use), and free
+ * them again. This is done for 1, 2, 4 ... up to the given maximum number
+ * of threads, and the throughput is printed for each thread count. With
+ * --serialize, all allocations are serialized by a global mutex, which
+ * emulates an allocator that holds a lock while allocating, and serves
+ * as a reference for how much the threads interfere with each other. */
+
+#include <stdio.h>
+#include <gst/gst.h>
+#include <gst/allocators/allocators.h>
+#include "gst/imx/common/gstimxmemfdallocator.h"
+
+
+typedef struct
+{
+	GstAllocator *allocator;
+	gsize block_size;
+	guint num_iterations;
+	guint num_failures;
+}
+ThreadContext;
+
+
+static GMutex start_mutex;
+static GCond start_cond;
+static gboolean started;
+
+static gboolean serialize = FALSE;
+static GMutex serialize_mutex;
+
+
+static gpointer run_allocations(gpointer data)
+{
+	ThreadContext *context = data;
+	guint i;
+
+	g_mutex_lock(&start_mutex);
+	while (!started)
+		g_cond_wait(&start_cond, &start_mutex);
+	g_mutex_unlock(&start_mutex);
+
+	for (i = 0; i < context->num_iterations; ++i)
+	{
+		GstMemory *memory;
+
+		if (serialize)
+			g_mutex_lock(&serialize_mutex);
+
+		memory = gst_allocator_alloc(context->allocator, context->block_size, NULL);
+		if ((memory == NULL) || (gst_phys_memory_get_phys_addr(memory) == 0))
+			context->num_failures++;
+
+		if (serialize)
+			g_mutex_unlock(&serialize_mutex);
+
+		if (memory != NULL)
+			gst_memory_unref(memory);
+	}
+
+	return NULL;
+}
+
+
+int main(int argc, char *argv[])
+{
+	int ret = -1;
+	gint max_num_threads = 8;
+	gint num_iterations = 2000;
+	gint block_size = 64 * 1024;
+	GError *error = NULL;
+	GOptionContext *option_context;
+	GstAllocator *allocator = NULL;
+	gint num_threads;
+	GOptionEntry const option_entries[] =
+	{
+		{ "max-threads", 't', 0, G_OPTION_ARG_INT, &max_num_threads, "Maximum number of threads (default: 8)", "N" },
+		{ "iterations", 'n', 0, G_OPTION_ARG_INT, &num_iterations, "Allocations per thread (default: 2000)", "N" },
+		{ "block-size", 's', 0, G_OPTION_ARG_INT, &block_size, "Size of each memory block in bytes (default: 65536)", "BYTES" },
+		{ "serialize", 0, 0, G_OPTION_ARG_NONE, &serialize, "Serialize all allocations with a global mutex", NULL },
+		{ NULL, 0, 0, G_OPTION_ARG_NONE, NULL, NULL, NULL }
+	};
+
+	gst_init(&argc, &argv);
+
+	option_context = g_option_context_new("- memfd allocator contention benchmark");
+	g_option_context_add_main_entries(option_context, option_entries, NULL);
+	if (!g_option_context_parse(option_context, &argc, &argv, &error))
+	{
+		fprintf(stderr, "could not parse command line: %s\n", error->message);
+		g_error_free(error);
+		g_option_context_free(option_context);
+		return -1;
+	}
+	g_option_context_free(option_context);
+
+	if ((max_num_threads < 1) || (num_iterations < 1) || (block_size < 1))
+	{
+		fprintf(stderr, "thread count, iteration count, and block size must be positive\n");
+		return -1;
+	}
+
+	allocator = gst_imx_memfd_allocator_new();
+	if (allocator == NULL)
+	{
+		fprintf(stderr, "could not create memfd allocator\n");
+		goto finish;
+	}
+
+	printf("%d allocation(s) of %d byte(s) per thread%s\n\n", num_iterations, block_size, serialize ? ", serialized" : "");
+
+	for (num_threads = 1; num_threads <= max_num_threads; num_threads *= 2)
+	{
+		GThread **threads = g_new0(GThread *, num_threads);
+		ThreadContext *contexts = g_new0(ThreadContext, num_threads);
+		guint num_failures = 0;
+		gint64 duration;
+		gint i;
+
+		started = FALSE;
+
+		for (i = 0; i < num_threads; ++i)
+		{
+			contexts[i].allocator = allocator;
+			contexts[i].block_size = block_size;
+			contexts[i].num_iterations = num_iterations;
+			threads[i] = g_thread_new("allocator-benchmark", run_allocations, &(contexts[i]));
+		}
+
+		duration = g_get_monotonic_time();
+
+		g_mutex_lock(&start_mutex);
+		started = TRUE;
+		g_cond_broadcast(&start_cond);
+		g_mutex_unlock(&start_mutex);
+
+		for (i = 0; i < num_threads; ++i)
+		{
+			g_thread_join(threads[i]);
+			num_failures += contexts[i].num_failures;
+		}
+
+		duration = g_get_monotonic_time() - duration;
+
+		printf(
+			"%2d thread(s)  %8.0f allocations/s total  %8.0f allocations/s per thread  %u failure(s)\n",
+			num_threads,
+			(gdouble)num_threads * num_iterations * G_USEC_PER_SEC / MAX(duration, 1),
+			(gdouble)num_iterations * G_USEC_PER_SEC / MAX(duration, 1),
+			num_failures
+		);
+
+		g_free(contexts);
+		g_free(threads);
+
+		if (num_failures > 0)
+			goto finish;
+	}
+
+	ret = 0;
+
+finish:
+	if (allocator != NULL)
+		gst_object_unref(GST_OBJECT(allocator));
+
+	return ret;
+}
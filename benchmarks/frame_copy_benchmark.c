@@ -0,0 +1,240 @@
+/* gstreamer-imx: GStreamer plugins for the i.MX SoCs
+ * Copyright (C) 2026  agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/* Frame copy benchmark.
+ *
+ * Compares gst_video_frame_copy() with the banded SIMD copy of the
+ * video worker pool (which GstImxVideoUploader uses to repack frames
+ * that do not meet the blitters' alignment requirements). This is done
+ * for several formats, and with source frames that are aligned as well
+ * as source frames whose rows are misaligned (odd strides and a source
+ * pointer that is not aligned to a word boundary). The destination
+ * frames always use the default strides, like the DMA buffers the
+ * uploader copies into. */
+
+#include <stdio.h>
+#include <string.h>
+#include <gst/gst.h>
+#include <gst/video/video.h>
+#include "gst/imx/video/gstimxvideoworkerpool.h"
+
+
+typedef enum
+{
+	COPY_METHOD_GST_VIDEO_FRAME_COPY,
+	COPY_METHOD_WORKER_POOL_SINGLE_THREAD,
+	COPY_METHOD_WORKER_POOL
+}
+CopyMethod;
+
+
+static char const * const copy_method_names[] =
+{
+	"gst_video_frame_copy",
+	"worker pool (1 thread)",
+	"worker pool"
+};
+
+
+static GstBuffer* create_frame_buffer(GstVideoInfo *info, GstVideoFormat format, gint width, gint height, gboolean misaligned)
+{
+	/* Extra bytes for the misaligned variant: each row is padded by
+	 * this amount, and the frame starts this many bytes past the
+	 * beginning of the allocated block. */
+	static gsize const misalignment = 3;
+	gsize offset = 0;
+	guint plane;
+	guint8 *data;
+	GstBuffer *buffer;
+
+	gst_video_info_set_format(info, format, width, height);
+
+	if (misaligned)
+	{
+		GstVideoInfo default_info = *info;
+
+		for (plane = 0; plane < GST_VIDEO_INFO_N_PLANES(info); ++plane)
+		{
+			/* The default layout has no gaps between
+			 * planes, so the row count follows from
+			 * the default offsets and strides. */
+			gsize plane_end = ((plane + 1) < GST_VIDEO_INFO_N_PLANES(&default_info)) ? GST_VIDEO_INFO_PLANE_OFFSET(&default_info, plane + 1) : GST_VIDEO_INFO_SIZE(&default_info);
+			gsize num_rows = (plane_end - GST_VIDEO_INFO_PLANE_OFFSET(&default_info, plane)) / GST_VIDEO_INFO_PLANE_STRIDE(&default_info, plane);
+
+			GST_VIDEO_INFO_PLANE_STRIDE(info, plane) += misalignment;
+			GST_VIDEO_INFO_PLANE_OFFSET(info, plane) = offset;
+			offset += GST_VIDEO_INFO_PLANE_STRIDE(info, plane) * num_rows;
+		}
+
+		GST_VIDEO_INFO_SIZE(info) = offset;
+	}
+
+	data = g_malloc(GST_VIDEO_INFO_SIZE(info) + misalignment);
+	memset(data, 0x55, GST_VIDEO_INFO_SIZE(info) + misalignment);
+
+	buffer = gst_buffer_new_wrapped_full(
+		0,
+		data,
+		GST_VIDEO_INFO_SIZE(info) + misalignment,
+		misaligned ? misalignment : 0,
+		GST_VIDEO_INFO_SIZE(info),
+		data,
+		g_free
+	);
+
+	return buffer;
+}
+
+
+static gdouble run_copies(CopyMethod method, GstImxVideoWorkerPool *single_thread_pool, GstVideoFrame *dest_frame, GstVideoFrame const *src_frame, guint num_copies)
+{
+	gint64 duration;
+	guint i;
+
+	duration = g_get_monotonic_time();
+
+	for (i = 0; i < num_copies; ++i)
+	{
+		switch (method)
+		{
+			case COPY_METHOD_GST_VIDEO_FRAME_COPY:
+				gst_video_frame_copy(dest_frame, src_frame);
+				break;
+
+			case COPY_METHOD_WORKER_POOL_SINGLE_THREAD:
+				gst_imx_video_worker_pool_copy_frame(single_thread_pool, dest_frame, src_frame);
+				break;
+
+			case COPY_METHOD_WORKER_POOL:
+				gst_imx_video_worker_pool_copy_frame(NULL, dest_frame, src_frame);
+				break;
+		}
+	}
+
+	duration = g_get_monotonic_time() - duration;
+
+	return (gdouble)duration / 1000.0 / num_copies;
+}
+
+
+int main(int argc, char *argv[])
+{
+	static GstVideoFormat const formats[] =
+	{
+		GST_VIDEO_FORMAT_NV12,
+		GST_VIDEO_FORMAT_I420,
+		GST_VIDEO_FORMAT_YUY2,
+		GST_VIDEO_FORMAT_RGBA
+	};
+
+	gint width = 1920;
+	gint height = 1080;
+	gint num_copies = 200;
+	GError *error = NULL;
+	GOptionContext *option_context;
+	GstImxVideoWorkerPool *single_thread_pool;
+	guint format_index;
+	guint method;
+	GOptionEntry const option_entries[] =
+	{
+		{ "width", 0, 0, G_OPTION_ARG_INT, &width, "Frame width (default: 1920)", "PIXELS" },
+		{ "height", 0, 0, G_OPTION_ARG_INT, &height, "Frame height (default: 1080)", "PIXELS" },
+		{ "copies", 'n', 0, G_OPTION_ARG_INT, &num_copies, "Number of copies per measurement (default: 200)", "N" },
+		{ NULL, 0, 0, G_OPTION_ARG_NONE, NULL, NULL, NULL }
+	};
+
+	gst_init(&argc, &argv);
+
+	option_context = g_option_context_new("- frame copy benchmark");
+	g_option_context_add_main_entries(option_context, option_entries, NULL);
+	if (!g_option_context_parse(option_context, &argc, &argv, &error))
+	{
+		fprintf(stderr, "could not parse command line: %s\n", error->message);
+		g_error_free(error);
+		g_option_context_free(option_context);
+		return -1;
+	}
+	g_option_context_free(option_context);
+
+	if ((width < 2) || (height < 2) || (num_copies < 1))
+	{
+		fprintf(stderr, "invalid frame size or copy count\n");
+		return -1;
+	}
+
+	single_thread_pool = gst_imx_video_worker_pool_new(1);
+	if (single_thread_pool == NULL)
+	{
+		fprintf(stderr, "could not create single-threaded worker pool\n");
+		return -1;
+	}
+
+	printf(
+		"%dx%d frames, %d copies per measurement, %u worker pool thread(s); times in ms per frame\n\n",
+		width, height,
+		num_copies,
+		gst_imx_video_worker_pool_get_num_threads(gst_imx_video_worker_pool_get_default())
+	);
+
+	printf("%-8s %-12s", "format", "source");
+	for (method = 0; method < G_N_ELEMENTS(copy_method_names); ++method)
+		printf("  %24s", copy_method_names[method]);
+	printf("\n");
+
+	for (format_index = 0; format_index < G_N_ELEMENTS(formats); ++format_index)
+	{
+		GstVideoInfo dest_info;
+		GstBuffer *dest_buffer;
+		GstVideoFrame dest_frame;
+		gint misaligned;
+
+		dest_buffer = create_frame_buffer(&dest_info, formats[format_index], width, height, FALSE);
+		gst_video_frame_map(&dest_frame, &dest_info, dest_buffer, GST_MAP_WRITE);
+
+		for (misaligned = 0; misaligned < 2; ++misaligned)
+		{
+			GstVideoInfo src_info;
+			GstBuffer *src_buffer;
+			GstVideoFrame src_frame;
+
+			src_buffer = create_frame_buffer(&src_info, formats[format_index], width, height, misaligned);
+			gst_video_frame_map(&src_frame, &src_info, src_buffer, GST_MAP_READ);
+
+			printf("%-8s %-12s", gst_video_format_to_string(formats[format_index]), misaligned ? "misaligned" : "aligned");
+
+			for (method = 0; method < G_N_ELEMENTS(copy_method_names); ++method)
+			{
+				/* Warm up caches and worker threads first. */
+				run_copies(method, single_thread_pool, &dest_frame, &src_frame, 1);
+				printf("  %24.3f", run_copies(method, single_thread_pool, &dest_frame, &src_frame, num_copies));
+			}
+
+			printf("\n");
+
+			gst_video_frame_unmap(&src_frame);
+			gst_buffer_unref(src_buffer);
+		}
+
+		gst_video_frame_unmap(&dest_frame);
+		gst_buffer_unref(dest_buffer);
+	}
+
+	gst_imx_video_worker_pool_free(single_thread_pool);
+
+	return 0;
+}
@@ -0,0 +1,314 @@
+/* Benchmark for the sequence handling in the imx2d G2D backend.
+ *
+ * This runs sequences (start, fill, finish) with a G2D blitter that is
+ * linked against a stub G2D library (see g2d_stub.c) instead of libg2d,
+ * which simulates the cost of g2d_open(), g2d_close() and g2d_finish().
+ * It measures per-sequence latencies and counts how often the G2D handle
+ * is opened and closed. It also runs sequences from two threads one after
+ * the other and destroys the blitter from a third one, like a GStreamer
+ * element does when its streaming thread changes and when it is stopped,
+ * and verifies that no handle is closed or used by a thread other than
+ * the one that opened it, and that no handle is leaked.
+ *
+ * DMA buffers are allocated with libimxdmabuffer, so it has to be able
+ * to allocate memory on the machine this runs on. */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include <imxdmabuffer/imxdmabuffer.h>
+
+#include <config.h>
+
+#include "imx2d/imx2d.h"
+#include "imx2d/backend/g2d/g2d_blitter.h"
+#include "g2d_stub.h"
+
+
+#define SURFACE_WIDTH 64
+#define SURFACE_HEIGHT 64
+
+
+typedef struct
+{
+	Imx2dBlitter *blitter;
+	Imx2dSurface *surface;
+	unsigned int num_sequences;
+
+	unsigned int num_failed_sequences;
+	uint64_t total_duration;
+	uint64_t max_duration;
+
+	int done;
+}
+SequenceRun;
+
+
+static uint64_t get_time_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)(ts.tv_sec) * 1000000000ull + (uint64_t)(ts.tv_nsec);
+}
+
+
+static void* run_sequences(void *data)
+{
+	SequenceRun *run = data;
+	Imx2dRegion region = { 0, 0, SURFACE_WIDTH, SURFACE_HEIGHT };
+	unsigned int i;
+
+	for (i = 0; i < run->num_sequences; ++i)
+	{
+		uint64_t duration = get_time_ns();
+
+		if (!imx_2d_blitter_start(run->blitter, run->surface)
+		 || !imx_2d_blitter_fill_region(run->blitter, &region, 0xFF000000)
+		 || !imx_2d_blitter_finish(run->blitter))
+			run->num_failed_sequences++;
+
+		duration = get_time_ns() - duration;
+		run->total_duration += duration;
+		if (duration > run->max_duration)
+			run->max_duration = duration;
+	}
+
+	return NULL;
+}
+
+
+static pthread_mutex_t streaming_thread_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t streaming_thread_cond = PTHREAD_COND_INITIALIZER;
+static int threads_may_exit = 0;
+
+
+static void* run_sequences_in_streaming_thread(void *data)
+{
+	SequenceRun *run = data;
+
+	run_sequences(run);
+
+	/* Keep the thread alive until the main thread allows it
+	 * to exit, like a streaming thread from a thread pool. */
+	pthread_mutex_lock(&streaming_thread_mutex);
+	run->done = 1;
+	pthread_cond_broadcast(&streaming_thread_cond);
+	while (!threads_may_exit)
+		pthread_cond_wait(&streaming_thread_cond, &streaming_thread_mutex);
+	pthread_mutex_unlock(&streaming_thread_mutex);
+
+	return NULL;
+}
+
+
+static void print_run(char const *desc, SequenceRun const *run)
+{
+	printf(
+		"%-28s  %u sequence(s)  %u failed  avg %.1f us  max %.1f us\n",
+		desc,
+		run->num_sequences,
+		run->num_failed_sequences,
+		(run->num_sequences > 0) ? (run->total_duration / 1000.0 / run->num_sequences) : 0.0,
+		run->max_duration / 1000.0
+	);
+}
+
+
+static void print_statistics(G2DStubStatistics const *statistics)
+{
+	printf(
+		"%-28s  %u open(s)  %u close(s)  %u call(s) from foreign threads\n",
+		"",
+		statistics->num_opens,
+		statistics->num_closes,
+		statistics->num_foreign_thread_calls
+	);
+}
+
+
+static void usage(char const *progname)
+{
+	fprintf(stderr,
+		"Usage: %s [-n NUM_SEQUENCES] [-o OPEN_US] [-c CLOSE_US] [-f FINISH_US]\n"
+		"  -n  number of sequences per run (default: 1000)\n"
+		"  -o  simulated g2d_open() duration in microseconds (default: 2000)\n"
+		"  -c  simulated g2d_close() duration in microseconds (default: 1000)\n"
+		"  -f  simulated g2d_finish() duration in microseconds (default: 100)\n",
+		progname
+	);
+}
+
+
+int main(int argc, char *argv[])
+{
+	int ret = -1;
+	int err;
+	int opt;
+	unsigned int num_sequences = 1000;
+	G2DStubConfig stub_config = { 2000, 1000, 100 };
+	G2DStubStatistics statistics;
+	ImxDmaBufferAllocator *allocator = NULL;
+	ImxDmaBuffer *dma_buffer = NULL;
+	Imx2dSurface *surface = NULL;
+	Imx2dBlitter *blitter = NULL;
+	Imx2dSurfaceDesc desc;
+	SequenceRun run;
+	SequenceRun runs[2];
+	pthread_t threads[2];
+	int i;
+
+	while ((opt = getopt(argc, argv, "n:o:c:f:h")) != -1)
+	{
+		switch (opt)
+		{
+			case 'n': num_sequences = strtoul(optarg, NULL, 10); break;
+			case 'o': stub_config.open_duration = strtoul(optarg, NULL, 10); break;
+			case 'c': stub_config.close_duration = strtoul(optarg, NULL, 10); break;
+			case 'f': stub_config.finish_duration = strtoul(optarg, NULL, 10); break;
+			default:
+				usage(argv[0]);
+				return (opt == 'h') ? 0 : -1;
+		}
+	}
+
+	allocator = imx_dma_buffer_allocator_new(&err);
+	if (allocator == NULL)
+	{
+		fprintf(stderr, "could not create DMA buffer allocator: %s (%d)\n", strerror(err), err);
+		goto finish;
+	}
+
+	dma_buffer = imx_dma_buffer_allocate(allocator, SURFACE_WIDTH * SURFACE_HEIGHT * 4, 1, &err);
+	if (dma_buffer == NULL)
+	{
+		fprintf(stderr, "could not allocate DMA buffer: %s (%d)\n", strerror(err), err);
+		goto finish;
+	}
+
+	memset(&desc, 0, sizeof(desc));
+	desc.width = SURFACE_WIDTH;
+	desc.height = SURFACE_HEIGHT;
+	desc.plane_strides[0] = SURFACE_WIDTH * 4;
+	desc.format = IMX_2D_PIXEL_FORMAT_RGBA8888;
+
+	surface = imx_2d_surface_create(&desc);
+	imx_2d_surface_set_dma_buffer(surface, dma_buffer, 0, 0);
+
+	printf(
+		"simulated durations: g2d_open() %u us  g2d_close() %u us  g2d_finish() %u us\n\n",
+		stub_config.open_duration,
+		stub_config.close_duration,
+		stub_config.finish_duration
+	);
+
+
+	/* Run 1: all sequences in the thread that
+	 * creates and destroys the blitter. */
+
+	g2d_stub_configure(&stub_config);
+
+	blitter = imx_2d_backend_g2d_blitter_create();
+	if (blitter == NULL)
+	{
+		fprintf(stderr, "could not create G2D blitter\n");
+		goto finish;
+	}
+
+	memset(&run, 0, sizeof(run));
+	run.blitter = blitter;
+	run.surface = surface;
+	run.num_sequences = num_sequences;
+	run_sequences(&run);
+
+	imx_2d_blitter_destroy(blitter);
+	blitter = NULL;
+
+	g2d_stub_get_statistics(&statistics);
+	print_run("single thread", &run);
+	print_statistics(&statistics);
+
+
+	/* Run 2: half of the sequences in one streaming thread, the other
+	 * half in another one, and the blitter is destroyed by the main
+	 * thread while both streaming threads still exist. The threads
+	 * are shut down afterwards. */
+
+	g2d_stub_configure(&stub_config);
+
+	blitter = imx_2d_backend_g2d_blitter_create();
+	if (blitter == NULL)
+	{
+		fprintf(stderr, "could not create G2D blitter\n");
+		goto finish;
+	}
+
+	memset(&runs, 0, sizeof(runs));
+	for (i = 0; i < 2; ++i)
+	{
+		runs[i].blitter = blitter;
+		runs[i].surface = surface;
+		runs[i].num_sequences = (i == 0) ? (num_sequences / 2) : (num_sequences - num_sequences / 2);
+
+		/* A blitter must not be used by two threads at the same
+		 * time, so wait until this thread is done with it. */
+		pthread_create(&(threads[i]), NULL, run_sequences_in_streaming_thread, &(runs[i]));
+		pthread_mutex_lock(&streaming_thread_mutex);
+		while (!runs[i].done)
+			pthread_cond_wait(&streaming_thread_cond, &streaming_thread_mutex);
+		pthread_mutex_unlock(&streaming_thread_mutex);
+	}
+
+	imx_2d_blitter_destroy(blitter);
+	blitter = NULL;
+
+	pthread_mutex_lock(&streaming_thread_mutex);
+	threads_may_exit = 1;
+	pthread_cond_broadcast(&streaming_thread_cond);
+	pthread_mutex_unlock(&streaming_thread_mutex);
+
+	for (i = 0; i < 2; ++i)
+		pthread_join(threads[i], NULL);
+
+	print_run("first streaming thread", &(runs[0]));
+	print_run("second streaming thread", &(runs[1]));
+
+	g2d_stub_get_statistics(&statistics);
+	print_statistics(&statistics);
+
+#ifndef IMX2D_G2D_IMPLEMENTATION_BASED_ON_DPU
+	/* The DPU emulation does not require G2D calls
+	 * to come from the thread that opened the handle. */
+	if (statistics.num_foreign_thread_calls != 0)
+	{
+		fprintf(stderr, "G2D handles were used by foreign threads\n");
+		goto finish;
+	}
+#endif
+
+	if (statistics.num_opens != statistics.num_closes)
+	{
+		fprintf(stderr, "%u G2D handle(s) leaked\n", statistics.num_opens - statistics.num_closes);
+		goto finish;
+	}
+
+	ret = 0;
+
+finish:
+	if (blitter != NULL)
+		imx_2d_blitter_destroy(blitter);
+	if (surface != NULL)
+		imx_2d_surface_destroy(surface);
+	if (dma_buffer != NULL)
+		imx_dma_buffer_deallocate(dma_buffer);
+	if (allocator != NULL)
+		imx_dma_buffer_allocator_destroy(allocator);
+
+	return ret;
+}
@@ -0,0 +1,174 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include <g2d.h>
+#include <g2dExt.h>
+
+#include "g2d_stub.h"
+
+
+typedef struct
+{
+	pthread_t owner;
+}
+G2DStubHandle;
+
+
+static pthread_mutex_t stub_mutex = PTHREAD_MUTEX_INITIALIZER;
+static G2DStubConfig stub_config;
+static G2DStubStatistics stub_statistics;
+
+
+static void simulate_duration(unsigned int duration)
+{
+	struct timespec ts;
+
+	if (duration == 0)
+		return;
+
+	ts.tv_sec = duration / 1000000;
+	ts.tv_nsec = (long)(duration % 1000000) * 1000;
+	nanosleep(&ts, NULL);
+}
+
+
+static int check_handle(void *handle)
+{
+	G2DStubHandle *stub_handle = handle;
+
+	if (stub_handle == NULL)
+		return -1;
+
+	if (!pthread_equal(stub_handle->owner, pthread_self()))
+	{
+		pthread_mutex_lock(&stub_mutex);
+		stub_statistics.num_foreign_thread_calls++;
+		pthread_mutex_unlock(&stub_mutex);
+	}
+
+	return 0;
+}
+
+
+void g2d_stub_configure(G2DStubConfig const *config)
+{
+	pthread_mutex_lock(&stub_mutex);
+	stub_config = *config;
+	memset(&stub_statistics, 0, sizeof(stub_statistics));
+	pthread_mutex_unlock(&stub_mutex);
+}
+
+
+void g2d_stub_get_statistics(G2DStubStatistics *statistics)
+{
+	pthread_mutex_lock(&stub_mutex);
+	*statistics = stub_statistics;
+	pthread_mutex_unlock(&stub_mutex);
+}
+
+
+int g2d_open(void **handle)
+{
+	G2DStubHandle *stub_handle = malloc(sizeof(G2DStubHandle));
+	if (stub_handle == NULL)
+		return -1;
+
+	stub_handle->owner = pthread_self();
+
+	pthread_mutex_lock(&stub_mutex);
+	stub_statistics.num_opens++;
+	pthread_mutex_unlock(&stub_mutex);
+
+	simulate_duration(stub_config.open_duration);
+
+	*handle = stub_handle;
+	return 0;
+}
+
+
+int g2d_close(void *handle)
+{
+	if (check_handle(handle) != 0)
+		return -1;
+
+	pthread_mutex_lock(&stub_mutex);
+	stub_statistics.num_closes++;
+	pthread_mutex_unlock(&stub_mutex);
+
+	simulate_duration(stub_config.close_duration);
+
+	free(handle);
+	return 0;
+}
+
+
+int g2d_make_current(void *handle, enum g2d_hardware_type type)
+{
+	(void)type;
+	return check_handle(handle);
+}
+
+
+int g2d_clear(void *handle, struct g2d_surface *area)
+{
+	(void)area;
+	return check_handle(handle);
+}
+
+
+int g2d_blit(void *handle, struct g2d_surface *src, struct g2d_surface *dst)
+{
+	(void)src;
+	(void)dst;
+	return check_handle(handle);
+}
+
+
+int g2d_blitEx(void *handle, struct g2d_surfaceEx *srcEx, struct g2d_surfaceEx *dstEx)
+{
+	(void)srcEx;
+	(void)dstEx;
+	return check_handle(handle);
+}
+
+
+int g2d_multi_blit(void *handle, struct g2d_surface_pair *sp[], int layers)
+{
+	(void)sp;
+	(void)layers;
+	return check_handle(handle);
+}
+
+
+int g2d_enable(void *handle, enum g2d_cap_mode cap)
+{
+	(void)cap;
+	return check_handle(handle);
+}
+
+
+int g2d_disable(void *handle, enum g2d_cap_mode cap)
+{
+	(void)cap;
+	return check_handle(handle);
+}
+
+
+int g2d_flush(void *handle)
+{
+	return check_handle(handle);
+}
+
+
+int g2d_finish(void *handle)
+{
+	if (check_handle(handle) != 0)
+		return -1;
+
+	simulate_duration(stub_config.finish_duration);
+	return 0;
+}
@@ -0,0 +1,36 @@
+#ifndef G2D_STUB_H
+#define G2D_STUB_H
+
+
+/* Stand-in for libg2d. It implements the G2D functions that the imx2d
+ * G2D backend uses, does not touch any memory, and simulates the cost
+ * of the calls by sleeping. It also checks that calls that use a G2D
+ * handle come from the thread that opened that handle. */
+
+
+typedef struct
+{
+	/* Simulated durations of the calls, in microseconds. */
+	unsigned int open_duration;
+	unsigned int close_duration;
+	unsigned int finish_duration;
+}
+G2DStubConfig;
+
+
+typedef struct
+{
+	unsigned int num_opens;
+	unsigned int num_closes;
+	/* Number of calls that used a handle from a thread
+	 * other than the one that opened that handle. */
+	unsigned int num_foreign_thread_calls;
+}
+G2DStubStatistics;
+
+
+void g2d_stub_configure(G2DStubConfig const *config);
+void g2d_stub_get_statistics(G2DStubStatistics *statistics);
+
+
+#endif /* G2D_STUB_H */
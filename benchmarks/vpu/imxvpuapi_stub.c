@@ -0,0 +1,792 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <imxvpuapi2/imxvpuapi2.h>
+
+
+/* Stand-in for libimxvpuapi2. It implements the decoder and encoder
+ * functions that the VPU elements use, without any actual coding.
+ * The decoder produces MPEG-2 streams as NV12 frames, the encoder
+ * produces JPEG pictures. Neither touches frame pixels. This makes it
+ * possible to measure the overhead of the decode_queued_frames() and
+ * encode_queued_frames() loops without VPU hardware.
+ *
+ * The behavior can be adjusted with these environment variables,
+ * which are read when a decoder or encoder is opened:
+ *
+ * IMX_VPU_STUB_LATENCY: Simulated time it takes to decode or encode
+ *   one frame, in microseconds. Default is 0.
+ * IMX_VPU_STUB_REORDER_DEPTH: Number of frames that are held back
+ *   before the first frame is output. The decoder then outputs the
+ *   held back frame with the lowest PTS, like a decoder that reorders
+ *   frames from decoding order to presentation order. The encoder
+ *   outputs the newest frame first and then the held back ones, like
+ *   an encoder that produces B-frames. Default is 0.
+ * IMX_VPU_STUB_ADDITIONAL_FRAMEBUFFER_INTERVAL: If nonzero, the
+ *   NEED_ADDITIONAL_FRAMEBUFFER output code is returned once every
+ *   this many frames. The decoder also returns that code if all of
+ *   its framebuffers are in use. Default is 0. */
+
+
+#define STUB_FRAME_ALIGNMENT 16
+#define STUB_MIN_DIMENSION 16
+#define STUB_MAX_DIMENSION 4096
+
+
+typedef struct
+{
+	unsigned int latency;
+	size_t reorder_depth;
+	size_t additional_framebuffer_interval;
+}
+StubConfig;
+
+
+typedef struct
+{
+	void *context;
+	uint64_t pts;
+	uint64_t dts;
+	/* Index of the framebuffer the frame was decoded into.
+	 * Only used by the decoder. */
+	size_t fb_index;
+}
+StubFrame;
+
+
+typedef struct
+{
+	ImxDmaBuffer *dma_buffer;
+	void *context;
+	int in_use;
+}
+StubFramebuffer;
+
+
+static unsigned int get_env_uint(char const *name)
+{
+	char const *value = getenv(name);
+	return (value != NULL) ? (unsigned int)strtoul(value, NULL, 10) : 0;
+}
+
+
+static void read_stub_config(StubConfig *config)
+{
+	config->latency = get_env_uint("IMX_VPU_STUB_LATENCY");
+	config->reorder_depth = get_env_uint("IMX_VPU_STUB_REORDER_DEPTH");
+	config->additional_framebuffer_interval = get_env_uint("IMX_VPU_STUB_ADDITIONAL_FRAMEBUFFER_INTERVAL");
+}
+
+
+static void simulate_latency(unsigned int latency)
+{
+	struct timespec ts;
+
+	if (latency == 0)
+		return;
+
+	ts.tv_sec = latency / 1000000;
+	ts.tv_nsec = (long)(latency % 1000000) * 1000;
+	nanosleep(&ts, NULL);
+}
+
+
+static void fill_framebuffer_metrics(ImxVpuApiFramebufferMetrics *metrics, size_t width, size_t height)
+{
+	size_t aligned_width = (width + STUB_FRAME_ALIGNMENT - 1) & ~((size_t)(STUB_FRAME_ALIGNMENT - 1));
+	size_t aligned_height = (height + STUB_FRAME_ALIGNMENT - 1) & ~((size_t)(STUB_FRAME_ALIGNMENT - 1));
+
+	/* NV12 layout. Since the width and height are multiples of the
+	 * alignment in the benchmarks, the frames are tightly packed. */
+	memset(metrics, 0, sizeof(ImxVpuApiFramebufferMetrics));
+	metrics->actual_frame_width = width;
+	metrics->actual_frame_height = height;
+	metrics->aligned_frame_width = aligned_width;
+	metrics->aligned_frame_height = aligned_height;
+	metrics->y_stride = aligned_width;
+	metrics->uv_stride = aligned_width;
+	metrics->y_size = aligned_width * aligned_height;
+	metrics->uv_size = aligned_width * aligned_height / 2;
+}
+
+
+static size_t select_frame_by_lowest_pts(StubFrame const *frames, size_t num_frames)
+{
+	size_t i, selected = 0;
+
+	for (i = 1; i < num_frames; ++i)
+	{
+		if (frames[i].pts < frames[selected].pts)
+			selected = i;
+	}
+
+	return selected;
+}
+
+
+static void remove_frame(StubFrame *frames, size_t *num_frames, size_t index)
+{
+	memmove(&(frames[index]), &(frames[index + 1]), (*num_frames - index - 1) * sizeof(StubFrame));
+	(*num_frames)--;
+}
+
+
+
+
+/*** Decoder ***/
+
+static ImxVpuApiCompressionFormat dec_supported_compression_formats[] =
+{
+	IMX_VPU_API_COMPRESSION_FORMAT_MPEG2
+};
+
+static ImxVpuApiColorFormat dec_supported_color_formats[] =
+{
+	IMX_VPU_API_COLOR_FORMAT_SEMI_PLANAR_YUV420_8BIT
+};
+
+static ImxVpuApiDecGlobalInfo const dec_global_info =
+{
+	.flags = IMX_VPU_API_DEC_GLOBAL_INFO_FLAG_HAS_DECODER
+	       | IMX_VPU_API_DEC_GLOBAL_INFO_FLAG_SEMI_PLANAR_FRAMES_SUPPORTED
+	       | IMX_VPU_API_DEC_GLOBAL_INFO_FLAG_DECODED_FRAMES_ARE_FROM_BUFFER_POOL,
+	.min_required_stream_buffer_size = 0,
+	.required_stream_buffer_physaddr_alignment = 1,
+	.supported_compression_formats = dec_supported_compression_formats,
+	.num_supported_compression_formats = sizeof(dec_supported_compression_formats) / sizeof(ImxVpuApiCompressionFormat)
+};
+
+static ImxVpuApiCompressionFormatSupportDetails const dec_support_details =
+{
+	.min_width = STUB_MIN_DIMENSION, .max_width = STUB_MAX_DIMENSION,
+	.min_height = STUB_MIN_DIMENSION, .max_height = STUB_MAX_DIMENSION,
+	.supported_color_formats = dec_supported_color_formats,
+	.num_supported_color_formats = sizeof(dec_supported_color_formats) / sizeof(ImxVpuApiColorFormat),
+	.min_quantization = 0, .max_quantization = 0
+};
+
+
+struct _ImxVpuApiDecoder
+{
+	StubConfig config;
+	ImxVpuApiDecStreamInfo stream_info;
+	int stream_info_announced;
+	int drain_mode_enabled;
+
+	StubFramebuffer *framebuffers;
+	size_t num_framebuffers;
+
+	/* The frame that was pushed, but not decoded yet. */
+	StubFrame input_frame;
+	int has_input_frame;
+
+	/* Decoded frames that were not output yet. */
+	StubFrame *queued_frames;
+	size_t num_queued_frames;
+
+	/* The frame that is retrieved by the next
+	 * imx_vpu_api_dec_get_decoded_frame() call. */
+	StubFrame decoded_frame;
+	int has_decoded_frame;
+
+	size_t num_decoded_frames;
+	size_t num_additional_framebuffer_requests;
+};
+
+
+ImxVpuApiDecGlobalInfo const * imx_vpu_api_dec_get_global_info(void)
+{
+	return &dec_global_info;
+}
+
+
+ImxVpuApiCompressionFormatSupportDetails const * imx_vpu_api_dec_get_compression_format_support_details(ImxVpuApiCompressionFormat compression_format)
+{
+	return (compression_format == IMX_VPU_API_COMPRESSION_FORMAT_MPEG2) ? &dec_support_details : NULL;
+}
+
+
+ImxVpuApiDecReturnCodes imx_vpu_api_dec_open(ImxVpuApiDecoder **decoder, ImxVpuApiDecOpenParams *open_params, ImxDmaBuffer *stream_buffer)
+{
+	ImxVpuApiDecoder *dec;
+	size_t frame_size;
+
+	(void)stream_buffer;
+
+	if ((decoder == NULL) || (open_params == NULL))
+		return IMX_VPU_API_DEC_RETURN_CODE_INVALID_PARAMS;
+	if (open_params->compression_format != IMX_VPU_API_COMPRESSION_FORMAT_MPEG2)
+		return IMX_VPU_API_DEC_RETURN_CODE_INVALID_PARAMS;
+
+	dec = calloc(1, sizeof(ImxVpuApiDecoder));
+	if (dec == NULL)
+		return IMX_VPU_API_DEC_RETURN_CODE_ERROR;
+
+	read_stub_config(&(dec->config));
+
+	dec->queued_frames = calloc(dec->config.reorder_depth + 1, sizeof(StubFrame));
+	if (dec->queued_frames == NULL)
+	{
+		free(dec);
+		return IMX_VPU_API_DEC_RETURN_CODE_ERROR;
+	}
+
+	fill_framebuffer_metrics(&(dec->stream_info.decoded_frame_framebuffer_metrics), open_params->frame_width, open_params->frame_height);
+	frame_size = dec->stream_info.decoded_frame_framebuffer_metrics.y_size + dec->stream_info.decoded_frame_framebuffer_metrics.uv_size;
+
+	dec->stream_info.min_fb_pool_framebuffer_size = frame_size;
+	dec->stream_info.min_output_framebuffer_size = frame_size;
+	/* The decoder needs one framebuffer for each held back frame,
+	 * one for the frame that is being decoded, and one more so
+	 * downstream can keep the last output frame. */
+	dec->stream_info.min_num_required_framebuffers = dec->config.reorder_depth + 2;
+	dec->stream_info.frame_rate_numerator = 0;
+	dec->stream_info.frame_rate_denominator = 1;
+	dec->stream_info.color_format = IMX_VPU_API_COLOR_FORMAT_SEMI_PLANAR_YUV420_8BIT;
+	dec->stream_info.flags = IMX_VPU_API_DEC_STREAM_INFO_FLAG_SEMI_PLANAR_FRAMES;
+
+	*decoder = dec;
+
+	return IMX_VPU_API_DEC_RETURN_CODE_OK;
+}
+
+
+void imx_vpu_api_dec_close(ImxVpuApiDecoder *decoder)
+{
+	if (decoder == NULL)
+		return;
+
+	free(decoder->framebuffers);
+	free(decoder->queued_frames);
+	free(decoder);
+}
+
+
+ImxVpuApiDecStreamInfo const * imx_vpu_api_dec_get_stream_info(ImxVpuApiDecoder *decoder)
+{
+	return &(decoder->stream_info);
+}
+
+
+ImxVpuApiDecReturnCodes imx_vpu_api_dec_add_framebuffers_to_pool(ImxVpuApiDecoder *decoder, ImxDmaBuffer **fb_dma_buffers, void **fb_contexts, size_t num_framebuffers)
+{
+	size_t i;
+	StubFramebuffer *framebuffers;
+
+	framebuffers = realloc(decoder->framebuffers, (decoder->num_framebuffers + num_framebuffers) * sizeof(StubFramebuffer));
+	if (framebuffers == NULL)
+		return IMX_VPU_API_DEC_RETURN_CODE_ERROR;
+
+	for (i = 0; i < num_framebuffers; ++i)
+	{
+		StubFramebuffer *framebuffer = &(framebuffers[decoder->num_framebuffers + i]);
+		framebuffer->dma_buffer = fb_dma_buffers[i];
+		framebuffer->context = (fb_contexts != NULL) ? fb_contexts[i] : NULL;
+		framebuffer->in_use = 0;
+	}
+
+	decoder->framebuffers = framebuffers;
+	decoder->num_framebuffers += num_framebuffers;
+
+	return IMX_VPU_API_DEC_RETURN_CODE_OK;
+}
+
+
+void imx_vpu_api_dec_enable_drain_mode(ImxVpuApiDecoder *decoder)
+{
+	decoder->drain_mode_enabled = 1;
+}
+
+
+void imx_vpu_api_dec_flush(ImxVpuApiDecoder *decoder)
+{
+	size_t i;
+
+	for (i = 0; i < decoder->num_queued_frames; ++i)
+		decoder->framebuffers[decoder->queued_frames[i].fb_index].in_use = 0;
+	if (decoder->has_decoded_frame)
+		decoder->framebuffers[decoder->decoded_frame.fb_index].in_use = 0;
+
+	decoder->num_queued_frames = 0;
+	decoder->has_input_frame = 0;
+	decoder->has_decoded_frame = 0;
+	decoder->drain_mode_enabled = 0;
+}
+
+
+ImxVpuApiDecReturnCodes imx_vpu_api_dec_push_encoded_frame(ImxVpuApiDecoder *decoder, ImxVpuApiEncodedFrame *encoded_frame)
+{
+	if (decoder->has_input_frame)
+		return IMX_VPU_API_DEC_RETURN_CODE_INVALID_CALL;
+
+	/* The frame data itself is not needed, since nothing is decoded. */
+	decoder->input_frame.context = encoded_frame->context;
+	decoder->input_frame.pts = encoded_frame->pts;
+	decoder->input_frame.dts = encoded_frame->dts;
+	decoder->has_input_frame = 1;
+
+	return IMX_VPU_API_DEC_RETURN_CODE_OK;
+}
+
+
+void imx_vpu_api_dec_set_output_frame_dma_buffer(ImxVpuApiDecoder *decoder, ImxDmaBuffer *output_frame_dma_buffer, void *fb_context)
+{
+	/* Decoded frames are always taken from the framebuffer pool,
+	 * so output frame DMA buffers are never needed. */
+	(void)decoder;
+	(void)output_frame_dma_buffer;
+	(void)fb_context;
+}
+
+
+ImxVpuApiDecReturnCodes imx_vpu_api_dec_decode(ImxVpuApiDecoder *decoder, ImxVpuApiDecOutputCodes *output_code)
+{
+	/* Like actual decoders, announce the stream info once the first
+	 * frame is available, so the caller can add framebuffers. */
+	if (!decoder->stream_info_announced && decoder->has_input_frame)
+	{
+		decoder->stream_info_announced = 1;
+		*output_code = IMX_VPU_API_DEC_OUTPUT_CODE_NEW_STREAM_INFO_AVAILABLE;
+		return IMX_VPU_API_DEC_RETURN_CODE_OK;
+	}
+
+	if (decoder->has_input_frame)
+	{
+		size_t fb_index;
+		size_t interval = decoder->config.additional_framebuffer_interval;
+
+		if ((interval > 0) && (decoder->num_decoded_frames / interval > decoder->num_additional_framebuffer_requests))
+		{
+			decoder->num_additional_framebuffer_requests++;
+			*output_code = IMX_VPU_API_DEC_OUTPUT_CODE_NEED_ADDITIONAL_FRAMEBUFFER;
+			return IMX_VPU_API_DEC_RETURN_CODE_OK;
+		}
+
+		for (fb_index = 0; fb_index < decoder->num_framebuffers; ++fb_index)
+		{
+			if (!decoder->framebuffers[fb_index].in_use)
+				break;
+		}
+
+		if (fb_index == decoder->num_framebuffers)
+		{
+			*output_code = IMX_VPU_API_DEC_OUTPUT_CODE_NEED_ADDITIONAL_FRAMEBUFFER;
+			return IMX_VPU_API_DEC_RETURN_CODE_OK;
+		}
+
+		simulate_latency(decoder->config.latency);
+
+		decoder->framebuffers[fb_index].in_use = 1;
+		decoder->input_frame.fb_index = fb_index;
+		decoder->queued_frames[decoder->num_queued_frames++] = decoder->input_frame;
+		decoder->has_input_frame = 0;
+		decoder->num_decoded_frames++;
+	}
+
+	if (!decoder->has_decoded_frame && (decoder->num_queued_frames > 0)
+	 && ((decoder->num_queued_frames > decoder->config.reorder_depth) || decoder->drain_mode_enabled))
+	{
+		size_t index = select_frame_by_lowest_pts(decoder->queued_frames, decoder->num_queued_frames);
+
+		decoder->decoded_frame = decoder->queued_frames[index];
+		decoder->has_decoded_frame = 1;
+		remove_frame(decoder->queued_frames, &(decoder->num_queued_frames), index);
+
+		*output_code = IMX_VPU_API_DEC_OUTPUT_CODE_DECODED_FRAME_AVAILABLE;
+		return IMX_VPU_API_DEC_RETURN_CODE_OK;
+	}
+
+	if (decoder->drain_mode_enabled && (decoder->num_queued_frames == 0))
+		*output_code = IMX_VPU_API_DEC_OUTPUT_CODE_EOS;
+	else
+		*output_code = IMX_VPU_API_DEC_OUTPUT_CODE_MORE_INPUT_DATA_NEEDED;
+
+	return IMX_VPU_API_DEC_RETURN_CODE_OK;
+}
+
+
+ImxVpuApiDecReturnCodes imx_vpu_api_dec_get_decoded_frame(ImxVpuApiDecoder *decoder, ImxVpuApiRawFrame *decoded_frame)
+{
+	StubFramebuffer *framebuffer;
+
+	if (!decoder->has_decoded_frame)
+		return IMX_VPU_API_DEC_RETURN_CODE_INVALID_CALL;
+
+	framebuffer = &(decoder->framebuffers[decoder->decoded_frame.fb_index]);
+
+	memset(decoded_frame, 0, sizeof(ImxVpuApiRawFrame));
+	decoded_frame->fb_dma_buffer = framebuffer->dma_buffer;
+	decoded_frame->fb_context = framebuffer->context;
+	decoded_frame->frame_types[0] = decoded_frame->frame_types[1] = IMX_VPU_API_FRAME_TYPE_I;
+	decoded_frame->interlacing_mode = IMX_VPU_API_INTERLACING_MODE_NO_INTERLACING;
+	decoded_frame->context = decoder->decoded_frame.context;
+	decoded_frame->pts = decoder->decoded_frame.pts;
+	decoded_frame->dts = decoder->decoded_frame.dts;
+
+	decoder->has_decoded_frame = 0;
+
+	return IMX_VPU_API_DEC_RETURN_CODE_OK;
+}
+
+
+void imx_vpu_api_dec_return_framebuffer_to_decoder(ImxVpuApiDecoder *decoder, ImxDmaBuffer *fb_dma_buffer)
+{
+	size_t i;
+
+	for (i = 0; i < decoder->num_framebuffers; ++i)
+	{
+		if (decoder->framebuffers[i].dma_buffer == fb_dma_buffer)
+		{
+			decoder->framebuffers[i].in_use = 0;
+			break;
+		}
+	}
+}
+
+
+void imx_vpu_api_dec_get_skipped_frame_info(ImxVpuApiDecoder *decoder, ImxVpuApiDecSkippedFrameReasons *reason, void **context, uint64_t *pts, uint64_t *dts)
+{
+	/* Frames are never skipped. */
+	(void)decoder;
+	(void)reason;
+	(void)context;
+	(void)pts;
+	(void)dts;
+}
+
+
+char const * imx_vpu_api_dec_return_code_string(ImxVpuApiDecReturnCodes code)
+{
+	switch (code)
+	{
+		case IMX_VPU_API_DEC_RETURN_CODE_OK: return "ok";
+		case IMX_VPU_API_DEC_RETURN_CODE_INVALID_PARAMS: return "invalid params";
+		case IMX_VPU_API_DEC_RETURN_CODE_INVALID_CALL: return "invalid call";
+		default: return "error";
+	}
+}
+
+
+char const * imx_vpu_api_dec_skipped_frame_reason_string(ImxVpuApiDecSkippedFrameReasons reason)
+{
+	(void)reason;
+	return "<unknown>";
+}
+
+
+
+
+/*** Encoder ***/
+
+static ImxVpuApiCompressionFormat enc_supported_compression_formats[] =
+{
+	IMX_VPU_API_COMPRESSION_FORMAT_JPEG
+};
+
+static ImxVpuApiColorFormat enc_supported_color_formats[] =
+{
+	IMX_VPU_API_COLOR_FORMAT_SEMI_PLANAR_YUV420_8BIT
+};
+
+static ImxVpuApiEncGlobalInfo const enc_global_info =
+{
+	.flags = IMX_VPU_API_ENC_GLOBAL_INFO_FLAG_HAS_ENCODER,
+	.min_required_stream_buffer_size = 0,
+	.required_stream_buffer_physaddr_alignment = 1,
+	.supported_compression_formats = enc_supported_compression_formats,
+	.num_supported_compression_formats = sizeof(enc_supported_compression_formats) / sizeof(ImxVpuApiCompressionFormat)
+};
+
+static ImxVpuApiCompressionFormatSupportDetails const enc_support_details =
+{
+	.min_width = STUB_MIN_DIMENSION, .max_width = STUB_MAX_DIMENSION,
+	.min_height = STUB_MIN_DIMENSION, .max_height = STUB_MAX_DIMENSION,
+	.supported_color_formats = enc_supported_color_formats,
+	.num_supported_color_formats = sizeof(enc_supported_color_formats) / sizeof(ImxVpuApiColorFormat),
+	.min_quantization = 1, .max_quantization = 100
+};
+
+
+struct _ImxVpuApiEncoder
+{
+	StubConfig config;
+	ImxVpuApiEncStreamInfo stream_info;
+	int drain_mode_enabled;
+	size_t encoded_frame_size;
+
+	/* The frame that was pushed, but not encoded yet. */
+	StubFrame input_frame;
+	int has_input_frame;
+
+	/* Encoded frames that were not output yet. If output_held_back_frames
+	 * is set, the frames in the queue are output before new ones. */
+	StubFrame *queued_frames;
+	size_t num_queued_frames;
+	int output_held_back_frames;
+
+	/* The frame that is retrieved by the next
+	 * imx_vpu_api_enc_get_encoded_frame() call. */
+	StubFrame encoded_frame;
+	int has_encoded_frame;
+
+	size_t num_encoded_frames;
+	size_t num_additional_framebuffer_requests;
+};
+
+
+ImxVpuApiEncGlobalInfo const * imx_vpu_api_enc_get_global_info(void)
+{
+	return &enc_global_info;
+}
+
+
+ImxVpuApiCompressionFormatSupportDetails const * imx_vpu_api_enc_get_compression_format_support_details(ImxVpuApiCompressionFormat compression_format)
+{
+	return (compression_format == IMX_VPU_API_COMPRESSION_FORMAT_JPEG) ? &enc_support_details : NULL;
+}
+
+
+void imx_vpu_api_enc_set_default_open_params(ImxVpuApiCompressionFormat compression_format, ImxVpuApiColorFormat color_format, size_t frame_width, size_t frame_height, ImxVpuApiEncOpenParams *open_params)
+{
+	memset(open_params, 0, sizeof(ImxVpuApiEncOpenParams));
+	open_params->compression_format = compression_format;
+	open_params->color_format = color_format;
+	open_params->frame_width = frame_width;
+	open_params->frame_height = frame_height;
+	open_params->frame_rate_numerator = 25;
+	open_params->frame_rate_denominator = 1;
+	open_params->quantization = enc_support_details.min_quantization;
+}
+
+
+ImxVpuApiEncReturnCodes imx_vpu_api_enc_open(ImxVpuApiEncoder **encoder, ImxVpuApiEncOpenParams *open_params, ImxDmaBuffer *stream_buffer)
+{
+	ImxVpuApiEncoder *enc;
+	ImxVpuApiFramebufferMetrics *metrics;
+
+	(void)stream_buffer;
+
+	if ((encoder == NULL) || (open_params == NULL))
+		return IMX_VPU_API_ENC_RETURN_CODE_INVALID_PARAMS;
+	if (open_params->compression_format != IMX_VPU_API_COMPRESSION_FORMAT_JPEG)
+		return IMX_VPU_API_ENC_RETURN_CODE_INVALID_PARAMS;
+
+	enc = calloc(1, sizeof(ImxVpuApiEncoder));
+	if (enc == NULL)
+		return IMX_VPU_API_ENC_RETURN_CODE_ERROR;
+
+	read_stub_config(&(enc->config));
+
+	enc->queued_frames = calloc(enc->config.reorder_depth + 1, sizeof(StubFrame));
+	if (enc->queued_frames == NULL)
+	{
+		free(enc);
+		return IMX_VPU_API_ENC_RETURN_CODE_ERROR;
+	}
+
+	metrics = &(enc->stream_info.frame_encoding_framebuffer_metrics);
+	fill_framebuffer_metrics(metrics, open_params->frame_width, open_params->frame_height);
+
+	enc->stream_info.min_framebuffer_size = metrics->y_size + metrics->uv_size;
+	enc->stream_info.framebuffer_alignment = 1;
+	/* One framebuffer for the reconstructed frame, and
+	 * one for each held back frame as reference frames. */
+	enc->stream_info.min_num_required_framebuffers = enc->config.reorder_depth + 1;
+	enc->stream_info.frame_rate_numerator = open_params->frame_rate_numerator;
+	enc->stream_info.frame_rate_denominator = open_params->frame_rate_denominator;
+	enc->stream_info.format_specific_open_params = open_params->format_specific_open_params;
+
+	/* Roughly the size of a JPEG picture with medium quality. */
+	enc->encoded_frame_size = metrics->y_size / 8 + 1;
+
+	*encoder = enc;
+
+	return IMX_VPU_API_ENC_RETURN_CODE_OK;
+}
+
+
+void imx_vpu_api_enc_close(ImxVpuApiEncoder *encoder)
+{
+	if (encoder == NULL)
+		return;
+
+	free(encoder->queued_frames);
+	free(encoder);
+}
+
+
+ImxVpuApiEncStreamInfo const * imx_vpu_api_enc_get_stream_info(ImxVpuApiEncoder *encoder)
+{
+	return &(encoder->stream_info);
+}
+
+
+ImxVpuApiEncReturnCodes imx_vpu_api_enc_add_framebuffers_to_pool(ImxVpuApiEncoder *encoder, ImxDmaBuffer **fb_dma_buffers, size_t num_framebuffers)
+{
+	/* The framebuffers are not accessed, so there is nothing to record. */
+	(void)encoder;
+	(void)fb_dma_buffers;
+	(void)num_framebuffers;
+	return IMX_VPU_API_ENC_RETURN_CODE_OK;
+}
+
+
+void imx_vpu_api_enc_enable_drain_mode(ImxVpuApiEncoder *encoder)
+{
+	encoder->drain_mode_enabled = 1;
+}
+
+
+void imx_vpu_api_enc_flush(ImxVpuApiEncoder *encoder)
+{
+	encoder->num_queued_frames = 0;
+	encoder->output_held_back_frames = 0;
+	encoder->has_input_frame = 0;
+	encoder->has_encoded_frame = 0;
+	encoder->drain_mode_enabled = 0;
+}
+
+
+ImxVpuApiEncReturnCodes imx_vpu_api_enc_set_bitrate(ImxVpuApiEncoder *encoder, unsigned int bitrate)
+{
+	(void)encoder;
+	(void)bitrate;
+	return IMX_VPU_API_ENC_RETURN_CODE_OK;
+}
+
+
+ImxVpuApiEncReturnCodes imx_vpu_api_enc_push_raw_frame(ImxVpuApiEncoder *encoder, ImxVpuApiRawFrame const *raw_frame)
+{
+	if (encoder->has_input_frame)
+		return IMX_VPU_API_ENC_RETURN_CODE_INVALID_CALL;
+
+	encoder->input_frame.context = raw_frame->context;
+	encoder->input_frame.pts = raw_frame->pts;
+	encoder->input_frame.dts = raw_frame->dts;
+	encoder->has_input_frame = 1;
+
+	return IMX_VPU_API_ENC_RETURN_CODE_OK;
+}
+
+
+ImxVpuApiEncReturnCodes imx_vpu_api_enc_encode(ImxVpuApiEncoder *encoder, size_t *encoded_frame_size, ImxVpuApiEncOutputCodes *output_code)
+{
+	if (encoder->has_input_frame)
+	{
+		size_t interval = encoder->config.additional_framebuffer_interval;
+
+		if ((interval > 0) && (encoder->num_encoded_frames / interval > encoder->num_additional_framebuffer_requests))
+		{
+			encoder->num_additional_framebuffer_requests++;
+			*output_code = IMX_VPU_API_ENC_OUTPUT_CODE_NEED_ADDITIONAL_FRAMEBUFFER;
+			return IMX_VPU_API_ENC_RETURN_CODE_OK;
+		}
+
+		/* If the held back frames are still being output,
+		 * the new frame has to wait until that is done. */
+		if (!encoder->output_held_back_frames)
+		{
+			simulate_latency(encoder->config.latency);
+
+			encoder->queued_frames[encoder->num_queued_frames++] = encoder->input_frame;
+			encoder->has_input_frame = 0;
+			encoder->num_encoded_frames++;
+
+			/* Once the queue is full, output the newest frame first,
+			 * followed by the held back ones in their original order. */
+			if (encoder->num_queued_frames > encoder->config.reorder_depth)
+			{
+				encoder->encoded_frame = encoder->queued_frames[encoder->num_queued_frames - 1];
+				encoder->has_encoded_frame = 1;
+				encoder->num_queued_frames--;
+				encoder->output_held_back_frames = (encoder->num_queued_frames > 0);
+
+				*encoded_frame_size = encoder->encoded_frame_size;
+				*output_code = IMX_VPU_API_ENC_OUTPUT_CODE_ENCODED_FRAME_AVAILABLE;
+				return IMX_VPU_API_ENC_RETURN_CODE_OK;
+			}
+		}
+	}
+
+	if (!encoder->has_encoded_frame && (encoder->num_queued_frames > 0)
+	 && (encoder->output_held_back_frames || encoder->drain_mode_enabled))
+	{
+		encoder->encoded_frame = encoder->queued_frames[0];
+		encoder->has_encoded_frame = 1;
+		remove_frame(encoder->queued_frames, &(encoder->num_queued_frames), 0);
+		if (encoder->num_queued_frames == 0)
+			encoder->output_held_back_frames = 0;
+
+		*encoded_frame_size = encoder->encoded_frame_size;
+		*output_code = IMX_VPU_API_ENC_OUTPUT_CODE_ENCODED_FRAME_AVAILABLE;
+		return IMX_VPU_API_ENC_RETURN_CODE_OK;
+	}
+
+	if (encoder->drain_mode_enabled && !encoder->has_input_frame && (encoder->num_queued_frames == 0))
+		*output_code = IMX_VPU_API_ENC_OUTPUT_CODE_EOS;
+	else
+		*output_code = IMX_VPU_API_ENC_OUTPUT_CODE_MORE_INPUT_DATA_NEEDED;
+
+	return IMX_VPU_API_ENC_RETURN_CODE_OK;
+}
+
+
+ImxVpuApiEncReturnCodes imx_vpu_api_enc_get_encoded_frame(ImxVpuApiEncoder *encoder, ImxVpuApiEncodedFrame *encoded_frame)
+{
+	if (!encoder->has_encoded_frame)
+		return IMX_VPU_API_ENC_RETURN_CODE_INVALID_CALL;
+
+	if (encoded_frame->data_size < encoder->encoded_frame_size)
+		return IMX_VPU_API_ENC_RETURN_CODE_INVALID_PARAMS;
+
+	/* Only write the JPEG SOI marker; the rest is left as-is. */
+	encoded_frame->data[0] = 0xFF;
+	encoded_frame->data[1] = 0xD8;
+	encoded_frame->data_size = encoder->encoded_frame_size;
+	encoded_frame->context = encoder->encoded_frame.context;
+	encoded_frame->pts = encoder->encoded_frame.pts;
+	encoded_frame->dts = encoder->encoded_frame.dts;
+
+	encoder->has_encoded_frame = 0;
+
+	return IMX_VPU_API_ENC_RETURN_CODE_OK;
+}
+
+
+char const * imx_vpu_api_enc_return_code_string(ImxVpuApiEncReturnCodes code)
+{
+	switch (code)
+	{
+		case IMX_VPU_API_ENC_RETURN_CODE_OK: return "ok";
+		case IMX_VPU_API_ENC_RETURN_CODE_INVALID_PARAMS: return "invalid params";
+		case IMX_VPU_API_ENC_RETURN_CODE_INVALID_CALL: return "invalid call";
+		default: return "error";
+	}
+}
+
+
+
+
+/*** Common ***/
+
+char const * imx_vpu_api_color_format_string(ImxVpuApiColorFormat color_format)
+{
+	return (color_format == IMX_VPU_API_COLOR_FORMAT_SEMI_PLANAR_YUV420_8BIT) ? "semi-planar YUV 4:2:0 8-bit" : "<unsupported>";
+}
+
+
+void imx_vpu_api_set_logging_threshold(ImxVpuApiLogLevel threshold)
+{
+	(void)threshold;
+}
+
+
+void imx_vpu_api_set_logging_function(void (*logging_fn)(ImxVpuApiLogLevel level, char const *file, int const line, char const *fn, const char *format, ...))
+{
+	/* The stub does not log anything. */
+	(void)logging_fn;
+}
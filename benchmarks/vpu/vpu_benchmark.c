@@ -0,0 +1,411 @@
+/* gstreamer-imx: GStreamer plugins for the i.MX SoCs
+ * Copyright (C) 2026  agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/* VPU decoding and encoding loop benchmark.
+ *
+ * Runs the imxvpudec_mpeg2 and imxvpuenc_jpeg elements on top of a stub
+ * libimxvpuapi2 (see imxvpuapi_stub.c), so the overhead of the elements'
+ * decode_queued_frames() and encode_queued_frames() loops, the framebuffer
+ * pool handling, and the output queue can be measured on any machine.
+ * The stub's latency, reordering depth, and NEED_ADDITIONAL_FRAMEBUFFER
+ * interval can be set on the command line. The printed overhead per
+ * frame is the wall-clock time per frame minus the simulated latency. */
+
+#include <stdio.h>
+#include <gst/gst.h>
+
+
+typedef struct
+{
+	gint num_frames;
+	gint width;
+	gint height;
+	gint latency;
+	gint reorder_depth;
+	gint additional_framebuffer_interval;
+	gint output_queue_depth;
+}
+BenchmarkConfig;
+
+
+static void on_handoff(GstElement *fakesink, GstBuffer *buffer, GstPad *pad, gpointer user_data)
+{
+	guint *num_output_frames = user_data;
+
+	(void)fakesink;
+	(void)buffer;
+	(void)pad;
+
+	(*num_output_frames)++;
+}
+
+
+static gboolean check_element_origin(gchar const *factory_name, GstPlugin *stub_plugin)
+{
+	/* An installed imxvpu plugin must not be used
+	 * in place of the one that uses the stub. */
+	GstElementFactory *factory;
+	GstPlugin *plugin;
+	gboolean ret;
+
+	factory = gst_element_factory_find(factory_name);
+	if (factory == NULL)
+	{
+		fprintf(stderr, "element %s not found\n", factory_name);
+		return FALSE;
+	}
+
+	plugin = gst_plugin_feature_get_plugin(GST_PLUGIN_FEATURE(factory));
+	ret = (plugin != NULL) && (g_strcmp0(gst_plugin_get_filename(plugin), gst_plugin_get_filename(stub_plugin)) == 0);
+	if (!ret)
+		fprintf(stderr, "element %s does not come from the stub plugin %s\n", factory_name, gst_plugin_get_filename(stub_plugin));
+
+	if (plugin != NULL)
+		gst_object_unref(GST_OBJECT(plugin));
+	gst_object_unref(GST_OBJECT(factory));
+
+	return ret;
+}
+
+
+static gboolean wait_for_eos(GstElement *pipeline)
+{
+	GstBus *bus;
+	GstMessage *msg;
+	gboolean ret = TRUE;
+
+	bus = gst_element_get_bus(pipeline);
+	msg = gst_bus_timed_pop_filtered(bus, GST_CLOCK_TIME_NONE, GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+
+	if (GST_MESSAGE_TYPE(msg) == GST_MESSAGE_ERROR)
+	{
+		GError *error = NULL;
+		gchar *debug_info = NULL;
+
+		gst_message_parse_error(msg, &error, &debug_info);
+		fprintf(stderr, "pipeline error: %s (%s)\n", error->message, (debug_info != NULL) ? debug_info : "no debug info");
+		g_error_free(error);
+		g_free(debug_info);
+
+		ret = FALSE;
+	}
+
+	gst_message_unref(msg);
+	gst_object_unref(GST_OBJECT(bus));
+
+	return ret;
+}
+
+
+static void print_result(gchar const *name, BenchmarkConfig const *config, guint num_output_frames, gint64 duration)
+{
+	gdouble time_per_frame = (gdouble)duration / num_output_frames;
+
+	printf(
+		"%-8s %8u frames  %10.1f frames/s  %8.1f us/frame  %8.1f us/frame overhead\n",
+		name,
+		num_output_frames,
+		num_output_frames * 1000000.0 / duration,
+		time_per_frame,
+		time_per_frame - config->latency
+	);
+}
+
+
+static GstElement* create_pipeline(gchar const *description)
+{
+	GError *error = NULL;
+	GstElement *pipeline;
+
+	pipeline = gst_parse_launch(description, &error);
+	if (pipeline == NULL)
+	{
+		fprintf(stderr, "could not create pipeline \"%s\": %s\n", description, error->message);
+		g_error_free(error);
+	}
+	else if (error != NULL)
+	{
+		fprintf(stderr, "could not create pipeline \"%s\": %s\n", description, error->message);
+		g_error_free(error);
+		gst_object_unref(GST_OBJECT(pipeline));
+		pipeline = NULL;
+	}
+
+	return pipeline;
+}
+
+
+static gboolean run_pipeline(gchar const *name, GstElement *pipeline, BenchmarkConfig const *config, gboolean (*push_frames)(GstElement *pipeline, BenchmarkConfig const *config))
+{
+	GstElement *fakesink;
+	guint num_output_frames = 0;
+	gint64 duration;
+	gboolean ret;
+
+	fakesink = gst_bin_get_by_name(GST_BIN(pipeline), "sink");
+	g_object_set(G_OBJECT(fakesink), "sync", FALSE, "signal-handoffs", TRUE, NULL);
+	g_signal_connect(G_OBJECT(fakesink), "handoff", G_CALLBACK(on_handoff), &num_output_frames);
+	gst_object_unref(GST_OBJECT(fakesink));
+
+	if (gst_element_set_state(pipeline, GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE)
+	{
+		fprintf(stderr, "could not start %s pipeline\n", name);
+		gst_element_set_state(pipeline, GST_STATE_NULL);
+		return FALSE;
+	}
+
+	duration = g_get_monotonic_time();
+
+	ret = ((push_frames == NULL) || push_frames(pipeline, config)) && wait_for_eos(pipeline);
+
+	duration = g_get_monotonic_time() - duration;
+
+	gst_element_set_state(pipeline, GST_STATE_NULL);
+
+	if (ret && (num_output_frames != (guint)(config->num_frames)))
+	{
+		fprintf(stderr, "%s produced %u frames instead of %d\n", name, num_output_frames, config->num_frames);
+		ret = FALSE;
+	}
+
+	if (ret)
+		print_result(name, config, num_output_frames, duration);
+
+	return ret;
+}
+
+
+static gboolean push_encoded_frames(GstElement *pipeline, BenchmarkConfig const *config)
+{
+	/* The stub does not parse the input, so the frames just contain
+	 * placeholder bytes. They are pushed in decoding order: with a
+	 * reordering depth of N, each group of N+1 frames starts with the
+	 * frame that is presented last in that group, like an I- or P-frame
+	 * followed by B-frames. */
+	GstClockTime const frame_duration = GST_SECOND / 25;
+	guint group_size = config->reorder_depth + 1;
+	GstElement *appsrc;
+	GstFlowReturn flow_ret = GST_FLOW_OK;
+	gint i;
+
+	appsrc = gst_bin_get_by_name(GST_BIN(pipeline), "src");
+
+	for (i = 0; i < config->num_frames; ++i)
+	{
+		GstBuffer *buffer;
+		guint group_start = i - (i % group_size);
+		guint index_in_group = i % group_size;
+		guint presentation_index;
+
+		if (index_in_group == 0)
+			presentation_index = MIN(group_start + group_size, (guint)(config->num_frames)) - 1;
+		else
+			presentation_index = group_start + index_in_group - 1;
+
+		buffer = gst_buffer_new_allocate(NULL, 4096, NULL);
+		gst_buffer_memset(buffer, 0, 0, 4096);
+		GST_BUFFER_PTS(buffer) = presentation_index * frame_duration;
+		GST_BUFFER_DTS(buffer) = i * frame_duration;
+		GST_BUFFER_DURATION(buffer) = frame_duration;
+
+		g_signal_emit_by_name(appsrc, "push-buffer", buffer, &flow_ret);
+		gst_buffer_unref(buffer);
+
+		if (flow_ret != GST_FLOW_OK)
+		{
+			fprintf(stderr, "could not push frame #%d: %s\n", i, gst_flow_get_name(flow_ret));
+			break;
+		}
+	}
+
+	if (flow_ret == GST_FLOW_OK)
+		g_signal_emit_by_name(appsrc, "end-of-stream", &flow_ret);
+
+	gst_object_unref(GST_OBJECT(appsrc));
+
+	return (flow_ret == GST_FLOW_OK);
+}
+
+
+static gboolean run_decoder(BenchmarkConfig const *config)
+{
+	static guint8 const codec_data_bytes[] = { 0x00, 0x00, 0x01, 0xB3 };
+	GstElement *pipeline, *appsrc, *decoder;
+	GstBuffer *codec_data;
+	GstCaps *caps;
+	gboolean ret;
+
+	pipeline = create_pipeline("appsrc name=src ! imxvpudec_mpeg2 name=dec ! fakesink name=sink");
+	if (pipeline == NULL)
+		return FALSE;
+
+	codec_data = gst_buffer_new_allocate(NULL, sizeof(codec_data_bytes), NULL);
+	gst_buffer_fill(codec_data, 0, codec_data_bytes, sizeof(codec_data_bytes));
+	caps = gst_caps_new_simple(
+		"video/mpeg",
+		"mpegversion", G_TYPE_INT, 2,
+		"systemstream", G_TYPE_BOOLEAN, FALSE,
+		"parsed", G_TYPE_BOOLEAN, TRUE,
+		"width", G_TYPE_INT, config->width,
+		"height", G_TYPE_INT, config->height,
+		"framerate", GST_TYPE_FRACTION, 25, 1,
+		"codec_data", GST_TYPE_BUFFER, codec_data,
+		NULL
+	);
+	gst_buffer_unref(codec_data);
+
+	/* Limit the queued bytes so pushing blocks instead of
+	 * filling the appsrc queue with all frames at once. */
+	appsrc = gst_bin_get_by_name(GST_BIN(pipeline), "src");
+	g_object_set(G_OBJECT(appsrc), "caps", caps, "format", GST_FORMAT_TIME, "block", TRUE, "max-bytes", (guint64)(4096 * 4), NULL);
+	gst_object_unref(GST_OBJECT(appsrc));
+	gst_caps_unref(caps);
+
+	if (config->output_queue_depth >= 0)
+	{
+		decoder = gst_bin_get_by_name(GST_BIN(pipeline), "dec");
+		g_object_set(G_OBJECT(decoder), "output-queue-depth", (guint)(config->output_queue_depth), NULL);
+		gst_object_unref(GST_OBJECT(decoder));
+	}
+
+	ret = run_pipeline("decoder", pipeline, config, push_encoded_frames);
+
+	gst_object_unref(GST_OBJECT(pipeline));
+
+	return ret;
+}
+
+
+static gboolean run_encoder(BenchmarkConfig const *config)
+{
+	gchar *description;
+	GstElement *pipeline;
+	gboolean ret;
+
+	description = g_strdup_printf(
+		"videotestsrc name=src num-buffers=%d pattern=black ! video/x-raw, format=NV12, width=%d, height=%d, framerate=25/1 ! imxvpuenc_jpeg ! fakesink name=sink",
+		config->num_frames,
+		config->width,
+		config->height
+	);
+	pipeline = create_pipeline(description);
+	g_free(description);
+
+	if (pipeline == NULL)
+		return FALSE;
+
+	ret = run_pipeline("encoder", pipeline, config, NULL);
+
+	gst_object_unref(GST_OBJECT(pipeline));
+
+	return ret;
+}
+
+
+int main(int argc, char *argv[])
+{
+	BenchmarkConfig config =
+	{
+		.num_frames = 1000,
+		.width = 1280,
+		.height = 720,
+		.latency = 0,
+		.reorder_depth = 0,
+		.additional_framebuffer_interval = 0,
+		.output_queue_depth = -1
+	};
+	GError *error = NULL;
+	GOptionContext *option_context;
+	GstPlugin *stub_plugin;
+	gchar *value;
+	gboolean ret;
+	GOptionEntry const option_entries[] =
+	{
+		{ "frames", 'n', 0, G_OPTION_ARG_INT, &(config.num_frames), "Number of frames per run (default: 1000)", "N" },
+		{ "width", 0, 0, G_OPTION_ARG_INT, &(config.width), "Frame width; must be a multiple of 16 (default: 1280)", "PIXELS" },
+		{ "height", 0, 0, G_OPTION_ARG_INT, &(config.height), "Frame height; must be a multiple of 16 (default: 720)", "PIXELS" },
+		{ "latency", 'l', 0, G_OPTION_ARG_INT, &(config.latency), "Simulated decoding/encoding time per frame (default: 0)", "MICROSECONDS" },
+		{ "reorder-depth", 'r', 0, G_OPTION_ARG_INT, &(config.reorder_depth), "Number of frames the stub holds back and reorders (default: 0)", "N" },
+		{ "additional-framebuffer-interval", 'a', 0, G_OPTION_ARG_INT, &(config.additional_framebuffer_interval), "Request an additional framebuffer every N frames; 0 disables this (default: 0)", "N" },
+		{ "output-queue-depth", 'q', 0, G_OPTION_ARG_INT, &(config.output_queue_depth), "Decoder output-queue-depth property; -1 keeps its default (default: -1)", "N" },
+		{ NULL, 0, 0, G_OPTION_ARG_NONE, NULL, NULL, NULL }
+	};
+
+	gst_init(&argc, &argv);
+
+	option_context = g_option_context_new("- VPU decoding and encoding loop benchmark");
+	g_option_context_add_main_entries(option_context, option_entries, NULL);
+	if (!g_option_context_parse(option_context, &argc, &argv, &error))
+	{
+		fprintf(stderr, "could not parse command line: %s\n", error->message);
+		g_error_free(error);
+		g_option_context_free(option_context);
+		return -1;
+	}
+	g_option_context_free(option_context);
+
+	if ((config.num_frames < 1) || (config.width < 16) || (config.height < 16)
+	 || ((config.width % 16) != 0) || ((config.height % 16) != 0)
+	 || (config.latency < 0) || (config.reorder_depth < 0) || (config.additional_framebuffer_interval < 0))
+	{
+		fprintf(stderr, "invalid frame count, frame size, or stub setting\n");
+		return -1;
+	}
+
+	/* The stub reads its settings from the environment when
+	 * a decoder or encoder is opened. The memfd allocator is
+	 * used, since there is no DMA memory outside of i.MX SoCs. */
+	value = g_strdup_printf("%d", config.latency);
+	g_setenv("IMX_VPU_STUB_LATENCY", value, TRUE);
+	g_free(value);
+	value = g_strdup_printf("%d", config.reorder_depth);
+	g_setenv("IMX_VPU_STUB_REORDER_DEPTH", value, TRUE);
+	g_free(value);
+	value = g_strdup_printf("%d", config.additional_framebuffer_interval);
+	g_setenv("IMX_VPU_STUB_ADDITIONAL_FRAMEBUFFER_INTERVAL", value, TRUE);
+	g_free(value);
+	g_setenv("GSTREAMER_IMX_USE_MEMFD_ALLOCATOR", "1", TRUE);
+
+	stub_plugin = gst_plugin_load_file(VPU_STUB_PLUGIN_FILENAME, &error);
+	if (stub_plugin == NULL)
+	{
+		fprintf(stderr, "could not load stub VPU plugin: %s\n", error->message);
+		g_error_free(error);
+		return -1;
+	}
+
+	ret = check_element_origin("imxvpudec_mpeg2", stub_plugin) && check_element_origin("imxvpuenc_jpeg", stub_plugin);
+
+	if (ret)
+	{
+		printf(
+			"%dx%d frames, stub latency %d us, reorder depth %d, additional framebuffer interval %d\n\n",
+			config.width, config.height,
+			config.latency,
+			config.reorder_depth,
+			config.additional_framebuffer_interval
+		);
+
+		ret = run_decoder(&config);
+		ret = run_encoder(&config) && ret;
+	}
+
+	gst_object_unref(GST_OBJECT(stub_plugin));
+
+	return ret ? 0 : -1;
+}
@@ -49,6 +49,38 @@ typedef struct _GstImx2dCompositorPadClass GstImx2dCompositorPadClass;
 GType gst_imx_2d_compositor_pad_get_type(void);
 
 
+/* Snapshot of everything that defines what a pad draws into
+ * the output frame. Snapshots of all pads are stored for each
+ * output buffer to be able to determine later which parts of
+ * that buffer need to be redrawn (see the damage tracking
+ * notes in gst_imx_2d_compositor_aggregate_frames()). */
+typedef struct
+{
+	/* The pad this state belongs to. In stored damage records,
+	 * this is only used for comparisons and never dereferenced,
+	 * so it is not a problem if the pad is gone in the meantime.
+	 * A new pad that happens to get the same address is still
+	 * detected as changed, since its content_serial differs. */
+	gpointer pad;
+
+	/* Serial number of the pad's current frame content, or
+	 * 0 if the pad has no buffer. See content_serial below. */
+	guint64 content_serial;
+
+	/* Part of the output frame that is modified by the pad,
+	 * clipped to the output frame. This region is empty if
+	 * the pad does not draw anything. */
+	Imx2dRegion drawn_region;
+
+	Imx2dRegion inner_region;
+	guint32 margin_color;
+	gint alpha;
+	GstVideoOrientationMethod video_direction;
+	gboolean input_crop;
+}
+GstImx2dCompositorPadDrawState;
+
+
 struct _GstImx2dCompositorPad
 {
 	GstVideoAggregatorPad parent;
@@ -108,6 +140,14 @@ struct _GstImx2dCompositorPad
 
 	gboolean region_coords_need_update;
 
+	/* If TRUE, then nothing that this pad draws would be
+	 * visible in the current output frame, either because
+	 * opaque pads with a higher zorder cover it, or because
+	 * it is outside of the output frame or fully transparent.
+	 * Such pads are neither uploaded nor blitted. This is
+	 * determined anew in each aggregate_frames() call. */
+	gboolean fully_occluded;
+
 	/* letterbox_margin: Margin calculated for producing
 	 * a letterbox around the inner_region. inner_region
 	 * plus letterbox_margin result in the outer_region.
@@ -130,6 +170,34 @@ struct _GstImx2dCompositorPad
 
 	GstImxVideoUploader *uploader;
 
+	/* Copies of the pad's regions and margin that are used by
+	 * the blit parameters of the current aggregate_frames() call.
+	 * These must stay valid until the batched blit is performed. */
+	Imx2dRegion blit_inner_region;
+	Imx2dBlitMargin blit_combined_margin;
+	Imx2dRegion blit_crop_rectangle;
+
+	/* Used for detecting when the pad's frame content changes.
+	 * Whenever a buffer with a different pointer or PTS than
+	 * the last one shows up, content_serial is set to a new,
+	 * compositor wide unique value. last_seen_buffer is only
+	 * compared against, and never dereferenced, so no buffer
+	 * reference needs to be held. */
+	GstBuffer *last_seen_buffer;
+	GstClockTime last_seen_buffer_pts;
+	guint64 content_serial;
+
+	/* What the pad draws in the current aggregate_frames() call.
+	 * Filled in by gst_imx_2d_compositor_pad_update_draw_state(). */
+	GstImx2dCompositorPadDrawState draw_state;
+
+	/* property_serial is incremented whenever a property that
+	 * affects the output changes. composed_property_serial is
+	 * the value property_serial had when the last output frame
+	 * was composed. If these differ, that frame is outdated. */
+	guint property_serial;
+	guint composed_property_serial;
+
 	gint xpos, ypos;
 	gint width, height;
 	Imx2dBlitMargin extra_margin;
@@ -201,6 +269,7 @@ static GstPadProbeReturn gst_imx_2d_compositor_downstream_event_probe(GstPad *pa
 
 static void gst_imx_2d_compositor_pad_recalculate_regions_if_needed(GstImx2dCompositorPad *self, GstVideoInfo *output_video_info);
 static GstVideoOrientationMethod gst_imx_2d_compositor_pad_get_current_video_direction(GstImx2dCompositorPad *self);
+static void gst_imx_2d_compositor_pad_update_draw_state(GstImx2dCompositorPad *self, GstBuffer *input_buffer, Imx2dRegion const *output_region, guint64 *content_serial_counter);
 
 
 static void gst_imx_2d_compositor_pad_class_init(GstImx2dCompositorPadClass *klass)
@@ -396,6 +465,14 @@ static void gst_imx_2d_compositor_pad_init(GstImx2dCompositorPad *self)
 	self->inner_region_fills_output_frame = TRUE;
 	self->total_region_fills_output_frame = TRUE;
 
+	self->last_seen_buffer = NULL;
+	self->last_seen_buffer_pts = GST_CLOCK_TIME_NONE;
+	self->content_serial = 0;
+	memset(&(self->draw_state), 0, sizeof(self->draw_state));
+
+	self->property_serial = 0;
+	self->composed_property_serial = 0;
+
 	memset(&(self->letterbox_margin), 0, sizeof(Imx2dRegion));
 	memcpy(&(self->combined_margin), &(self->extra_margin), sizeof(Imx2dRegion));
 
@@ -515,8 +592,12 @@ static void gst_imx_2d_compositor_pad_set_property(GObject *object, guint prop_i
 
 		default:
 			G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
-			break;
+			return;
 	}
+
+	GST_OBJECT_LOCK(self);
+	self->property_serial++;
+	GST_OBJECT_UNLOCK(self);
 }
 
 
@@ -635,6 +716,7 @@ static GstPadProbeReturn gst_imx_2d_compositor_downstream_event_probe(GstPad *pa
 			{
 				GST_OBJECT_LOCK(compositor_pad);
 				compositor_pad->tag_video_direction = new_tag_video_direction;
+				compositor_pad->property_serial++;
 				GST_OBJECT_UNLOCK(compositor_pad);
 			}
 
@@ -680,6 +762,7 @@ static GstPadProbeReturn gst_imx_2d_compositor_downstream_event_probe(GstPad *pa
 			compositor_pad->input_surface_desc.format = gst_imx_2d_convert_from_gst_video_format(GST_VIDEO_INFO_FORMAT(&video_info), &input_video_tile_layout);
 
 			compositor_pad->region_coords_need_update = TRUE;
+			compositor_pad->property_serial++;
 
 			/* TODO: There is currently no way to report an error if this call fails. */
 			gst_imx_video_uploader_set_input_video_info(compositor_pad->uploader, &video_info);
@@ -841,6 +924,60 @@ static GstVideoOrientationMethod gst_imx_2d_compositor_pad_get_current_video_dir
 }
 
 
+static void gst_imx_2d_compositor_pad_update_draw_state(GstImx2dCompositorPad *self, GstBuffer *input_buffer, Imx2dRegion const *output_region, guint64 *content_serial_counter)
+{
+	GstImx2dCompositorPadDrawState *draw_state = &(self->draw_state);
+	Imx2dRegion const *drawn_region;
+	gint margin_alpha;
+
+	memset(draw_state, 0, sizeof(GstImx2dCompositorPadDrawState));
+	draw_state->pad = self;
+
+	/* The output frame that is about to be composed will
+	 * reflect all property changes made up to this point. */
+	GST_OBJECT_LOCK(self);
+	self->composed_property_serial = self->property_serial;
+	GST_OBJECT_UNLOCK(self);
+
+	if (input_buffer == NULL)
+	{
+		/* Forget about the last buffer. Otherwise, if the same
+		 * buffer shows up again later, it would not be recognized
+		 * as new content, even though the pad drew nothing in
+		 * between. */
+		self->last_seen_buffer = NULL;
+		self->last_seen_buffer_pts = GST_CLOCK_TIME_NONE;
+		return;
+	}
+
+	if ((input_buffer != self->last_seen_buffer) || (GST_BUFFER_PTS(input_buffer) != self->last_seen_buffer_pts))
+	{
+		self->last_seen_buffer = input_buffer;
+		self->last_seen_buffer_pts = GST_BUFFER_PTS(input_buffer);
+		self->content_serial = ++(*content_serial_counter);
+	}
+
+	draw_state->content_serial = self->content_serial;
+
+	GST_OBJECT_LOCK(self);
+
+	memcpy(&(draw_state->inner_region), &(self->inner_region), sizeof(Imx2dRegion));
+	draw_state->margin_color = self->combined_margin.color;
+	draw_state->alpha = CLAMP((gint)(self->alpha * 255), 0, 255);
+	draw_state->video_direction = gst_imx_2d_compositor_pad_get_current_video_direction(self);
+	draw_state->input_crop = self->input_crop;
+
+	/* The margin is only drawn if it is not fully transparent. */
+	margin_alpha = (self->combined_margin.color >> 24) & 0xFF;
+	drawn_region = (margin_alpha != 0) ? &(self->total_region) : &(self->inner_region);
+
+	if ((self->alpha > 0.0) && (imx_2d_region_check_inclusion(drawn_region, output_region) != IMX_2D_REGION_INCLUSION_NONE))
+		imx_2d_region_intersect(&(draw_state->drawn_region), drawn_region, output_region);
+
+	GST_OBJECT_UNLOCK(self);
+}
+
+
 
 
 /********** GstImx2dCompositor **********/
@@ -848,10 +985,40 @@ static GstVideoOrientationMethod gst_imx_2d_compositor_pad_get_current_video_dir
 enum
 {
 	PROP_0,
-	PROP_BACKGROUND_COLOR
+	PROP_BACKGROUND_COLOR,
+	PROP_DAMAGE_HISTORY_DEPTH,
+	PROP_REPEAT_UNCHANGED_OUTPUT
 };
 
 #define DEFAULT_BACKGROUND_COLOR 0x000000
+#define DEFAULT_DAMAGE_HISTORY_DEPTH 0
+#define DEFAULT_REPEAT_UNCHANGED_OUTPUT FALSE
+
+/* If the damaged area of an output buffer consists of more
+ * regions than this, it is redrawn as one bounding box instead.
+ * Every region requires its own set of background fills and
+ * blits, so beyond some point, redrawing a bit more than what
+ * is strictly necessary is cheaper. */
+#define MAX_NUM_DAMAGE_REGIONS 8
+
+
+/* Describes how an output buffer was composed. The ID of the
+ * record is attached to the buffer as qdata. This way, it is
+ * possible to figure out what is already in a buffer when it
+ * comes back from the buffer pool. Using qdata instead of the
+ * buffer pointer as the key also makes sure that a new buffer
+ * which happens to reuse the memory of a freed one is not
+ * mistaken for the freed one. */
+typedef struct
+{
+	guint id;
+	guint32 background_color;
+	GstImx2dCompositorPadDrawState *pad_states;
+	guint num_pad_states;
+}
+GstImx2dCompositorDamageRecord;
+
+static GQuark damage_record_id_quark;
 
 
 
@@ -891,10 +1058,21 @@ static gboolean gst_imx_2d_compositor_sink_query(GstAggregator *aggregator, GstA
 static gboolean gst_imx_2d_compositor_negotiated_src_caps(GstAggregator *aggregator, GstCaps *caps);
 
 /* Frame output. */
+static GstFlowReturn gst_imx_2d_compositor_create_output_buffer(GstVideoAggregator *videoaggregator, GstBuffer **outbuffer);
 static GstFlowReturn gst_imx_2d_compositor_aggregate_frames(GstVideoAggregator *videoaggregator, GstBuffer *output_buffer);
 
 /* Misc GstImx2dCompositor functionality. */
 static gboolean gst_imx_2d_compositor_create_blitter(GstImx2dCompositor *self);
+static gboolean gst_imx_2d_compositor_add_opaque_region(GstImx2dCompositor *self, Imx2dRegion const *region, Imx2dRegion const *output_region);
+static gboolean gst_imx_2d_compositor_draw(GstImx2dCompositor *self);
+static gboolean gst_imx_2d_compositor_is_last_output_unchanged(GstImx2dCompositor *self);
+
+/* Damage tracking. */
+static void gst_imx_2d_compositor_free_damage_record(GstImx2dCompositorDamageRecord *damage_record);
+static void gst_imx_2d_compositor_clear_damage_history(GstImx2dCompositor *self);
+static GstImx2dCompositorDamageRecord* gst_imx_2d_compositor_take_damage_record(GstImx2dCompositor *self, GstBuffer *buffer);
+static void gst_imx_2d_compositor_store_damage_record(GstImx2dCompositor *self, GstBuffer *buffer, guint32 background_color, guint damage_history_depth);
+static gboolean gst_imx_2d_compositor_compute_damage(GstImx2dCompositor *self, GstImx2dCompositorDamageRecord const *damage_record, guint32 background_color, gboolean *full_redraw_needed);
 
 
 static void gst_imx_2d_compositor_class_init(GstImx2dCompositorClass *klass)
@@ -927,10 +1105,13 @@ static void gst_imx_2d_compositor_class_init(GstImx2dCompositorClass *klass)
 	aggregator_class->sink_query          = GST_DEBUG_FUNCPTR(gst_imx_2d_compositor_sink_query);
 	aggregator_class->negotiated_src_caps = GST_DEBUG_FUNCPTR(gst_imx_2d_compositor_negotiated_src_caps);
 
-	video_aggregator_class->aggregate_frames = GST_DEBUG_FUNCPTR(gst_imx_2d_compositor_aggregate_frames);
+	video_aggregator_class->create_output_buffer = GST_DEBUG_FUNCPTR(gst_imx_2d_compositor_create_output_buffer);
+	video_aggregator_class->aggregate_frames     = GST_DEBUG_FUNCPTR(gst_imx_2d_compositor_aggregate_frames);
 
 	klass->create_blitter = NULL;
 
+	damage_record_id_quark = g_quark_from_static_string("gst-imx-2d-compositor-damage-record-id");
+
 	g_object_class_install_property(
 		object_class,
 		PROP_BACKGROUND_COLOR,
@@ -944,12 +1125,51 @@ static void gst_imx_2d_compositor_class_init(GstImx2dCompositorClass *klass)
 			G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS
 		)
 	);
+	g_object_class_install_property(
+		object_class,
+		PROP_DAMAGE_HISTORY_DEPTH,
+		g_param_spec_uint(
+			"damage-history-depth",
+			"Damage history depth",
+			"How many output buffers to remember the composition of, for redrawing only the parts "
+			"that changed since a buffer was last used (0 = disabled; always redraw the whole frame); "
+			"only enable this if downstream does not modify output buffers in place",
+			0,
+			64,
+			DEFAULT_DAMAGE_HISTORY_DEPTH,
+			G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS
+		)
+	);
+	g_object_class_install_property(
+		object_class,
+		PROP_REPEAT_UNCHANGED_OUTPUT,
+		g_param_spec_boolean(
+			"repeat-unchanged-output",
+			"Repeat unchanged output",
+			"If neither input buffers nor properties changed since the last output frame was composed, "
+			"output that frame again instead of composing a new one; the repeated frame shares the memory "
+			"of the previous one, so downstream must not modify output buffers in place",
+			DEFAULT_REPEAT_UNCHANGED_OUTPUT,
+			G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS
+		)
+	);
 }
 
 
 static void gst_imx_2d_compositor_init(GstImx2dCompositor *self)
 {
 	self->background_color = DEFAULT_BACKGROUND_COLOR;
+	self->damage_history_depth = DEFAULT_DAMAGE_HISTORY_DEPTH;
+	self->repeat_unchanged_output = DEFAULT_REPEAT_UNCHANGED_OUTPUT;
+
+	self->last_output_buffer = NULL;
+	self->output_state_serial = 0;
+	self->composed_output_state_serial = 0;
+	self->repeating_output = FALSE;
+
+	g_queue_init(&(self->damage_history));
+	self->next_damage_record_id = 1;
+	self->content_serial_counter = 0;
 
 	/* NOTE: This is created here instead of in start() because new
 	 * compositor pads may appear before start() runs. When a new pad
@@ -1025,6 +1245,23 @@ static void gst_imx_2d_compositor_set_property(GObject *object, guint prop_id, G
 		{
 			GST_OBJECT_LOCK(self);
 			self->background_color = g_value_get_uint(value);
+			self->output_state_serial++;
+			GST_OBJECT_UNLOCK(self);
+			break;
+		}
+
+		case PROP_DAMAGE_HISTORY_DEPTH:
+		{
+			GST_OBJECT_LOCK(self);
+			self->damage_history_depth = g_value_get_uint(value);
+			GST_OBJECT_UNLOCK(self);
+			break;
+		}
+
+		case PROP_REPEAT_UNCHANGED_OUTPUT:
+		{
+			GST_OBJECT_LOCK(self);
+			self->repeat_unchanged_output = g_value_get_boolean(value);
 			GST_OBJECT_UNLOCK(self);
 			break;
 		}
@@ -1050,6 +1287,22 @@ static void gst_imx_2d_compositor_get_property(GObject *object, guint prop_id, G
 			break;
 		}
 
+		case PROP_DAMAGE_HISTORY_DEPTH:
+		{
+			GST_OBJECT_LOCK(self);
+			g_value_set_uint(value, self->damage_history_depth);
+			GST_OBJECT_UNLOCK(self);
+			break;
+		}
+
+		case PROP_REPEAT_UNCHANGED_OUTPUT:
+		{
+			GST_OBJECT_LOCK(self);
+			g_value_set_boolean(value, self->repeat_unchanged_output);
+			GST_OBJECT_UNLOCK(self);
+			break;
+		}
+
 		default:
 			G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
 			break;
@@ -1089,6 +1342,10 @@ static GstPad* gst_imx_2d_compositor_request_new_pad(GstElement *element, GstPad
 	}
 	GST_IMX_2D_COMPOSITOR_PAD(new_pad)->uploader = uploader;
 
+	GST_OBJECT_LOCK(self);
+	self->output_state_serial++;
+	GST_OBJECT_UNLOCK(self);
+
 	GST_DEBUG_OBJECT(element, "created and added new request pad %s:%s", GST_DEBUG_PAD_NAME(new_pad));
 
 	gst_child_proxy_child_added(GST_CHILD_PROXY(element), G_OBJECT(new_pad), GST_OBJECT_NAME(new_pad));
@@ -1112,6 +1369,10 @@ static void gst_imx_2d_compositor_release_pad(GstElement *element, GstPad *pad)
 	gst_child_proxy_child_removed(GST_CHILD_PROXY(element), G_OBJECT(pad), GST_OBJECT_NAME(pad));
 
 	GST_ELEMENT_CLASS(gst_imx_2d_compositor_parent_class)->release_pad(element, pad);
+
+	GST_OBJECT_LOCK(element);
+	GST_IMX_2D_COMPOSITOR(element)->output_state_serial++;
+	GST_OBJECT_UNLOCK(element);
 }
 
 
@@ -1138,6 +1399,11 @@ static gboolean gst_imx_2d_compositor_decide_allocation(GstAggregator *aggregato
 		self->video_buffer_pool = NULL;
 	}
 
+	/* The damage records and the last output buffer
+	 * belong to the old pool. */
+	gst_imx_2d_compositor_clear_damage_history(self);
+	gst_buffer_replace(&(self->last_output_buffer), NULL);
+
 	self->video_buffer_pool = gst_imx_video_buffer_pool_new(
 		self->imx_dma_buffer_allocator,
 		query,
@@ -1183,6 +1449,21 @@ static gboolean gst_imx_2d_compositor_start(GstAggregator *aggregator)
 	/* imx_2d_surface_create() is never supposed to return NULL. */
 	g_assert(self->output_surface != NULL);
 
+	self->batched_blit_params = g_array_new(FALSE, TRUE, sizeof(Imx2dBlitParams));
+	self->batched_blit_sources = g_ptr_array_new();
+	self->batched_uploaded_input_buffers = g_ptr_array_new_with_free_func((GDestroyNotify)gst_buffer_unref);
+
+	self->opaque_region_set = imx_2d_region_set_create();
+	self->background_region_set = imx_2d_region_set_create();
+	self->damage_region_set = imx_2d_region_set_create();
+	if ((self->opaque_region_set == NULL) || (self->background_region_set == NULL) || (self->damage_region_set == NULL))
+	{
+		GST_ERROR_OBJECT(self, "creating region sets failed");
+		goto error;
+	}
+
+	self->current_pad_states = g_array_new(FALSE, TRUE, sizeof(GstImx2dCompositorPadDrawState));
+
 	return TRUE;
 
 error:
@@ -1195,6 +1476,52 @@ static gboolean gst_imx_2d_compositor_stop(GstAggregator *aggregator)
 {
 	GstImx2dCompositor *self = GST_IMX_2D_COMPOSITOR(aggregator);
 
+	if (self->batched_blit_params != NULL)
+	{
+		g_array_free(self->batched_blit_params, TRUE);
+		self->batched_blit_params = NULL;
+	}
+
+	if (self->batched_blit_sources != NULL)
+	{
+		g_ptr_array_free(self->batched_blit_sources, TRUE);
+		self->batched_blit_sources = NULL;
+	}
+
+	if (self->batched_uploaded_input_buffers != NULL)
+	{
+		g_ptr_array_free(self->batched_uploaded_input_buffers, TRUE);
+		self->batched_uploaded_input_buffers = NULL;
+	}
+
+	if (self->opaque_region_set != NULL)
+	{
+		imx_2d_region_set_destroy(self->opaque_region_set);
+		self->opaque_region_set = NULL;
+	}
+
+	if (self->background_region_set != NULL)
+	{
+		imx_2d_region_set_destroy(self->background_region_set);
+		self->background_region_set = NULL;
+	}
+
+	if (self->damage_region_set != NULL)
+	{
+		imx_2d_region_set_destroy(self->damage_region_set);
+		self->damage_region_set = NULL;
+	}
+
+	if (self->current_pad_states != NULL)
+	{
+		g_array_free(self->current_pad_states, TRUE);
+		self->current_pad_states = NULL;
+	}
+
+	gst_imx_2d_compositor_clear_damage_history(self);
+	gst_buffer_replace(&(self->last_output_buffer), NULL);
+	self->repeating_output = FALSE;
+
 	if (self->output_surface != NULL)
 	{
 		imx_2d_surface_destroy(self->output_surface);
@@ -1209,6 +1536,16 @@ static gboolean gst_imx_2d_compositor_stop(GstAggregator *aggregator)
 
 	if (self->video_buffer_pool != NULL)
 	{
+		guint64 num_zero_copy_transfers, num_copied_transfers;
+
+		gst_imx_video_buffer_pool_get_transfer_statistics(self->video_buffer_pool, &num_zero_copy_transfers, &num_copied_transfers);
+		GST_INFO_OBJECT(
+			self,
+			"output frame transfers: %" G_GUINT64_FORMAT " without copy, %" G_GUINT64_FORMAT " copied with the CPU",
+			num_zero_copy_transfers,
+			num_copied_transfers
+		);
+
 		gst_object_unref(GST_OBJECT(self->video_buffer_pool));
 		self->video_buffer_pool = NULL;
 	}
@@ -1335,21 +1672,69 @@ static gboolean gst_imx_2d_compositor_negotiated_src_caps(GstAggregator *aggrega
 		compositor_pad->region_coords_need_update = TRUE;
 	}
 
+	/* Existing output buffers were composed for the old caps. */
+	gst_imx_2d_compositor_clear_damage_history(self);
+	gst_buffer_replace(&(self->last_output_buffer), NULL);
+	self->output_state_serial++;
+
 	GST_OBJECT_UNLOCK(self);
 
 	return GST_AGGREGATOR_CLASS(gst_imx_2d_compositor_parent_class)->negotiated_src_caps(aggregator, caps);
 }
 
 
+static GstFlowReturn gst_imx_2d_compositor_create_output_buffer(GstVideoAggregator *videoaggregator, GstBuffer **outbuffer)
+{
+	GstImx2dCompositor *self = GST_IMX_2D_COMPOSITOR(videoaggregator);
+	gboolean repeat_output;
+
+	GST_OBJECT_LOCK(self);
+	repeat_output = self->repeat_unchanged_output && gst_imx_2d_compositor_is_last_output_unchanged(self);
+	GST_OBJECT_UNLOCK(self);
+
+	self->repeating_output = repeat_output;
+
+	if (repeat_output)
+	{
+		/* Output a shallow copy of the last output buffer. It shares
+		 * the memory blocks of the last output buffer, so no pixels
+		 * are copied. A new GstBuffer is necessary nevertheless, since
+		 * the base class sets the new timestamps in it, and the last
+		 * output buffer may still be in use downstream. */
+		GST_LOG_OBJECT(self, "nothing changed since the last output frame was composed; repeating that frame");
+		*outbuffer = gst_buffer_copy(self->last_output_buffer);
+		GST_BUFFER_FLAG_UNSET(*outbuffer, GST_BUFFER_FLAG_DISCONT);
+		return GST_FLOW_OK;
+	}
+
+	return GST_VIDEO_AGGREGATOR_CLASS(gst_imx_2d_compositor_parent_class)->create_output_buffer(videoaggregator, outbuffer);
+}
+
+
 static GstFlowReturn gst_imx_2d_compositor_aggregate_frames(GstVideoAggregator *videoaggregator, GstBuffer *output_buffer)
 {
 	GstImx2dCompositor *self = GST_IMX_2D_COMPOSITOR(videoaggregator);
 	GstFlowReturn flow_ret = GST_FLOW_OK;
 	GList *walk;
-	Imx2dBlitParams blit_params;
-	gboolean background_needs_to_be_cleared = TRUE;
+	Imx2dRegion output_region;
+	gint i, num_damage_regions;
 	gboolean blitting_started = FALSE;
 	GstBuffer *intermediate_buffer = NULL;
+	guint32 background_color = 0;
+	guint damage_history_depth = 0;
+	GstImx2dCompositorDamageRecord *damage_record = NULL;
+	gboolean full_redraw_needed = TRUE;
+	gboolean repeat_unchanged_output = FALSE;
+	guint output_state_serial = 0;
+	gboolean frame_composed = FALSE;
+
+	/* output_buffer already contains the frame if it is a repeat
+	 * of the last output frame (see create_output_buffer()). */
+	if (self->repeating_output)
+	{
+		GST_LOG_OBJECT(self, "repeating last output frame; nothing to aggregate");
+		return GST_FLOW_OK;
+	}
 
 	GST_LOG_OBJECT(self, "aggregating frames");
 
@@ -1376,28 +1761,53 @@ static GstFlowReturn gst_imx_2d_compositor_aggregate_frames(GstVideoAggregator *
 
 	blitting_started = TRUE;
 
-	memset(&blit_params, 0, sizeof(blit_params));
+	g_array_set_size(self->batched_blit_params, 0);
+	g_ptr_array_set_size(self->batched_blit_sources, 0);
 
 	/* Lock the compositor to prevent pads from being added/removed
 	 * while we are walking over the existing pads. */
 	GST_OBJECT_LOCK(self);
 
 	/* In this first walk, we look at each compositor sinkpad,
-	 * update their regions if necessary, and determine if at
-	 * least one of them produces frames that are 100% opaque
-	 * and fully cover the screen. If so, we do not need to clear
-	 * the output frame first. */
-	GST_LOG_OBJECT(self, "looking at %" G_GUINT16_FORMAT " sinkpad(s) to see if the background needs to be cleared", GST_ELEMENT_CAST(videoaggregator)->numsinkpads);
-	walk = GST_ELEMENT_CAST(videoaggregator)->sinkpads;
-	for (; walk != NULL; walk = g_list_next(walk))
+	 * update their regions if necessary, and determine which
+	 * parts of the output frame are covered by fully opaque
+	 * pixels. The walk starts at the sinkpad with the highest
+	 * zorder, so when a sinkpad is visited, opaque_region_set
+	 * contains what all sinkpads above it cover. If that hides
+	 * everything the sinkpad would draw, it is fully occluded,
+	 * and its frame does not need to be uploaded and blitted.
+	 * The parts of the output frame that are not covered at all
+	 * are the ones that need to be cleared with the background
+	 * color. Each sinkpad's draw state is updated as well; these
+	 * are needed for damage tracking (see below). */
+	GST_LOG_OBJECT(self, "looking at %" G_GUINT16_FORMAT " sinkpad(s) to compute visible and opaque regions", GST_ELEMENT_CAST(videoaggregator)->numsinkpads);
+
+	output_region.x1 = 0;
+	output_region.y1 = 0;
+	output_region.x2 = GST_VIDEO_INFO_WIDTH(&(self->output_video_info));
+	output_region.y2 = GST_VIDEO_INFO_HEIGHT(&(self->output_video_info));
+
+	imx_2d_region_set_clear(self->opaque_region_set);
+
+	walk = g_list_last(GST_ELEMENT_CAST(videoaggregator)->sinkpads);
+	for (; walk != NULL; walk = g_list_previous(walk))
 	{
 		GstVideoAggregatorPad *videoaggregator_pad = walk->data;
 		GstImx2dCompositorPad *compositor_pad = GST_IMX_2D_COMPOSITOR_PAD_CAST(videoaggregator_pad);
 		GstBuffer *input_buffer;
+		gint margin_alpha;
+		gboolean frame_is_opaque, margin_is_opaque;
+		Imx2dRegion const *drawn_region;
+		Imx2dRegion clipped_drawn_region;
 
 		gst_imx_2d_compositor_pad_recalculate_regions_if_needed(compositor_pad, &(self->output_video_info));
 
+		compositor_pad->fully_occluded = FALSE;
+
 		input_buffer = gst_video_aggregator_pad_get_current_buffer(videoaggregator_pad);
+
+		gst_imx_2d_compositor_pad_update_draw_state(compositor_pad, input_buffer, &output_region, &(self->content_serial_counter));
+
 		if (G_UNLIKELY(input_buffer == NULL))
 		{
 			GST_LOG_OBJECT(
@@ -1418,6 +1828,38 @@ static GstFlowReturn gst_imx_2d_compositor_aggregate_frames(GstVideoAggregator *
 			compositor_pad->combined_margin.color
 		);
 
+		if (compositor_pad->alpha <= 0.0)
+		{
+			GST_LOG_OBJECT(self, "pad %s is fully transparent; skipping it", GST_PAD_NAME(compositor_pad));
+			compositor_pad->fully_occluded = TRUE;
+			continue;
+		}
+
+		/* The margin is only drawn if it is not fully transparent. */
+		margin_alpha = (compositor_pad->combined_margin.color >> 24) & 0xFF;
+		drawn_region = (margin_alpha != 0) ? &(compositor_pad->total_region) : &(compositor_pad->inner_region);
+
+		if (imx_2d_region_check_inclusion(drawn_region, &output_region) == IMX_2D_REGION_INCLUSION_NONE)
+		{
+			GST_LOG_OBJECT(self, "pad %s is fully outside of the output frame; skipping it", GST_PAD_NAME(compositor_pad));
+			compositor_pad->fully_occluded = TRUE;
+			continue;
+		}
+
+		imx_2d_region_intersect(&clipped_drawn_region, drawn_region, &output_region);
+
+		if (imx_2d_region_set_check_inclusion(self->opaque_region_set, &clipped_drawn_region) == IMX_2D_REGION_INCLUSION_FULL)
+		{
+			GST_LOG_OBJECT(self, "pad %s is fully covered by opaque pads with a higher zorder; skipping it", GST_PAD_NAME(compositor_pad));
+			compositor_pad->fully_occluded = TRUE;
+			/* Nothing that the pad draws is visible, so as far as
+			 * damage tracking is concerned, it draws nothing. */
+			memset(&(compositor_pad->draw_state.drawn_region), 0, sizeof(Imx2dRegion));
+			continue;
+		}
+
+		/* Now add the parts of this pad that are fully opaque. */
+
 		if (compositor_pad->alpha < 1.0)
 		{
 			GST_LOG_OBJECT(
@@ -1429,82 +1871,91 @@ static GstFlowReturn gst_imx_2d_compositor_aggregate_frames(GstVideoAggregator *
 			continue;
 		}
 
-		if (background_needs_to_be_cleared)
-		{
-			if (GST_VIDEO_INFO_HAS_ALPHA(&(videoaggregator_pad->info)))
-			{
-				GST_LOG_OBJECT(
-					self,
-					"pad %s's video format is %s, which contains an alpha channel",
-					GST_PAD_NAME(compositor_pad),
-					gst_video_format_to_string(GST_VIDEO_INFO_FORMAT(&(videoaggregator_pad->info)))
-				);
-
-				continue;
-			}
-
-			if (compositor_pad->inner_region_fills_output_frame)
-			{
-				GST_LOG_OBJECT(
-					self,
-					"pad %s's inner region fully covers the output frame and is fully opaque; no need to clear the background",
-					GST_PAD_NAME(compositor_pad)
-				);
-				background_needs_to_be_cleared = FALSE;
-			}
-			else
-			{
-				GST_LOG_OBJECT(
-					self,
-					"pad %s's inner region does not fully cover the output frame",
-					GST_PAD_NAME(compositor_pad)
-				);
-			}
+		frame_is_opaque = !GST_VIDEO_INFO_HAS_ALPHA(&(videoaggregator_pad->info));
+		margin_is_opaque = (margin_alpha == 255);
 
+		GST_LOG_OBJECT(
+			self,
+			"pad %s's frame is %sopaque, margin is %sopaque",
+			GST_PAD_NAME(compositor_pad),
+			frame_is_opaque ? "" : "not ",
+			margin_is_opaque ? "" : "not "
+		);
 
-			if (compositor_pad->total_region_fills_output_frame)
+		if (frame_is_opaque && margin_is_opaque)
+		{
+			if (!gst_imx_2d_compositor_add_opaque_region(self, &(compositor_pad->total_region), &output_region))
+				goto error_while_locked;
+		}
+		else if (frame_is_opaque)
+		{
+			if (!gst_imx_2d_compositor_add_opaque_region(self, &(compositor_pad->inner_region), &output_region))
+				goto error_while_locked;
+		}
+		else if (margin_is_opaque)
+		{
+			Imx2dRegion const *inner_region = &(compositor_pad->inner_region);
+			Imx2dRegion const *total_region = &(compositor_pad->total_region);
+			Imx2dRegion margin_regions[4] =
 			{
-				gint margin_alpha = compositor_pad->combined_margin.color >> 24;
-				if (margin_alpha == 255)
-				{
-					GST_LOG_OBJECT(
-						self,
-						"pad %s's total region fully covers the output frame, and both the actual frame and the margin are fully opaque; no need to clear the background",
-						GST_PAD_NAME(compositor_pad)
-					);
-					background_needs_to_be_cleared = FALSE;
-				}
-				else
-					GST_LOG_OBJECT(
-						self,
-						"pad %s's total region fully covers the output frame, but the margin is not fully opaque",
-						GST_PAD_NAME(compositor_pad)
-					);
-			}
-			else
+				/* Left, top, right, bottom margin. */
+				{ total_region->x1, inner_region->y1, inner_region->x1, inner_region->y2 },
+				{ total_region->x1, total_region->y1, total_region->x2, inner_region->y1 },
+				{ inner_region->x2, inner_region->y1, total_region->x2, inner_region->y2 },
+				{ total_region->x1, inner_region->y2, total_region->x2, total_region->y2 }
+			};
+
+			for (i = 0; i < 4; ++i)
 			{
-				GST_LOG_OBJECT(
-					self,
-					"pad %s's total region does not fully cover the output frame",
-					GST_PAD_NAME(compositor_pad)
-				);
+				if (!gst_imx_2d_compositor_add_opaque_region(self, &(margin_regions[i]), &output_region))
+					goto error_while_locked;
 			}
 		}
 	}
 
-	if (background_needs_to_be_cleared)
+	/* The background consists of all the parts of the output
+	 * frame that are not covered by opaque pixels. */
+	imx_2d_region_set_clear(self->background_region_set);
+	if (!imx_2d_region_set_add_region(self->background_region_set, &output_region)
+	 || !imx_2d_region_set_subtract_region_set(self->background_region_set, self->opaque_region_set))
 	{
-		GST_LOG_OBJECT(self, "need to clear background with color %#06" G_GINT32_MODIFIER "x", self->background_color & 0xFFFFFF);
+		GST_ERROR_OBJECT(self, "could not compute background region");
+		goto error_while_locked;
+	}
 
-		if (!imx_2d_blitter_fill_region(self->blitter, NULL, self->background_color))
-		{
-			GST_ERROR_OBJECT(self, "could not clear background");
+	/* Damage tracking: If enabled, the output buffer pool hands
+	 * out buffers that still contain the frame that was composed
+	 * into them earlier. If a damage record exists for the buffer,
+	 * it is compared against the current sinkpad draw states to
+	 * find the parts of the frame that changed. Only these are
+	 * then redrawn, using the blitter's clip region. This greatly
+	 * reduces the amount of blitting when only some of the sinkpads
+	 * get new frames, for example with inputs that have different
+	 * framerates. The draw states are collected in zorder, which
+	 * is the order in which the sinkpads are blitted. */
+	background_color = self->background_color;
+	damage_history_depth = self->damage_history_depth;
+	repeat_unchanged_output = self->repeat_unchanged_output;
+	output_state_serial = self->output_state_serial;
+
+	g_array_set_size(self->current_pad_states, 0);
+	walk = GST_ELEMENT_CAST(videoaggregator)->sinkpads;
+	for (; walk != NULL; walk = g_list_next(walk))
+		g_array_append_val(self->current_pad_states, GST_IMX_2D_COMPOSITOR_PAD_CAST(walk->data)->draw_state);
+
+	if (damage_history_depth > 0)
+	{
+		damage_record = gst_imx_2d_compositor_take_damage_record(self, intermediate_buffer);
+
+		if (!gst_imx_2d_compositor_compute_damage(self, damage_record, background_color, &full_redraw_needed))
 			goto error_while_locked;
-		}
 	}
+	else
+		gst_imx_2d_compositor_clear_damage_history(self);
 
-	/* In this second walk, we perform the actual blitting.
-	 * Blitting order is defined by the zorder values of each sinkpad.
+	/* In this second walk, we upload the input frames and collect
+	 * the blits, which are then performed in one batch. Blitting
+	 * order is defined by the zorder values of each sinkpad.
 	 * This ordering is taken care of by the GstVideoAggregator base
 	 * class, so we just have to visit each sinkpad sequentially. */
 	GST_LOG_OBJECT(self, "getting input frames from %" G_GUINT16_FORMAT " sinkpad(s)", GST_ELEMENT_CAST(videoaggregator)->numsinkpads);
@@ -1515,13 +1966,10 @@ static GstFlowReturn gst_imx_2d_compositor_aggregate_frames(GstVideoAggregator *
 		GstImx2dCompositorPad *compositor_pad = GST_IMX_2D_COMPOSITOR_PAD_CAST(videoaggregator_pad);
 		GstBuffer *input_buffer;
 		gboolean input_crop;
-		Imx2dRegion inner_region;
-		Imx2dBlitMargin combined_margin;
-		Imx2dRegion crop_rectangle;
 		GstVideoOrientationMethod video_direction;
 		gint alpha;
 		GstBuffer *uploaded_input_buffer;
-		int blit_ret;
+		Imx2dBlitParams blit_params;
 
 		/* Retrieve the input from the sinkpad, and upload it.
 		 * The uploader is capable of determining whether or not
@@ -1535,6 +1983,18 @@ static GstFlowReturn gst_imx_2d_compositor_aggregate_frames(GstVideoAggregator *
 		if (G_UNLIKELY(input_buffer == NULL))
 			continue;
 
+		if (compositor_pad->fully_occluded)
+		{
+			GST_LOG_OBJECT(self, "pad %s is fully occluded; not uploading and blitting its frame", GST_PAD_NAME(compositor_pad));
+			continue;
+		}
+
+		if (!full_redraw_needed && (imx_2d_region_set_check_inclusion(self->damage_region_set, &(compositor_pad->draw_state.drawn_region)) == IMX_2D_REGION_INCLUSION_NONE))
+		{
+			GST_LOG_OBJECT(self, "pad %s is not in a damaged region; not uploading and blitting its frame", GST_PAD_NAME(compositor_pad));
+			continue;
+		}
+
 		{
 			/* Lock the pad so we can get copies of its property
 			 * values safely. Otherwise, the pad's set_property()
@@ -1548,8 +2008,8 @@ static GstFlowReturn gst_imx_2d_compositor_aggregate_frames(GstVideoAggregator *
 			alpha = (gint)(compositor_pad->alpha * 255);
 			alpha = CLAMP(alpha, 0, 255);
 
-			memcpy(&inner_region, &(compositor_pad->inner_region), sizeof(inner_region));
-			memcpy(&combined_margin, &(compositor_pad->combined_margin), sizeof(combined_margin));
+			memcpy(&(compositor_pad->blit_inner_region), &(compositor_pad->inner_region), sizeof(Imx2dRegion));
+			memcpy(&(compositor_pad->blit_combined_margin), &(compositor_pad->combined_margin), sizeof(Imx2dBlitMargin));
 
 			GST_OBJECT_UNLOCK(compositor_pad);
 		}
@@ -1563,6 +2023,8 @@ static GstFlowReturn gst_imx_2d_compositor_aggregate_frames(GstVideoAggregator *
 		if (G_UNLIKELY(flow_ret != GST_FLOW_OK))
 			goto error_while_locked;
 
+		g_ptr_array_add(self->batched_uploaded_input_buffers, uploaded_input_buffer);
+
 		/* Set up the pad's input surface. */
 
 		gst_imx_2d_assign_input_buffer_to_surface(
@@ -1580,16 +2042,17 @@ static GstFlowReturn gst_imx_2d_compositor_aggregate_frames(GstVideoAggregator *
 		GST_LOG_OBJECT(
 			self,
 			"combined margin: %d/%d/%d/%d  margin color: %#08" G_GINT32_MODIFIER "x",
-			combined_margin.left_margin,
-			combined_margin.top_margin,
-			combined_margin.right_margin,
-			combined_margin.bottom_margin,
-			(guint32)(combined_margin.color)
+			compositor_pad->blit_combined_margin.left_margin,
+			compositor_pad->blit_combined_margin.top_margin,
+			compositor_pad->blit_combined_margin.right_margin,
+			compositor_pad->blit_combined_margin.bottom_margin,
+			(guint32)(compositor_pad->blit_combined_margin.color)
 		);
 
-		blit_params.margin = &combined_margin;
+		memset(&blit_params, 0, sizeof(blit_params));
+		blit_params.margin = &(compositor_pad->blit_combined_margin);
 		blit_params.source_region = NULL;
-		blit_params.dest_region = &inner_region;
+		blit_params.dest_region = &(compositor_pad->blit_inner_region);
 		blit_params.rotation = gst_imx_2d_convert_from_video_orientation_method(video_direction);
 		blit_params.alpha = alpha;
 
@@ -1599,39 +2062,69 @@ static GstFlowReturn gst_imx_2d_compositor_aggregate_frames(GstVideoAggregator *
 
 			if (crop_meta != NULL)
 			{
-				crop_rectangle.x1 = crop_meta->x;
-				crop_rectangle.y1 = crop_meta->y;
-				crop_rectangle.x2 = crop_meta->x + crop_meta->width;
-				crop_rectangle.y2 = crop_meta->y + crop_meta->height;
+				Imx2dRegion *crop_rectangle = &(compositor_pad->blit_crop_rectangle);
 
-				blit_params.source_region = &crop_rectangle;
+				crop_rectangle->x1 = crop_meta->x;
+				crop_rectangle->y1 = crop_meta->y;
+				crop_rectangle->x2 = crop_meta->x + crop_meta->width;
+				crop_rectangle->y2 = crop_meta->y + crop_meta->height;
+
+				blit_params.source_region = crop_rectangle;
 
 				GST_LOG_OBJECT(
 					self,
 					"using crop rectangle (%d, %d) - (%d, %d)",
-					crop_rectangle.x1, crop_rectangle.y1,
-					crop_rectangle.x2, crop_rectangle.y2
+					crop_rectangle->x1, crop_rectangle->y1,
+					crop_rectangle->x2, crop_rectangle->y2
 				);
 			}
 		}
 
 
-		/* Now perform the actual blit. */
-
-		blit_ret = imx_2d_blitter_do_blit(self->blitter, compositor_pad->input_surface, &blit_params);
+		/* Add the blit to the batch. */
+		g_array_append_val(self->batched_blit_params, blit_params);
+		g_ptr_array_add(self->batched_blit_sources, compositor_pad->input_surface);
+	}
 
+	/* Now clear the background and perform the actual blits.
+	 * This is done while the compositor is still locked, since
+	 * the blit parameters refer to regions that are stored in
+	 * the sinkpads. If only the damaged regions need to be
+	 * redrawn, this is done once per damaged region, with the
+	 * blitter's clip region set to that damaged region. */
 
-		/* Discard the uploaded version of the input buffer. */
-		gst_buffer_unref(uploaded_input_buffer);
+	if (full_redraw_needed)
+	{
+		if (!gst_imx_2d_compositor_draw(self))
+			goto error_while_locked;
+	}
+	else
+	{
+		num_damage_regions = imx_2d_region_set_get_num_regions(self->damage_region_set);
 
+		GST_LOG_OBJECT(self, "redrawing %d damaged region(s)", num_damage_regions);
 
-		if (!blit_ret)
+		for (i = 0; i < num_damage_regions; ++i)
 		{
-			GST_ERROR_OBJECT(self, "blitting failed");
-			goto error_while_locked;
+			Imx2dRegion const *damage_region = imx_2d_region_set_get_region(self->damage_region_set, i);
+
+			GST_LOG_OBJECT(self, "redrawing damaged region %" IMX_2D_REGION_FORMAT, IMX_2D_REGION_ARGS(damage_region));
+
+			if (!imx_2d_blitter_set_clip_region(self->blitter, damage_region))
+			{
+				GST_ERROR_OBJECT(self, "could not set clip region");
+				goto error_while_locked;
+			}
+
+			if (!gst_imx_2d_compositor_draw(self))
+				goto error_while_locked;
 		}
+
+		imx_2d_blitter_set_clip_region(self->blitter, NULL);
 	}
 
+	frame_composed = TRUE;
+
 	GST_OBJECT_UNLOCK(self);
 
 
@@ -1642,6 +2135,21 @@ finish:
 		flow_ret = GST_FLOW_ERROR;
 	}
 
+	/* Discard the uploaded versions of the input buffers. This is
+	 * done only after the blitter sequence is finished, since the
+	 * blitter may access them until then. */
+	if (self->batched_uploaded_input_buffers != NULL)
+		g_ptr_array_set_size(self->batched_uploaded_input_buffers, 0);
+
+	/* The record that was taken from the history no longer describes
+	 * the intermediate buffer contents. If composing succeeded, store
+	 * a new record for what the buffer contains now. */
+	if (damage_record != NULL)
+		gst_imx_2d_compositor_free_damage_record(damage_record);
+
+	if (frame_composed && (flow_ret == GST_FLOW_OK) && (damage_history_depth > 0))
+		gst_imx_2d_compositor_store_damage_record(self, intermediate_buffer, background_color, damage_history_depth);
+
 	if (flow_ret == GST_FLOW_OK)
 	{
 		/* The blitter is done. Transfer the resulting pixels to the output buffer.
@@ -1663,6 +2171,18 @@ finish:
 	else
 		gst_buffer_unref(intermediate_buffer);
 
+	/* Keep a reference to the output buffer to be able to repeat it.
+	 * If composing failed, any previous output buffer must not be
+	 * repeated either, since the sinkpads' last seen buffers were
+	 * updated already, and no longer match its contents. */
+	if (frame_composed && (flow_ret == GST_FLOW_OK) && repeat_unchanged_output)
+	{
+		gst_buffer_replace(&(self->last_output_buffer), output_buffer);
+		self->composed_output_state_serial = output_state_serial;
+	}
+	else
+		gst_buffer_replace(&(self->last_output_buffer), NULL);
+
 	return flow_ret;
 
 error:
@@ -1695,6 +2215,277 @@ static gboolean gst_imx_2d_compositor_create_blitter(GstImx2dCompositor *self)
 }
 
 
+static gboolean gst_imx_2d_compositor_add_opaque_region(GstImx2dCompositor *self, Imx2dRegion const *region, Imx2dRegion const *output_region)
+{
+	Imx2dRegion clipped_region;
+
+	/* Only the part of the region that is inside the output frame
+	 * is of interest. If the region is not inside at all, the
+	 * intersection has no pixels, and is ignored by the region set. */
+	imx_2d_region_intersect(&clipped_region, region, output_region);
+
+	GST_LOG_OBJECT(self, "adding opaque region %" IMX_2D_REGION_FORMAT, IMX_2D_REGION_ARGS(&clipped_region));
+
+	if (!imx_2d_region_set_add_region(self->opaque_region_set, &clipped_region))
+	{
+		GST_ERROR_OBJECT(self, "could not add region to opaque region set");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+
+static gboolean gst_imx_2d_compositor_draw(GstImx2dCompositor *self)
+{
+	gint i, num_background_regions;
+
+	num_background_regions = imx_2d_region_set_get_num_regions(self->background_region_set);
+
+	GST_LOG_OBJECT(
+		self,
+		"need to clear %d background region(s) with color %#06" G_GINT32_MODIFIER "x",
+		num_background_regions,
+		self->background_color & 0xFFFFFF
+	);
+
+	for (i = 0; i < num_background_regions; ++i)
+	{
+		Imx2dRegion const *background_region = imx_2d_region_set_get_region(self->background_region_set, i);
+
+		if (!imx_2d_blitter_fill_region(self->blitter, background_region, self->background_color))
+		{
+			GST_ERROR_OBJECT(self, "could not clear background");
+			return FALSE;
+		}
+	}
+
+	GST_LOG_OBJECT(self, "blitting %u input frame(s)", self->batched_blit_sources->len);
+
+	if (!imx_2d_blitter_do_blits(
+		self->blitter,
+		self->batched_blit_sources->len,
+		(Imx2dSurface **)(self->batched_blit_sources->pdata),
+		(Imx2dBlitParams const *)(self->batched_blit_params->data)
+	))
+	{
+		GST_ERROR_OBJECT(self, "blitting failed");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+
+/* Must be called with the object lock held. */
+static gboolean gst_imx_2d_compositor_is_last_output_unchanged(GstImx2dCompositor *self)
+{
+	GList *walk;
+	guint pad_index;
+	GstImx2dCompositorPadDrawState const *composed_pad_states;
+
+	if (self->last_output_buffer == NULL)
+		return FALSE;
+
+	if (self->output_state_serial != self->composed_output_state_serial)
+		return FALSE;
+
+	/* current_pad_states still holds the draw states of the last
+	 * composed frame, in the order the sinkpads were blitted. Changing
+	 * the zorder of a sinkpad re-sorts the sinkpads list without
+	 * changing any of the serials, so compare the order as well. */
+	if (self->current_pad_states->len != GST_ELEMENT_CAST(self)->numsinkpads)
+		return FALSE;
+	composed_pad_states = (GstImx2dCompositorPadDrawState const *)(self->current_pad_states->data);
+
+	walk = GST_ELEMENT_CAST(self)->sinkpads;
+	for (pad_index = 0; walk != NULL; walk = g_list_next(walk), ++pad_index)
+	{
+		GstVideoAggregatorPad *videoaggregator_pad = walk->data;
+		GstImx2dCompositorPad *compositor_pad = GST_IMX_2D_COMPOSITOR_PAD_CAST(videoaggregator_pad);
+		GstBuffer *input_buffer = gst_video_aggregator_pad_get_current_buffer(videoaggregator_pad);
+		gboolean properties_changed;
+
+		if (composed_pad_states[pad_index].pad != compositor_pad)
+			return FALSE;
+
+		if (input_buffer != compositor_pad->last_seen_buffer)
+			return FALSE;
+
+		if ((input_buffer != NULL) && (GST_BUFFER_PTS(input_buffer) != compositor_pad->last_seen_buffer_pts))
+			return FALSE;
+
+		GST_OBJECT_LOCK(compositor_pad);
+		properties_changed = (compositor_pad->property_serial != compositor_pad->composed_property_serial);
+		GST_OBJECT_UNLOCK(compositor_pad);
+
+		if (properties_changed)
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+
+static void gst_imx_2d_compositor_free_damage_record(GstImx2dCompositorDamageRecord *damage_record)
+{
+	g_free(damage_record->pad_states);
+	g_free(damage_record);
+}
+
+
+static void gst_imx_2d_compositor_clear_damage_history(GstImx2dCompositor *self)
+{
+	GstImx2dCompositorDamageRecord *damage_record;
+
+	while ((damage_record = g_queue_pop_head(&(self->damage_history))) != NULL)
+		gst_imx_2d_compositor_free_damage_record(damage_record);
+}
+
+
+static GstImx2dCompositorDamageRecord* gst_imx_2d_compositor_take_damage_record(GstImx2dCompositor *self, GstBuffer *buffer)
+{
+	GList *link;
+	guint id = GPOINTER_TO_UINT(gst_mini_object_get_qdata(GST_MINI_OBJECT_CAST(buffer), damage_record_id_quark));
+
+	if (id == 0)
+		return NULL;
+
+	/* The record is removed from the history, since the buffer
+	 * is about to be modified. If composing fails, the buffer
+	 * contents are undefined, and with the record gone, the
+	 * buffer will be redrawn entirely the next time it is used. */
+	for (link = self->damage_history.head; link != NULL; link = link->next)
+	{
+		GstImx2dCompositorDamageRecord *damage_record = link->data;
+
+		if (damage_record->id == id)
+		{
+			g_queue_delete_link(&(self->damage_history), link);
+			return damage_record;
+		}
+	}
+
+	return NULL;
+}
+
+
+static void gst_imx_2d_compositor_store_damage_record(GstImx2dCompositor *self, GstBuffer *buffer, guint32 background_color, guint damage_history_depth)
+{
+	GstImx2dCompositorDamageRecord *damage_record;
+
+	damage_record = g_new0(GstImx2dCompositorDamageRecord, 1);
+	damage_record->id = self->next_damage_record_id;
+	damage_record->background_color = background_color;
+	damage_record->num_pad_states = self->current_pad_states->len;
+	damage_record->pad_states = g_new(GstImx2dCompositorPadDrawState, damage_record->num_pad_states);
+	memcpy(damage_record->pad_states, self->current_pad_states->data, damage_record->num_pad_states * sizeof(GstImx2dCompositorPadDrawState));
+
+	/* ID 0 is reserved for "no record". */
+	self->next_damage_record_id++;
+	if (G_UNLIKELY(self->next_damage_record_id == 0))
+		self->next_damage_record_id = 1;
+
+	gst_mini_object_set_qdata(GST_MINI_OBJECT_CAST(buffer), damage_record_id_quark, GUINT_TO_POINTER(damage_record->id), NULL);
+
+	g_queue_push_head(&(self->damage_history), damage_record);
+
+	while (g_queue_get_length(&(self->damage_history)) > damage_history_depth)
+		gst_imx_2d_compositor_free_damage_record(g_queue_pop_tail(&(self->damage_history)));
+}
+
+
+static gboolean gst_imx_2d_compositor_compute_damage(GstImx2dCompositor *self, GstImx2dCompositorDamageRecord const *damage_record, guint32 background_color, gboolean *full_redraw_needed)
+{
+	guint i;
+	gint num_damage_regions;
+	GstImx2dCompositorPadDrawState const *current_pad_states = (GstImx2dCompositorPadDrawState const *)(self->current_pad_states->data);
+
+	imx_2d_region_set_clear(self->damage_region_set);
+	*full_redraw_needed = TRUE;
+
+	if (damage_record == NULL)
+	{
+		GST_LOG_OBJECT(self, "no damage record for this output buffer; need to redraw everything");
+		return TRUE;
+	}
+
+	if (damage_record->background_color != background_color)
+	{
+		GST_LOG_OBJECT(self, "background color changed; need to redraw everything");
+		return TRUE;
+	}
+
+	if (damage_record->num_pad_states != self->current_pad_states->len)
+	{
+		GST_LOG_OBJECT(self, "number of sinkpads changed; need to redraw everything");
+		return TRUE;
+	}
+
+	for (i = 0; i < damage_record->num_pad_states; ++i)
+	{
+		GstImx2dCompositorPadDrawState const *old_state = &(damage_record->pad_states[i]);
+		GstImx2dCompositorPadDrawState const *new_state = &(current_pad_states[i]);
+
+		if (old_state->pad != new_state->pad)
+		{
+			GST_LOG_OBJECT(self, "sinkpads or their zorder changed; need to redraw everything");
+			return TRUE;
+		}
+
+		if ((old_state->content_serial == new_state->content_serial)
+		 && imx_2d_region_check_if_equal(&(old_state->drawn_region), &(new_state->drawn_region))
+		 && imx_2d_region_check_if_equal(&(old_state->inner_region), &(new_state->inner_region))
+		 && (old_state->margin_color == new_state->margin_color)
+		 && (old_state->alpha == new_state->alpha)
+		 && (old_state->video_direction == new_state->video_direction)
+		 && (old_state->input_crop == new_state->input_crop))
+			continue;
+
+		/* Both the area the pad drew before and the area it draws
+		 * now have to be redrawn. If nothing but the frame content
+		 * changed, these two are the same. */
+		GST_LOG_OBJECT(
+			self,
+			"pad %s changed; damaged regions: %" IMX_2D_REGION_FORMAT " and %" IMX_2D_REGION_FORMAT,
+			GST_PAD_NAME(new_state->pad),
+			IMX_2D_REGION_ARGS(&(old_state->drawn_region)),
+			IMX_2D_REGION_ARGS(&(new_state->drawn_region))
+		);
+
+		if (!imx_2d_region_set_add_region(self->damage_region_set, &(old_state->drawn_region))
+		 || !imx_2d_region_set_add_region(self->damage_region_set, &(new_state->drawn_region)))
+		{
+			GST_ERROR_OBJECT(self, "could not add region to damage region set");
+			return FALSE;
+		}
+	}
+
+	num_damage_regions = imx_2d_region_set_get_num_regions(self->damage_region_set);
+
+	if (num_damage_regions > MAX_NUM_DAMAGE_REGIONS)
+	{
+		Imx2dRegion bounding_box = *imx_2d_region_set_get_region(self->damage_region_set, 0);
+
+		for (i = 1; i < (guint)num_damage_regions; ++i)
+			imx_2d_region_merge(&bounding_box, &bounding_box, imx_2d_region_set_get_region(self->damage_region_set, i));
+
+		GST_LOG_OBJECT(self, "%d damaged regions; redrawing their bounding box %" IMX_2D_REGION_FORMAT " instead", num_damage_regions, IMX_2D_REGION_ARGS(&bounding_box));
+
+		imx_2d_region_set_clear(self->damage_region_set);
+		if (!imx_2d_region_set_add_region(self->damage_region_set, &bounding_box))
+		{
+			GST_ERROR_OBJECT(self, "could not add region to damage region set");
+			return FALSE;
+		}
+	}
+
+	*full_redraw_needed = FALSE;
+
+	return TRUE;
+}
+
+
 void gst_imx_2d_compositor_common_class_init(GstImx2dCompositorClass *klass, Imx2dHardwareCapabilities const *capabilities)
 {
 	GstElementClass *element_class;
@@ -22,6 +22,7 @@
 #include <gst/gst.h>
 #include <gst/video/video.h>
 #include "imx2d/imx2d.h"
+#include "imx2d/region_set.h"
 #include "gst/imx/video/gstimxvideobufferpool.h"
 
 
@@ -56,7 +57,56 @@ struct _GstImx2dCompositor
 	GstVideoInfo output_video_info;
 	Imx2dSurface *output_surface;
 
+	/* Blits for all sinkpads are collected in these arrays
+	 * and then performed with one imx_2d_blitter_do_blits()
+	 * call. The uploaded input buffers are kept referenced
+	 * until the blitter sequence is finished. */
+	GArray *batched_blit_params;
+	GPtrArray *batched_blit_sources;
+	GPtrArray *batched_uploaded_input_buffers;
+
+	/* Region sets for occlusion culling. opaque_region_set
+	 * accumulates the output frame areas that are covered by
+	 * fully opaque pixels. background_region_set contains the
+	 * areas that are not, and must therefore be cleared. */
+	Imx2dRegionSet *opaque_region_set;
+	Imx2dRegionSet *background_region_set;
+
+	/* Damage tracking states. damage_history contains records
+	 * that describe what the most recently composed output
+	 * buffers contain (newest record at the head). These are
+	 * used for redrawing only the parts of a reused output
+	 * buffer that differ from what it currently contains.
+	 * damage_region_set holds these parts. current_pad_states
+	 * is an array of GstImx2dCompositorPadDrawState with the
+	 * states of all sinkpads in the current aggregate_frames()
+	 * call. See the GstImx2dCompositorDamageRecord notes in
+	 * gstimx2dcompositor.c for more. */
+	GQueue damage_history;
+	guint next_damage_record_id;
+	guint64 content_serial_counter;
+	Imx2dRegionSet *damage_region_set;
+	GArray *current_pad_states;
+
+	/* Output frame repetition states. last_output_buffer is
+	 * the most recently composed output buffer. It is repeated
+	 * if neither the input buffers nor any property changed
+	 * since it was composed. Sinkpad properties are tracked by
+	 * the sinkpads themselves. Other changes that affect the
+	 * output (background color, caps, added/removed sinkpads)
+	 * increment output_state_serial. composed_output_state_serial
+	 * is the value it had when last_output_buffer was composed.
+	 * The sinkpad order (which changes with the zorder) is checked
+	 * against the pads in current_pad_states. repeating_output is set by create_output_buffer() to tell
+	 * aggregate_frames() that there is nothing to compose. */
+	GstBuffer *last_output_buffer;
+	guint output_state_serial;
+	guint composed_output_state_serial;
+	gboolean repeating_output;
+
 	guint32 background_color;
+	guint damage_history_depth;
+	gboolean repeat_unchanged_output;
 };
 
 
@@ -18,6 +18,7 @@
 
 #include <gst/gst.h>
 #include "gst/imx/common/gstimxdmabufferallocator.h"
+#include "gst/imx/video/gstimxvideoworkerpool.h"
 #include "gstimx2dvideooverlayhandler.h"
 #include "gstimx2dmisc.h"
 
@@ -26,12 +27,27 @@ GST_DEBUG_CATEGORY_STATIC(imx_2d_video_overlay_handler_debug);
 #define GST_CAT_DEFAULT imx_2d_video_overlay_handler_debug
 
 
-/* Structure for cached overlay data. A cached overlay is understood
- * to be "populated" when buffer is non-NULL. */
+/* Structure for cached overlay data. Each cached overlay contains
+ * the uploaded version of one overlay rectangle's pixels. Cached
+ * overlays are looked up by the seqnum of their rectangle. */
 typedef struct
 {
+	/* The rectangle whose pixels are cached. It is ref'd to make
+	 * sure that it cannot be modified in-place by someone else. */
+	GstVideoOverlayRectangle *rectangle;
+
 	GstBuffer *buffer;
 	Imx2dSurface *surface;
+
+	/* Size of the uploaded buffer, in bytes. */
+	gsize size;
+
+	/* This cached overlay's link in the LRU queue. */
+	GList *lru_link;
+
+	/* TRUE if the rectangle is part of the current composition.
+	 * Such cached overlays are never evicted. */
+	gboolean in_use;
 }
 CachedOverlay;
 
@@ -56,26 +72,33 @@ struct _GstImx2dVideoOverlayHandler
 	 * in mini objects if the refcount is >1). Also, this allows us to
 	 * compare compositions in newer buffers with older compositions to
 	 * detect if said composition really is a new different one. If it
-	 * is, we have to repopulate the overlay cache. */
+	 * is, we have to look up its rectangles in the overlay cache. */
 	GstVideoOverlayComposition *previous_composition;
 
-	/* The overlay cache. This is an array of CachedOverlay structures.
-	 * It is populated by gst_imx_2d_video_overlay_handler_cache_buffers()
-	 * and cleared by gst_imx_2d_video_overlay_handler_clear_cached_overlays_full().
-	 * To reduce the amount of reallocations, there are two quantities
-	 * associated with the cache: the total number of cached overlays
-	 * and the number of actually populated cached overlays. When the
-	 * cache is cleared, any non-NULL gstbuffers are unref'd. In some
-	 * cases though the cached overlay structures and surfaces are kept
-	 * around and later reused. In such cases, num_populated_cached_overlays
-	 * is set to 0 (since due to unref'ing all the gstbuffers, none of
-	 * the cached overlays are populated anymore), but total_num_cached_overlays
-	 * remains unchanged. When done a full cache clearing though, the
-	 * surfaces and cached_overlays array are also deallocated, and
-	 * total_num_cached_overlays is also set to 0. */
-	CachedOverlay *cached_overlays;
-	guint num_populated_cached_overlays;
-	guint total_num_cached_overlays;
+	/* The cached overlays for the rectangles of previous_composition,
+	 * in the same order as the rectangles. */
+	GPtrArray *current_overlays;
+
+	/* The overlay cache. cached_overlays is a hash table that maps
+	 * rectangle seqnums to CachedOverlay instances. It owns these
+	 * instances. Subtitle and OSD renderers often only change some
+	 * of the rectangles of a composition, and the seqnums of the
+	 * others stay the same, so these can be reused without having
+	 * to upload their pixels again.
+	 *
+	 * lru_queue contains the same CachedOverlay instances, with the
+	 * most recently used one at the head. When the sum of the sizes
+	 * of all cached overlays (total_cache_size) exceeds max_cache_size,
+	 * the least recently used cached overlays are evicted, except for
+	 * those that are in use by the current composition. */
+	GHashTable *cached_overlays;
+	GQueue lru_queue;
+	gsize total_cache_size;
+	gsize max_cache_size;
+
+	/* Statistics for tuning max_cache_size. Protected by the object lock. */
+	guint64 num_cache_hits;
+	guint64 num_cache_misses;
 };
 
 
@@ -90,8 +113,11 @@ G_DEFINE_TYPE(GstImx2dVideoOverlayHandler, gst_imx_2d_video_overlay_handler, GST
 
 static void gst_imx_2d_video_overlay_handler_dispose(GObject *object);
 
-static gboolean gst_imx_2d_video_overlay_handler_cache_buffers(GstImx2dVideoOverlayHandler *self, GstVideoOverlayComposition *new_composition);
-static void gst_imx_2d_video_overlay_handler_clear_cached_overlays_full(GstImx2dVideoOverlayHandler *video_overlay_handler, gboolean do_full_clearing);
+static gboolean gst_imx_2d_video_overlay_handler_set_composition(GstImx2dVideoOverlayHandler *self, GstVideoOverlayComposition *new_composition);
+static CachedOverlay* gst_imx_2d_video_overlay_handler_upload_rectangle(GstImx2dVideoOverlayHandler *self, GstVideoOverlayRectangle *rectangle, guint rectangle_idx);
+static void gst_imx_2d_video_overlay_handler_release_composition(GstImx2dVideoOverlayHandler *self);
+static void gst_imx_2d_video_overlay_handler_evict_cached_overlays(GstImx2dVideoOverlayHandler *self);
+static void gst_imx_2d_video_overlay_handler_free_cached_overlay(CachedOverlay *cached_overlay);
 
 
 static void gst_imx_2d_video_overlay_handler_class_init(GstImx2dVideoOverlayHandlerClass *klass)
@@ -107,9 +133,16 @@ static void gst_imx_2d_video_overlay_handler_class_init(GstImx2dVideoOverlayHand
 
 static void gst_imx_2d_video_overlay_handler_init(GstImx2dVideoOverlayHandler *self)
 {
-	self->cached_overlays = NULL;
-	self->num_populated_cached_overlays = 0;
-	self->total_num_cached_overlays = 0;
+	self->previous_composition = NULL;
+	self->current_overlays = g_ptr_array_new();
+
+	self->cached_overlays = g_hash_table_new(g_direct_hash, g_direct_equal);
+	g_queue_init(&(self->lru_queue));
+	self->total_cache_size = 0;
+	self->max_cache_size = GST_IMX_2D_VIDEO_OVERLAY_HANDLER_DEFAULT_MAX_CACHE_SIZE;
+
+	self->num_cache_hits = 0;
+	self->num_cache_misses = 0;
 }
 
 
@@ -117,9 +150,19 @@ static void gst_imx_2d_video_overlay_handler_dispose(GObject *object)
 {
 	GstImx2dVideoOverlayHandler *self = GST_IMX_2D_VIDEO_OVERLAY_HANDLER(object);
 
-	/* Clear the cached overlays entirely and free all structures.
-	 * (Normally, only parts are cleared, since the structures may be reused.) */
-	gst_imx_2d_video_overlay_handler_clear_cached_overlays_full(self, TRUE);
+	if (self->cached_overlays != NULL)
+	{
+		gst_imx_2d_video_overlay_handler_clear_cached_overlays(self);
+
+		g_hash_table_destroy(self->cached_overlays);
+		self->cached_overlays = NULL;
+	}
+
+	if (self->current_overlays != NULL)
+	{
+		g_ptr_array_free(self->current_overlays, TRUE);
+		self->current_overlays = NULL;
+	}
 
 	/* Unref the allocator here since the gst_imx_dma_buffer_uploader_get_allocator()
 	 * in gst_imx_2d_video_overlay_handler_new() refs it. */
@@ -162,9 +205,48 @@ GstImx2dVideoOverlayHandler* gst_imx_2d_video_overlay_handler_new(GstImxDmaBuffe
 
 void gst_imx_2d_video_overlay_handler_clear_cached_overlays(GstImx2dVideoOverlayHandler *video_overlay_handler)
 {
-	/* Clear the overlay gstbuffers, but retain the surface and CachedOverlay structures,
-	 * since we may need those again when new composition data comes in. */
-	gst_imx_2d_video_overlay_handler_clear_cached_overlays_full(video_overlay_handler, FALSE);
+	CachedOverlay *cached_overlay;
+
+	g_assert(video_overlay_handler != NULL);
+
+	GST_DEBUG_OBJECT(
+		video_overlay_handler,
+		"about to clear %u cached overlay(s) with a total size of %" G_GSIZE_FORMAT " byte(s)",
+		g_queue_get_length(&(video_overlay_handler->lru_queue)),
+		video_overlay_handler->total_cache_size
+	);
+
+	gst_imx_2d_video_overlay_handler_release_composition(video_overlay_handler);
+
+	g_hash_table_remove_all(video_overlay_handler->cached_overlays);
+
+	while ((cached_overlay = g_queue_pop_head(&(video_overlay_handler->lru_queue))) != NULL)
+		gst_imx_2d_video_overlay_handler_free_cached_overlay(cached_overlay);
+
+	video_overlay_handler->total_cache_size = 0;
+}
+
+
+void gst_imx_2d_video_overlay_handler_set_max_cache_size(GstImx2dVideoOverlayHandler *video_overlay_handler, gsize max_cache_size)
+{
+	g_assert(video_overlay_handler != NULL);
+
+	GST_OBJECT_LOCK(video_overlay_handler);
+	video_overlay_handler->max_cache_size = max_cache_size;
+	GST_OBJECT_UNLOCK(video_overlay_handler);
+}
+
+
+void gst_imx_2d_video_overlay_handler_get_cache_statistics(GstImx2dVideoOverlayHandler *video_overlay_handler, guint64 *num_cache_hits, guint64 *num_cache_misses)
+{
+	g_assert(video_overlay_handler != NULL);
+
+	GST_OBJECT_LOCK(video_overlay_handler);
+	if (num_cache_hits != NULL)
+		*num_cache_hits = video_overlay_handler->num_cache_hits;
+	if (num_cache_misses != NULL)
+		*num_cache_misses = video_overlay_handler->num_cache_misses;
+	GST_OBJECT_UNLOCK(video_overlay_handler);
 }
 
 
@@ -205,12 +287,13 @@ gboolean gst_imx_2d_video_overlay_handler_render(GstImx2dVideoOverlayHandler *vi
 	}
 
 
-	/* Check whether or not the composition changed.
-	 * If so, we have to repopulate the cache. */
+	/* Check whether or not the composition changed. If so, we
+	 * have to look up its rectangles in the cache, and upload
+	 * the ones that are not in there yet. */
 
 	if (composition != video_overlay_handler->previous_composition)
 	{
-		if (!gst_imx_2d_video_overlay_handler_cache_buffers(video_overlay_handler, composition))
+		if (!gst_imx_2d_video_overlay_handler_set_composition(video_overlay_handler, composition))
 			goto error;
 	}
 
@@ -224,7 +307,7 @@ gboolean gst_imx_2d_video_overlay_handler_render(GstImx2dVideoOverlayHandler *vi
 	for (rectangle_idx = 0; rectangle_idx < num_rectangles; ++rectangle_idx)
 	{
 		GstVideoOverlayRectangle *rectangle = gst_video_overlay_composition_get_rectangle(composition, rectangle_idx);
-		CachedOverlay *cached_overlay = &(video_overlay_handler->cached_overlays[rectangle_idx]);
+		CachedOverlay *cached_overlay = g_ptr_array_index(video_overlay_handler->current_overlays, rectangle_idx);
 		gint x, y;
 		guint w, h;
 		gboolean rect_ret;
@@ -274,316 +357,310 @@ error:
 }
 
 
-static gboolean gst_imx_2d_video_overlay_handler_cache_buffers(GstImx2dVideoOverlayHandler *self, GstVideoOverlayComposition *new_composition)
+static gboolean gst_imx_2d_video_overlay_handler_set_composition(GstImx2dVideoOverlayHandler *self, GstVideoOverlayComposition *new_composition)
 {
-	GstFlowReturn flow_ret;
-	CachedOverlay *new_cached_overlays;
-	guint rectangle_idx, previous_total_num_cached_overlays, num_rectangles;
-
-	/* Prerequisites. */
-
-	previous_total_num_cached_overlays = self->total_num_cached_overlays;
+	guint rectangle_idx, num_rectangles;
+	guint num_uploaded_rectangles = 0;
 
 	num_rectangles = gst_video_overlay_composition_n_rectangles(new_composition);
-	GST_DEBUG_OBJECT(self, "about to cache %u overlay(s) (previously cached amount: %u)", num_rectangles, previous_total_num_cached_overlays);
-
-
-	/* Get rid of any previously cached data (since we want to repoulate the cache). */
+	GST_DEBUG_OBJECT(self, "looking up %u overlay rectangle(s) of new composition in the cache", num_rectangles);
 
-	GST_DEBUG_OBJECT(self, "first, discarding old cached data (if any is present)");
-	gst_imx_2d_video_overlay_handler_clear_cached_overlays(self);
+	/* The cached overlays of the previous composition are no longer
+	 * in use, but stay in the cache, since the new composition may
+	 * contain some of the same rectangles. */
+	gst_imx_2d_video_overlay_handler_release_composition(self);
 
-
-	/* Check if we need to expand or contract the cached_overlays array. */
-
-	if (num_rectangles > previous_total_num_cached_overlays)
+	for (rectangle_idx = 0; rectangle_idx < num_rectangles; ++rectangle_idx)
 	{
-		/* We need more space than is available. Expand the array and
-		 * make sure the new CachedOverlay instances are initialized. */
-
-		GST_DEBUG_OBJECT(self, "need to make room for %u more cached overlay(s)", num_rectangles - previous_total_num_cached_overlays);
+		GstVideoOverlayRectangle *rectangle = gst_video_overlay_composition_get_rectangle(new_composition, rectangle_idx);
+		guint seqnum = gst_video_overlay_rectangle_get_seqnum(rectangle);
+		CachedOverlay *cached_overlay;
 
-		new_cached_overlays = (CachedOverlay *)g_try_realloc(self->cached_overlays, sizeof(CachedOverlay) * num_rectangles);
+		cached_overlay = g_hash_table_lookup(self->cached_overlays, GUINT_TO_POINTER(seqnum));
 
-		if (G_UNLIKELY(new_cached_overlays == NULL))
+		if (cached_overlay != NULL)
 		{
-			GST_ERROR_OBJECT(self, "could not (re)allocate cached overlays array");
-			return FALSE;
-		}
+			GST_LOG_OBJECT(self, "overlay rectangle #%u with seqnum %u is already cached", rectangle_idx, seqnum);
 
-		for (rectangle_idx = previous_total_num_cached_overlays; rectangle_idx < num_rectangles; ++rectangle_idx)
+			/* Move the cached overlay to the head of the LRU queue. */
+			g_queue_unlink(&(self->lru_queue), cached_overlay->lru_link);
+			g_queue_push_head_link(&(self->lru_queue), cached_overlay->lru_link);
+		}
+		else
 		{
-			CachedOverlay *cached_overlay = &(new_cached_overlays[rectangle_idx]);
-			memset(cached_overlay, 0, sizeof(CachedOverlay));
+			GST_LOG_OBJECT(self, "overlay rectangle #%u with seqnum %u is not cached yet", rectangle_idx, seqnum);
+
+			cached_overlay = gst_imx_2d_video_overlay_handler_upload_rectangle(self, rectangle, rectangle_idx);
+			if (G_UNLIKELY(cached_overlay == NULL))
+				goto error;
+
+			g_hash_table_insert(self->cached_overlays, GUINT_TO_POINTER(seqnum), cached_overlay);
+			g_queue_push_head(&(self->lru_queue), cached_overlay);
+			cached_overlay->lru_link = self->lru_queue.head;
+			self->total_cache_size += cached_overlay->size;
+
+			num_uploaded_rectangles++;
 		}
 
-		self->cached_overlays = new_cached_overlays;
-		self->total_num_cached_overlays = num_rectangles;
+		cached_overlay->in_use = TRUE;
+		g_ptr_array_add(self->current_overlays, cached_overlay);
 	}
-	else if (num_rectangles < previous_total_num_cached_overlays)
-	{
-		/* We need less space than is available. Contract the array and
-		 * make sure imx2d surface instances in the excess CachedOverlay
-		 * instances are destroyed to avoid memory leaks. */
 
-		GST_DEBUG_OBJECT(self, "need to erase the last %u cached overlay(s)", previous_total_num_cached_overlays - num_rectangles);
+	GST_OBJECT_LOCK(self);
+	self->num_cache_hits += num_rectangles - num_uploaded_rectangles;
+	self->num_cache_misses += num_uploaded_rectangles;
+	GST_OBJECT_UNLOCK(self);
 
-		for (rectangle_idx = num_rectangles; rectangle_idx < previous_total_num_cached_overlays; ++rectangle_idx)
-		{
-			CachedOverlay *cached_overlay = &(self->cached_overlays[rectangle_idx]);
-
-			/* Destroy the surface of the cached overlays that we need to get rid of.
-			 * (Note that at this point, the cached overlay's gstbuffer is always NULL,
-			 * since the gst_imx_2d_video_overlay_handler_clear_cached_overlays() call
-			 * above takes care of getting rid of those gstbuffers.) */
-			g_assert(cached_overlay->buffer == NULL);
-
-			if (cached_overlay->surface != NULL)
-			{
-				imx_2d_surface_destroy(cached_overlay->surface);
-				cached_overlay->surface = NULL;
-			}
-		}
+	GST_DEBUG_OBJECT(
+		self,
+		"uploaded %u of %u overlay rectangle(s); total cache size: %" G_GSIZE_FORMAT " byte(s)",
+		num_uploaded_rectangles,
+		num_rectangles,
+		self->total_cache_size
+	);
 
-		/* Reallocate the cached_overlays array. */
-		new_cached_overlays = (CachedOverlay *)g_try_realloc(self->cached_overlays, sizeof(CachedOverlay) * num_rectangles);
-		if (G_UNLIKELY(new_cached_overlays == NULL))
-		{
-			GST_ERROR_OBJECT(self, "could not (re)allocate cached overlays array");
-			return FALSE;
-		}
+	gst_imx_2d_video_overlay_handler_evict_cached_overlays(self);
 
-		self->cached_overlays = new_cached_overlays;
-		self->total_num_cached_overlays = num_rectangles;
-	}
-	/* Do nothing in case the amount of rectangles and the array size are the same. */
+	/* Ref the new composition to avoid modifications (taking
+	 * advantage of the copy-on-write mechanism in miniobject
+	 * based entities) and to be able to compare future
+	 * compositions with this one to detect changes. */
+	GST_DEBUG_OBJECT(self, "ref'ing new video overlay composition %" GST_PTR_FORMAT, (gpointer)new_composition);
+	self->previous_composition = gst_video_overlay_composition_ref(new_composition);
 
+	return TRUE;
 
-	/* Perform the actual gstbuffer upload now and set up
-	 * the imx2d surface for each overlay. */
+error:
+	gst_imx_2d_video_overlay_handler_release_composition(self);
+	return FALSE;
+}
 
-	GST_DEBUG_OBJECT(self, "now uploading incoming overlay gstbuffers and storing the uploaded versions in the cached overlays");
 
-	for (rectangle_idx = 0; rectangle_idx < num_rectangles; ++rectangle_idx)
+static CachedOverlay* gst_imx_2d_video_overlay_handler_upload_rectangle(GstImx2dVideoOverlayHandler *self, GstVideoOverlayRectangle *rectangle, guint rectangle_idx)
+{
+	GstFlowReturn flow_ret;
+	CachedOverlay *cached_overlay;
+	guint plane_idx;
+	Imx2dSurfaceDesc surface_desc;
+	GstVideoMeta *video_meta;
+	GstBuffer *rectangle_buffer = gst_video_overlay_rectangle_get_pixels_raw(rectangle, GST_VIDEO_OVERLAY_FORMAT_FLAG_GLOBAL_ALPHA);
+	GstBuffer *uploaded_buffer;
+	GstVideoInfo video_info, adjusted_video_info;
+	GstVideoAlignment video_alignment;
+	gboolean must_copy_frame = FALSE;
+
+	GST_DEBUG_OBJECT(self, "uploading gstbuffer of overlay #%u", rectangle_idx);
+
+	/* The GstBuffer of an overlay rectangle _must_ have a video meta. This
+	 * is a requirement as per the GstVideoOverlayRectangle documentation. */
+	video_meta = gst_buffer_get_video_meta(rectangle_buffer);
+	if (G_UNLIKELY(video_meta == NULL))
 	{
-		guint plane_idx;
-		Imx2dSurfaceDesc surface_desc;
-		GstVideoMeta *video_meta;
-		GstVideoOverlayRectangle *rectangle = gst_video_overlay_composition_get_rectangle(new_composition, rectangle_idx);
-		GstBuffer *rectangle_buffer = gst_video_overlay_rectangle_get_pixels_raw(rectangle, GST_VIDEO_OVERLAY_FORMAT_FLAG_GLOBAL_ALPHA);
-		GstBuffer *uploaded_buffer;
-		CachedOverlay *cached_overlay = &(self->cached_overlays[rectangle_idx]);
-		GstVideoInfo video_info, adjusted_video_info;
-		GstVideoAlignment video_alignment;
-		gboolean must_copy_frame = FALSE;
-
-		GST_DEBUG_OBJECT(self, "uploading gstbuffer of overlay #%u", rectangle_idx);
-
-		/* The GstBuffer of an overlay rectangle _must_ have a video meta. This
-		 * is a requirement as per the GstVideoOverlayRectangle documentation. */
-		video_meta = gst_buffer_get_video_meta(rectangle_buffer);
-		if (G_UNLIKELY(video_meta == NULL))
-		{
-			GST_ERROR_OBJECT(self, "overlay rectangle has a gstbuffer without video meta; gstbuffer: %" GST_PTR_FORMAT, (gpointer)rectangle_buffer);
-			return FALSE;
-		}
+		GST_ERROR_OBJECT(self, "overlay rectangle has a gstbuffer without video meta; gstbuffer: %" GST_PTR_FORMAT, (gpointer)rectangle_buffer);
+		return NULL;
+	}
 
 
-		/* Fill video_info, make a copy of it, and then align the copy's
-		 * stride values to the alignment the imx2d blitter requires.
-		 * That way, we can compare the stride values of both video info
-		 * structures. If the ones from the copy got changed, we know
-		 * that the original stride sizes are unsuitable for the imx2d
-		 * blitter, and we must do an adjusted frame copy. Otherwise, we
-		 * can use the input frame directly, and pass it to the uploader. */
+	/* Fill video_info, make a copy of it, and then align the copy's
+	 * stride values to the alignment the imx2d blitter requires.
+	 * That way, we can compare the stride values of both video info
+	 * structures. If the ones from the copy got changed, we know
+	 * that the original stride sizes are unsuitable for the imx2d
+	 * blitter, and we must do an adjusted frame copy. Otherwise, we
+	 * can use the input frame directly, and pass it to the uploader. */
 
-		gst_video_info_set_format(&video_info, video_meta->format, video_meta->width, video_meta->height);
-		gst_video_alignment_reset(&video_alignment);
+	gst_video_info_set_format(&video_info, video_meta->format, video_meta->width, video_meta->height);
+	gst_video_alignment_reset(&video_alignment);
 
-		for (plane_idx = 0; plane_idx < video_meta->n_planes; ++plane_idx)
-		{
-			if (G_LIKELY(video_meta->stride[plane_idx] > 0))
-				GST_VIDEO_INFO_PLANE_STRIDE(&video_info, plane_idx) = video_meta->stride[plane_idx];
-			if (G_LIKELY(video_meta->offset[plane_idx] > 0))
-				GST_VIDEO_INFO_PLANE_OFFSET(&video_info, plane_idx) = video_meta->offset[plane_idx];
-			video_alignment.stride_align[plane_idx] = self->stride_alignment - 1;
-		}
+	for (plane_idx = 0; plane_idx < video_meta->n_planes; ++plane_idx)
+	{
+		if (G_LIKELY(video_meta->stride[plane_idx] > 0))
+			GST_VIDEO_INFO_PLANE_STRIDE(&video_info, plane_idx) = video_meta->stride[plane_idx];
+		if (G_LIKELY(video_meta->offset[plane_idx] > 0))
+			GST_VIDEO_INFO_PLANE_OFFSET(&video_info, plane_idx) = video_meta->offset[plane_idx];
+		video_alignment.stride_align[plane_idx] = self->stride_alignment - 1;
+	}
 
-		/* Create the video_info copy and adjust it by aligning the strides. */
-		memcpy(&adjusted_video_info, &video_info, sizeof(GstVideoInfo));
-		gst_video_info_align(&adjusted_video_info, &video_alignment);
+	/* Create the video_info copy and adjust it by aligning the strides. */
+	memcpy(&adjusted_video_info, &video_info, sizeof(GstVideoInfo));
+	gst_video_info_align(&adjusted_video_info, &video_alignment);
 
-		/* Now check if the stride sizes were actually changed. */
-		for (plane_idx = 0; plane_idx < video_meta->n_planes; ++plane_idx)
-		{
-			GST_LOG_OBJECT(
-				self,
-				"checking plane %u: original stride %d adjusted stride %d",
-				plane_idx,
-				GST_VIDEO_INFO_PLANE_STRIDE(&video_info, plane_idx),
-				GST_VIDEO_INFO_PLANE_STRIDE(&adjusted_video_info, plane_idx)
-			);
+	/* Now check if the stride sizes were actually changed. */
+	for (plane_idx = 0; plane_idx < video_meta->n_planes; ++plane_idx)
+	{
+		GST_LOG_OBJECT(
+			self,
+			"checking plane %u: original stride %d adjusted stride %d",
+			plane_idx,
+			GST_VIDEO_INFO_PLANE_STRIDE(&video_info, plane_idx),
+			GST_VIDEO_INFO_PLANE_STRIDE(&adjusted_video_info, plane_idx)
+		);
 
-			if (GST_VIDEO_INFO_PLANE_STRIDE(&adjusted_video_info, plane_idx) != GST_VIDEO_INFO_PLANE_STRIDE(&video_info, plane_idx))
-			{
-				GST_LOG_OBJECT(self, "stride was modified; need to do a frame copy");
-				must_copy_frame = TRUE;
-				break;
-			}
+		if (GST_VIDEO_INFO_PLANE_STRIDE(&adjusted_video_info, plane_idx) != GST_VIDEO_INFO_PLANE_STRIDE(&video_info, plane_idx))
+		{
+			GST_LOG_OBJECT(self, "stride was modified; need to do a frame copy");
+			must_copy_frame = TRUE;
+			break;
 		}
+	}
 
-		/* The actual upload / copy. */
+	/* The actual upload / copy. */
 
-		if (must_copy_frame)
-		{
-			GstVideoFrame in_frame, out_frame;
+	if (must_copy_frame)
+	{
+		GstVideoFrame in_frame, out_frame;
 
-			GST_LOG_OBJECT(self, "copying the overlay frame to produce a frame that meets the imx2d blitter stride alignment requirements");
+		GST_LOG_OBJECT(self, "copying the overlay frame to produce a frame that meets the imx2d blitter stride alignment requirements");
 
-			uploaded_buffer = gst_buffer_new_allocate(
-				self->dma_buffer_allocator,
-				GST_VIDEO_INFO_SIZE(&adjusted_video_info),
-				NULL
-			);
+		uploaded_buffer = gst_buffer_new_allocate(
+			self->dma_buffer_allocator,
+			GST_VIDEO_INFO_SIZE(&adjusted_video_info),
+			NULL
+		);
 
-			gst_video_frame_map(&in_frame, &(video_info), rectangle_buffer, GST_MAP_READ);
-			gst_video_frame_map(&out_frame, &(adjusted_video_info), uploaded_buffer, GST_MAP_WRITE);
+		gst_video_frame_map(&in_frame, &(video_info), rectangle_buffer, GST_MAP_READ);
+		gst_video_frame_map(&out_frame, &(adjusted_video_info), uploaded_buffer, GST_MAP_WRITE);
 
-			gst_video_frame_copy(&out_frame, &in_frame);
+		gst_imx_video_worker_pool_copy_frame(NULL, &out_frame, &in_frame);
 
-			gst_video_frame_unmap(&out_frame);
-			gst_video_frame_unmap(&in_frame);
-		}
-		else
-		{
-			GST_LOG_OBJECT(self, "uploading the overlay frame");
-
-			flow_ret = gst_imx_dma_buffer_uploader_perform(self->uploader, rectangle_buffer, &uploaded_buffer);
-			if (G_UNLIKELY(flow_ret != GST_FLOW_OK))
-			{
-				GST_ERROR_OBJECT(self, "could not upload gstbuffer for overlaay #%u: %s", rectangle_idx, gst_flow_get_name(flow_ret));
-				return FALSE;
-			}
-		}
+		gst_video_frame_unmap(&out_frame);
+		gst_video_frame_unmap(&in_frame);
+	}
+	else
+	{
+		GST_LOG_OBJECT(self, "uploading the overlay frame");
 
-		if (uploaded_buffer != rectangle_buffer)
+		flow_ret = gst_imx_dma_buffer_uploader_perform(self->uploader, rectangle_buffer, &uploaded_buffer);
+		if (G_UNLIKELY(flow_ret != GST_FLOW_OK))
 		{
-			GST_LOG_OBJECT(self, "frame was copied or uploaded; adding video meta with data from adjusted video info");
-
-			gst_buffer_add_video_meta_full(
-				uploaded_buffer,
-				video_meta->flags,
-				GST_VIDEO_INFO_FORMAT(&adjusted_video_info),
-				GST_VIDEO_INFO_WIDTH(&adjusted_video_info),
-				GST_VIDEO_INFO_HEIGHT(&adjusted_video_info),
-				GST_VIDEO_INFO_N_PLANES(&adjusted_video_info),
-				&(GST_VIDEO_INFO_PLANE_OFFSET(&adjusted_video_info, 0)),
-				&(GST_VIDEO_INFO_PLANE_STRIDE(&adjusted_video_info, 0))
-			);
+			GST_ERROR_OBJECT(self, "could not upload gstbuffer for overlaay #%u: %s", rectangle_idx, gst_flow_get_name(flow_ret));
+			return NULL;
 		}
+	}
 
+	if (uploaded_buffer != rectangle_buffer)
+	{
+		GST_LOG_OBJECT(self, "frame was copied or uploaded; adding video meta with data from adjusted video info");
 
-		cached_overlay->buffer = uploaded_buffer;
+		gst_buffer_add_video_meta_full(
+			uploaded_buffer,
+			video_meta->flags,
+			GST_VIDEO_INFO_FORMAT(&adjusted_video_info),
+			GST_VIDEO_INFO_WIDTH(&adjusted_video_info),
+			GST_VIDEO_INFO_HEIGHT(&adjusted_video_info),
+			GST_VIDEO_INFO_N_PLANES(&adjusted_video_info),
+			&(GST_VIDEO_INFO_PLANE_OFFSET(&adjusted_video_info, 0)),
+			&(GST_VIDEO_INFO_PLANE_STRIDE(&adjusted_video_info, 0))
+		);
+	}
 
 
-		/* Now set up the surface. */
+	cached_overlay = g_new0(CachedOverlay, 1);
+	cached_overlay->rectangle = gst_video_overlay_rectangle_ref(rectangle);
+	cached_overlay->buffer = uploaded_buffer;
+	cached_overlay->size = gst_buffer_get_size(uploaded_buffer);
 
-		if (cached_overlay->surface == NULL)
-			cached_overlay->surface = imx_2d_surface_create(NULL);
 
-		memset(&surface_desc, 0, sizeof(surface_desc));
-		surface_desc.width = video_meta->width;
-		surface_desc.height = video_meta->height;
-		surface_desc.format = gst_imx_2d_convert_from_gst_video_format(video_meta->format, NULL);
+	/* Now set up the surface. */
 
-		gst_imx_2d_assign_input_buffer_to_surface(
-			uploaded_buffer,
-			cached_overlay->surface,
-			&surface_desc,
-			NULL
-		);
+	cached_overlay->surface = imx_2d_surface_create(NULL);
 
-		imx_2d_surface_set_desc(cached_overlay->surface, &(surface_desc));
-	}
+	memset(&surface_desc, 0, sizeof(surface_desc));
+	surface_desc.width = video_meta->width;
+	surface_desc.height = video_meta->height;
+	surface_desc.format = gst_imx_2d_convert_from_gst_video_format(video_meta->format, NULL);
 
+	gst_imx_2d_assign_input_buffer_to_surface(
+		uploaded_buffer,
+		cached_overlay->surface,
+		&surface_desc,
+		NULL
+	);
 
-	self->num_populated_cached_overlays = num_rectangles;
+	imx_2d_surface_set_desc(cached_overlay->surface, &(surface_desc));
 
-	/* Ref the new composition to avoid modifications (taking
-	 * advantage of the copy-on-write mechanism in miniobject
-	 * based entities) and to be able to compare future
-	 * compositions with this one to detect changes. */
-	GST_DEBUG_OBJECT(self, "ref'ing new video overlay composition %" GST_PTR_FORMAT, (gpointer)new_composition);
-	self->previous_composition = gst_video_overlay_composition_ref(new_composition);
+	return cached_overlay;
+}
 
 
-	GST_DEBUG_OBJECT(self, "uploading complete");
+static void gst_imx_2d_video_overlay_handler_release_composition(GstImx2dVideoOverlayHandler *self)
+{
+	guint i;
 
+	for (i = 0; i < self->current_overlays->len; ++i)
+	{
+		CachedOverlay *cached_overlay = g_ptr_array_index(self->current_overlays, i);
+		cached_overlay->in_use = FALSE;
+	}
 
-	return TRUE;
+	g_ptr_array_set_size(self->current_overlays, 0);
+
+	if (self->previous_composition != NULL)
+	{
+		GST_DEBUG_OBJECT(self, "unref'ing old overlay composition %" GST_PTR_FORMAT, (gpointer)(self->previous_composition));
+		gst_video_overlay_composition_unref(self->previous_composition);
+		self->previous_composition = NULL;
+	}
 }
 
 
-static void gst_imx_2d_video_overlay_handler_clear_cached_overlays_full(GstImx2dVideoOverlayHandler *video_overlay_handler, gboolean do_full_clearing)
+static void gst_imx_2d_video_overlay_handler_evict_cached_overlays(GstImx2dVideoOverlayHandler *self)
 {
-	g_assert(video_overlay_handler != NULL);
-
-	GST_DEBUG_OBJECT(
-		video_overlay_handler,
-		"about to clear cached overlays:  num populated: %u  total num: %u  do full clearing: %d",
-		video_overlay_handler->num_populated_cached_overlays,
-		video_overlay_handler->total_num_cached_overlays,
-		do_full_clearing
-	);
-
-	if (video_overlay_handler->cached_overlays != NULL)
+	GList *link;
+	gsize max_cache_size;
+
+	GST_OBJECT_LOCK(self);
+	max_cache_size = self->max_cache_size;
+	GST_OBJECT_UNLOCK(self);
+
+	/* Walk from the least recently used cached overlay towards
+	 * the most recently used one, and evict cached overlays until
+	 * the cache is small enough. Cached overlays that are used by
+	 * the current composition are skipped. If these alone exceed
+	 * max_cache_size, then the cache stays above that size. */
+	link = self->lru_queue.tail;
+	while ((link != NULL) && (self->total_cache_size > max_cache_size))
 	{
-		guint i;
+		GList *previous_link = link->prev;
+		CachedOverlay *cached_overlay = link->data;
 
-		/* First, unref any non-NULL overlay gstbuffer. This is done
-		 * no matter what the do_full_clearing is. */
-		for (i = 0; i < video_overlay_handler->num_populated_cached_overlays; ++i)
+		if (!cached_overlay->in_use)
 		{
-			CachedOverlay *cached_overlay = &(video_overlay_handler->cached_overlays[i]);
-
-			if (cached_overlay->buffer != NULL)
-			{
-				GST_DEBUG_OBJECT(
-					video_overlay_handler,
-					"unref'ing non-NULL gst buffer from cached overlay #%u; gstbuffer: %" GST_PTR_FORMAT,
-					i,
-					(gpointer)(cached_overlay->buffer)
-				);
-
-				gst_buffer_unref(cached_overlay->buffer);
-				cached_overlay->buffer = NULL;
-			}
-		}
+			GST_LOG_OBJECT(
+				self,
+				"evicting cached overlay with seqnum %u and size %" G_GSIZE_FORMAT,
+				gst_video_overlay_rectangle_get_seqnum(cached_overlay->rectangle),
+				cached_overlay->size
+			);
 
-		video_overlay_handler->num_populated_cached_overlays = 0;
+			g_hash_table_remove(self->cached_overlays, GUINT_TO_POINTER(gst_video_overlay_rectangle_get_seqnum(cached_overlay->rectangle)));
+			g_queue_delete_link(&(self->lru_queue), link);
+			self->total_cache_size -= cached_overlay->size;
 
-		/* If requested, also deallocate the cached_overlays array and the imx2d
-		 * surfaces in each CachedOverlay entry. This is typically done when
-		 * disposing of this GstImx2dVideoOverlayHandler. */
-		if (do_full_clearing)
-		{
-			for (i = 0; i < video_overlay_handler->total_num_cached_overlays; ++i)
-			{
-				CachedOverlay *cached_buf = &(video_overlay_handler->cached_overlays[i]);
-				if (cached_buf->surface != NULL)
-					imx_2d_surface_destroy(cached_buf->surface);
-			}
-
-			g_free(video_overlay_handler->cached_overlays);
-			video_overlay_handler->cached_overlays = NULL;
-			video_overlay_handler->total_num_cached_overlays = 0;
+			gst_imx_2d_video_overlay_handler_free_cached_overlay(cached_overlay);
 		}
+
+		link = previous_link;
 	}
 
-	if (video_overlay_handler->previous_composition != NULL)
+	if (self->total_cache_size > max_cache_size)
 	{
-		GST_DEBUG_OBJECT(video_overlay_handler, "unref'ing old overlay composition %" GST_PTR_FORMAT, (gpointer)(video_overlay_handler->previous_composition));
-		gst_video_overlay_composition_unref(video_overlay_handler->previous_composition);
-		video_overlay_handler->previous_composition = NULL;
+		GST_DEBUG_OBJECT(
+			self,
+			"overlays of the current composition need %" G_GSIZE_FORMAT " byte(s), which is more than the maximum cache size %" G_GSIZE_FORMAT,
+			self->total_cache_size,
+			max_cache_size
+		);
 	}
 }
+
+
+static void gst_imx_2d_video_overlay_handler_free_cached_overlay(CachedOverlay *cached_overlay)
+{
+	if (cached_overlay->surface != NULL)
+		imx_2d_surface_destroy(cached_overlay->surface);
+	if (cached_overlay->buffer != NULL)
+		gst_buffer_unref(cached_overlay->buffer);
+	gst_video_overlay_rectangle_unref(cached_overlay->rectangle);
+	g_free(cached_overlay);
+}
@@ -51,9 +51,18 @@ G_BEGIN_DECLS
  * or until the GstImx2dVideoOverlayHandler instance is destroyed.
  * Ref'ing the GstVideoOverlayComposition makes sure that it cannot
  * be modified in-place by someone else, and also allows for checking
- * if incoming buffers contain the exact same composition. If so,
- * the cached data can be reused, otherwise the cache has to be
- * repopulated with the new composition's data.
+ * if incoming buffers contain the exact same composition.
+ *
+ * The cache is not tied to one composition. Uploaded rectangles are
+ * cached individually, identified by their seqnum. When a new composition
+ * shows up, only the rectangles that are not in the cache yet are uploaded.
+ * This helps a lot with subtitle and OSD renderers that only change some
+ * of the rectangles from one composition to the next. Rectangles that are
+ * no longer part of the current composition stay in the cache until its
+ * size exceeds the limit set by gst_imx_2d_video_overlay_handler_set_max_cache_size().
+ * Then, the least recently used ones are evicted. The number of cache hits
+ * and misses can be retrieved with gst_imx_2d_video_overlay_handler_get_cache_statistics()
+ * to help with choosing a suitable limit.
  *
  * The overlays are drawn with gst_imx_2d_video_overlay_handler_render().
  * Note that imx_2d_blitter_start() must have been called before
@@ -78,10 +87,16 @@ typedef struct _GstImx2dVideoOverlayHandler GstImx2dVideoOverlayHandler;
 typedef struct _GstImx2dVideoOverlayHandlerClass GstImx2dVideoOverlayHandlerClass;
 
 
+#define GST_IMX_2D_VIDEO_OVERLAY_HANDLER_DEFAULT_MAX_CACHE_SIZE (16 * 1024 * 1024)
+
+
 GstImx2dVideoOverlayHandler* gst_imx_2d_video_overlay_handler_new(GstImxDmaBufferUploader *uploader, Imx2dBlitter *blitter);
 
 void gst_imx_2d_video_overlay_handler_clear_cached_overlays(GstImx2dVideoOverlayHandler *video_overlay_handler);
 
+void gst_imx_2d_video_overlay_handler_set_max_cache_size(GstImx2dVideoOverlayHandler *video_overlay_handler, gsize max_cache_size);
+void gst_imx_2d_video_overlay_handler_get_cache_statistics(GstImx2dVideoOverlayHandler *video_overlay_handler, guint64 *num_cache_hits, guint64 *num_cache_misses);
+
 gboolean gst_imx_2d_video_overlay_handler_render(GstImx2dVideoOverlayHandler *video_overlay_handler, GstBuffer *buffer);
 
 
@@ -33,13 +33,17 @@ enum
 	PROP_0,
 	PROP_INPUT_CROP,
 	PROP_VIDEO_DIRECTION,
-	PROP_DISABLE_PASSTHROUGH
+	PROP_DISABLE_PASSTHROUGH,
+	PROP_OVERLAY_CACHE_MAX_SIZE,
+	PROP_OVERLAY_CACHE_HITS,
+	PROP_OVERLAY_CACHE_MISSES
 };
 
 
 #define DEFAULT_INPUT_CROP TRUE
 #define DEFAULT_VIDEO_DIRECTION GST_VIDEO_ORIENTATION_IDENTITY
 #define DEFAULT_DISABLE_PASSTHROUGH FALSE
+#define DEFAULT_OVERLAY_CACHE_MAX_SIZE GST_IMX_2D_VIDEO_OVERLAY_HANDLER_DEFAULT_MAX_CACHE_SIZE
 
 
 /* Cached quark to avoid contention on the global quark table lock */
@@ -166,6 +170,43 @@ static void gst_imx_2d_video_transform_class_init(GstImx2dVideoTransformClass *k
 			G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS
 		)
 	);
+	g_object_class_install_property(
+		object_class,
+		PROP_OVERLAY_CACHE_MAX_SIZE,
+		g_param_spec_uint(
+			"overlay-cache-max-size",
+			"Overlay cache maximum size",
+			"Maximum size of the cache for uploaded overlay rectangles, in bytes "
+			"(the rectangles of the current overlay composition are always cached, even if they exceed this size)",
+			0, G_MAXUINT,
+			DEFAULT_OVERLAY_CACHE_MAX_SIZE,
+			G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS
+		)
+	);
+	g_object_class_install_property(
+		object_class,
+		PROP_OVERLAY_CACHE_HITS,
+		g_param_spec_uint64(
+			"overlay-cache-hits",
+			"Overlay cache hits",
+			"How many overlay rectangles were found in the overlay cache since the element was started",
+			0, G_MAXUINT64,
+			0,
+			G_PARAM_READABLE | G_PARAM_STATIC_STRINGS
+		)
+	);
+	g_object_class_install_property(
+		object_class,
+		PROP_OVERLAY_CACHE_MISSES,
+		g_param_spec_uint64(
+			"overlay-cache-misses",
+			"Overlay cache misses",
+			"How many overlay rectangles had to be uploaded because they were not in the overlay cache since the element was started",
+			0, G_MAXUINT64,
+			0,
+			G_PARAM_READABLE | G_PARAM_STATIC_STRINGS
+		)
+	);
 }
 
 
@@ -193,6 +234,7 @@ void gst_imx_2d_video_transform_init(GstImx2dVideoTransform *self)
 	self->input_crop = DEFAULT_INPUT_CROP;
 	self->video_direction = DEFAULT_VIDEO_DIRECTION;
 	self->disable_passthrough = DEFAULT_DISABLE_PASSTHROUGH;
+	self->overlay_cache_max_size = DEFAULT_OVERLAY_CACHE_MAX_SIZE;
 
 	self->tag_video_direction = DEFAULT_VIDEO_DIRECTION;
 
@@ -235,6 +277,16 @@ static void gst_imx_2d_video_transform_set_property(GObject *object, guint prop_
 			break;
 		}
 
+		case PROP_OVERLAY_CACHE_MAX_SIZE:
+		{
+			GST_OBJECT_LOCK(self);
+			self->overlay_cache_max_size = g_value_get_uint(value);
+			if (self->overlay_handler != NULL)
+				gst_imx_2d_video_overlay_handler_set_max_cache_size(self->overlay_handler, self->overlay_cache_max_size);
+			GST_OBJECT_UNLOCK(self);
+			break;
+		}
+
 		default:
 			G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
 			break;
@@ -272,6 +324,28 @@ static void gst_imx_2d_video_transform_get_property(GObject *object, guint prop_
 			break;
 		}
 
+		case PROP_OVERLAY_CACHE_MAX_SIZE:
+		{
+			GST_OBJECT_LOCK(self);
+			g_value_set_uint(value, self->overlay_cache_max_size);
+			GST_OBJECT_UNLOCK(self);
+			break;
+		}
+
+		case PROP_OVERLAY_CACHE_HITS:
+		case PROP_OVERLAY_CACHE_MISSES:
+		{
+			guint64 num_cache_hits = 0, num_cache_misses = 0;
+
+			GST_OBJECT_LOCK(self);
+			if (self->overlay_handler != NULL)
+				gst_imx_2d_video_overlay_handler_get_cache_statistics(self->overlay_handler, &num_cache_hits, &num_cache_misses);
+			GST_OBJECT_UNLOCK(self);
+
+			g_value_set_uint64(value, (prop_id == PROP_OVERLAY_CACHE_HITS) ? num_cache_hits : num_cache_misses);
+			break;
+		}
+
 		default:
 			G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
 			break;
@@ -1527,6 +1601,7 @@ static GstFlowReturn gst_imx_2d_video_transform_transform_frame(GstBaseTransform
 	GstVideoOrientationMethod video_direction;
 	GstBuffer *uploaded_input_buffer = NULL;
 	GstBuffer *intermediate_buffer = NULL;
+	Imx2dCompletionToken completion_token;
 	GstImx2dVideoTransform *self = GST_IMX_2D_VIDEO_TRANSFORM(transform);
 
 	/* Initial checks. */
@@ -1650,9 +1725,38 @@ static GstFlowReturn gst_imx_2d_video_transform_transform_frame(GstBaseTransform
 		}
 	}
 
-	if (!imx_2d_blitter_finish(self->blitter))
+	/* Submit the blitter operations instead of finishing them right away.
+	 * Blitters that can run their operations asynchronously then work
+	 * on the frame while this thread takes care of the metadata.
+	 * The input and output buffers stay referenced until the
+	 * submission is completed, so their DMA buffers remain valid. */
+	if (!imx_2d_blitter_submit(self->blitter, &completion_token))
 	{
-		GST_ERROR_OBJECT(self, "finishing blitter failed");
+		GST_ERROR_OBJECT(self, "submitting blitter operations failed");
+		goto error;
+	}
+
+
+	/* Pass through the overlay meta if necessary. This only touches
+	 * metadata, so it can happen while the blitter is still busy. */
+
+	if (self->passing_through_overlay_meta)
+	{
+		GstVideoOverlayCompositionMeta *composition_meta;
+		GstVideoOverlayComposition *composition;
+
+		GST_LOG_OBJECT(self, "passing through overlay meta");
+
+		composition_meta = gst_buffer_get_video_overlay_composition_meta(input_buffer);
+		composition = composition_meta->overlay;
+
+		gst_buffer_add_video_overlay_composition_meta(output_buffer, composition);
+	}
+
+
+	if (!imx_2d_blitter_wait(self->blitter, completion_token))
+	{
+		GST_ERROR_OBJECT(self, "blitter operations failed");
 		goto error;
 	}
 
@@ -1676,22 +1780,6 @@ static GstFlowReturn gst_imx_2d_video_transform_transform_frame(GstBaseTransform
 	intermediate_buffer = NULL;
 
 
-	/* Pass through the overlay meta if necessary. */
-
-	if (self->passing_through_overlay_meta)
-	{
-		GstVideoOverlayCompositionMeta *composition_meta;
-		GstVideoOverlayComposition *composition;
-
-		GST_LOG_OBJECT(self, "passing through overlay meta");
-
-		composition_meta = gst_buffer_get_video_overlay_composition_meta(input_buffer);
-		composition = composition_meta->overlay;
-
-		gst_buffer_add_video_overlay_composition_meta(output_buffer, composition);
-	}
-
-
 	GST_LOG_OBJECT(self, "blitting procedure finished successfully; frame transform complete");
 
 
@@ -1775,6 +1863,7 @@ static gboolean gst_imx_2d_video_transform_start(GstImx2dVideoTransform *self)
 {
 	GstImx2dVideoTransformClass *klass = GST_IMX_2D_VIDEO_TRANSFORM_CLASS(G_OBJECT_GET_CLASS(self));
 	GstImxDmaBufferUploader *dma_buffer_uploader;
+	GstImx2dVideoOverlayHandler *overlay_handler;
 
 	self->inout_info_equal = FALSE;
 	self->inout_info_set = FALSE;
@@ -1829,14 +1918,21 @@ static gboolean gst_imx_2d_video_transform_start(GstImx2dVideoTransform *self)
 	}
 
 	dma_buffer_uploader = gst_imx_video_uploader_get_dma_buffer_uploader(self->uploader);
-	self->overlay_handler = gst_imx_2d_video_overlay_handler_new(dma_buffer_uploader, self->blitter);
+	overlay_handler = gst_imx_2d_video_overlay_handler_new(dma_buffer_uploader, self->blitter);
 	gst_object_unref(GST_OBJECT(dma_buffer_uploader));
-	if (self->overlay_handler == NULL)
+	if (overlay_handler == NULL)
 	{
 		GST_ERROR_OBJECT(self, "creating overlay handler failed");
 		goto error;
 	}
 
+	/* The overlay handler is set while the object lock is held,
+	 * since the overlay cache properties access it. */
+	GST_OBJECT_LOCK(self);
+	self->overlay_handler = overlay_handler;
+	gst_imx_2d_video_overlay_handler_set_max_cache_size(overlay_handler, self->overlay_cache_max_size);
+	GST_OBJECT_UNLOCK(self);
+
 	return TRUE;
 
 error:
@@ -1848,17 +1944,20 @@ error:
 static void gst_imx_2d_video_transform_stop(GstImx2dVideoTransform *self)
 {
 	GstImx2dVideoTransformClass *klass = GST_IMX_2D_VIDEO_TRANSFORM_CLASS(G_OBJECT_GET_CLASS(self));
+	GstImx2dVideoOverlayHandler *overlay_handler;
 
 	if ((klass->stop != NULL) && !(klass->stop(self)))
 		GST_ERROR_OBJECT(self, "stop() failed");
 
 	gst_caps_replace(&(self->input_caps), NULL);
 
-	if (self->overlay_handler != NULL)
-	{
-		gst_object_unref(GST_OBJECT(self->overlay_handler));
-		self->overlay_handler = NULL;
-	}
+	GST_OBJECT_LOCK(self);
+	overlay_handler = self->overlay_handler;
+	self->overlay_handler = NULL;
+	GST_OBJECT_UNLOCK(self);
+
+	if (overlay_handler != NULL)
+		gst_object_unref(GST_OBJECT(overlay_handler));
 
 	if (self->input_surface != NULL)
 	{
@@ -1892,6 +1991,16 @@ static void gst_imx_2d_video_transform_stop(GstImx2dVideoTransform *self)
 
 	if (self->video_buffer_pool != NULL)
 	{
+		guint64 num_zero_copy_transfers, num_copied_transfers;
+
+		gst_imx_video_buffer_pool_get_transfer_statistics(self->video_buffer_pool, &num_zero_copy_transfers, &num_copied_transfers);
+		GST_INFO_OBJECT(
+			self,
+			"output frame transfers: %" G_GUINT64_FORMAT " without copy, %" G_GUINT64_FORMAT " copied with the CPU",
+			num_zero_copy_transfers,
+			num_copied_transfers
+		);
+
 		gst_object_unref(GST_OBJECT(self->video_buffer_pool));
 		self->video_buffer_pool = NULL;
 	}
@@ -78,6 +78,7 @@ struct _GstImx2dVideoTransform
 	gboolean input_crop;
 	GstVideoOrientationMethod video_direction;
 	gboolean disable_passthrough;
+	guint overlay_cache_max_size;
 
 	GstVideoOrientationMethod tag_video_direction;
 };
@@ -0,0 +1,68 @@
+/* gstreamer-imx: GStreamer plugins for the i.MX SoCs
+ * Copyright (C) 2026  agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <gst/gst.h>
+#include "gst/imx/video/gstimxvideoworkerpool.h"
+#include "imx2d/backend/cpu/cpu_blitter.h"
+#include "gstimxcpublitter.h"
+
+
+typedef struct
+{
+	Imx2dCpuBlitterBandFunc band_func;
+	void *band_data;
+}
+GstImxCPUBlitterBands;
+
+
+static void gst_imx_cpu_blitter_process_band(guint band_index, guint num_bands, gpointer user_data)
+{
+	GstImxCPUBlitterBands *bands = (GstImxCPUBlitterBands *)user_data;
+	bands->band_func((int)band_index, (int)num_bands, bands->band_data);
+}
+
+
+static void gst_imx_cpu_blitter_run_bands(int num_bands, Imx2dCpuBlitterBandFunc band_func, void *band_data, void *user_data)
+{
+	GstImxCPUBlitterBands bands = { band_func, band_data };
+	gst_imx_video_worker_pool_run((GstImxVideoWorkerPool *)user_data, num_bands, gst_imx_cpu_blitter_process_band, &bands);
+}
+
+
+Imx2dBlitter* gst_imx_cpu_blitter_create(void)
+{
+	Imx2dBlitter *blitter;
+	GstImxVideoWorkerPool *worker_pool;
+
+	blitter = imx_2d_backend_cpu_blitter_create();
+	if (blitter == NULL)
+		return NULL;
+
+	worker_pool = gst_imx_video_worker_pool_get_default();
+	if (worker_pool != NULL)
+	{
+		imx_2d_backend_cpu_blitter_set_band_runner(
+			blitter,
+			gst_imx_cpu_blitter_run_bands,
+			gst_imx_video_worker_pool_get_num_threads(worker_pool),
+			worker_pool
+		);
+	}
+
+	return blitter;
+}
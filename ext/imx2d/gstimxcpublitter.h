@@ -0,0 +1,39 @@
+/* gstreamer-imx: GStreamer plugins for the i.MX SoCs
+ * Copyright (C) 2026  agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef GST_IMX_CPU_BLITTER_H
+#define GST_IMX_CPU_BLITTER_H
+
+#include <gst/gst.h>
+#include "imx2d/imx2d.h"
+
+
+G_BEGIN_DECLS
+
+
+/* Creates an imx2d CPU blitter that splits its work across the threads
+ * of the default GstImxVideoWorkerPool. Used by the create_blitter vfuncs
+ * of the CPU based elements. The number of threads is read once here,
+ * so changes to it are picked up the next time the element is started. */
+Imx2dBlitter* gst_imx_cpu_blitter_create(void);
+
+
+G_END_DECLS
+
+
+#endif /* GST_IMX_CPU_BLITTER_H */
@@ -21,6 +21,7 @@
 
 #ifdef WITH_GST_IMX2D_COMPOSITOR
 #include "gstimxg2dcompositor.h"
+#include "gstimxcpucompositor.h"
 #endif
 
 #ifdef WITH_GST_IMX2D_VIDEOSINK
@@ -31,6 +32,7 @@
 #include "gstimxg2dvideotransform.h"
 #include "gstimxipuvideotransform.h"
 #include "gstimxpxpvideotransform.h"
+#include "gstimxcpuvideotransform.h"
 
 
 static gboolean plugin_init(GstPlugin *plugin)
@@ -58,6 +60,13 @@ static gboolean plugin_init(GstPlugin *plugin)
 	ret = ret && gst_element_register(plugin, "imxpxpvideotransform", GST_RANK_NONE, gst_imx_pxp_video_transform_get_type());
 #endif
 
+#ifdef WITH_IMX2D_CPU_BACKEND
+#ifdef WITH_GST_IMX2D_COMPOSITOR
+	ret = ret && gst_element_register(plugin, "imxcpucompositor", GST_RANK_NONE, gst_imx_cpu_compositor_get_type());
+#endif
+	ret = ret && gst_element_register(plugin, "imxcpuvideotransform", GST_RANK_NONE, gst_imx_cpu_video_transform_get_type());
+#endif
+
 	return ret;
 }
 
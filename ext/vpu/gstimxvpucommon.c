@@ -16,9 +16,16 @@
  * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
  */
 
+/* clock_gettime() and CLOCK_THREAD_CPUTIME_ID
+ * are not part of plain C99. */
+#define _POSIX_C_SOURCE 200112L
+
 #include <config.h>
 #include <stdarg.h>
+#include <string.h>
+#include <time.h>
 #include <gst/gst.h>
+#include <gst/base/gstbitreader.h>
 #include <gst/video/video.h>
 #include <imxvpuapi2/imxvpuapi2.h>
 #include "gstimxvpucommon.h"
@@ -28,7 +35,7 @@ GST_DEBUG_CATEGORY_STATIC(imx_vpu_api_debug);
 GST_DEBUG_CATEGORY_EXTERN(gst_imx_vpu_common_debug);
 
 
-static gboolean gst_imx_vpu_h264_is_frame_reordering_required(GstStructure *format);
+static gboolean gst_imx_vpu_h264_is_frame_reordering_required(GstStructure *format, gboolean low_latency);
 
 
 static GstImxVpuCodecDetails const decoder_details_table[NUM_IMX_VPU_API_COMPRESSION_FORMATS] =
@@ -69,6 +76,463 @@ GstImxVpuCodecDetails const * gst_imx_vpu_get_codec_details(ImxVpuApiCompression
 }
 
 
+static GstClockTime gst_imx_vpu_get_thread_cpu_time(void)
+{
+	struct timespec ts;
+
+	if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0)
+		return 0;
+
+	return GST_TIMESPEC_TO_TIME(ts);
+}
+
+
+void gst_imx_vpu_processing_stats_reset(GstImxVpuProcessingStats *stats)
+{
+	memset(stats, 0, sizeof(GstImxVpuProcessingStats));
+}
+
+
+void gst_imx_vpu_processing_stats_begin_section(GstImxVpuProcessingStats *stats)
+{
+	stats->section_wall_start_time = g_get_monotonic_time() * GST_USECOND;
+	stats->section_cpu_start_time = gst_imx_vpu_get_thread_cpu_time();
+}
+
+
+void gst_imx_vpu_processing_stats_suspend_section(GstImxVpuProcessingStats *stats)
+{
+	stats->total_wall_time += g_get_monotonic_time() * GST_USECOND - stats->section_wall_start_time;
+	stats->total_cpu_time += gst_imx_vpu_get_thread_cpu_time() - stats->section_cpu_start_time;
+}
+
+
+void gst_imx_vpu_processing_stats_resume_section(GstImxVpuProcessingStats *stats)
+{
+	gst_imx_vpu_processing_stats_begin_section(stats);
+}
+
+
+void gst_imx_vpu_processing_stats_end_section(GstImxVpuProcessingStats *stats, guint num_finished_frames)
+{
+	gst_imx_vpu_processing_stats_suspend_section(stats);
+	stats->num_frames += num_finished_frames;
+}
+
+
+
+
+/* h.264 SPS parsing. Only the parts that are needed for getting to the
+ * VUI bitstream restriction values are interpreted; everything else is
+ * skipped. See section 7.3.2.1.1 (SPS syntax), E.1.1 (VUI syntax) and
+ * E.1.2 (HRD syntax) in the h.264 specification. */
+
+#define H264_NAL_UNIT_TYPE_SPS 7
+
+#define READ_BITS(NUM_BITS) \
+	G_STMT_START { \
+		if (!gst_bit_reader_get_bits_uint32(&reader, &value, (NUM_BITS))) \
+			goto truncated; \
+	} G_STMT_END
+
+#define SKIP_BITS(NUM_BITS) \
+	G_STMT_START { \
+		if (!gst_bit_reader_skip(&reader, (NUM_BITS))) \
+			goto truncated; \
+	} G_STMT_END
+
+#define READ_UE() \
+	G_STMT_START { \
+		if (!gst_imx_vpu_h264_read_ue(&reader, &value)) \
+			goto truncated; \
+	} G_STMT_END
+
+
+static gboolean gst_imx_vpu_h264_read_ue(GstBitReader *reader, guint32 *value)
+{
+	/* Reads an unsigned Exp-Golomb coded value. Signed values
+	 * are read with this as well, since they are only skipped. */
+
+	guint num_leading_zero_bits = 0;
+	guint32 bit, suffix;
+
+	while (TRUE)
+	{
+		if (!gst_bit_reader_get_bits_uint32(reader, &bit, 1))
+			return FALSE;
+		if (bit)
+			break;
+
+		/* Valid values fit in 32 bits, so there cannot be more
+		 * than 31 leading zero bits. */
+		if (++num_leading_zero_bits > 31)
+			return FALSE;
+	}
+
+	if (num_leading_zero_bits == 0)
+	{
+		*value = 0;
+		return TRUE;
+	}
+
+	if (!gst_bit_reader_get_bits_uint32(reader, &suffix, num_leading_zero_bits))
+		return FALSE;
+
+	*value = ((((guint32)1) << num_leading_zero_bits) - 1) + suffix;
+	return TRUE;
+}
+
+
+static gboolean gst_imx_vpu_h264_skip_scaling_list(GstBitReader *reader, guint size)
+{
+	guint i;
+	gint last_scale = 8, next_scale = 8;
+	guint32 code;
+
+	for (i = 0; i < size; ++i)
+	{
+		if (next_scale != 0)
+		{
+			gint64 delta_scale;
+
+			if (!gst_imx_vpu_h264_read_ue(reader, &code))
+				return FALSE;
+
+			/* Convert the ue(v) code to the se(v) value. */
+			delta_scale = (code & 1) ? ((gint64)(code >> 1) + 1) : -((gint64)(code >> 1));
+			if ((delta_scale < -128) || (delta_scale > 127))
+				return FALSE;
+
+			next_scale = (last_scale + (gint)delta_scale + 256) % 256;
+		}
+
+		if (next_scale != 0)
+			last_scale = next_scale;
+	}
+
+	return TRUE;
+}
+
+
+static gboolean gst_imx_vpu_h264_skip_hrd_parameters(GstBitReader *reader)
+{
+	guint32 cpb_cnt_minus1, value;
+	guint i;
+
+	if (!gst_imx_vpu_h264_read_ue(reader, &cpb_cnt_minus1) || (cpb_cnt_minus1 > 31))
+		return FALSE;
+
+	/* bit_rate_scale and cpb_size_scale */
+	if (!gst_bit_reader_skip(reader, 4 + 4))
+		return FALSE;
+
+	for (i = 0; i <= cpb_cnt_minus1; ++i)
+	{
+		/* bit_rate_value_minus1, cpb_size_value_minus1, cbr_flag */
+		if (!gst_imx_vpu_h264_read_ue(reader, &value) || !gst_imx_vpu_h264_read_ue(reader, &value) || !gst_bit_reader_skip(reader, 1))
+			return FALSE;
+	}
+
+	/* initial_cpb_removal_delay_length_minus1, cpb_removal_delay_length_minus1,
+	 * dpb_output_delay_length_minus1, time_offset_length */
+	return gst_bit_reader_skip(reader, 5 + 5 + 5 + 5);
+}
+
+
+static gboolean gst_imx_vpu_h264_parse_sps_reorder_info(guint8 const *nal_unit, gsize nal_unit_size, GstImxVpuH264ReorderInfo *reorder_info)
+{
+	/* nal_unit points to the NAL unit header byte, and
+	 * nal_unit_size does not include any start code. */
+
+	gboolean ret = FALSE;
+	guint8 *rbsp;
+	gsize rbsp_size, i;
+	guint num_zero_bytes;
+	GstBitReader reader;
+	guint32 value;
+	guint32 profile_idc, constraint_set3_flag, chroma_format_idc = 1;
+	gboolean nal_hrd_present, vcl_hrd_present;
+
+	if ((nal_unit_size < 2) || ((nal_unit[0] & 0x1F) != H264_NAL_UNIT_TYPE_SPS))
+		return FALSE;
+
+	/* Remove the emulation prevention bytes (the 0x03 byte in
+	 * 0x00 0x00 0x03 sequences) to get the raw SPS payload. */
+	rbsp = g_malloc(nal_unit_size - 1);
+	rbsp_size = 0;
+	num_zero_bytes = 0;
+	for (i = 1; i < nal_unit_size; ++i)
+	{
+		if ((num_zero_bytes >= 2) && (nal_unit[i] == 0x03))
+		{
+			num_zero_bytes = 0;
+			continue;
+		}
+
+		num_zero_bytes = (nal_unit[i] == 0x00) ? (num_zero_bytes + 1) : 0;
+		rbsp[rbsp_size++] = nal_unit[i];
+	}
+
+	gst_bit_reader_init(&reader, rbsp, rbsp_size);
+
+	READ_BITS(8);
+	profile_idc = value;
+	READ_BITS(8);
+	constraint_set3_flag = (value >> 4) & 1;
+	/* level_idc */
+	SKIP_BITS(8);
+	/* seq_parameter_set_id */
+	READ_UE();
+
+	switch (profile_idc)
+	{
+		case 100: case 110: case 122: case 244: case 44:
+		case 83: case 86: case 118: case 128: case 138:
+		case 139: case 134: case 135:
+		{
+			guint num_scaling_lists;
+
+			READ_UE();
+			chroma_format_idc = value;
+			if (chroma_format_idc == 3)
+				SKIP_BITS(1); /* separate_colour_plane_flag */
+
+			READ_UE(); /* bit_depth_luma_minus8 */
+			READ_UE(); /* bit_depth_chroma_minus8 */
+			SKIP_BITS(1); /* qpprime_y_zero_transform_bypass_flag */
+
+			READ_BITS(1); /* seq_scaling_matrix_present_flag */
+			if (value)
+			{
+				num_scaling_lists = (chroma_format_idc != 3) ? 8 : 12;
+				for (i = 0; i < num_scaling_lists; ++i)
+				{
+					READ_BITS(1); /* seq_scaling_list_present_flag */
+					if (value && !gst_imx_vpu_h264_skip_scaling_list(&reader, (i < 6) ? 16 : 64))
+						goto truncated;
+				}
+			}
+
+			break;
+		}
+
+		default:
+			break;
+	}
+
+	READ_UE(); /* log2_max_frame_num_minus4 */
+
+	READ_UE(); /* pic_order_cnt_type */
+	if (value == 0)
+	{
+		READ_UE(); /* log2_max_pic_order_cnt_lsb_minus4 */
+	}
+	else if (value == 1)
+	{
+		guint32 num_ref_frames_in_pic_order_cnt_cycle;
+
+		SKIP_BITS(1); /* delta_pic_order_always_zero_flag */
+		READ_UE(); /* offset_for_non_ref_pic */
+		READ_UE(); /* offset_for_top_to_bottom_field */
+		READ_UE();
+		num_ref_frames_in_pic_order_cnt_cycle = value;
+		if (num_ref_frames_in_pic_order_cnt_cycle > 255)
+			goto truncated;
+		for (i = 0; i < num_ref_frames_in_pic_order_cnt_cycle; ++i)
+			READ_UE(); /* offset_for_ref_frame */
+	}
+
+	READ_UE(); /* max_num_ref_frames */
+	SKIP_BITS(1); /* gaps_in_frame_num_value_allowed_flag */
+	READ_UE(); /* pic_width_in_mbs_minus1 */
+	READ_UE(); /* pic_height_in_map_units_minus1 */
+
+	READ_BITS(1); /* frame_mbs_only_flag */
+	if (!value)
+		SKIP_BITS(1); /* mb_adaptive_frame_field_flag */
+
+	SKIP_BITS(1); /* direct_8x8_inference_flag */
+
+	READ_BITS(1); /* frame_cropping_flag */
+	if (value)
+	{
+		READ_UE(); /* frame_crop_left_offset */
+		READ_UE(); /* frame_crop_right_offset */
+		READ_UE(); /* frame_crop_top_offset */
+		READ_UE(); /* frame_crop_bottom_offset */
+	}
+
+	READ_BITS(1); /* vui_parameters_present_flag */
+	if (!value)
+		goto no_bitstream_restriction;
+
+	READ_BITS(1); /* aspect_ratio_info_present_flag */
+	if (value)
+	{
+		READ_BITS(8); /* aspect_ratio_idc */
+		if (value == 255) /* Extended_SAR */
+			SKIP_BITS(16 + 16); /* sar_width, sar_height */
+	}
+
+	READ_BITS(1); /* overscan_info_present_flag */
+	if (value)
+		SKIP_BITS(1); /* overscan_appropriate_flag */
+
+	READ_BITS(1); /* video_signal_type_present_flag */
+	if (value)
+	{
+		SKIP_BITS(3 + 1); /* video_format, video_full_range_flag */
+		READ_BITS(1); /* colour_description_present_flag */
+		if (value)
+			SKIP_BITS(8 + 8 + 8); /* colour_primaries, transfer_characteristics, matrix_coefficients */
+	}
+
+	READ_BITS(1); /* chroma_loc_info_present_flag */
+	if (value)
+	{
+		READ_UE(); /* chroma_sample_loc_type_top_field */
+		READ_UE(); /* chroma_sample_loc_type_bottom_field */
+	}
+
+	READ_BITS(1); /* timing_info_present_flag */
+	if (value)
+		SKIP_BITS(32 + 32 + 1); /* num_units_in_tick, time_scale, fixed_frame_rate_flag */
+
+	READ_BITS(1);
+	nal_hrd_present = !!value;
+	if (nal_hrd_present && !gst_imx_vpu_h264_skip_hrd_parameters(&reader))
+		goto truncated;
+
+	READ_BITS(1);
+	vcl_hrd_present = !!value;
+	if (vcl_hrd_present && !gst_imx_vpu_h264_skip_hrd_parameters(&reader))
+		goto truncated;
+
+	if (nal_hrd_present || vcl_hrd_present)
+		SKIP_BITS(1); /* low_delay_hrd_flag */
+
+	SKIP_BITS(1); /* pic_struct_present_flag */
+
+	READ_BITS(1); /* bitstream_restriction_flag */
+	if (!value)
+		goto no_bitstream_restriction;
+
+	SKIP_BITS(1); /* motion_vectors_over_pic_boundaries_flag */
+	READ_UE(); /* max_bytes_per_pic_denom */
+	READ_UE(); /* max_bits_per_mb_denom */
+	READ_UE(); /* log2_max_mv_length_horizontal */
+	READ_UE(); /* log2_max_mv_length_vertical */
+	READ_UE();
+	reorder_info->max_num_reorder_frames = value;
+	READ_UE();
+	reorder_info->max_dec_frame_buffering = value;
+
+	GST_DEBUG("h.264 SPS VUI: max_num_reorder_frames %u max_dec_frame_buffering %u", reorder_info->max_num_reorder_frames, reorder_info->max_dec_frame_buffering);
+
+	ret = TRUE;
+	goto finish;
+
+no_bitstream_restriction:
+	/* Without bitstream restriction values, both values are inferred to
+	 * be 0 for the intra-only profiles (see the semantics of
+	 * max_num_reorder_frames in section E.2.1). For the other profiles,
+	 * they are inferred from the level, so they are not of any use. */
+	switch (profile_idc)
+	{
+		case 44: case 86: case 100: case 110: case 122: case 244:
+			if (constraint_set3_flag)
+			{
+				GST_DEBUG("h.264 SPS has no bitstream restriction values, but signals an intra-only profile");
+				reorder_info->max_num_reorder_frames = 0;
+				reorder_info->max_dec_frame_buffering = 0;
+				ret = TRUE;
+				goto finish;
+			}
+			break;
+
+		default:
+			break;
+	}
+
+	GST_DEBUG("h.264 SPS has no bitstream restriction values");
+	goto finish;
+
+truncated:
+	GST_DEBUG("h.264 SPS is truncated or invalid");
+
+finish:
+	g_free(rbsp);
+	return ret;
+}
+
+#undef READ_BITS
+#undef SKIP_BITS
+#undef READ_UE
+
+
+gboolean gst_imx_vpu_h264_get_reorder_info_from_codec_data(guint8 const *codec_data, gsize codec_data_size, GstImxVpuH264ReorderInfo *reorder_info)
+{
+	guint num_sps;
+	gsize sps_size;
+
+	g_assert(reorder_info != NULL);
+
+	/* The AVCDecoderConfigurationRecord starts with configurationVersion,
+	 * AVCProfileIndication, profile_compatibility, AVCLevelIndication,
+	 * lengthSizeMinusOne, and numOfSequenceParameterSets. The first
+	 * SPS follows, prefixed by its 16-bit size. */
+	if ((codec_data == NULL) || (codec_data_size < 8) || (codec_data[0] != 1))
+		return FALSE;
+
+	num_sps = codec_data[5] & 0x1F;
+	if (num_sps == 0)
+		return FALSE;
+
+	sps_size = GST_READ_UINT16_BE(codec_data + 6);
+	if (sps_size > (codec_data_size - 8))
+		return FALSE;
+
+	return gst_imx_vpu_h264_parse_sps_reorder_info(codec_data + 8, sps_size, reorder_info);
+}
+
+
+gboolean gst_imx_vpu_h264_get_reorder_info_from_byte_stream(guint8 const *data, gsize data_size, GstImxVpuH264ReorderInfo *reorder_info)
+{
+	gsize offset = 0;
+	gsize nal_unit_start = 0;
+	gboolean in_nal_unit = FALSE;
+
+	g_assert(reorder_info != NULL);
+
+	if (data == NULL)
+		return FALSE;
+
+	/* Look for 0x00 0x00 0x01 start codes. The NAL unit ends at the next
+	 * start code or at the end of the data. Trailing zero bytes in front
+	 * of a start code do not matter, since the SPS parser only reads up
+	 * to the bitstream restriction values. */
+	while ((offset + 3) <= data_size)
+	{
+		if ((data[offset] == 0x00) && (data[offset + 1] == 0x00) && (data[offset + 2] == 0x01))
+		{
+			if (in_nal_unit && ((data[nal_unit_start] & 0x1F) == H264_NAL_UNIT_TYPE_SPS))
+				return gst_imx_vpu_h264_parse_sps_reorder_info(data + nal_unit_start, offset - nal_unit_start, reorder_info);
+
+			offset += 3;
+			nal_unit_start = offset;
+			in_nal_unit = (nal_unit_start < data_size);
+		}
+		else
+			offset++;
+	}
+
+	if (in_nal_unit && ((data[nal_unit_start] & 0x1F) == H264_NAL_UNIT_TYPE_SPS))
+		return gst_imx_vpu_h264_parse_sps_reorder_info(data + nal_unit_start, data_size - nal_unit_start, reorder_info);
+
+	return FALSE;
+}
+
+
 gboolean gst_imx_vpu_get_caps_for_format(ImxVpuApiCompressionFormat compression_format, ImxVpuApiCompressionFormatSupportDetails const *details, GstCaps **encoded_caps, GstCaps **raw_caps, gboolean for_encoder)
 {
 	size_t i;
@@ -422,7 +886,7 @@ gboolean gst_imx_vpu_get_caps_for_format(ImxVpuApiCompressionFormat compression_
 }
 
 
-static gboolean gst_imx_vpu_h264_is_frame_reordering_required(GstStructure *format)
+static gboolean gst_imx_vpu_h264_is_frame_reordering_required(GstStructure *format, gboolean low_latency)
 {
 	gchar const *media_type_str;
 	gchar const *profile_str;
@@ -437,8 +901,19 @@ static gboolean gst_imx_vpu_h264_is_frame_reordering_required(GstStructure *form
 	g_assert(g_strcmp0(media_type_str, "video/x-h264") == 0);
 
 	profile_str = gst_structure_get_string(format, "profile");
+	if (profile_str == NULL)
+		return TRUE;
 
-	return (profile_str == NULL) || ((g_strcmp0(profile_str, "constrained-baseline") != 0) && (g_strcmp0(profile_str, "baseline") != 0));
+	if ((g_strcmp0(profile_str, "constrained-baseline") == 0) || (g_strcmp0(profile_str, "baseline") == 0))
+		return FALSE;
+
+	/* The constrained high profile does not allow for B slices either.
+	 * Since this has been less widely tested with the various VPUs,
+	 * only disable frame reordering for it in low-latency mode. */
+	if (low_latency && (g_strcmp0(profile_str, "constrained-high") == 0))
+		return FALSE;
+
+	return TRUE;
 }
 
 
@@ -553,6 +1028,27 @@ gboolean gst_imx_vpu_color_format_is_semi_planar(GstVideoFormat gst_video_format
 }
 
 
+gboolean gst_imx_vpu_compression_format_can_reorder_frames(ImxVpuApiCompressionFormat compression_format)
+{
+	/* These formats have no B-frames or similar constructs,
+	 * so frames are always output in decoding order. */
+	switch (compression_format)
+	{
+		case IMX_VPU_API_COMPRESSION_FORMAT_JPEG:
+		case IMX_VPU_API_COMPRESSION_FORMAT_WEBP:
+		case IMX_VPU_API_COMPRESSION_FORMAT_H263:
+		case IMX_VPU_API_COMPRESSION_FORMAT_VP6:
+		case IMX_VPU_API_COMPRESSION_FORMAT_VP7:
+		case IMX_VPU_API_COMPRESSION_FORMAT_VP8:
+		case IMX_VPU_API_COMPRESSION_FORMAT_SORENSON_SPARK:
+			return FALSE;
+
+		default:
+			return TRUE;
+	}
+}
+
+
 gboolean gst_imx_vpu_color_format_has_10bit(GstVideoFormat gst_video_format)
 {
 	GstVideoFormatInfo const *format_info = gst_video_format_get_info(gst_video_format);
@@ -81,8 +81,10 @@ struct _GstImxVpuCodecDetails
 	ImxVpuApiCompressionFormat compression_format;
     /* Determines whether or not frame reodering is needed depending on
      * the format in the GstStructure. If this is NULL, frame reodering
-     * is enabled by default. */
-    gboolean (*is_frame_reordering_required)(GstStructure *format);
+     * is enabled by default. low_latency is the value of the decoder's
+     * low-latency property; checks that change the default behavior
+     * are only done if it is TRUE. */
+    gboolean (*is_frame_reordering_required)(GstStructure *format, gboolean low_latency);
 	/* If TRUE, then out-of-band codec data is required for decoding.
 	 * Unused in encoders. */
 	gboolean requires_codec_data;
@@ -102,6 +104,73 @@ GstImxVpuCodecDetails const * gst_imx_vpu_get_codec_details(ImxVpuApiCompression
 
 
 
+/* Per-frame processing cost statistics for the en- and decoder loops.
+ *
+ * These accumulate the time that is spent in one processing section (the
+ * loops in gst_imx_vpu_dec_decode_queued_frames() and
+ * gst_imx_vpu_enc_encode_queued_frames()) along with the number of frames
+ * that were finished in there. Pushing frames downstream is not part of
+ * the processing cost, so the section is suspended around the calls that
+ * finish frames, since these calls block until downstream is done with
+ * the frame (or until there is room in the output queue if the decoder
+ * uses an output task). Time is measured both as wall clock time
+ * and as CPU time of the calling thread. The wall clock time includes
+ * waiting for the VPU, the CPU time does not, so the latter approximates
+ * the CPU cost of the element and libimxvpuapi per frame. Averages are
+ * logged when the elements are stopped, which allows for comparing runs
+ * and spotting regressions. */
+
+typedef struct
+{
+	guint64 num_frames;
+	GstClockTime total_wall_time;
+	GstClockTime total_cpu_time;
+
+	/* Timestamps from gst_imx_vpu_processing_stats_begin_section(). */
+	GstClockTime section_wall_start_time;
+	GstClockTime section_cpu_start_time;
+}
+GstImxVpuProcessingStats;
+
+void gst_imx_vpu_processing_stats_reset(GstImxVpuProcessingStats *stats);
+void gst_imx_vpu_processing_stats_begin_section(GstImxVpuProcessingStats *stats);
+void gst_imx_vpu_processing_stats_suspend_section(GstImxVpuProcessingStats *stats);
+void gst_imx_vpu_processing_stats_resume_section(GstImxVpuProcessingStats *stats);
+void gst_imx_vpu_processing_stats_end_section(GstImxVpuProcessingStats *stats, guint num_finished_frames);
+
+
+
+/* h.264 frame reordering information from the sequence parameter set (SPS).
+ *
+ * The caps only contain the h.264 profile, which says whether or not a
+ * stream _may_ reorder frames. The SPS VUI bitstream restriction values
+ * say how many frames a stream actually reorders at most, and how many
+ * frames the decoder has to keep in its decoded picture buffer. Many
+ * live streams (cameras for example) signal max_num_reorder_frames = 0
+ * there even if they use the main or high profile. This is used by the
+ * decoder's low-latency mode. */
+
+typedef struct
+{
+	/* Maximum number of frames that precede any frame in decoding
+	 * order and follow it in output order. */
+	guint max_num_reorder_frames;
+	/* Required size of the decoded picture buffer, in frames. */
+	guint max_dec_frame_buffering;
+}
+GstImxVpuH264ReorderInfo;
+
+/* Parses the first SPS in AVCDecoderConfigurationRecord codec data (the
+ * codec_data of "avc" and "avc3" h.264 streams). Returns TRUE if an SPS was
+ * found that signals the reordering information, FALSE otherwise. */
+gboolean gst_imx_vpu_h264_get_reorder_info_from_codec_data(guint8 const *codec_data, gsize codec_data_size, GstImxVpuH264ReorderInfo *reorder_info);
+/* Like gst_imx_vpu_h264_get_reorder_info_from_codec_data(), except that this
+ * parses the first SPS in Annex B byte-stream data (NAL units with start
+ * codes). Useful for the in-band SPS in "byte-stream" h.264 streams. */
+gboolean gst_imx_vpu_h264_get_reorder_info_from_byte_stream(guint8 const *data, gsize data_size, GstImxVpuH264ReorderInfo *reorder_info);
+
+
+
 /* Miscellaneous functions. */
 
 gboolean gst_imx_vpu_get_caps_for_format(ImxVpuApiCompressionFormat compression_format, ImxVpuApiCompressionFormatSupportDetails const *details, GstCaps **encoded_caps, GstCaps **raw_caps, gboolean for_encoder);
@@ -111,6 +180,8 @@ guint gst_imx_vpu_get_default_quantization(ImxVpuApiCompressionFormatSupportDeta
 gboolean gst_imx_vpu_color_format_to_gstvidfmt(GstVideoFormat *gst_video_format, ImxVpuApiColorFormat imxvpuapi_format);
 gboolean gst_imx_vpu_color_format_from_gstvidfmt(ImxVpuApiColorFormat *imxvpuapi_format, GstVideoFormat gst_video_format);
 
+gboolean gst_imx_vpu_compression_format_can_reorder_frames(ImxVpuApiCompressionFormat compression_format);
+
 gboolean gst_imx_vpu_color_format_is_semi_planar(GstVideoFormat gst_video_format);
 gboolean gst_imx_vpu_color_format_has_10bit(GstVideoFormat gst_video_format);
 
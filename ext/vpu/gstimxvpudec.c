@@ -16,6 +16,8 @@
  * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
  */
 
+#include <config.h>
+
 #include <gst/gst.h>
 #include <gst/allocators/allocators.h>
 #include <gst/video/gstvideodecoder.h>
@@ -24,16 +26,49 @@
 #include <imxdmabuffer/imxdmabuffer_config.h>
 #include <imxvpuapi2/imxvpuapi2.h>
 #include "gst/imx/common/gstimxdmabufferallocator.h"
+#include "gst/imx/common/gstimxmemoryrecycler.h"
 #include "gstimxvpudec.h"
 #include "gstimxvpudeccontext.h"
 #include "gstimxvpudecbufferpool.h"
 #include "gstimxvpucommon.h"
 
+#if defined(WITH_IMX2D_G2D_BACKEND) || defined(WITH_IMX2D_PXP_BACKEND) || defined(WITH_IMX2D_IPU_BACKEND)
+#define GST_IMX_VPU_DEC_WITH_BLITTER
+#include "imx2d/imx2d.h"
+#endif
+#ifdef WITH_IMX2D_G2D_BACKEND
+#include "imx2d/backend/g2d/g2d_blitter.h"
+#endif
+#ifdef WITH_IMX2D_PXP_BACKEND
+#include "imx2d/backend/pxp/pxp_blitter.h"
+#endif
+#ifdef WITH_IMX2D_IPU_BACKEND
+#include "imx2d/backend/ipu/ipu_blitter.h"
+#endif
+
 
 GST_DEBUG_CATEGORY_STATIC(imx_vpu_dec_debug);
 #define GST_CAT_DEFAULT imx_vpu_dec_debug
 
 
+enum
+{
+	PROP_0,
+	PROP_OUTPUT_COPY_METHOD,
+	PROP_ACTIVE_OUTPUT_COPY_METHOD,
+	PROP_OUTPUT_QUEUE_DEPTH,
+	PROP_LOW_LATENCY,
+	PROP_FRAMEBUFFER_CACHE_SIZE
+};
+
+
+#define DEFAULT_OUTPUT_COPY_METHOD GST_IMX_VPU_DEC_OUTPUT_COPY_METHOD_AUTO
+#define DEFAULT_OUTPUT_QUEUE_DEPTH 0
+#define MAX_OUTPUT_QUEUE_DEPTH 32
+#define DEFAULT_LOW_LATENCY FALSE
+#define DEFAULT_FRAMEBUFFER_CACHE_SIZE 0
+
+
 /* This is the base class for decoder elements. Derived classes
  * are not implemented manually. Rather, they are procedurally
  * generated out of information from the GstImxVpuCodecDetails
@@ -76,6 +111,17 @@ struct _GstImxVpuDec
 	/* Current DMA buffer pool. Created in
 	 * gst_imx_vpu_dec_decide_allocation(). */
 	GstImxVpuDecBufferPool *dma_buffer_pool;
+	/* Cache for the DMA memory of the framebuffers of DMA buffer
+	 * pools, so that the memory of a previous pool can be reused
+	 * after a stream change. Only created in gst_imx_vpu_dec_start()
+	 * if the framebuffer-cache-size property is nonzero. Shut down in
+	 * gst_imx_vpu_dec_stop(). framebuffer_cache_size is the value of
+	 * that property, protected by the object lock. The cache is filled
+	 * with framebuffer memory in the first gst_imx_vpu_dec_decide_allocation()
+	 * call after start; framebuffer_cache_prefilled is set once that is done. */
+	GstImxMemoryRecycler *framebuffer_cache;
+	guint framebuffer_cache_size;
+	gboolean framebuffer_cache_prefilled;
 	/* The "nonvideometa pool" is used when the frames the VPU
 	 * outputs aren't "tightly packed". See need_to_copy_output_frames
 	 * below for details. */
@@ -115,6 +161,31 @@ struct _GstImxVpuDec
 	 * cleared once the decoder is restarted. */
 	gboolean fatal_error_cannot_decode;
 
+	/* Per-frame processing cost of gst_imx_vpu_dec_decode_queued_frames().
+	 * Reset in gst_imx_vpu_dec_start(), logged in gst_imx_vpu_dec_stop(). */
+	GstImxVpuProcessingStats processing_stats;
+
+	/* Value of the low-latency property. Protected by the object lock. */
+	gboolean low_latency;
+
+	/* Decode latency statistics, that is, the time between pushing an
+	 * encoded frame into the VPU and getting the decoded frame back.
+	 * Only measured if measure_decode_latency is TRUE, which is the case
+	 * in low-latency mode or if the debug level is at least DEBUG. The
+	 * time an encoded frame was pushed is stored in its GstVideoCodecFrame
+	 * user data. Reset in gst_imx_vpu_dec_start(), logged in
+	 * gst_imx_vpu_dec_stop(). */
+	gboolean measure_decode_latency;
+	guint64 num_decode_latency_samples;
+	GstClockTime total_decode_latency;
+	GstClockTime max_decode_latency;
+
+	/* h.264 specific low-latency state, set up in gst_imx_vpu_dec_set_format().
+	 * If the caps contain no SPS, open_decoder_at_first_frame is set to TRUE,
+	 * and opening the decoder is deferred until the first frame arrives, so
+	 * that the in-band SPS in that frame can be checked first. */
+	gboolean open_decoder_at_first_frame;
+
 	/* true if the VPU output plane stride & plane offset values are "tightly
 	 * packed", that is, they do not contain extra room for padding bytes. If
 	 * they do, and downstream can't handle videometas, then frames have to
@@ -122,6 +193,47 @@ struct _GstImxVpuDec
 	 * will get frames with padding bytes and not know that these need to be
 	 * skipped. */
 	gboolean need_to_copy_output_frames;
+
+	/* How output frames are copied if need_to_copy_output_frames is TRUE.
+	 * output_copy_method is the method requested by the output-copy-method
+	 * property. active_output_copy_method is the one that is actually used.
+	 * It is picked in gst_imx_vpu_dec_decide_allocation(), and is set to
+	 * the CPU method if no suitable blitter is available. Both are
+	 * protected by the object lock. */
+	GstImxVpuDecOutputCopyMethod output_copy_method;
+	GstImxVpuDecOutputCopyMethod active_output_copy_method;
+
+#ifdef GST_IMX_VPU_DEC_WITH_BLITTER
+	/* Blitter and surfaces for blitter based output frame copies. Only
+	 * non-NULL if a blitter is the active output copy method. Created in
+	 * gst_imx_vpu_dec_decide_allocation(), destroyed together with the
+	 * nonvideometa pool. */
+	Imx2dBlitter *output_copy_blitter;
+	Imx2dSurface *output_copy_source_surface;
+	Imx2dSurface *output_copy_dest_surface;
+#endif
+
+	/* Decoupled output. If the output queue depth is nonzero, decoded
+	 * frames are not finished in the thread that decodes them. Instead,
+	 * they are put into output_queue, and an output task running on the
+	 * srcpad finishes them (see gst_imx_vpu_dec_output_loop()). That way,
+	 * downstream blocking (for example, a sink that waits for vsync) does
+	 * not prevent upstream from feeding the VPU. If the queue is full, the
+	 * decoding thread waits until the output task has finished a frame.
+	 *
+	 * output_queue_depth is the value of the output-queue-depth property
+	 * and is protected by the object lock. current_output_queue_depth is
+	 * copied from it in gst_imx_vpu_dec_start(). The rest is protected by
+	 * output_queue_mutex. num_pending_output_frames is the number of queued
+	 * frames plus the one the output task may currently be finishing. */
+	guint output_queue_depth;
+	guint current_output_queue_depth;
+	GQueue output_queue;
+	guint num_pending_output_frames;
+	gboolean output_queue_flushing;
+	GstFlowReturn output_task_flow_ret;
+	GMutex output_queue_mutex;
+	GCond output_queue_cond;
 };
 
 
@@ -129,7 +241,7 @@ struct _GstImxVpuDecClass
 {
 	GstVideoDecoderClass parent_class;
 
-	gboolean (*is_frame_reordering_required)(GstStructure *format);
+	gboolean (*is_frame_reordering_required)(GstStructure *format, gboolean low_latency);
 
 	/* This is a copy of the flag from the entry from the
 	 * GstImxVpuCodecDetails table that corresponds to the compression
@@ -141,6 +253,38 @@ struct _GstImxVpuDecClass
 G_DEFINE_ABSTRACT_TYPE(GstImxVpuDec, gst_imx_vpu_dec, GST_TYPE_VIDEO_DECODER)
 
 
+GType gst_imx_vpu_dec_output_copy_method_get_type(void)
+{
+	static GType gst_imx_vpu_dec_output_copy_method_type = 0;
+
+	if (!gst_imx_vpu_dec_output_copy_method_type)
+	{
+		static GEnumValue output_copy_method_values[] =
+		{
+			{ GST_IMX_VPU_DEC_OUTPUT_COPY_METHOD_AUTO, "Automatic (first usable 2D blitter, CPU otherwise)", "auto" },
+			{ GST_IMX_VPU_DEC_OUTPUT_COPY_METHOD_CPU, "CPU", "cpu" },
+			{ GST_IMX_VPU_DEC_OUTPUT_COPY_METHOD_G2D, "G2D blitter", "g2d" },
+			{ GST_IMX_VPU_DEC_OUTPUT_COPY_METHOD_PXP, "PxP blitter", "pxp" },
+			{ GST_IMX_VPU_DEC_OUTPUT_COPY_METHOD_IPU, "IPU blitter", "ipu" },
+			{ 0, NULL, NULL },
+		};
+
+		gst_imx_vpu_dec_output_copy_method_type = g_enum_register_static(
+			"GstImxVpuDecOutputCopyMethod",
+			output_copy_method_values
+		);
+	}
+
+	return gst_imx_vpu_dec_output_copy_method_type;
+}
+
+
+static void gst_imx_vpu_dec_finalize(GObject *object);
+static void gst_imx_vpu_dec_set_property(GObject *object, guint prop_id, GValue const *value, GParamSpec *pspec);
+static void gst_imx_vpu_dec_get_property(GObject *object, guint prop_id, GValue *value, GParamSpec *pspec);
+
+static GstStateChangeReturn gst_imx_vpu_dec_change_state(GstElement *element, GstStateChange transition);
+
 static gboolean gst_imx_vpu_dec_start(GstVideoDecoder *decoder);
 static gboolean gst_imx_vpu_dec_stop(GstVideoDecoder *decoder);
 static gboolean gst_imx_vpu_dec_set_format(GstVideoDecoder *decoder, GstVideoCodecState *state);
@@ -150,23 +294,47 @@ static GstFlowReturn gst_imx_vpu_dec_drain(GstVideoDecoder *decoder);
 static GstFlowReturn gst_imx_vpu_dec_finish(GstVideoDecoder *decoder);
 static gboolean gst_imx_vpu_dec_decide_allocation(GstVideoDecoder *decoder, GstQuery *query);
 
+static gboolean gst_imx_vpu_dec_get_h264_reorder_info_from_caps(GstImxVpuDec *imx_vpu_dec, GstCaps *caps, GstImxVpuH264ReorderInfo *reorder_info);
+static void gst_imx_vpu_dec_apply_h264_reorder_info(GstImxVpuDec *imx_vpu_dec, GstImxVpuH264ReorderInfo const *reorder_info);
+static gboolean gst_imx_vpu_dec_open_decoder(GstImxVpuDec *imx_vpu_dec);
 static GstFlowReturn gst_imx_vpu_dec_decode_queued_frames(GstImxVpuDec *imx_vpu_dec);
 static void gst_imx_vpu_dec_teardown_current_decoder(GstImxVpuDec *imx_vpu_dec);
 static void gst_imx_vpu_dec_unref_decoder_context(GstImxVpuDec *imx_vpu_dec);
 static gboolean gst_imx_vpu_dec_allocate_and_add_framebuffers(GstImxVpuDec *imx_vpu_dec, size_t num_framebuffers);
+static void gst_imx_vpu_dec_setup_output_copy_method(GstImxVpuDec *imx_vpu_dec, GstVideoInfo const *vpu_video_info, GstVideoInfo const *output_video_info);
+static void gst_imx_vpu_dec_destroy_output_copy_blitter(GstImxVpuDec *imx_vpu_dec);
 static GstFlowReturn gst_imx_vpu_dec_copy_output_frame_if_needed(GstImxVpuDec *imx_vpu_dec, GstVideoCodecFrame *output_frame);
 
+static void gst_imx_vpu_dec_update_decode_latency(GstImxVpuDec *imx_vpu_dec, GstVideoCodecFrame *decoded_frame);
+
+static GstFlowReturn gst_imx_vpu_dec_finish_output_frame(GstImxVpuDec *imx_vpu_dec, GstVideoCodecFrame *output_frame);
+static GstFlowReturn gst_imx_vpu_dec_output_frame(GstImxVpuDec *imx_vpu_dec, GstVideoCodecFrame *output_frame);
+static GstFlowReturn gst_imx_vpu_dec_wait_for_output_queue(GstImxVpuDec *imx_vpu_dec, guint max_num_pending_frames);
+static void gst_imx_vpu_dec_stop_output_loop(GstImxVpuDec *imx_vpu_dec);
+static void gst_imx_vpu_dec_resume_output_queue(GstImxVpuDec *imx_vpu_dec);
+static void gst_imx_vpu_dec_output_loop(GstImxVpuDec *imx_vpu_dec);
+
 
 static void gst_imx_vpu_dec_class_init(GstImxVpuDecClass *klass)
 {
+	GObjectClass *object_class;
+	GstElementClass *element_class;
 	GstVideoDecoderClass *video_decoder_class;
 
 	gst_imx_vpu_api_setup_logging();
 
 	GST_DEBUG_CATEGORY_INIT(imx_vpu_dec_debug, "imxvpudec", 0, "NXP i.MX VPU video decoder");
 
+	object_class = G_OBJECT_CLASS(klass);
+	element_class = GST_ELEMENT_CLASS(klass);
 	video_decoder_class = GST_VIDEO_DECODER_CLASS(klass);
 
+	object_class->finalize     = GST_DEBUG_FUNCPTR(gst_imx_vpu_dec_finalize);
+	object_class->set_property = GST_DEBUG_FUNCPTR(gst_imx_vpu_dec_set_property);
+	object_class->get_property = GST_DEBUG_FUNCPTR(gst_imx_vpu_dec_get_property);
+
+	element_class->change_state = GST_DEBUG_FUNCPTR(gst_imx_vpu_dec_change_state);
+
 	video_decoder_class->start             = GST_DEBUG_FUNCPTR(gst_imx_vpu_dec_start);
 	video_decoder_class->stop              = GST_DEBUG_FUNCPTR(gst_imx_vpu_dec_stop);
 	video_decoder_class->set_format        = GST_DEBUG_FUNCPTR(gst_imx_vpu_dec_set_format);
@@ -178,6 +346,71 @@ static void gst_imx_vpu_dec_class_init(GstImxVpuDecClass *klass)
 
 	klass->is_frame_reordering_required = NULL;
 	klass->requires_codec_data = FALSE;
+
+	g_object_class_install_property(
+		object_class,
+		PROP_OUTPUT_COPY_METHOD,
+		g_param_spec_enum(
+			"output-copy-method",
+			"Output copy method",
+			"How to remove the padding from decoded frames if downstream cannot handle video meta; "
+			"blitter based methods fall back to the CPU if the blitter is unavailable or cannot handle the frames",
+			gst_imx_vpu_dec_output_copy_method_get_type(),
+			DEFAULT_OUTPUT_COPY_METHOD,
+			G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS
+		)
+	);
+	g_object_class_install_property(
+		object_class,
+		PROP_ACTIVE_OUTPUT_COPY_METHOD,
+		g_param_spec_enum(
+			"active-output-copy-method",
+			"Active output copy method",
+			"Output copy method that is actually used; only meaningful while decoded frames need to be copied",
+			gst_imx_vpu_dec_output_copy_method_get_type(),
+			GST_IMX_VPU_DEC_OUTPUT_COPY_METHOD_CPU,
+			G_PARAM_READABLE | G_PARAM_STATIC_STRINGS
+		)
+	);
+	g_object_class_install_property(
+		object_class,
+		PROP_OUTPUT_QUEUE_DEPTH,
+		g_param_spec_uint(
+			"output-queue-depth",
+			"Output queue depth",
+			"Maximum number of decoded frames that are queued for a separate output thread which pushes them downstream "
+			"(0 = push decoded frames from the decoding thread)",
+			0, MAX_OUTPUT_QUEUE_DEPTH,
+			DEFAULT_OUTPUT_QUEUE_DEPTH,
+			GST_PARAM_MUTABLE_READY | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS
+		)
+	);
+	g_object_class_install_property(
+		object_class,
+		PROP_LOW_LATENCY,
+		g_param_spec_boolean(
+			"low-latency",
+			"Low latency",
+			"Output frames as soon as they are decoded by disabling frame reordering whenever the stream allows for it, "
+			"and log the decode latency of each frame",
+			DEFAULT_LOW_LATENCY,
+			GST_PARAM_MUTABLE_READY | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS
+		)
+	);
+	g_object_class_install_property(
+		object_class,
+		PROP_FRAMEBUFFER_CACHE_SIZE,
+		g_param_spec_uint(
+			"framebuffer-cache-size",
+			"Framebuffer cache size",
+			"Maximum number of bytes of unused framebuffer memory to keep for reuse after stream changes "
+			"instead of freeing and allocating framebuffers again; filled with the stream's framebuffers "
+			"at the first allocation (0 = disabled)",
+			0, G_MAXUINT,
+			DEFAULT_FRAMEBUFFER_CACHE_SIZE,
+			GST_PARAM_MUTABLE_READY | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS
+		)
+	);
 }
 
 
@@ -191,6 +424,9 @@ static void gst_imx_vpu_dec_init(GstImxVpuDec *imx_vpu_dec)
 
 	imx_vpu_dec->decoder_context = NULL;
 	imx_vpu_dec->dma_buffer_pool = NULL;
+	imx_vpu_dec->framebuffer_cache = NULL;
+	imx_vpu_dec->framebuffer_cache_size = DEFAULT_FRAMEBUFFER_CACHE_SIZE;
+	imx_vpu_dec->framebuffer_cache_prefilled = FALSE;
 	imx_vpu_dec->nonvideometa_output_buffer_pool = NULL;
 	imx_vpu_dec->prepared_output_buffer = NULL;
 
@@ -201,6 +437,148 @@ static void gst_imx_vpu_dec_init(GstImxVpuDec *imx_vpu_dec)
 	imx_vpu_dec->default_dma_buf_allocator = NULL;
 
 	imx_vpu_dec->fatal_error_cannot_decode = FALSE;
+
+	imx_vpu_dec->low_latency = DEFAULT_LOW_LATENCY;
+	imx_vpu_dec->measure_decode_latency = FALSE;
+	imx_vpu_dec->open_decoder_at_first_frame = FALSE;
+
+	imx_vpu_dec->output_copy_method = DEFAULT_OUTPUT_COPY_METHOD;
+	imx_vpu_dec->active_output_copy_method = GST_IMX_VPU_DEC_OUTPUT_COPY_METHOD_CPU;
+#ifdef GST_IMX_VPU_DEC_WITH_BLITTER
+	imx_vpu_dec->output_copy_blitter = NULL;
+	imx_vpu_dec->output_copy_source_surface = NULL;
+	imx_vpu_dec->output_copy_dest_surface = NULL;
+#endif
+
+	imx_vpu_dec->output_queue_depth = DEFAULT_OUTPUT_QUEUE_DEPTH;
+	imx_vpu_dec->current_output_queue_depth = 0;
+	g_queue_init(&(imx_vpu_dec->output_queue));
+	imx_vpu_dec->num_pending_output_frames = 0;
+	imx_vpu_dec->output_queue_flushing = FALSE;
+	imx_vpu_dec->output_task_flow_ret = GST_FLOW_OK;
+	g_mutex_init(&(imx_vpu_dec->output_queue_mutex));
+	g_cond_init(&(imx_vpu_dec->output_queue_cond));
+}
+
+
+static void gst_imx_vpu_dec_finalize(GObject *object)
+{
+	GstImxVpuDec *imx_vpu_dec = GST_IMX_VPU_DEC(object);
+	GstVideoCodecFrame *frame;
+
+	/* stop() normally discards queued frames already. This is
+	 * just for the case that the element was never started. */
+	while ((frame = g_queue_pop_head(&(imx_vpu_dec->output_queue))) != NULL)
+		gst_video_codec_frame_unref(frame);
+
+	g_mutex_clear(&(imx_vpu_dec->output_queue_mutex));
+	g_cond_clear(&(imx_vpu_dec->output_queue_cond));
+
+	G_OBJECT_CLASS(gst_imx_vpu_dec_parent_class)->finalize(object);
+}
+
+
+static void gst_imx_vpu_dec_set_property(GObject *object, guint prop_id, GValue const *value, GParamSpec *pspec)
+{
+	GstImxVpuDec *imx_vpu_dec = GST_IMX_VPU_DEC(object);
+
+	switch (prop_id)
+	{
+		case PROP_OUTPUT_COPY_METHOD:
+			GST_OBJECT_LOCK(imx_vpu_dec);
+			imx_vpu_dec->output_copy_method = g_value_get_enum(value);
+			GST_OBJECT_UNLOCK(imx_vpu_dec);
+			break;
+
+		case PROP_OUTPUT_QUEUE_DEPTH:
+			GST_OBJECT_LOCK(imx_vpu_dec);
+			imx_vpu_dec->output_queue_depth = g_value_get_uint(value);
+			GST_OBJECT_UNLOCK(imx_vpu_dec);
+			break;
+
+		case PROP_LOW_LATENCY:
+			GST_OBJECT_LOCK(imx_vpu_dec);
+			imx_vpu_dec->low_latency = g_value_get_boolean(value);
+			GST_OBJECT_UNLOCK(imx_vpu_dec);
+			break;
+
+		case PROP_FRAMEBUFFER_CACHE_SIZE:
+			GST_OBJECT_LOCK(imx_vpu_dec);
+			imx_vpu_dec->framebuffer_cache_size = g_value_get_uint(value);
+			GST_OBJECT_UNLOCK(imx_vpu_dec);
+			break;
+
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+			break;
+	}
+}
+
+
+static void gst_imx_vpu_dec_get_property(GObject *object, guint prop_id, GValue *value, GParamSpec *pspec)
+{
+	GstImxVpuDec *imx_vpu_dec = GST_IMX_VPU_DEC(object);
+
+	switch (prop_id)
+	{
+		case PROP_OUTPUT_COPY_METHOD:
+			GST_OBJECT_LOCK(imx_vpu_dec);
+			g_value_set_enum(value, imx_vpu_dec->output_copy_method);
+			GST_OBJECT_UNLOCK(imx_vpu_dec);
+			break;
+
+		case PROP_ACTIVE_OUTPUT_COPY_METHOD:
+			GST_OBJECT_LOCK(imx_vpu_dec);
+			g_value_set_enum(value, imx_vpu_dec->active_output_copy_method);
+			GST_OBJECT_UNLOCK(imx_vpu_dec);
+			break;
+
+		case PROP_OUTPUT_QUEUE_DEPTH:
+			GST_OBJECT_LOCK(imx_vpu_dec);
+			g_value_set_uint(value, imx_vpu_dec->output_queue_depth);
+			GST_OBJECT_UNLOCK(imx_vpu_dec);
+			break;
+
+		case PROP_LOW_LATENCY:
+			GST_OBJECT_LOCK(imx_vpu_dec);
+			g_value_set_boolean(value, imx_vpu_dec->low_latency);
+			GST_OBJECT_UNLOCK(imx_vpu_dec);
+			break;
+
+		case PROP_FRAMEBUFFER_CACHE_SIZE:
+			GST_OBJECT_LOCK(imx_vpu_dec);
+			g_value_set_uint(value, imx_vpu_dec->framebuffer_cache_size);
+			GST_OBJECT_UNLOCK(imx_vpu_dec);
+			break;
+
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+			break;
+	}
+}
+
+
+static GstStateChangeReturn gst_imx_vpu_dec_change_state(GstElement *element, GstStateChange transition)
+{
+	GstImxVpuDec *imx_vpu_dec = GST_IMX_VPU_DEC(element);
+
+	switch (transition)
+	{
+		case GST_STATE_CHANGE_PAUSED_TO_READY:
+			/* The output task must be stopped before the base class
+			 * deactivates the pads and calls stop(). Otherwise, it
+			 * could still be blocked waiting for queued frames.
+			 * The output queue stays in the flushing state until
+			 * start() is called again, so the streaming thread
+			 * cannot queue frames and restart the task meanwhile. */
+			gst_imx_vpu_dec_stop_output_loop(imx_vpu_dec);
+			break;
+
+		default:
+			break;
+	}
+
+	return GST_ELEMENT_CLASS(gst_imx_vpu_dec_parent_class)->change_state(element, transition);
 }
 
 
@@ -210,11 +588,31 @@ static gboolean gst_imx_vpu_dec_start(GstVideoDecoder *decoder)
 	GstImxVpuDec *imx_vpu_dec = GST_IMX_VPU_DEC(decoder);
 	size_t stream_buffer_size, stream_buffer_alignment;
 	GstAllocationParams alloc_params;
+	guint framebuffer_cache_size;
 	ImxVpuApiCompressionFormat compression_format = GST_IMX_VPU_GET_ELEMENT_COMPRESSION_FORMAT(decoder);
 	GstImxVpuCodecDetails const * codec_details = gst_imx_vpu_get_codec_details(compression_format);
 
 	imx_vpu_dec->fatal_error_cannot_decode = FALSE;
 
+	gst_imx_vpu_processing_stats_reset(&(imx_vpu_dec->processing_stats));
+
+	gst_imx_vpu_dec_resume_output_queue(imx_vpu_dec);
+
+	GST_OBJECT_LOCK(imx_vpu_dec);
+	imx_vpu_dec->current_output_queue_depth = imx_vpu_dec->output_queue_depth;
+	imx_vpu_dec->measure_decode_latency = imx_vpu_dec->low_latency;
+	framebuffer_cache_size = imx_vpu_dec->framebuffer_cache_size;
+	GST_OBJECT_UNLOCK(imx_vpu_dec);
+
+	if (gst_debug_category_get_threshold(imx_vpu_dec_debug) >= GST_LEVEL_DEBUG)
+		imx_vpu_dec->measure_decode_latency = TRUE;
+	imx_vpu_dec->num_decode_latency_samples = 0;
+	imx_vpu_dec->total_decode_latency = 0;
+	imx_vpu_dec->max_decode_latency = 0;
+
+	if (imx_vpu_dec->current_output_queue_depth > 0)
+		GST_DEBUG_OBJECT(imx_vpu_dec, "using output task with a queue depth of %u frame(s)", imx_vpu_dec->current_output_queue_depth);
+
 
 	/* Set up the stream buffer */
 
@@ -252,6 +650,17 @@ static gboolean gst_imx_vpu_dec_start(GstVideoDecoder *decoder)
 		GST_DEBUG_OBJECT(imx_vpu_dec, "not allocating stream buffer since the VPU does not need one");
 
 
+	/* Set up the framebuffer cache. It lives until stop() is called,
+	 * so framebuffer memory can be reused across all stream changes
+	 * until then. */
+
+	imx_vpu_dec->framebuffer_cache_prefilled = FALSE;
+	if (framebuffer_cache_size > 0)
+		imx_vpu_dec->framebuffer_cache = gst_imx_memory_recycler_new(framebuffer_cache_size);
+	else
+		GST_DEBUG_OBJECT(imx_vpu_dec, "not using a framebuffer cache");
+
+
 	/* VPU decoder setup continues in set_format(), since we need to
 	 * know the input caps to fill the open_params structure. */
 
@@ -268,9 +677,54 @@ static gboolean gst_imx_vpu_dec_stop(GstVideoDecoder *decoder)
 	GstImxVpuDec *imx_vpu_dec = GST_IMX_VPU_DEC(decoder);
 	ImxVpuApiCompressionFormat compression_format = GST_IMX_VPU_GET_ELEMENT_COMPRESSION_FORMAT(decoder);
 	GstImxVpuCodecDetails const * codec_details = gst_imx_vpu_get_codec_details(compression_format);
+	GstImxVpuProcessingStats const *stats = &(imx_vpu_dec->processing_stats);
+
+	if (stats->num_frames > 0)
+	{
+		GST_INFO_OBJECT(
+			imx_vpu_dec,
+			"decoded %" G_GUINT64_FORMAT " frame(s); average time per frame: wall clock %" G_GUINT64_FORMAT " us  CPU %" G_GUINT64_FORMAT " us",
+			stats->num_frames,
+			(guint64)(stats->total_wall_time / stats->num_frames / GST_USECOND),
+			(guint64)(stats->total_cpu_time / stats->num_frames / GST_USECOND)
+		);
+	}
+
+	if (imx_vpu_dec->num_decode_latency_samples > 0)
+	{
+		GST_INFO_OBJECT(
+			imx_vpu_dec,
+			"decode latency over %" G_GUINT64_FORMAT " frame(s): average %" G_GUINT64_FORMAT " us  max %" G_GUINT64_FORMAT " us",
+			imx_vpu_dec->num_decode_latency_samples,
+			(guint64)(imx_vpu_dec->total_decode_latency / imx_vpu_dec->num_decode_latency_samples / GST_USECOND),
+			(guint64)(imx_vpu_dec->max_decode_latency / GST_USECOND)
+		);
+	}
+
+	/* The output task is normally already stopped by the PAUSED->READY
+	 * state change. Do it here as well, since this also discards frames
+	 * that are still queued, which in turn releases their framebuffers
+	 * before the decoder is torn down. */
+	gst_imx_vpu_dec_stop_output_loop(imx_vpu_dec);
 
 	gst_imx_vpu_dec_teardown_current_decoder(imx_vpu_dec);
 
+	if (imx_vpu_dec->framebuffer_cache != NULL)
+	{
+		guint64 num_allocations, num_reuses;
+
+		gst_imx_memory_recycler_get_statistics(imx_vpu_dec->framebuffer_cache, &num_allocations, &num_reuses, NULL);
+		GST_INFO_OBJECT(
+			imx_vpu_dec,
+			"framebuffer cache: %" G_GUINT64_FORMAT " memory block(s) allocated, %" G_GUINT64_FORMAT " reused",
+			num_allocations,
+			num_reuses
+		);
+
+		gst_imx_memory_recycler_shutdown(imx_vpu_dec->framebuffer_cache);
+		imx_vpu_dec->framebuffer_cache = NULL;
+	}
+
 	if (imx_vpu_dec->stream_buffer != NULL)
 	{
 		gst_memory_unref(imx_vpu_dec->stream_buffer);
@@ -291,7 +745,6 @@ static gboolean gst_imx_vpu_dec_stop(GstVideoDecoder *decoder)
 
 static gboolean gst_imx_vpu_dec_set_format(GstVideoDecoder *decoder, GstVideoCodecState *state)
 {
-	ImxVpuApiDecReturnCodes dec_ret;
 	GstVideoFormat downstream_format;
 	gboolean ret = TRUE;
 	GstImxVpuDec *imx_vpu_dec = GST_IMX_VPU_DEC_CAST(decoder);
@@ -300,6 +753,8 @@ static gboolean gst_imx_vpu_dec_set_format(GstVideoDecoder *decoder, GstVideoCod
 	ImxVpuApiDecOpenParams *open_params = &(imx_vpu_dec->open_params);
 	GstCaps *allowed_srccaps = NULL;
 	ImxVpuApiCompressionFormat compression_format = GST_IMX_VPU_GET_ELEMENT_COMPRESSION_FORMAT(decoder);
+	gboolean low_latency;
+	gboolean use_frame_reordering;
 
 	GST_DEBUG_OBJECT(decoder, "setting decoder format");
 
@@ -312,6 +767,14 @@ static gboolean gst_imx_vpu_dec_set_format(GstVideoDecoder *decoder, GstVideoCod
 		goto finish;
 	}
 
+	/* Also make sure the output task has pushed all of these
+	 * frames before the decoder and its pools are torn down. */
+	if (gst_imx_vpu_dec_wait_for_output_queue(imx_vpu_dec, 0) != GST_FLOW_OK)
+	{
+		ret = FALSE;
+		goto finish;
+	}
+
 
 
 	/* Cleanup any existing data and states. */
@@ -402,8 +865,19 @@ static gboolean gst_imx_vpu_dec_set_format(GstVideoDecoder *decoder, GstVideoCod
 	/* By default, we want the VPU to reorder the frames. We can keep track of
 	 * this reordering through the GstVideoDecoder system frame numbers. In
 	 * some cases though, it may be beneficial to disable it. It may lower
-	 * latency to turn it off if it is not necessary, for example. */
-	if ((klass->is_frame_reordering_required == NULL) || klass->is_frame_reordering_required(gst_caps_get_structure(state->caps, 0)))
+	 * latency to turn it off if it is not necessary, for example. In
+	 * low-latency mode, it is also turned off for all formats that never
+	 * reorder frames, even if they do not have a format specific check. */
+	GST_OBJECT_LOCK(imx_vpu_dec);
+	low_latency = imx_vpu_dec->low_latency;
+	GST_OBJECT_UNLOCK(imx_vpu_dec);
+
+	if (low_latency && !gst_imx_vpu_compression_format_can_reorder_frames(compression_format))
+		use_frame_reordering = FALSE;
+	else
+		use_frame_reordering = (klass->is_frame_reordering_required == NULL) || klass->is_frame_reordering_required(gst_caps_get_structure(state->caps, 0), low_latency);
+
+	if (use_frame_reordering)
 	{
 		GST_DEBUG_OBJECT(imx_vpu_dec, "using frame reodering");
 		open_params->flags |= IMX_VPU_API_DEC_OPEN_PARAMS_FLAG_ENABLE_FRAME_REORDERING;
@@ -411,6 +885,29 @@ static gboolean gst_imx_vpu_dec_set_format(GstVideoDecoder *decoder, GstVideoCod
 	else
 		GST_DEBUG_OBJECT(imx_vpu_dec, "not using frame reodering");
 
+	/* The h.264 profile alone often is not enough to know whether frames are
+	 * reordered, since many live sources use the main or high profile without
+	 * B frames. In low-latency mode, look at the SPS as well, which may signal
+	 * this explicitly. If the caps do not contain the SPS (the usual case with
+	 * byte-stream data), check the in-band SPS in the first frame instead. */
+	imx_vpu_dec->open_decoder_at_first_frame = FALSE;
+	if (low_latency && (compression_format == IMX_VPU_API_COMPRESSION_FORMAT_H264))
+	{
+		GstImxVpuH264ReorderInfo reorder_info;
+
+		if (gst_imx_vpu_dec_get_h264_reorder_info_from_caps(imx_vpu_dec, state->caps, &reorder_info))
+		{
+			gst_imx_vpu_dec_apply_h264_reorder_info(imx_vpu_dec, &reorder_info);
+		}
+		else
+		{
+			GST_DEBUG_OBJECT(imx_vpu_dec, "no h.264 SPS with reordering information in caps; deferring opening the decoder until the first frame arrives");
+			imx_vpu_dec->open_decoder_at_first_frame = TRUE;
+		}
+	}
+	else if (low_latency && use_frame_reordering)
+		GST_INFO_OBJECT(imx_vpu_dec, "low-latency mode is enabled, but the stream does not signal that it can be decoded without frame reordering; keeping reordering enabled");
+
 
 	/* Check if 10-bit decoding is required. */
 
@@ -458,6 +955,103 @@ static gboolean gst_imx_vpu_dec_set_format(GstVideoDecoder *decoder, GstVideoCod
 	}
 
 
+	/* Ref the codec state, to be able to use it later as reference
+	 * for the gst_video_decoder_set_output_state() function. */
+	imx_vpu_dec->input_state = gst_video_codec_state_ref(state);
+
+
+	if (imx_vpu_dec->open_decoder_at_first_frame)
+	{
+		GST_DEBUG_OBJECT(decoder, "setting format finished; decoder will be opened when the first frame arrives");
+		goto finish;
+	}
+
+	if (!gst_imx_vpu_dec_open_decoder(imx_vpu_dec))
+	{
+		ret = FALSE;
+		goto finish;
+	}
+
+
+	GST_DEBUG_OBJECT(decoder, "setting format finished");
+
+
+finish:
+	if (allowed_srccaps != NULL)
+		gst_caps_unref(allowed_srccaps);
+
+	return ret;
+}
+
+
+static gboolean gst_imx_vpu_dec_get_h264_reorder_info_from_caps(GstImxVpuDec *imx_vpu_dec, GstCaps *caps, GstImxVpuH264ReorderInfo *reorder_info)
+{
+	GValue const *value;
+	GstBuffer *codec_data;
+	GstMapInfo map_info;
+	gboolean found;
+
+	value = gst_structure_get_value(gst_caps_get_structure(caps, 0), "codec_data");
+	if ((value == NULL) || !GST_VALUE_HOLDS_BUFFER(value))
+		return FALSE;
+
+	codec_data = gst_value_get_buffer(value);
+	if (!gst_buffer_map(codec_data, &map_info, GST_MAP_READ))
+		return FALSE;
+
+	/* The codec data is normally an AVCDecoderConfigurationRecord, which
+	 * starts with a configurationVersion byte that is set to 1. Some
+	 * sources however put SPS and PPS in byte-stream form in there. */
+	if ((map_info.size > 0) && (map_info.data[0] == 1))
+		found = gst_imx_vpu_h264_get_reorder_info_from_codec_data(map_info.data, map_info.size, reorder_info);
+	else
+		found = gst_imx_vpu_h264_get_reorder_info_from_byte_stream(map_info.data, map_info.size, reorder_info);
+
+	gst_buffer_unmap(codec_data, &map_info);
+
+	GST_DEBUG_OBJECT(imx_vpu_dec, "found h.264 SPS with reordering information in codec data: %d", found);
+
+	return found;
+}
+
+
+static void gst_imx_vpu_dec_apply_h264_reorder_info(GstImxVpuDec *imx_vpu_dec, GstImxVpuH264ReorderInfo const *reorder_info)
+{
+	/* Only used in low-latency mode. Adjusts the open_params
+	 * flags, so this must be called before the decoder is opened. */
+
+	ImxVpuApiDecOpenParams *open_params = &(imx_vpu_dec->open_params);
+
+	GST_DEBUG_OBJECT(
+		imx_vpu_dec,
+		"h.264 SPS reordering information:  max_num_reorder_frames: %u  max_dec_frame_buffering: %u",
+		reorder_info->max_num_reorder_frames,
+		reorder_info->max_dec_frame_buffering
+	);
+
+	if (reorder_info->max_num_reorder_frames > 0)
+	{
+		if (open_params->flags & IMX_VPU_API_DEC_OPEN_PARAMS_FLAG_ENABLE_FRAME_REORDERING)
+			GST_INFO_OBJECT(imx_vpu_dec, "low-latency mode is enabled, but the h.264 SPS signals up to %u reordered frame(s); keeping reordering enabled", reorder_info->max_num_reorder_frames);
+		return;
+	}
+
+	if (open_params->flags & IMX_VPU_API_DEC_OPEN_PARAMS_FLAG_ENABLE_FRAME_REORDERING)
+	{
+		GST_INFO_OBJECT(imx_vpu_dec, "h.264 SPS signals that frames are not reordered; disabling frame reordering");
+		open_params->flags &= ~IMX_VPU_API_DEC_OPEN_PARAMS_FLAG_ENABLE_FRAME_REORDERING;
+	}
+}
+
+
+static gboolean gst_imx_vpu_dec_open_decoder(GstImxVpuDec *imx_vpu_dec)
+{
+	/* Opens a decoder instance with the open_params that were
+	 * filled in gst_imx_vpu_dec_set_format(). */
+
+	ImxVpuApiDecReturnCodes dec_ret;
+	ImxVpuApiDecOpenParams *open_params = &(imx_vpu_dec->open_params);
+
 	/* Map the codec data since the decoder needs to be
 	  able to access it in the handle_frame() calls. */
 	if (imx_vpu_dec->codec_data != NULL)
@@ -478,7 +1072,7 @@ static gboolean gst_imx_vpu_dec_set_format(GstVideoDecoder *decoder, GstVideoCod
 	/* open_params filled with valid data. Now we can actually open a new VPU
 	 * decoder instance, as a contination from what we began in start().
 	 * (The instance is closed in gst_imx_vpu_dec_context_close_decoder() ). */
-	GST_DEBUG_OBJECT(decoder, "(re)opening decoder");
+	GST_DEBUG_OBJECT(imx_vpu_dec, "(re)opening decoder");
 	if ((dec_ret = imx_vpu_api_dec_open(
 		&(imx_vpu_dec->decoder),
 		open_params,
@@ -486,8 +1080,7 @@ static gboolean gst_imx_vpu_dec_set_format(GstVideoDecoder *decoder, GstVideoCod
 	)) != IMX_VPU_API_DEC_RETURN_CODE_OK)
 	{
 		GST_ERROR_OBJECT(imx_vpu_dec, "could not open decoder: %s", imx_vpu_api_dec_return_code_string(dec_ret));
-		ret = FALSE;
-		goto finish;
+		return FALSE;
 	}
 
 	/* Create new context for the decoder. */
@@ -495,19 +1088,7 @@ static gboolean gst_imx_vpu_dec_set_format(GstVideoDecoder *decoder, GstVideoCod
 	gst_object_ref_sink(GST_OBJECT_CAST(imx_vpu_dec->decoder_context));
 	g_assert(imx_vpu_dec->decoder_context != NULL);
 
-	/* Ref the codec state, to be able to use it later as reference
-	 * for the gst_video_decoder_set_output_state() function. */
-	imx_vpu_dec->input_state = gst_video_codec_state_ref(state);
-
-
-	GST_DEBUG_OBJECT(decoder, "setting format finished");
-
-
-finish:
-	if (allowed_srccaps != NULL)
-		gst_caps_unref(allowed_srccaps);
-
-	return ret;
+	return TRUE;
 }
 
 
@@ -516,6 +1097,36 @@ static GstFlowReturn gst_imx_vpu_dec_handle_frame(GstVideoDecoder *decoder, GstV
 	GstImxVpuDec *imx_vpu_dec = GST_IMX_VPU_DEC_CAST(decoder);
 	GstFlowReturn flow_ret;
 
+	if (G_UNLIKELY(imx_vpu_dec->open_decoder_at_first_frame) && (cur_frame != NULL))
+	{
+		GstMapInfo in_map_info;
+		GstImxVpuH264ReorderInfo reorder_info;
+		gboolean found = FALSE;
+
+		/* Opening the decoder was deferred by gst_imx_vpu_dec_set_format()
+		 * to be able to check the in-band SPS first. If this frame contains
+		 * no SPS, the decoder is opened with the settings from the caps. */
+		imx_vpu_dec->open_decoder_at_first_frame = FALSE;
+
+		if (gst_buffer_map(cur_frame->input_buffer, &in_map_info, GST_MAP_READ))
+		{
+			found = gst_imx_vpu_h264_get_reorder_info_from_byte_stream(in_map_info.data, in_map_info.size, &reorder_info);
+			gst_buffer_unmap(cur_frame->input_buffer, &in_map_info);
+		}
+
+		if (found)
+			gst_imx_vpu_dec_apply_h264_reorder_info(imx_vpu_dec, &reorder_info);
+		else if (imx_vpu_dec->open_params.flags & IMX_VPU_API_DEC_OPEN_PARAMS_FLAG_ENABLE_FRAME_REORDERING)
+			GST_INFO_OBJECT(imx_vpu_dec, "low-latency mode is enabled, but the first frame contains no h.264 SPS with reordering information; keeping reordering enabled");
+
+		if (!gst_imx_vpu_dec_open_decoder(imx_vpu_dec))
+		{
+			gst_video_codec_frame_unref(cur_frame);
+			imx_vpu_dec->fatal_error_cannot_decode = TRUE;
+			return GST_FLOW_ERROR;
+		}
+	}
+
 	if (G_UNLIKELY(imx_vpu_dec->decoder == NULL))
 	{
 		GST_ERROR_OBJECT(imx_vpu_dec, "decoder was not initialized; cannot continue");
@@ -571,6 +1182,13 @@ static GstFlowReturn gst_imx_vpu_dec_handle_frame(GstVideoDecoder *decoder, GstV
 		 * it yet), we have to unref it here. We'll pull the frame from the
 		 * GstVideoDecoder queue based on its system frame number later,
 		 * and then we finish it. */
+		if (imx_vpu_dec->measure_decode_latency)
+		{
+			GstClockTime *push_time = g_new(GstClockTime, 1);
+			*push_time = gst_util_get_timestamp();
+			gst_video_codec_frame_set_user_data(cur_frame, push_time, g_free);
+		}
+
 		gst_video_codec_frame_unref(cur_frame);
 		cur_frame = NULL;
 	}
@@ -589,6 +1207,14 @@ static gboolean gst_imx_vpu_dec_flush(GstVideoDecoder *decoder)
 	if (imx_vpu_dec->decoder == NULL)
 		return TRUE;
 
+	/* Discard any frames that are still queued for the output task.
+	 * The task will be restarted by the next decoded frame. The stream
+	 * lock has to be released, since the task may be waiting for it. */
+	GST_VIDEO_DECODER_STREAM_UNLOCK(decoder);
+	gst_imx_vpu_dec_stop_output_loop(imx_vpu_dec);
+	GST_VIDEO_DECODER_STREAM_LOCK(decoder);
+	gst_imx_vpu_dec_resume_output_queue(imx_vpu_dec);
+
 	/* decoder_context == NULL may happen with single-frame
 	 * decoding like with WebP data or JPEG pictures. */
 	if (imx_vpu_dec->decoder_context != NULL)
@@ -618,6 +1244,8 @@ static GstFlowReturn gst_imx_vpu_dec_drain(GstVideoDecoder *decoder)
 	flow_ret = gst_imx_vpu_dec_decode_queued_frames(imx_vpu_dec);
 	if (flow_ret == GST_FLOW_EOS)
 		flow_ret = GST_FLOW_OK;
+	if (flow_ret == GST_FLOW_OK)
+		flow_ret = gst_imx_vpu_dec_wait_for_output_queue(imx_vpu_dec, 0);
 
 	GST_INFO_OBJECT(imx_vpu_dec, "decoder drained");
 
@@ -654,6 +1282,8 @@ static GstFlowReturn gst_imx_vpu_dec_finish(GstVideoDecoder *decoder)
 	flow_ret = gst_imx_vpu_dec_decode_queued_frames(imx_vpu_dec);
 	if (flow_ret == GST_FLOW_EOS)
 		flow_ret = GST_FLOW_OK;
+	if (flow_ret == GST_FLOW_OK)
+		flow_ret = gst_imx_vpu_dec_wait_for_output_queue(imx_vpu_dec, 0);
 
 	return flow_ret;
 }
@@ -751,7 +1381,14 @@ static gboolean gst_imx_vpu_dec_decide_allocation(GstVideoDecoder *decoder, GstQ
 		}
 
 		/* Now create our DMA buffer pool. */
-		imx_vpu_dec->dma_buffer_pool = gst_imx_vpu_dec_buffer_pool_new(&(imx_vpu_dec->current_stream_info), imx_vpu_dec->decoder_context);
+		/* Idle framebuffers from previous streams that are too small for
+		 * this stream would only occupy CMA memory next to the new ones
+		 * until stop() is called, so free them before anything new is
+		 * allocated. */
+		if (imx_vpu_dec->framebuffer_cache != NULL)
+			gst_imx_memory_recycler_evict_smaller(imx_vpu_dec->framebuffer_cache, buffer_size);
+
+		imx_vpu_dec->dma_buffer_pool = gst_imx_vpu_dec_buffer_pool_new(&(imx_vpu_dec->current_stream_info), imx_vpu_dec->decoder_context, imx_vpu_dec->framebuffer_cache);
 		buffer_pool = GST_BUFFER_POOL(imx_vpu_dec->dma_buffer_pool);
 
 		/* And configure our newly created pool. */
@@ -763,6 +1400,32 @@ static gboolean gst_imx_vpu_dec_decide_allocation(GstVideoDecoder *decoder, GstQ
 		gst_buffer_pool_config_add_option(pool_config, GST_BUFFER_POOL_OPTION_IMX_VPU_DEC_BUFFER_POOL);
 		gst_buffer_pool_set_config(buffer_pool, pool_config);
 
+		/* Fill the framebuffer cache with as many framebuffers as the
+		 * decoder requires (or as many as fit in the cache) up front.
+		 * This takes the DMA memory out of CMA while it is still mostly
+		 * unfragmented, and keeps it for subsequent streams. Only do this
+		 * once after start; later pools reuse the blocks of previous ones. */
+		if ((imx_vpu_dec->framebuffer_cache != NULL) && !(imx_vpu_dec->framebuffer_cache_prefilled))
+		{
+			guint num_prefilled = gst_imx_memory_recycler_prefill(
+				imx_vpu_dec->framebuffer_cache,
+				GST_ALLOCATOR(imx_dma_buffer_allocator),
+				buffer_size,
+				imx_vpu_dec->current_stream_info.min_num_required_framebuffers,
+				NULL
+			);
+
+			GST_DEBUG_OBJECT(
+				imx_vpu_dec,
+				"prefilled framebuffer cache with %u of %zu framebuffer(s) with %u byte(s) each",
+				num_prefilled,
+				imx_vpu_dec->current_stream_info.min_num_required_framebuffers,
+				buffer_size
+			);
+
+			imx_vpu_dec->framebuffer_cache_prefilled = TRUE;
+		}
+
 		/* Check if the plane stride & plane offset values are "tightly packed".
 		 * See the vpu_output_buffers_are_tightly_packed for more details. */
 		dma_bufpool_video_info = gst_imx_vpu_dec_buffer_pool_get_video_info(imx_vpu_dec->dma_buffer_pool);
@@ -804,18 +1467,26 @@ static gboolean gst_imx_vpu_dec_decide_allocation(GstVideoDecoder *decoder, GstQ
 			 * will come from this very buffer pool. */
 
 			GstAllocationParams allocation_params;
+			GstAllocator *nonvideometa_allocator = NULL;
 
 			buffer_size = GST_VIDEO_INFO_SIZE(&negotiated_video_info);
 
 			gst_allocation_params_init(&allocation_params);
 
+			/* Blitters can only write into DMA memory, so if one
+			 * is used, the pool has to allocate from our allocator.
+			 * Otherwise, regular system memory is fine. */
+			gst_imx_vpu_dec_setup_output_copy_method(imx_vpu_dec, dma_bufpool_video_info, &negotiated_video_info);
+			if (imx_vpu_dec->active_output_copy_method != GST_IMX_VPU_DEC_OUTPUT_COPY_METHOD_CPU)
+				nonvideometa_allocator = imx_vpu_dec->default_dma_buf_allocator;
+
 			imx_vpu_dec->nonvideometa_output_buffer_pool = gst_video_buffer_pool_new();
 
 			memcpy(&(imx_vpu_dec->nonvideometa_output_video_info), &negotiated_video_info, sizeof(GstVideoInfo));
 
 			pool_config = gst_buffer_pool_get_config(imx_vpu_dec->nonvideometa_output_buffer_pool);
 			gst_buffer_pool_config_set_params(pool_config, negotiated_caps, buffer_size, 0, 0);
-			gst_buffer_pool_config_set_allocator(pool_config, NULL, &allocation_params);
+			gst_buffer_pool_config_set_allocator(pool_config, nonvideometa_allocator, &allocation_params);
 			gst_buffer_pool_set_config(imx_vpu_dec->nonvideometa_output_buffer_pool, pool_config);
 
 			gst_buffer_pool_set_active(imx_vpu_dec->nonvideometa_output_buffer_pool, TRUE);
@@ -864,6 +1535,9 @@ static GstFlowReturn gst_imx_vpu_dec_decode_queued_frames(GstImxVpuDec *imx_vpu_
 	gboolean do_loop = TRUE;
 	ImxVpuApiDecReturnCodes dec_ret;
 	ImxVpuApiDecOutputCodes output_code;
+	guint num_finished_frames = 0;
+
+	gst_imx_vpu_processing_stats_begin_section(&(imx_vpu_dec->processing_stats));
 
 	do_loop = TRUE;
 
@@ -983,18 +1657,18 @@ static GstFlowReturn gst_imx_vpu_dec_decode_queued_frames(GstImxVpuDec *imx_vpu_
 
 				skipped_frame->output_buffer = NULL;
 
-				switch (reason)
-				{
-					case IMX_VPU_API_DEC_SKIPPED_FRAME_REASON_INTERNAL_FRAME:
-						GST_VIDEO_CODEC_FRAME_SET_DECODE_ONLY(skipped_frame);
-						flow_ret = gst_video_decoder_finish_frame(decoder, skipped_frame);
-						break;
+				/* Internal frames are finished as decode-only frames,
+				 * all others (like corrupted frames) are dropped. See
+				 * gst_imx_vpu_dec_finish_output_frame() for details.
+				 * Skipped frames go through gst_imx_vpu_dec_output_frame()
+				 * like decoded ones to keep them in order with the frames
+				 * that may still be waiting in the output queue. */
+				if (reason == IMX_VPU_API_DEC_SKIPPED_FRAME_REASON_INTERNAL_FRAME)
+					GST_VIDEO_CODEC_FRAME_SET_DECODE_ONLY(skipped_frame);
 
-					case IMX_VPU_API_DEC_SKIPPED_FRAME_REASON_CORRUPTED_FRAME:
-					default:
-						flow_ret = gst_video_decoder_drop_frame(decoder, skipped_frame);
-						break;
-				}
+				gst_imx_vpu_processing_stats_suspend_section(&(imx_vpu_dec->processing_stats));
+				flow_ret = gst_imx_vpu_dec_output_frame(imx_vpu_dec, skipped_frame);
+				gst_imx_vpu_processing_stats_resume_section(&(imx_vpu_dec->processing_stats));
 
 				break;
 			}
@@ -1020,6 +1694,12 @@ static GstFlowReturn gst_imx_vpu_dec_decode_queued_frames(GstImxVpuDec *imx_vpu_
 
 				imx_vpu_dec->current_stream_info = *new_stream_info;
 
+				/* Frames of the old stream that are still queued must be
+				 * pushed before the output state and pools are replaced. */
+				flow_ret = gst_imx_vpu_dec_wait_for_output_queue(imx_vpu_dec, 0);
+				if (G_UNLIKELY(flow_ret != GST_FLOW_OK))
+					goto finish;
+
 
 				/* Process the new stream info. */
 
@@ -1462,7 +2142,11 @@ static GstFlowReturn gst_imx_vpu_dec_decode_queued_frames(GstImxVpuDec *imx_vpu_
 
 
 					/* We have finished processing the decoded frame. */
-					flow_ret = gst_video_decoder_finish_frame(decoder, out_frame);
+					gst_imx_vpu_dec_update_decode_latency(imx_vpu_dec, out_frame);
+					gst_imx_vpu_processing_stats_suspend_section(&(imx_vpu_dec->processing_stats));
+					flow_ret = gst_imx_vpu_dec_output_frame(imx_vpu_dec, out_frame);
+					gst_imx_vpu_processing_stats_resume_section(&(imx_vpu_dec->processing_stats));
+					num_finished_frames++;
 				}
 				else
 				{
@@ -1486,6 +2170,7 @@ static GstFlowReturn gst_imx_vpu_dec_decode_queued_frames(GstImxVpuDec *imx_vpu_
 	while (do_loop);
 
 finish:
+	gst_imx_vpu_processing_stats_end_section(&(imx_vpu_dec->processing_stats), num_finished_frames);
 	return flow_ret;
 }
 
@@ -1511,6 +2196,7 @@ static void gst_imx_vpu_dec_teardown_current_decoder(GstImxVpuDec *imx_vpu_dec)
 {
 	/* Cleanup old decoder context. */
 	gst_imx_vpu_dec_unref_decoder_context(imx_vpu_dec);
+	imx_vpu_dec->open_decoder_at_first_frame = FALSE;
 
 	/* Clean up the old codec data copy. */
 	if (imx_vpu_dec->codec_data != NULL)
@@ -1546,6 +2232,8 @@ static void gst_imx_vpu_dec_teardown_current_decoder(GstImxVpuDec *imx_vpu_dec)
 		imx_vpu_dec->nonvideometa_output_buffer_pool = NULL;
 	}
 
+	gst_imx_vpu_dec_destroy_output_copy_blitter(imx_vpu_dec);
+
 	/* Clean up old input and output states. */
 	if (imx_vpu_dec->input_state != NULL)
 	{
@@ -1634,6 +2322,269 @@ finish:
 }
 
 
+#ifdef GST_IMX_VPU_DEC_WITH_BLITTER
+
+typedef struct
+{
+	GstImxVpuDecOutputCopyMethod method;
+	gchar const *name;
+	Imx2dBlitter* (*blitter_create)(void);
+	Imx2dHardwareCapabilities const * (*get_hardware_capabilities)(void);
+}
+GstImxVpuDecOutputCopyBlitterBackend;
+
+
+/* Candidates for the "auto" output copy method, in order of preference. */
+static GstImxVpuDecOutputCopyBlitterBackend const output_copy_blitter_backends[] =
+{
+#ifdef WITH_IMX2D_G2D_BACKEND
+	{ GST_IMX_VPU_DEC_OUTPUT_COPY_METHOD_G2D, "G2D", imx_2d_backend_g2d_blitter_create, imx_2d_backend_g2d_get_hardware_capabilities },
+#endif
+#ifdef WITH_IMX2D_PXP_BACKEND
+	{ GST_IMX_VPU_DEC_OUTPUT_COPY_METHOD_PXP, "PxP", imx_2d_backend_pxp_blitter_create, imx_2d_backend_pxp_get_hardware_capabilities },
+#endif
+#ifdef WITH_IMX2D_IPU_BACKEND
+	{ GST_IMX_VPU_DEC_OUTPUT_COPY_METHOD_IPU, "IPU", imx_2d_backend_ipu_blitter_create, imx_2d_backend_ipu_get_hardware_capabilities },
+#endif
+};
+
+
+static Imx2dPixelFormat gst_imx_vpu_dec_get_imx2d_pixel_format(GstVideoFormat format)
+{
+	/* Only the formats the VPU can produce are listed here. */
+	switch (format)
+	{
+		case GST_VIDEO_FORMAT_I420: return IMX_2D_PIXEL_FORMAT_FULLY_PLANAR_I420;
+		case GST_VIDEO_FORMAT_NV12: return IMX_2D_PIXEL_FORMAT_SEMI_PLANAR_NV12;
+		case GST_VIDEO_FORMAT_Y42B: return IMX_2D_PIXEL_FORMAT_FULLY_PLANAR_Y42B;
+		case GST_VIDEO_FORMAT_NV16: return IMX_2D_PIXEL_FORMAT_SEMI_PLANAR_NV16;
+		case GST_VIDEO_FORMAT_Y444: return IMX_2D_PIXEL_FORMAT_FULLY_PLANAR_Y444;
+		case GST_VIDEO_FORMAT_GRAY8: return IMX_2D_PIXEL_FORMAT_GRAY8;
+		case GST_VIDEO_FORMAT_UYVY: return IMX_2D_PIXEL_FORMAT_PACKED_YUV422_UYVY;
+		case GST_VIDEO_FORMAT_YUY2: return IMX_2D_PIXEL_FORMAT_PACKED_YUV422_YUYV;
+		case GST_VIDEO_FORMAT_RGB16: return IMX_2D_PIXEL_FORMAT_RGB565;
+		case GST_VIDEO_FORMAT_BGR16: return IMX_2D_PIXEL_FORMAT_BGR565;
+		case GST_VIDEO_FORMAT_RGBA: return IMX_2D_PIXEL_FORMAT_RGBA8888;
+		case GST_VIDEO_FORMAT_BGRA: return IMX_2D_PIXEL_FORMAT_BGRA8888;
+		default: return IMX_2D_PIXEL_FORMAT_UNKNOWN;
+	}
+}
+
+
+static gboolean gst_imx_vpu_dec_is_pixel_format_in_list(Imx2dPixelFormat format, Imx2dPixelFormat const *formats, int num_formats)
+{
+	int i;
+
+	for (i = 0; i < num_formats; ++i)
+	{
+		if (formats[i] == format)
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+
+static gboolean gst_imx_vpu_dec_is_video_layout_usable(Imx2dHardwareCapabilities const *capabilities, GstVideoInfo const *video_info)
+{
+	guint plane_index;
+	guint num_planes = GST_VIDEO_INFO_N_PLANES(video_info);
+
+	for (plane_index = 0; plane_index < num_planes; ++plane_index)
+	{
+		if ((GST_VIDEO_INFO_PLANE_STRIDE(video_info, plane_index) % capabilities->stride_alignment) != 0)
+			return FALSE;
+	}
+
+	/* In multi-plane frames, the number of rows between the beginning of
+	 * the first and of the second plane (that is, the frame height plus
+	 * any padding rows) must also be aligned. */
+	if (num_planes > 1)
+	{
+		gsize row_count = GST_VIDEO_INFO_PLANE_OFFSET(video_info, 1) / GST_VIDEO_INFO_PLANE_STRIDE(video_info, 0);
+		if ((row_count % capabilities->total_row_count_alignment) != 0)
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+
+static gboolean gst_imx_vpu_dec_can_blitter_copy_output_frames(Imx2dHardwareCapabilities const *capabilities, Imx2dPixelFormat format, GstVideoInfo const *vpu_video_info, GstVideoInfo const *output_video_info)
+{
+	gint width = GST_VIDEO_INFO_WIDTH(output_video_info);
+	gint height = GST_VIDEO_INFO_HEIGHT(output_video_info);
+
+	if (!gst_imx_vpu_dec_is_pixel_format_in_list(format, capabilities->supported_source_pixel_formats, capabilities->num_supported_source_pixel_formats)
+	 || !gst_imx_vpu_dec_is_pixel_format_in_list(format, capabilities->supported_dest_pixel_formats, capabilities->num_supported_dest_pixel_formats))
+		return FALSE;
+
+	if ((width < capabilities->min_width) || (width > capabilities->max_width)
+	 || (height < capabilities->min_height) || (height > capabilities->max_height))
+		return FALSE;
+
+	if ((capabilities->width_step_size > 1) && (((width - capabilities->min_width) % capabilities->width_step_size) != 0))
+		return FALSE;
+	if ((capabilities->height_step_size > 1) && (((height - capabilities->min_height) % capabilities->height_step_size) != 0))
+		return FALSE;
+
+	return gst_imx_vpu_dec_is_video_layout_usable(capabilities, vpu_video_info)
+	    && gst_imx_vpu_dec_is_video_layout_usable(capabilities, output_video_info);
+}
+
+
+static void gst_imx_vpu_dec_fill_surface_desc(Imx2dSurfaceDesc *desc, Imx2dPixelFormat format, GstVideoInfo const *video_info)
+{
+	guint plane_index;
+	guint num_planes = GST_VIDEO_INFO_N_PLANES(video_info);
+
+	memset(desc, 0, sizeof(Imx2dSurfaceDesc));
+
+	desc->width = GST_VIDEO_INFO_WIDTH(video_info);
+	desc->height = GST_VIDEO_INFO_HEIGHT(video_info);
+	desc->format = format;
+
+	for (plane_index = 0; plane_index < num_planes; ++plane_index)
+		desc->plane_strides[plane_index] = GST_VIDEO_INFO_PLANE_STRIDE(video_info, plane_index);
+
+	if (num_planes > 1)
+		desc->num_padding_rows = GST_VIDEO_INFO_PLANE_OFFSET(video_info, 1) / GST_VIDEO_INFO_PLANE_STRIDE(video_info, 0) - desc->height;
+}
+
+#endif
+
+
+static void gst_imx_vpu_dec_setup_output_copy_method(GstImxVpuDec *imx_vpu_dec, GstVideoInfo const *vpu_video_info, GstVideoInfo const *output_video_info)
+{
+	GstImxVpuDecOutputCopyMethod requested_method;
+	GstImxVpuDecOutputCopyMethod active_method = GST_IMX_VPU_DEC_OUTPUT_COPY_METHOD_CPU;
+
+	gst_imx_vpu_dec_destroy_output_copy_blitter(imx_vpu_dec);
+
+	GST_OBJECT_LOCK(imx_vpu_dec);
+	requested_method = imx_vpu_dec->output_copy_method;
+	GST_OBJECT_UNLOCK(imx_vpu_dec);
+
+#ifdef GST_IMX_VPU_DEC_WITH_BLITTER
+	if (requested_method != GST_IMX_VPU_DEC_OUTPUT_COPY_METHOD_CPU)
+	{
+		guint i;
+		Imx2dPixelFormat format = gst_imx_vpu_dec_get_imx2d_pixel_format(GST_VIDEO_INFO_FORMAT(output_video_info));
+
+		for (i = 0; (format != IMX_2D_PIXEL_FORMAT_UNKNOWN) && (i < G_N_ELEMENTS(output_copy_blitter_backends)); ++i)
+		{
+			GstImxVpuDecOutputCopyBlitterBackend const *backend = &(output_copy_blitter_backends[i]);
+			Imx2dSurfaceDesc surface_desc;
+
+			if ((requested_method != GST_IMX_VPU_DEC_OUTPUT_COPY_METHOD_AUTO) && (requested_method != backend->method))
+				continue;
+
+			if (!gst_imx_vpu_dec_can_blitter_copy_output_frames(backend->get_hardware_capabilities(), format, vpu_video_info, output_video_info))
+			{
+				GST_DEBUG_OBJECT(imx_vpu_dec, "%s blitter cannot handle the output frames", backend->name);
+				continue;
+			}
+
+			imx_vpu_dec->output_copy_blitter = backend->blitter_create();
+			if (imx_vpu_dec->output_copy_blitter == NULL)
+			{
+				GST_WARNING_OBJECT(imx_vpu_dec, "could not create %s blitter", backend->name);
+				continue;
+			}
+
+			gst_imx_vpu_dec_fill_surface_desc(&surface_desc, format, vpu_video_info);
+			imx_vpu_dec->output_copy_source_surface = imx_2d_surface_create(&surface_desc);
+			gst_imx_vpu_dec_fill_surface_desc(&surface_desc, format, output_video_info);
+			imx_vpu_dec->output_copy_dest_surface = imx_2d_surface_create(&surface_desc);
+
+			if ((imx_vpu_dec->output_copy_source_surface == NULL) || (imx_vpu_dec->output_copy_dest_surface == NULL))
+			{
+				GST_WARNING_OBJECT(imx_vpu_dec, "could not create surfaces for %s blitter", backend->name);
+				gst_imx_vpu_dec_destroy_output_copy_blitter(imx_vpu_dec);
+				continue;
+			}
+
+			active_method = backend->method;
+			break;
+		}
+	}
+#endif
+
+	if ((requested_method != GST_IMX_VPU_DEC_OUTPUT_COPY_METHOD_AUTO) && (requested_method != active_method))
+		GST_WARNING_OBJECT(imx_vpu_dec, "requested output copy method is not usable; falling back to CPU based copies");
+
+	GST_INFO_OBJECT(
+		imx_vpu_dec,
+		"using %s to copy output frames",
+		g_enum_get_value(g_type_class_peek(gst_imx_vpu_dec_output_copy_method_get_type()), active_method)->value_nick
+	);
+
+	GST_OBJECT_LOCK(imx_vpu_dec);
+	imx_vpu_dec->active_output_copy_method = active_method;
+	GST_OBJECT_UNLOCK(imx_vpu_dec);
+}
+
+
+static void gst_imx_vpu_dec_destroy_output_copy_blitter(GstImxVpuDec *imx_vpu_dec)
+{
+#ifdef GST_IMX_VPU_DEC_WITH_BLITTER
+	if (imx_vpu_dec->output_copy_source_surface != NULL)
+	{
+		imx_2d_surface_destroy(imx_vpu_dec->output_copy_source_surface);
+		imx_vpu_dec->output_copy_source_surface = NULL;
+	}
+
+	if (imx_vpu_dec->output_copy_dest_surface != NULL)
+	{
+		imx_2d_surface_destroy(imx_vpu_dec->output_copy_dest_surface);
+		imx_vpu_dec->output_copy_dest_surface = NULL;
+	}
+
+	if (imx_vpu_dec->output_copy_blitter != NULL)
+	{
+		imx_2d_blitter_destroy(imx_vpu_dec->output_copy_blitter);
+		imx_vpu_dec->output_copy_blitter = NULL;
+	}
+#endif
+
+	GST_OBJECT_LOCK(imx_vpu_dec);
+	imx_vpu_dec->active_output_copy_method = GST_IMX_VPU_DEC_OUTPUT_COPY_METHOD_CPU;
+	GST_OBJECT_UNLOCK(imx_vpu_dec);
+}
+
+
+#ifdef GST_IMX_VPU_DEC_WITH_BLITTER
+
+static gboolean gst_imx_vpu_dec_blit_output_frame(GstImxVpuDec *imx_vpu_dec, GstBuffer *vpu_output_buffer, GstVideoInfo const *vpu_video_info, GstBuffer *new_output_buffer)
+{
+	guint plane_index;
+	ImxDmaBuffer *source_dma_buffer = gst_imx_get_dma_buffer_from_buffer(vpu_output_buffer);
+	ImxDmaBuffer *dest_dma_buffer = gst_imx_get_dma_buffer_from_buffer(new_output_buffer);
+
+	if ((source_dma_buffer == NULL) || (dest_dma_buffer == NULL))
+		return FALSE;
+
+	for (plane_index = 0; plane_index < GST_VIDEO_INFO_N_PLANES(vpu_video_info); ++plane_index)
+	{
+		imx_2d_surface_set_dma_buffer(imx_vpu_dec->output_copy_source_surface, source_dma_buffer, plane_index, GST_VIDEO_INFO_PLANE_OFFSET(vpu_video_info, plane_index));
+		imx_2d_surface_set_dma_buffer(imx_vpu_dec->output_copy_dest_surface, dest_dma_buffer, plane_index, GST_VIDEO_INFO_PLANE_OFFSET(&(imx_vpu_dec->nonvideometa_output_video_info), plane_index));
+	}
+
+	if (!imx_2d_blitter_start(imx_vpu_dec->output_copy_blitter, imx_vpu_dec->output_copy_dest_surface))
+		return FALSE;
+
+	if (!imx_2d_blitter_do_blit(imx_vpu_dec->output_copy_blitter, imx_vpu_dec->output_copy_source_surface, NULL))
+	{
+		imx_2d_blitter_finish(imx_vpu_dec->output_copy_blitter);
+		return FALSE;
+	}
+
+	return imx_2d_blitter_finish(imx_vpu_dec->output_copy_blitter);
+}
+
+#endif
+
+
 static GstFlowReturn gst_imx_vpu_dec_copy_output_frame_if_needed(GstImxVpuDec *imx_vpu_dec, GstVideoCodecFrame *output_frame)
 {
 	GstFlowReturn flow_ret;
@@ -1654,6 +2605,23 @@ static GstFlowReturn gst_imx_vpu_dec_copy_output_frame_if_needed(GstImxVpuDec *i
 
 	memcpy(&vpu_video_info, gst_imx_vpu_dec_buffer_pool_get_video_info(imx_vpu_dec->dma_buffer_pool), sizeof(GstVideoInfo));
 
+#ifdef GST_IMX_VPU_DEC_WITH_BLITTER
+	if (imx_vpu_dec->output_copy_blitter != NULL)
+	{
+		if (G_LIKELY(gst_imx_vpu_dec_blit_output_frame(imx_vpu_dec, output_frame->output_buffer, &vpu_video_info, new_output_buffer)))
+		{
+			GST_LOG_OBJECT(imx_vpu_dec, "blitted pixels from VPU output buffer into new output buffer");
+
+			gst_buffer_unref(output_frame->output_buffer);
+			output_frame->output_buffer = new_output_buffer;
+
+			return GST_FLOW_OK;
+		}
+
+		GST_WARNING_OBJECT(imx_vpu_dec, "could not blit pixels from VPU output buffer into new output buffer; copying them with the CPU instead");
+	}
+#endif
+
 	if (!gst_video_frame_map(
 		&vpu_output_video_frame,
 		&vpu_video_info,
@@ -1703,6 +2671,234 @@ error:
 
 
 
+static void gst_imx_vpu_dec_update_decode_latency(GstImxVpuDec *imx_vpu_dec, GstVideoCodecFrame *decoded_frame)
+{
+	GstClockTime const *push_time;
+	GstClockTime latency;
+
+	if (!(imx_vpu_dec->measure_decode_latency))
+		return;
+
+	push_time = gst_video_codec_frame_get_user_data(decoded_frame);
+	if (push_time == NULL)
+		return;
+
+	latency = gst_util_get_timestamp() - *push_time;
+
+	imx_vpu_dec->num_decode_latency_samples++;
+	imx_vpu_dec->total_decode_latency += latency;
+	imx_vpu_dec->max_decode_latency = MAX(imx_vpu_dec->max_decode_latency, latency);
+
+	GST_DEBUG_OBJECT(imx_vpu_dec, "decode latency of gst frame with number #%" G_GUINT32_FORMAT ": %" GST_TIME_FORMAT, decoded_frame->system_frame_number, GST_TIME_ARGS(latency));
+}
+
+
+static GstFlowReturn gst_imx_vpu_dec_finish_output_frame(GstImxVpuDec *imx_vpu_dec, GstVideoCodecFrame *output_frame)
+{
+	/* Must be called with the decoder stream lock held.
+	 *
+	 * Frames without an output buffer that are not decode-only
+	 * are skipped frames that have to be dropped. */
+
+	GstVideoDecoder *decoder = GST_VIDEO_DECODER_CAST(imx_vpu_dec);
+
+	if ((output_frame->output_buffer == NULL) && !GST_VIDEO_CODEC_FRAME_IS_DECODE_ONLY(output_frame))
+		return gst_video_decoder_drop_frame(decoder, output_frame);
+	else
+		return gst_video_decoder_finish_frame(decoder, output_frame);
+}
+
+
+static GstFlowReturn gst_imx_vpu_dec_output_frame(GstImxVpuDec *imx_vpu_dec, GstVideoCodecFrame *output_frame)
+{
+	/* Must be called with the decoder stream lock held.
+	 *
+	 * Takes ownership over output_frame. Without an output task, the frame
+	 * is finished right away. Otherwise, it is put into the output queue
+	 * once that queue has room for it. */
+
+	GstFlowReturn flow_ret;
+	GstPad *srcpad = GST_VIDEO_DECODER_SRC_PAD(imx_vpu_dec);
+
+	if (imx_vpu_dec->current_output_queue_depth == 0)
+		return gst_imx_vpu_dec_finish_output_frame(imx_vpu_dec, output_frame);
+
+	flow_ret = gst_imx_vpu_dec_wait_for_output_queue(imx_vpu_dec, imx_vpu_dec->current_output_queue_depth - 1);
+	if (G_UNLIKELY(flow_ret != GST_FLOW_OK))
+	{
+		GST_DEBUG_OBJECT(imx_vpu_dec, "cannot queue output frame: %s", gst_flow_get_name(flow_ret));
+		gst_video_codec_frame_unref(output_frame);
+		return flow_ret;
+	}
+
+	/* The flushing state is checked and the task is started while the
+	 * mutex is held. gst_imx_vpu_dec_stop_output_loop() sets the flushing
+	 * state with the mutex held before it stops the task. This way, the
+	 * task cannot be restarted after it was stopped. */
+	g_mutex_lock(&(imx_vpu_dec->output_queue_mutex));
+
+	if (G_UNLIKELY(imx_vpu_dec->output_queue_flushing))
+	{
+		g_mutex_unlock(&(imx_vpu_dec->output_queue_mutex));
+		GST_DEBUG_OBJECT(imx_vpu_dec, "cannot queue output frame: output queue is flushing");
+		gst_video_codec_frame_unref(output_frame);
+		return GST_FLOW_FLUSHING;
+	}
+
+	g_queue_push_tail(&(imx_vpu_dec->output_queue), output_frame);
+	imx_vpu_dec->num_pending_output_frames++;
+	g_cond_broadcast(&(imx_vpu_dec->output_queue_cond));
+
+	GST_LOG_OBJECT(imx_vpu_dec, "queued gst frame with number #%" G_GUINT32_FORMAT " for output", output_frame->system_frame_number);
+
+	if (G_UNLIKELY(gst_pad_get_task_state(srcpad) != GST_TASK_STARTED))
+	{
+		GST_DEBUG_OBJECT(imx_vpu_dec, "starting output task");
+
+		if (!gst_pad_start_task(srcpad, (GstTaskFunction)gst_imx_vpu_dec_output_loop, imx_vpu_dec, NULL))
+		{
+			GST_ERROR_OBJECT(imx_vpu_dec, "could not start output task");
+
+			/* Make sure nothing waits for the queued frames. */
+			imx_vpu_dec->output_task_flow_ret = GST_FLOW_ERROR;
+			flow_ret = GST_FLOW_ERROR;
+		}
+	}
+
+	g_mutex_unlock(&(imx_vpu_dec->output_queue_mutex));
+
+	return flow_ret;
+}
+
+
+static GstFlowReturn gst_imx_vpu_dec_wait_for_output_queue(GstImxVpuDec *imx_vpu_dec, guint max_num_pending_frames)
+{
+	/* Must be called with the decoder stream lock held. That lock is
+	 * released while waiting, since the output task needs it for
+	 * finishing frames.
+	 *
+	 * Waits until no more than max_num_pending_frames frames are pending
+	 * in the output queue. Returns early if the output task is stopped
+	 * or ran into a non-OK flow return value. */
+
+	GstFlowReturn flow_ret;
+
+	if (imx_vpu_dec->current_output_queue_depth == 0)
+		return GST_FLOW_OK;
+
+	GST_VIDEO_DECODER_STREAM_UNLOCK(imx_vpu_dec);
+
+	g_mutex_lock(&(imx_vpu_dec->output_queue_mutex));
+
+	while ((imx_vpu_dec->num_pending_output_frames > max_num_pending_frames)
+	    && (imx_vpu_dec->output_task_flow_ret == GST_FLOW_OK)
+	    && !(imx_vpu_dec->output_queue_flushing))
+	{
+		g_cond_wait(&(imx_vpu_dec->output_queue_cond), &(imx_vpu_dec->output_queue_mutex));
+	}
+
+	flow_ret = imx_vpu_dec->output_queue_flushing ? GST_FLOW_FLUSHING : imx_vpu_dec->output_task_flow_ret;
+
+	g_mutex_unlock(&(imx_vpu_dec->output_queue_mutex));
+
+	GST_VIDEO_DECODER_STREAM_LOCK(imx_vpu_dec);
+
+	return flow_ret;
+}
+
+
+static void gst_imx_vpu_dec_stop_output_loop(GstImxVpuDec *imx_vpu_dec)
+{
+	/* Must be called with the decoder stream lock *released* (!).
+	 * After this function finishes, the output task is guaranteed to be
+	 * stopped, and all frames that were still queued are discarded.
+	 * The output queue is left in the flushing state, so no new frames
+	 * can be queued until gst_imx_vpu_dec_resume_output_queue() is
+	 * called. */
+
+	GstVideoCodecFrame *frame;
+
+	g_mutex_lock(&(imx_vpu_dec->output_queue_mutex));
+	imx_vpu_dec->output_queue_flushing = TRUE;
+	g_cond_broadcast(&(imx_vpu_dec->output_queue_cond));
+	g_mutex_unlock(&(imx_vpu_dec->output_queue_mutex));
+
+	gst_pad_stop_task(GST_VIDEO_DECODER_SRC_PAD(imx_vpu_dec));
+
+	g_mutex_lock(&(imx_vpu_dec->output_queue_mutex));
+	while ((frame = g_queue_pop_head(&(imx_vpu_dec->output_queue))) != NULL)
+		gst_video_codec_frame_unref(frame);
+	imx_vpu_dec->num_pending_output_frames = 0;
+	g_mutex_unlock(&(imx_vpu_dec->output_queue_mutex));
+}
+
+
+static void gst_imx_vpu_dec_resume_output_queue(GstImxVpuDec *imx_vpu_dec)
+{
+	/* Leaves the flushing state that gst_imx_vpu_dec_stop_output_loop()
+	 * put the output queue into. Called in gst_imx_vpu_dec_start() and
+	 * after flushing, that is, when the streaming thread may produce
+	 * frames again. */
+
+	g_mutex_lock(&(imx_vpu_dec->output_queue_mutex));
+	imx_vpu_dec->output_queue_flushing = FALSE;
+	imx_vpu_dec->output_task_flow_ret = GST_FLOW_OK;
+	g_mutex_unlock(&(imx_vpu_dec->output_queue_mutex));
+}
+
+
+static void gst_imx_vpu_dec_output_loop(GstImxVpuDec *imx_vpu_dec)
+{
+	GstFlowReturn flow_ret;
+	GstVideoDecoder *decoder = GST_VIDEO_DECODER_CAST(imx_vpu_dec);
+	GstVideoCodecFrame *frame;
+
+	g_mutex_lock(&(imx_vpu_dec->output_queue_mutex));
+
+	while (g_queue_is_empty(&(imx_vpu_dec->output_queue)) && !(imx_vpu_dec->output_queue_flushing))
+		g_cond_wait(&(imx_vpu_dec->output_queue_cond), &(imx_vpu_dec->output_queue_mutex));
+
+	frame = imx_vpu_dec->output_queue_flushing ? NULL : g_queue_pop_head(&(imx_vpu_dec->output_queue));
+
+	g_mutex_unlock(&(imx_vpu_dec->output_queue_mutex));
+
+	if (frame == NULL)
+	{
+		GST_DEBUG_OBJECT(imx_vpu_dec, "output queue is flushing; pausing output task");
+		gst_pad_pause_task(decoder->srcpad);
+		return;
+	}
+
+	GST_LOG_OBJECT(imx_vpu_dec, "finishing gst frame with number #%" G_GUINT32_FORMAT " in output task", frame->system_frame_number);
+
+	/* gst_video_decoder_finish_frame() releases the stream lock while
+	 * pushing the frame downstream, so the decoding thread can continue
+	 * while downstream blocks. */
+	GST_VIDEO_DECODER_STREAM_LOCK(decoder);
+	flow_ret = gst_imx_vpu_dec_finish_output_frame(imx_vpu_dec, frame);
+	GST_VIDEO_DECODER_STREAM_UNLOCK(decoder);
+
+	/* Only decrement the counter now, after the frame was pushed. Otherwise,
+	 * gst_imx_vpu_dec_wait_for_output_queue() could return too early when
+	 * draining, and the EOS event could overtake the last frame. */
+	g_mutex_lock(&(imx_vpu_dec->output_queue_mutex));
+	imx_vpu_dec->num_pending_output_frames--;
+	if (flow_ret != GST_FLOW_OK)
+		imx_vpu_dec->output_task_flow_ret = flow_ret;
+	g_cond_broadcast(&(imx_vpu_dec->output_queue_cond));
+	g_mutex_unlock(&(imx_vpu_dec->output_queue_mutex));
+
+	if (flow_ret != GST_FLOW_OK)
+	{
+		/* The non-OK flow return value is reported back to the decoding
+		 * thread by gst_imx_vpu_dec_wait_for_output_queue(). */
+		GST_DEBUG_OBJECT(imx_vpu_dec, "pausing output task: %s", gst_flow_get_name(flow_ret));
+		gst_pad_pause_task(decoder->srcpad);
+	}
+}
+
+
+
 
 /* class_init function for autogenerated subclasses. */
 static void derived_class_init(void *klass)
@@ -39,6 +39,34 @@ typedef struct _GstImxVpuDec GstImxVpuDec;
 typedef struct _GstImxVpuDecClass GstImxVpuDecClass;
 
 
+/**
+ * GstImxVpuDecOutputCopyMethod:
+ * @GST_IMX_VPU_DEC_OUTPUT_COPY_METHOD_AUTO: Use the first 2D blitter that
+ *     can handle the frames, or the CPU if none can.
+ * @GST_IMX_VPU_DEC_OUTPUT_COPY_METHOD_CPU: Copy frames with the CPU.
+ * @GST_IMX_VPU_DEC_OUTPUT_COPY_METHOD_G2D: Copy frames with the G2D blitter.
+ * @GST_IMX_VPU_DEC_OUTPUT_COPY_METHOD_PXP: Copy frames with the PxP blitter.
+ * @GST_IMX_VPU_DEC_OUTPUT_COPY_METHOD_IPU: Copy frames with the IPU blitter.
+ *
+ * How decoded frames are copied if downstream cannot handle the
+ * padding in the VPU's output frames (see the "output-copy-method"
+ * property). Blitter based methods fall back to the CPU if the
+ * blitter is not available or cannot handle the frames.
+ */
+typedef enum
+{
+	GST_IMX_VPU_DEC_OUTPUT_COPY_METHOD_AUTO = 0,
+	GST_IMX_VPU_DEC_OUTPUT_COPY_METHOD_CPU,
+	GST_IMX_VPU_DEC_OUTPUT_COPY_METHOD_G2D,
+	GST_IMX_VPU_DEC_OUTPUT_COPY_METHOD_PXP,
+	GST_IMX_VPU_DEC_OUTPUT_COPY_METHOD_IPU
+}
+GstImxVpuDecOutputCopyMethod;
+
+
+GType gst_imx_vpu_dec_output_copy_method_get_type(void);
+
+
 GTypeInfo gst_imx_vpu_dec_get_derived_type_info(void);
 
 GType gst_imx_vpu_dec_get_type(void);
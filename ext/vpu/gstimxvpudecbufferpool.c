@@ -50,6 +50,14 @@ struct _GstImxVpuDecBufferPool
 	GMutex selected_buffer_mutex;
 	GstVideoInfo video_info;
 	gboolean add_videometa;
+
+	/* If non-NULL, memory blocks are allocated through this cache instead
+	 * of directly with the configured allocator. The allocator, size and
+	 * allocation parameters are copied from the configuration. */
+	GstImxMemoryRecycler *framebuffer_cache;
+	GstAllocator *allocator;
+	guint buffer_size;
+	GstAllocationParams allocation_params;
 };
 
 
@@ -114,6 +122,11 @@ static void gst_imx_vpu_dec_buffer_pool_init(GstImxVpuDecBufferPool *imx_vpu_dec
 
 	gst_video_info_init(&(imx_vpu_dec_buffer_pool->video_info));
 	imx_vpu_dec_buffer_pool->add_videometa = FALSE;
+
+	imx_vpu_dec_buffer_pool->framebuffer_cache = NULL;
+	imx_vpu_dec_buffer_pool->allocator = NULL;
+	imx_vpu_dec_buffer_pool->buffer_size = 0;
+	gst_allocation_params_init(&(imx_vpu_dec_buffer_pool->allocation_params));
 }
 
 
@@ -125,6 +138,10 @@ static void gst_imx_vpu_dec_buffer_pool_finalize(GObject *object)
 
 	if (imx_vpu_dec_buffer_pool->decoder_context != NULL)
 		gst_object_unref(GST_OBJECT(imx_vpu_dec_buffer_pool->decoder_context));
+	if (imx_vpu_dec_buffer_pool->framebuffer_cache != NULL)
+		gst_object_unref(GST_OBJECT(imx_vpu_dec_buffer_pool->framebuffer_cache));
+	if (imx_vpu_dec_buffer_pool->allocator != NULL)
+		gst_object_unref(GST_OBJECT(imx_vpu_dec_buffer_pool->allocator));
 
 	g_mutex_clear(&(imx_vpu_dec_buffer_pool->selected_buffer_mutex));
 
@@ -222,13 +239,22 @@ static gboolean gst_imx_vpu_dec_buffer_pool_set_config(GstBufferPool *pool, GstS
 	if (ret)
 	{
 		GstAllocator *allocator = NULL;
-		gboolean is_dma_buffer_allocator = gst_buffer_pool_config_get_allocator(config, &(allocator), NULL) && GST_IS_IMX_DMA_BUFFER_ALLOCATOR(allocator);
+		GstAllocationParams allocation_params;
+		gboolean is_dma_buffer_allocator = gst_buffer_pool_config_get_allocator(config, &(allocator), &allocation_params) && GST_IS_IMX_DMA_BUFFER_ALLOCATOR(allocator);
 
 		if (G_UNLIKELY(!is_dma_buffer_allocator))
 		{
 			GST_ERROR_OBJECT(imx_vpu_dec_buffer_pool, "cannot configure the buffer pool because its allocator cannot allocate DMA buffers");
 			ret = FALSE;
 		}
+		else
+		{
+			/* Keep our own copies of the allocation details, since
+			 * alloc_buffer() passes them to the framebuffer cache. */
+			gst_object_replace((GstObject **)&(imx_vpu_dec_buffer_pool->allocator), GST_OBJECT(allocator));
+			imx_vpu_dec_buffer_pool->buffer_size = size;
+			imx_vpu_dec_buffer_pool->allocation_params = allocation_params;
+		}
 	}
 
 	return ret;
@@ -303,7 +329,30 @@ static GstFlowReturn gst_imx_vpu_dec_buffer_pool_alloc_buffer(GstBufferPool *poo
 	GstImxVpuDecBufferPool *imx_vpu_dec_buffer_pool = GST_IMX_VPU_DEC_BUFFER_POOL(pool);
 	ImxVpuApiDecStreamInfo *stream_info = &(imx_vpu_dec_buffer_pool->stream_info);
 
-	if (G_UNLIKELY((flow_ret = GST_BUFFER_POOL_CLASS(gst_imx_vpu_dec_buffer_pool_parent_class)->alloc_buffer(pool, buffer, params)) != GST_FLOW_OK))
+	if (imx_vpu_dec_buffer_pool->framebuffer_cache != NULL)
+	{
+		/* This does the same as the default alloc_buffer implementation,
+		 * except that the memory block may come from the cache. */
+		GstMemory *memory = gst_imx_memory_recycler_acquire(
+			imx_vpu_dec_buffer_pool->framebuffer_cache,
+			imx_vpu_dec_buffer_pool->allocator,
+			imx_vpu_dec_buffer_pool->buffer_size,
+			G_MAXSIZE,
+			&(imx_vpu_dec_buffer_pool->allocation_params)
+		);
+		if (G_UNLIKELY(memory == NULL))
+		{
+			GST_ERROR_OBJECT(imx_vpu_dec_buffer_pool, "could not allocate gstbuffer: could not acquire memory from framebuffer cache");
+			return GST_FLOW_ERROR;
+		}
+
+		*buffer = gst_buffer_new();
+		gst_buffer_append_memory(*buffer, memory);
+		flow_ret = GST_FLOW_OK;
+
+		GST_LOG_OBJECT(imx_vpu_dec_buffer_pool, "allocated gstbuffer %p with memory %p from framebuffer cache", (gpointer)(*buffer), (gpointer)memory);
+	}
+	else if (G_UNLIKELY((flow_ret = GST_BUFFER_POOL_CLASS(gst_imx_vpu_dec_buffer_pool_parent_class)->alloc_buffer(pool, buffer, params)) != GST_FLOW_OK))
 	{
 		GST_ERROR_OBJECT(imx_vpu_dec_buffer_pool, "could not allocate gstbuffer: %s", gst_flow_get_name(flow_ret));
 		return flow_ret;
@@ -386,7 +435,7 @@ static void gst_imx_vpu_dec_buffer_pool_free_buffer(GstBufferPool *pool, GstBuff
 }
 
 
-GstImxVpuDecBufferPool* gst_imx_vpu_dec_buffer_pool_new(ImxVpuApiDecStreamInfo *stream_info, GstImxVpuDecContext *decoder_context)
+GstImxVpuDecBufferPool* gst_imx_vpu_dec_buffer_pool_new(ImxVpuApiDecStreamInfo *stream_info, GstImxVpuDecContext *decoder_context, GstImxMemoryRecycler *framebuffer_cache)
 {
 	GstImxVpuDecBufferPool *imx_vpu_dec_buffer_pool;
 
@@ -398,6 +447,8 @@ GstImxVpuDecBufferPool* gst_imx_vpu_dec_buffer_pool_new(ImxVpuApiDecStreamInfo *
 	imx_vpu_dec_buffer_pool = g_object_new(gst_imx_vpu_dec_buffer_pool_get_type(), NULL);
 	imx_vpu_dec_buffer_pool->decoder_context = decoder_context;
 	imx_vpu_dec_buffer_pool->stream_info = *stream_info;
+	if (framebuffer_cache != NULL)
+		imx_vpu_dec_buffer_pool->framebuffer_cache = GST_IMX_MEMORY_RECYCLER(gst_object_ref(GST_OBJECT(framebuffer_cache)));
 
 	// Clear the floating flag, since it is not useful
 	// with buffer pools, and could lead to subtle
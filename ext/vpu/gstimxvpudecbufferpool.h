@@ -24,6 +24,7 @@
 #include <gst/video/video.h>
 #include <imxvpuapi2/imxvpuapi2.h>
 #include "gstimxvpudeccontext.h"
+#include "gst/imx/common/gstimxmemoryrecycler.h"
 
 
 G_BEGIN_DECLS
@@ -69,6 +70,10 @@ G_BEGIN_DECLS
  * the buffer that holds the newly decoded frame. And, once that buffer is no
  * longer needed, it is properly returned to the VPU's pool by the behavior in the
  * release() function.
+ *
+ * If a GstImxMemoryRecycler is passed to gst_imx_vpu_dec_buffer_pool_new(),
+ * the memory blocks of all buffers (reserved and regular ones) are acquired from
+ * that recycler, so that the DMA memory of a previous pool can be reused.
  */
 
 
@@ -97,7 +102,7 @@ GstImxVpuDecBufferPoolAcquireFlags;
 
 GType gst_imx_vpu_dec_buffer_pool_get_type(void);
 
-GstImxVpuDecBufferPool* gst_imx_vpu_dec_buffer_pool_new(ImxVpuApiDecStreamInfo *stream_info, GstImxVpuDecContext *decoder_context);
+GstImxVpuDecBufferPool* gst_imx_vpu_dec_buffer_pool_new(ImxVpuApiDecStreamInfo *stream_info, GstImxVpuDecContext *decoder_context, GstImxMemoryRecycler *framebuffer_cache);
 
 GstVideoInfo const * gst_imx_vpu_dec_buffer_pool_get_video_info(GstImxVpuDecBufferPool *imx_vpu_dec_buffer_pool);
 
@@ -246,6 +246,8 @@ static gboolean gst_imx_vpu_enc_start(GstVideoEncoder *encoder)
 
 	imx_vpu_enc->fatal_error_cannot_encode = FALSE;
 
+	gst_imx_vpu_processing_stats_reset(&(imx_vpu_enc->processing_stats));
+
 	stream_buffer_size = imx_vpu_enc->enc_global_info->min_required_stream_buffer_size;
 	stream_buffer_alignment = imx_vpu_enc->enc_global_info->required_stream_buffer_physaddr_alignment;
 
@@ -296,6 +298,18 @@ static gboolean gst_imx_vpu_enc_stop(GstVideoEncoder *encoder)
 	GstImxVpuEnc *imx_vpu_enc = GST_IMX_VPU_ENC(encoder);
 	ImxVpuApiCompressionFormat compression_format = GST_IMX_VPU_GET_ELEMENT_COMPRESSION_FORMAT(encoder);
 	GstImxVpuCodecDetails const * codec_details = gst_imx_vpu_get_codec_details(compression_format);
+	GstImxVpuProcessingStats const *stats = &(imx_vpu_enc->processing_stats);
+
+	if (stats->num_frames > 0)
+	{
+		GST_INFO_OBJECT(
+			imx_vpu_enc,
+			"encoded %" G_GUINT64_FORMAT " frame(s); average time per frame: wall clock %" G_GUINT64_FORMAT " us  CPU %" G_GUINT64_FORMAT " us",
+			stats->num_frames,
+			(guint64)(stats->total_wall_time / stats->num_frames / GST_USECOND),
+			(guint64)(stats->total_cpu_time / stats->num_frames / GST_USECOND)
+		);
+	}
 
 	g_hash_table_remove_all(imx_vpu_enc->uploaded_buffers_table);
 
@@ -638,12 +652,36 @@ static gboolean gst_imx_vpu_enc_flush(GstVideoEncoder *encoder)
 
 static gboolean gst_imx_vpu_enc_propose_allocation(GstVideoEncoder *encoder, GstQuery *query)
 {
+	GstImxVpuEnc *imx_vpu_enc = GST_IMX_VPU_ENC_CAST(encoder);
+
 	if (!GST_VIDEO_ENCODER_CLASS(gst_imx_vpu_enc_parent_class)->propose_allocation(encoder, query))
 		return FALSE;
 
 	/* Inform upstream that we can handle GstVideoMeta. */
 	gst_query_add_allocation_meta(query, GST_VIDEO_META_API_TYPE, 0);
 
+	/* Propose our DMA buffer allocator. Upstream elements that allocate
+	 * their frames with it (for example through their own video buffer
+	 * pool) produce buffers that the uploader can pass through as-is.
+	 * Otherwise, each frame has to be copied into DMA memory, which is
+	 * expensive with large frames. The VPU reads frames directly from
+	 * physically contiguous memory, so importing non-contiguous system
+	 * memory instead of copying it is not an option. */
+	if (imx_vpu_enc->default_dma_buf_allocator != NULL)
+	{
+		GstAllocationParams alloc_params;
+
+		gst_allocation_params_init(&alloc_params);
+
+		/* The stream info is only valid once the encoder was opened. */
+		if ((imx_vpu_enc->encoder != NULL) && (imx_vpu_enc->current_stream_info.framebuffer_alignment > 1))
+			alloc_params.align = imx_vpu_enc->current_stream_info.framebuffer_alignment - 1;
+
+		GST_DEBUG_OBJECT(imx_vpu_enc, "proposing DMA buffer allocator %" GST_PTR_FORMAT " with alignment %" G_GSIZE_FORMAT, (gpointer)(imx_vpu_enc->default_dma_buf_allocator), alloc_params.align + 1);
+
+		gst_query_add_allocation_param(query, imx_vpu_enc->default_dma_buf_allocator, &alloc_params);
+	}
+
 	return TRUE;
 }
 
@@ -715,6 +753,9 @@ static GstFlowReturn gst_imx_vpu_enc_encode_queued_frames(GstImxVpuEnc *imx_vpu_
 	ImxVpuApiEncReturnCodes enc_ret;
 	ImxVpuApiEncOutputCodes output_code;
 	size_t encoded_frame_size;
+	guint num_finished_frames = 0;
+
+	gst_imx_vpu_processing_stats_begin_section(&(imx_vpu_enc->processing_stats));
 
 	do_loop = TRUE;
 
@@ -806,7 +847,10 @@ static GstFlowReturn gst_imx_vpu_enc_encode_queued_frames(GstImxVpuEnc *imx_vpu_
 				}
 				out_frame->output_buffer = output_buffer;
 
+				gst_imx_vpu_processing_stats_suspend_section(&(imx_vpu_enc->processing_stats));
 				flow_ret = gst_video_encoder_finish_frame(encoder, out_frame);
+				gst_imx_vpu_processing_stats_resume_section(&(imx_vpu_enc->processing_stats));
+				num_finished_frames++;
 
 				g_hash_table_remove(imx_vpu_enc->uploaded_buffers_table, (gpointer)(gintptr)system_frame_number);
 
@@ -832,6 +876,8 @@ static GstFlowReturn gst_imx_vpu_enc_encode_queued_frames(GstImxVpuEnc *imx_vpu_
 
 
 finish:
+	gst_imx_vpu_processing_stats_end_section(&(imx_vpu_enc->processing_stats), num_finished_frames);
+
 	if (flow_ret == GST_FLOW_ERROR)
 		imx_vpu_enc->fatal_error_cannot_encode = TRUE;
 
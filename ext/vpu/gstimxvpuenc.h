@@ -95,6 +95,10 @@ struct _GstImxVpuEnc
 	 * cleared once the encoder is restarted. */
 	gboolean fatal_error_cannot_encode;
 
+	/* Per-frame processing cost of gst_imx_vpu_enc_encode_queued_frames().
+	 * Reset in gst_imx_vpu_enc_start(), logged in gst_imx_vpu_enc_stop(). */
+	GstImxVpuProcessingStats processing_stats;
+
 	/* Copy of the GstVideoInfo that describes the raw input frames. */
 	GstVideoInfo in_video_info;
 
@@ -28,6 +28,7 @@
 #include <imxdmabuffer/imxdmabuffer.h>
 #include "gstimxdmabufferallocator.h"
 #include "gstimxdefaultallocator.h"
+#include "gstimxdmabufferslab.h"
 
 
 GST_DEBUG_CATEGORY_STATIC(imx_default_allocator_debug);
@@ -36,6 +37,8 @@ GST_DEBUG_CATEGORY_STATIC(imx_default_allocator_debug);
 
 #define GST_IMX_DEFAULT_MEMORY_TYPE "ImxDefaultDmaMemory"
 
+#define DISABLE_SLAB_ALLOCATION_ENV_VAR "GSTREAMER_IMX_DISABLE_SLAB_ALLOCATION"
+
 
 typedef struct _GstImxDefaultDmaMemory GstImxDefaultDmaMemory;
 
@@ -51,6 +54,7 @@ struct _GstImxDefaultAllocator
 {
 	GstAllocator parent;
 	ImxDmaBufferAllocator *imxdmabuffer_allocator;
+	gboolean uses_slab_allocation;
 };
 
 
@@ -122,6 +126,13 @@ static void gst_imx_default_allocator_dispose(GObject *object)
 
 	if (imx_default_allocator->imxdmabuffer_allocator != NULL)
 	{
+		if (imx_default_allocator->uses_slab_allocation)
+		{
+			guint num_chunks, num_slices;
+			gst_imx_dma_buffer_slab_allocator_get_statistics(imx_default_allocator->imxdmabuffer_allocator, &num_chunks, &num_slices);
+			GST_DEBUG_OBJECT(imx_default_allocator, "slab allocator has %u chunk(s) and %u slice(s) left", num_chunks, num_slices);
+		}
+
 		imx_dma_buffer_allocator_destroy(imx_default_allocator->imxdmabuffer_allocator);
 		imx_default_allocator->imxdmabuffer_allocator = NULL;
 	}
@@ -189,7 +200,10 @@ static void gst_imx_default_allocator_free(G_GNUC_UNUSED GstAllocator *allocator
 	g_assert(imx_dma_memory != NULL);
 	g_assert(imx_dma_memory->dmabuffer != NULL);
 
-	imx_dma_buffer_deallocate(imx_dma_memory->dmabuffer);
+	/* Shared memory blocks refer to the DMA buffer of their parent,
+	 * so only the parent may deallocate it. */
+	if (memory->parent == NULL)
+		imx_dma_buffer_deallocate(imx_dma_memory->dmabuffer);
 
 	g_slice_free1(sizeof(GstImxDefaultDmaMemory), imx_dma_memory);
 }
@@ -232,11 +246,11 @@ static GstMemory * gst_imx_default_allocator_copy(GstMemory *memory, gssize offs
 	uint8_t *mapped_src_data = NULL, *mapped_dest_data = NULL;
 	int error;
 
+	/* The offset is relative to the memory's own offset, and the
+	 * DMA buffer size is not necessarily the memory size (the DMA
+	 * buffer may be larger, for example because of padding). */
 	if (size == -1)
-	{
-		size = imx_dma_buffer_get_size(imx_dma_memory->dmabuffer);
-		size = (size > offset) ? (size - offset) : 0;
-	}
+		size = ((gssize)(memory->size) > offset) ? ((gssize)(memory->size) - offset) : 0;
 
 	new_imx_dma_memory = g_slice_alloc0(sizeof(GstImxDefaultDmaMemory));
 	if (G_UNLIKELY(new_imx_dma_memory == NULL))
@@ -269,7 +283,7 @@ static GstMemory * gst_imx_default_allocator_copy(GstMemory *memory, gssize offs
 	}
 
 	/* TODO: Is it perhaps possible to copy over DMA instead of by using the CPU? */
-	memcpy(mapped_dest_data, mapped_src_data + offset, size);
+	memcpy(mapped_dest_data, mapped_src_data + memory->offset + offset, size);
 
 finish:
 	if (mapped_src_data != NULL)
@@ -363,6 +377,18 @@ GstAllocator* gst_imx_default_allocator_new(void)
 		return NULL;
 	}
 
+	/* Small buffers (like encoded frames or audio buffers) are carved out of
+	 * larger chunks by the slab allocator. Each allocation from the default
+	 * libimxdmabuffer allocator is a separate contiguous memory allocation
+	 * in the kernel, which is comparatively slow and has a coarse granularity. */
+	if (g_strcmp0(g_getenv(DISABLE_SLAB_ALLOCATION_ENV_VAR), "1") != 0)
+	{
+		imx_default_allocator->imxdmabuffer_allocator = gst_imx_dma_buffer_slab_allocator_new(imx_default_allocator->imxdmabuffer_allocator);
+		imx_default_allocator->uses_slab_allocation = TRUE;
+	}
+	else
+		GST_DEBUG_OBJECT(imx_default_allocator, "slab allocation disabled by environment variable %s", DISABLE_SLAB_ALLOCATION_ENV_VAR);
+
 	GST_DEBUG_OBJECT(imx_default_allocator, "created new default i.MX DMA allocator %s", GST_OBJECT_NAME(imx_default_allocator));
 
 	/* Clear floating flag */
@@ -25,9 +25,12 @@
 #include "config.h"
 
 #include <assert.h>
+#include <errno.h>
+#include <string.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/vfs.h>
 #include <fcntl.h>
 #include <gst/gst.h>
 #include <gst/allocators/allocators.h>
@@ -37,19 +40,108 @@
 
 #include "gstimxdmaheapallocator.h"
 #include "gstimxionallocator.h"
+#include "gstimxmemfdallocator.h"
 
 
 GST_DEBUG_CATEGORY_STATIC(imx_dmabuf_allocator_debug);
 #define GST_CAT_DEFAULT imx_dmabuf_allocator_debug
 
 
+enum
+{
+	PROP_0,
+	PROP_PERSISTENT_MAPPINGS
+};
+
+
+#define DEFAULT_PERSISTENT_MAPPINGS FALSE
+
+#define PERSISTENT_MAPPINGS_ENV_VAR "GSTREAMER_IMX_PERSISTENT_MAPPINGS"
+
+
 #define GST_IMX_DMABUF_MEMORY_TYPE "ImxDmaBufMemory"
 
 
+/* Magic number of the dmabuf pseudo filesystem (see linux/magic.h).
+ * Only DMA-BUF FDs that reside on this filesystem have unique inodes.
+ * Older kernels use one shared anonymous inode for all DMA-BUFs. */
+#ifndef DMA_BUF_MAGIC
+#define DMA_BUF_MAGIC 0x444d4142
+#endif
+
+/* Maximum number of entries in the physical address cache. Upstream
+ * elements typically cycle through a small set of DMA-BUFs, so this
+ * is plenty, while still limiting the cache size if upstream keeps
+ * allocating new DMA-BUFs. */
+#define PHYSICAL_ADDRESS_CACHE_MAX_NUM_ENTRIES 64
+
+
 /* We store the ImxDmaBuffer (or rather, a derived type called InternalImxDmaBuffer)
- * as a qdata in the GstMemory. */
+ * in a GstImxDmaBufMemoryData instance, which is a qdata in the GstMemory. */
 static GQuark gst_imx_dmabuf_memory_internal_imxdmabuffer_quark;
 
+/* Stored as qdata in DMA-BUF GstMemory instances imported with
+ * gst_imx_dmabuf_allocator_import_dmabuf_memory() to remove their
+ * physical address cache entries once these memories are freed. */
+static GQuark gst_imx_dmabuf_memory_cache_invalidation_quark;
+
+
+/* Looking up the physical address of a DMA-BUF FD requires an ioctl.
+ * Since upstream elements usually recycle the same few DMA-BUFs,
+ * the physical addresses are cached. A DMA-BUF is identified by the
+ * device and inode numbers of its FD (the FD numbers themselves are
+ * useless as keys, since the FDs are dup()'d for each import). */
+typedef struct
+{
+	dev_t device;
+	ino_t inode;
+}
+GstImxDmaBufPhysicalAddressCacheKey;
+
+
+typedef struct
+{
+	/* Must be the first field, since the hash table
+	 * uses a pointer to it as the key. */
+	GstImxDmaBufPhysicalAddressCacheKey key;
+
+	/* Used as an additional sanity check. */
+	off_t size;
+
+	imx_physical_address_t physical_address;
+
+	/* Link in the LRU queue, with the most recently used entry at the head. */
+	GList lru_link;
+}
+GstImxDmaBufPhysicalAddressCacheEntry;
+
+
+typedef struct
+{
+	GstImxDmaBufAllocator *allocator;
+	GstImxDmaBufPhysicalAddressCacheKey key;
+}
+GstImxDmaBufCacheInvalidationData;
+
+
+typedef struct
+{
+	ImxDmaBuffer *imx_dma_buffer;
+	GDestroyNotify imx_dma_buffer_destroy_func;
+
+	/* The persistent mapping is created the first time the memory is
+	 * mapped while the persistent-mappings property is TRUE. It then
+	 * stays in place until the memory is freed. This is done in the
+	 * qdata destroy function (and not in the allocator's free vfunc)
+	 * to make sure the mapping is removed before imx_dma_buffer is
+	 * deallocated. persistent_mapping is set atomically, so the
+	 * mapping functions can check it without taking the mutex. */
+	GMutex persistent_mapping_mutex;
+	uint8_t *persistent_mapping;
+	gboolean persistent_mapping_failed;
+}
+GstImxDmaBufMemoryData;
+
 
 static void gst_imx_dmabuf_allocator_phys_mem_allocator_iface_init(gpointer iface, gpointer iface_data);
 static guintptr gst_imx_dmabuf_allocator_get_phys_addr(GstPhysMemoryAllocator *allocator, GstMemory *mem);
@@ -60,10 +152,46 @@ static ImxDmaBuffer* gst_imx_dmabuf_allocator_get_dma_buffer(GstImxDmaBufferAllo
 
 struct _GstImxDmaBufAllocatorPrivate
 {
-	gboolean active;
+	/* Accessed atomically. Once this is set to TRUE, the allocator's
+	 * state no longer changes, so the allocation and physical address
+	 * lookup paths do not need to take the object lock. Only the
+	 * activation itself is done with the object lock held. */
+	gint active;
+
+	/* The physical address cache has its own mutex to
+	 * not have to hold the object lock during lookups. */
+	GMutex physical_address_cache_mutex;
+	GHashTable *physical_address_cache;
+	GQueue physical_address_cache_lru;
+
+	/* Accessed atomically. */
+	gint persistent_mappings;
+
+	/* Accessed atomically, since they are updated in every map call,
+	 * and taking the object lock there would needlessly serialize
+	 * mapping in multiple threads. These are 32-bit counters,
+	 * since not all platforms have 64-bit atomic operations. */
+	guint num_map_calls;
+	guint num_avoided_map_calls;
 };
 
 
+static guint gst_imx_dmabuf_physical_address_cache_key_hash(gconstpointer key)
+{
+	GstImxDmaBufPhysicalAddressCacheKey const *cache_key = (GstImxDmaBufPhysicalAddressCacheKey const *)key;
+	guint64 value = (((guint64)(cache_key->device)) << 32) ^ ((guint64)(cache_key->inode));
+	return g_int64_hash(&value);
+}
+
+
+static gboolean gst_imx_dmabuf_physical_address_cache_key_equal(gconstpointer first_key, gconstpointer second_key)
+{
+	GstImxDmaBufPhysicalAddressCacheKey const *first_cache_key = (GstImxDmaBufPhysicalAddressCacheKey const *)first_key;
+	GstImxDmaBufPhysicalAddressCacheKey const *second_cache_key = (GstImxDmaBufPhysicalAddressCacheKey const *)second_key;
+	return (first_cache_key->device == second_cache_key->device) && (first_cache_key->inode == second_cache_key->inode);
+}
+
+
 G_DEFINE_ABSTRACT_TYPE_WITH_CODE(
 	GstImxDmaBufAllocator, gst_imx_dmabuf_allocator, GST_TYPE_DMABUF_ALLOCATOR,
 	G_IMPLEMENT_INTERFACE(GST_TYPE_PHYS_MEMORY_ALLOCATOR, gst_imx_dmabuf_allocator_phys_mem_allocator_iface_init)
@@ -72,11 +200,15 @@ G_DEFINE_ABSTRACT_TYPE_WITH_CODE(
 )
 
 static void gst_imx_dmabuf_allocator_dispose(GObject *object);
+static void gst_imx_dmabuf_allocator_finalize(GObject *object);
+static void gst_imx_dmabuf_allocator_set_property(GObject *object, guint prop_id, GValue const *value, GParamSpec *pspec);
+static void gst_imx_dmabuf_allocator_get_property(GObject *object, guint prop_id, GValue *value, GParamSpec *pspec);
 
 static GstMemory* gst_imx_dmabuf_allocator_alloc(GstAllocator *allocator, gsize size, GstAllocationParams *params);
 static void gst_imx_dmabuf_allocator_free(GstAllocator* allocator, GstMemory *memory);
 
 static gboolean gst_imx_dmabuf_allocator_activate(GstImxDmaBufAllocator *imx_dmabuf_allocator);
+static imx_physical_address_t gst_imx_dmabuf_allocator_lookup_physical_address(GstImxDmaBufAllocator *imx_dmabuf_allocator, int dmabuf_fd);
 
 static GstMemory * gst_imx_dmabuf_allocator_mem_copy(GstMemory *memory, gssize offset, gssize size);
 static gboolean gst_imx_dmabuf_allocator_mem_is_span(GstMemory *memory1, GstMemory *memory2, gsize *offset);
@@ -92,16 +224,33 @@ static void gst_imx_dmabuf_allocator_class_init(GstImxDmaBufAllocatorClass *klas
 	GST_DEBUG_CATEGORY_INIT(imx_dmabuf_allocator_debug, "imxdmabufallocator", 0, "physical memory allocator which allocates DMA-BUF memory");
 
 	gst_imx_dmabuf_memory_internal_imxdmabuffer_quark = g_quark_from_static_string("gst-imxdmabuffer-dmabuf-memory");
+	gst_imx_dmabuf_memory_cache_invalidation_quark = g_quark_from_static_string("gst-imxdmabuffer-dmabuf-cache-invalidation");
 
 	object_class = G_OBJECT_CLASS(klass);
 	allocator_class = GST_ALLOCATOR_CLASS(klass);
 
 	object_class->dispose = GST_DEBUG_FUNCPTR(gst_imx_dmabuf_allocator_dispose);
+	object_class->finalize = GST_DEBUG_FUNCPTR(gst_imx_dmabuf_allocator_finalize);
+	object_class->set_property = GST_DEBUG_FUNCPTR(gst_imx_dmabuf_allocator_set_property);
+	object_class->get_property = GST_DEBUG_FUNCPTR(gst_imx_dmabuf_allocator_get_property);
 	allocator_class->alloc = GST_DEBUG_FUNCPTR(gst_imx_dmabuf_allocator_alloc);
 	allocator_class->free = GST_DEBUG_FUNCPTR(gst_imx_dmabuf_allocator_free);
 
 	klass->activate = NULL;
 	klass->get_allocator = NULL;
+
+	g_object_class_install_property(
+		object_class,
+		PROP_PERSISTENT_MAPPINGS,
+		g_param_spec_boolean(
+			"persistent-mappings",
+			"Persistent mappings",
+			"Keep memories mapped until they are freed instead of mapping and unmapping them in every gst_memory_map() / gst_memory_unmap() call; "
+			"the default value is TRUE if the " PERSISTENT_MAPPINGS_ENV_VAR " environment variable is set to 1",
+			DEFAULT_PERSISTENT_MAPPINGS,
+			G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS
+		)
+	);
 }
 
 
@@ -112,6 +261,24 @@ static void gst_imx_dmabuf_allocator_init(GstImxDmaBufAllocator *imx_dmabuf_allo
 	imx_dmabuf_allocator->priv = gst_imx_dmabuf_allocator_get_instance_private(imx_dmabuf_allocator);
 	imx_dmabuf_allocator->priv->active = FALSE;
 
+	g_mutex_init(&(imx_dmabuf_allocator->priv->physical_address_cache_mutex));
+	imx_dmabuf_allocator->priv->physical_address_cache = g_hash_table_new_full(
+		gst_imx_dmabuf_physical_address_cache_key_hash,
+		gst_imx_dmabuf_physical_address_cache_key_equal,
+		NULL,
+		g_free
+	);
+	g_queue_init(&(imx_dmabuf_allocator->priv->physical_address_cache_lru));
+
+	imx_dmabuf_allocator->priv->persistent_mappings = DEFAULT_PERSISTENT_MAPPINGS;
+	if (g_strcmp0(g_getenv(PERSISTENT_MAPPINGS_ENV_VAR), "1") == 0)
+	{
+		GST_DEBUG_OBJECT(imx_dmabuf_allocator, "%s environment variable set to 1; enabling persistent mappings", PERSISTENT_MAPPINGS_ENV_VAR);
+		imx_dmabuf_allocator->priv->persistent_mappings = TRUE;
+	}
+	imx_dmabuf_allocator->priv->num_map_calls = 0;
+	imx_dmabuf_allocator->priv->num_avoided_map_calls = 0;
+
 	allocator->mem_type = GST_IMX_DMABUF_MEMORY_TYPE;
 	allocator->mem_copy = GST_DEBUG_FUNCPTR(gst_imx_dmabuf_allocator_mem_copy);
 	allocator->mem_is_span = GST_DEBUG_FUNCPTR(gst_imx_dmabuf_allocator_mem_is_span);
@@ -126,10 +293,111 @@ static void gst_imx_dmabuf_allocator_dispose(GObject *object)
 {
 	GstImxDmaBufAllocator *self = GST_IMX_DMABUF_ALLOCATOR(object);
 	GST_TRACE_OBJECT(self, "finalizing i.MX DMA-BUF GstAllocator %p", (gpointer)self);
+	GST_DEBUG_OBJECT(
+		self,
+		"mapping statistics:  map calls: %u  avoided map calls: %u",
+		(guint)g_atomic_int_get(&(self->priv->num_map_calls)),
+		(guint)g_atomic_int_get(&(self->priv->num_avoided_map_calls))
+	);
 	G_OBJECT_CLASS(gst_imx_dmabuf_allocator_parent_class)->dispose(object);
 }
 
 
+static void gst_imx_dmabuf_allocator_finalize(GObject *object)
+{
+	GstImxDmaBufAllocator *self = GST_IMX_DMABUF_ALLOCATOR(object);
+
+	/* The entries are freed by the hash table, so the
+	 * LRU queue's links must not be freed separately. */
+	g_queue_init(&(self->priv->physical_address_cache_lru));
+	g_hash_table_destroy(self->priv->physical_address_cache);
+	g_mutex_clear(&(self->priv->physical_address_cache_mutex));
+
+	G_OBJECT_CLASS(gst_imx_dmabuf_allocator_parent_class)->finalize(object);
+}
+
+
+static void gst_imx_dmabuf_allocator_set_property(GObject *object, guint prop_id, GValue const *value, GParamSpec *pspec)
+{
+	GstImxDmaBufAllocator *self = GST_IMX_DMABUF_ALLOCATOR(object);
+
+	switch (prop_id)
+	{
+		/* This can be changed at any time. It only affects memories
+		 * that have not been mapped in persistent mode yet; existing
+		 * persistent mappings are kept until their memories are freed. */
+		case PROP_PERSISTENT_MAPPINGS:
+			g_atomic_int_set(&(self->priv->persistent_mappings), g_value_get_boolean(value));
+			break;
+
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+			break;
+	}
+}
+
+
+static void gst_imx_dmabuf_allocator_get_property(GObject *object, guint prop_id, GValue *value, GParamSpec *pspec)
+{
+	GstImxDmaBufAllocator *self = GST_IMX_DMABUF_ALLOCATOR(object);
+
+	switch (prop_id)
+	{
+		case PROP_PERSISTENT_MAPPINGS:
+			g_value_set_boolean(value, g_atomic_int_get(&(self->priv->persistent_mappings)));
+			break;
+
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+			break;
+	}
+}
+
+
+static void gst_imx_dmabuf_memory_data_free(gpointer data)
+{
+	GstImxDmaBufMemoryData *memory_data = (GstImxDmaBufMemoryData *)data;
+
+	if (memory_data->persistent_mapping != NULL)
+		imx_dma_buffer_unmap(memory_data->imx_dma_buffer);
+
+	memory_data->imx_dma_buffer_destroy_func(memory_data->imx_dma_buffer);
+
+	g_mutex_clear(&(memory_data->persistent_mapping_mutex));
+	g_slice_free(GstImxDmaBufMemoryData, memory_data);
+}
+
+
+static void gst_imx_dmabuf_memory_attach_data(GstMemory *memory, ImxDmaBuffer *imx_dma_buffer, GDestroyNotify imx_dma_buffer_destroy_func)
+{
+	GstImxDmaBufMemoryData *memory_data = g_slice_new0(GstImxDmaBufMemoryData);
+
+	memory_data->imx_dma_buffer = imx_dma_buffer;
+	memory_data->imx_dma_buffer_destroy_func = imx_dma_buffer_destroy_func;
+	g_mutex_init(&(memory_data->persistent_mapping_mutex));
+
+	gst_mini_object_set_qdata(
+		GST_MINI_OBJECT_CAST(memory),
+		gst_imx_dmabuf_memory_internal_imxdmabuffer_quark,
+		(gpointer)memory_data,
+		gst_imx_dmabuf_memory_data_free
+	);
+}
+
+
+static GstImxDmaBufMemoryData* get_memory_data(GstMemory *memory)
+{
+	return (GstImxDmaBufMemoryData *)gst_mini_object_get_qdata(GST_MINI_OBJECT_CAST(memory), gst_imx_dmabuf_memory_internal_imxdmabuffer_quark);
+}
+
+
+static ImxDmaBuffer* get_dma_buffer_from_memory(GstMemory *memory)
+{
+	GstImxDmaBufMemoryData *memory_data = get_memory_data(memory);
+	return (memory_data != NULL) ? memory_data->imx_dma_buffer : NULL;
+}
+
+
 static void gst_imx_dmabuf_allocator_phys_mem_allocator_iface_init(gpointer iface, G_GNUC_UNUSED gpointer iface_data)
 {
 	GstPhysMemoryAllocatorInterface *phys_mem_allocator_iface = (GstPhysMemoryAllocatorInterface *)iface;
@@ -139,16 +407,14 @@ static void gst_imx_dmabuf_allocator_phys_mem_allocator_iface_init(gpointer ifac
 
 static guintptr gst_imx_dmabuf_allocator_get_phys_addr(GstPhysMemoryAllocator *allocator, GstMemory *mem)
 {
-	gpointer qdata;
-
-	qdata = gst_mini_object_get_qdata(GST_MINI_OBJECT_CAST(mem), gst_imx_dmabuf_memory_internal_imxdmabuffer_quark);
-	if (G_UNLIKELY(qdata == NULL))
+	ImxDmaBuffer *imx_dma_buffer = get_dma_buffer_from_memory(mem);
+	if (G_UNLIKELY(imx_dma_buffer == NULL))
 	{
 		GST_WARNING_OBJECT(allocator, "GstMemory object %p does not contain imxionbuffer qdata; returning 0 as physical address", (gpointer)mem);
 		return 0;
 	}
 
-	return imx_dma_buffer_get_physical_address((ImxDmaBuffer *)qdata) + mem->offset;
+	return imx_dma_buffer_get_physical_address(imx_dma_buffer) + mem->offset;
 }
 
 
@@ -159,14 +425,6 @@ static void gst_imx_dmabuf_allocator_dma_buffer_allocator_iface_init(gpointer if
 }
 
 
-static ImxDmaBuffer* get_dma_buffer_from_memory(GstMemory *memory)
-{
-	gpointer qdata;
-	qdata = gst_mini_object_get_qdata(GST_MINI_OBJECT_CAST(memory), gst_imx_dmabuf_memory_internal_imxdmabuffer_quark);
-	return ((ImxDmaBuffer *)qdata);
-}
-
-
 static ImxDmaBuffer* gst_imx_dmabuf_allocator_get_dma_buffer(GstImxDmaBufferAllocator *allocator, GstMemory *memory)
 {
 	ImxDmaBuffer *imx_dma_buffer = get_dma_buffer_from_memory(memory);
@@ -194,8 +452,6 @@ static GstMemory* gst_imx_dmabuf_allocator_alloc(GstAllocator *allocator, gsize
 
 	g_assert(klass->get_allocator != NULL);
 
-	GST_OBJECT_LOCK(self);
-
 	if (!gst_imx_dmabuf_allocator_activate(self))
 		goto error;
 
@@ -221,12 +477,7 @@ static GstMemory* gst_imx_dmabuf_allocator_alloc(GstAllocator *allocator, gsize
 		goto error;
 	}
 
-	gst_mini_object_set_qdata(
-		GST_MINI_OBJECT_CAST(memory),
-		gst_imx_dmabuf_memory_internal_imxdmabuffer_quark,
-		(gpointer)imx_dma_buffer,
-		(GDestroyNotify)imx_dma_buffer_deallocate
-	);
+	gst_imx_dmabuf_memory_attach_data(memory, imx_dma_buffer, (GDestroyNotify)imx_dma_buffer_deallocate);
 	qdata_set = TRUE;
 
 	GST_DEBUG_OBJECT(
@@ -240,7 +491,6 @@ static GstMemory* gst_imx_dmabuf_allocator_alloc(GstAllocator *allocator, gsize
 	);
 
 finish:
-	GST_OBJECT_UNLOCK(self);
 	return memory;
 
 error:
@@ -265,29 +515,169 @@ static void gst_imx_dmabuf_allocator_free(GstAllocator* allocator, GstMemory *me
 
 static gboolean gst_imx_dmabuf_allocator_activate(GstImxDmaBufAllocator *imx_dmabuf_allocator)
 {
-	/* must be called with object lock held */
+	/* must be called with object lock NOT held */
 
 	GstImxDmaBufAllocatorClass *klass = GST_IMX_DMABUF_ALLOCATOR_CLASS(G_OBJECT_GET_CLASS(imx_dmabuf_allocator));
+	gboolean ret = TRUE;
 
 	g_assert(klass->activate != NULL);
 
-	if (imx_dmabuf_allocator->priv->active)
+	/* Fast path, taken by every call after the activation. g_once_init_enter()
+	 * is not usable here, since activation can fail, and must then be retried
+	 * by subsequent calls. Instead, this uses double-checked locking. The
+	 * atomic get/set functions imply full memory barriers, so once the flag
+	 * is seen as set, the state that was set up by the activation is
+	 * visible as well. */
+	if (G_LIKELY(g_atomic_int_get(&(imx_dmabuf_allocator->priv->active))))
 		return TRUE;
 
+	GST_OBJECT_LOCK(imx_dmabuf_allocator);
+
+	if (g_atomic_int_get(&(imx_dmabuf_allocator->priv->active)))
+		goto finish;
+
 	if (!klass->activate(imx_dmabuf_allocator))
 	{
 		GST_ERROR_OBJECT(imx_dmabuf_allocator, "could not activate i.MX DMA-BUF allocator");
-		return FALSE;
+		ret = FALSE;
+		goto finish;
 	}
 
 	GST_DEBUG_OBJECT(imx_dmabuf_allocator, "i.MX DMA-BUF allocator activated");
 
-	imx_dmabuf_allocator->priv->active = TRUE;
+	g_atomic_int_set(&(imx_dmabuf_allocator->priv->active), TRUE);
+
+finish:
+	GST_OBJECT_UNLOCK(imx_dmabuf_allocator);
+	return ret;
+}
+
+
+static gboolean gst_imx_dmabuf_allocator_get_cache_key(int dmabuf_fd, GstImxDmaBufPhysicalAddressCacheKey *key, off_t *size)
+{
+	struct stat stat_buf;
+	struct statfs statfs_buf;
+
+	/* If the DMA-BUF does not reside on the dmabuf filesystem, its
+	 * inode is shared with other DMA-BUFs, and cannot be used as a key. */
+	if ((fstatfs(dmabuf_fd, &statfs_buf) < 0) || (statfs_buf.f_type != DMA_BUF_MAGIC))
+		return FALSE;
+
+	if (fstat(dmabuf_fd, &stat_buf) < 0)
+		return FALSE;
+
+	key->device = stat_buf.st_dev;
+	key->inode = stat_buf.st_ino;
+	*size = stat_buf.st_size;
 
 	return TRUE;
 }
 
 
+static void gst_imx_dmabuf_allocator_remove_cache_entry(GstImxDmaBufAllocator *imx_dmabuf_allocator, GstImxDmaBufPhysicalAddressCacheEntry *entry)
+{
+	/* must be called with the physical address cache mutex held */
+
+	g_queue_unlink(&(imx_dmabuf_allocator->priv->physical_address_cache_lru), &(entry->lru_link));
+	g_hash_table_remove(imx_dmabuf_allocator->priv->physical_address_cache, &(entry->key));
+}
+
+
+static imx_physical_address_t gst_imx_dmabuf_allocator_lookup_physical_address(GstImxDmaBufAllocator *imx_dmabuf_allocator, int dmabuf_fd)
+{
+	GstImxDmaBufAllocatorClass *klass = GST_IMX_DMABUF_ALLOCATOR_CLASS(G_OBJECT_GET_CLASS(imx_dmabuf_allocator));
+	GstImxDmaBufAllocatorPrivate *priv = imx_dmabuf_allocator->priv;
+	GstImxDmaBufPhysicalAddressCacheKey key;
+	GstImxDmaBufPhysicalAddressCacheEntry *entry;
+	imx_physical_address_t physical_address = 0;
+	gboolean has_key;
+	off_t size = 0;
+
+	has_key = gst_imx_dmabuf_allocator_get_cache_key(dmabuf_fd, &key, &size);
+
+	if (has_key)
+	{
+		g_mutex_lock(&(priv->physical_address_cache_mutex));
+
+		entry = g_hash_table_lookup(priv->physical_address_cache, &key);
+		if (entry != NULL)
+		{
+			if (entry->size == size)
+			{
+				physical_address = entry->physical_address;
+				g_queue_unlink(&(priv->physical_address_cache_lru), &(entry->lru_link));
+				g_queue_push_head_link(&(priv->physical_address_cache_lru), &(entry->lru_link));
+			}
+			else
+			{
+				/* The DMA-BUF this entry was created for is gone,
+				 * and its inode was reused by another DMA-BUF. */
+				gst_imx_dmabuf_allocator_remove_cache_entry(imx_dmabuf_allocator, entry);
+			}
+		}
+
+		g_mutex_unlock(&(priv->physical_address_cache_mutex));
+
+		if (physical_address != 0)
+		{
+			GST_LOG_OBJECT(imx_dmabuf_allocator, "found physical address %" IMX_PHYSICAL_ADDRESS_FORMAT " for DMA-BUF FD %d in cache", physical_address, dmabuf_fd);
+			return physical_address;
+		}
+	}
+
+	if (gst_imx_dmabuf_allocator_activate(imx_dmabuf_allocator))
+		physical_address = klass->get_physical_address(imx_dmabuf_allocator, dmabuf_fd);
+
+	if ((physical_address == 0) || !has_key)
+		return physical_address;
+
+	g_mutex_lock(&(priv->physical_address_cache_mutex));
+
+	/* Another thread may have added an entry for the same
+	 * DMA-BUF in the meantime, so check before inserting. */
+	if (g_hash_table_lookup(priv->physical_address_cache, &key) == NULL)
+	{
+		entry = g_new0(GstImxDmaBufPhysicalAddressCacheEntry, 1);
+		entry->key = key;
+		entry->size = size;
+		entry->physical_address = physical_address;
+		entry->lru_link.data = entry;
+
+		g_hash_table_insert(priv->physical_address_cache, &(entry->key), entry);
+		g_queue_push_head_link(&(priv->physical_address_cache_lru), &(entry->lru_link));
+
+		while (g_queue_get_length(&(priv->physical_address_cache_lru)) > PHYSICAL_ADDRESS_CACHE_MAX_NUM_ENTRIES)
+		{
+			GstImxDmaBufPhysicalAddressCacheEntry *oldest_entry = priv->physical_address_cache_lru.tail->data;
+			gst_imx_dmabuf_allocator_remove_cache_entry(imx_dmabuf_allocator, oldest_entry);
+		}
+	}
+
+	g_mutex_unlock(&(priv->physical_address_cache_mutex));
+
+	return physical_address;
+}
+
+
+static void gst_imx_dmabuf_allocator_invalidate_cache_entry(gpointer data)
+{
+	GstImxDmaBufCacheInvalidationData *invalidation_data = (GstImxDmaBufCacheInvalidationData *)data;
+	GstImxDmaBufAllocator *imx_dmabuf_allocator = invalidation_data->allocator;
+	GstImxDmaBufPhysicalAddressCacheEntry *entry;
+
+	g_mutex_lock(&(imx_dmabuf_allocator->priv->physical_address_cache_mutex));
+	entry = g_hash_table_lookup(imx_dmabuf_allocator->priv->physical_address_cache, &(invalidation_data->key));
+	if (entry != NULL)
+		gst_imx_dmabuf_allocator_remove_cache_entry(imx_dmabuf_allocator, entry);
+	g_mutex_unlock(&(imx_dmabuf_allocator->priv->physical_address_cache_mutex));
+
+	GST_LOG_OBJECT(imx_dmabuf_allocator, "DMA-BUF memory was freed; removed its physical address cache entry (if any)");
+
+	gst_object_unref(GST_OBJECT(imx_dmabuf_allocator));
+	g_free(invalidation_data);
+}
+
+
 static GstMemory * gst_imx_dmabuf_allocator_mem_copy(GstMemory *original_memory, gssize offset, gssize size)
 {
 	GstImxDmaBufAllocator *imx_dmabuf_allocator = GST_IMX_DMABUF_ALLOCATOR(original_memory->allocator);
@@ -362,15 +752,100 @@ static gboolean gst_imx_dmabuf_allocator_mem_is_span(G_GNUC_UNUSED GstMemory *me
 }
 
 
+/* Returns the persistent mapping of the memory, creating it if necessary.
+ * Returns NULL if the persistent mapping could not be created. */
+static uint8_t* gst_imx_dmabuf_allocator_get_persistent_mapping(GstMemory *memory, GstImxDmaBufMemoryData *memory_data, gboolean *reused)
+{
+	uint8_t *mapped_virtual_address;
+	int error;
+
+	*reused = FALSE;
+
+	g_mutex_lock(&(memory_data->persistent_mapping_mutex));
+
+	if (memory_data->persistent_mapping != NULL)
+	{
+		*reused = TRUE;
+	}
+	else if (!memory_data->persistent_mapping_failed)
+	{
+		/* The mapping is shared by all subsequent gst_memory_map()
+		 * calls, so always map with read and write access. Syncing
+		 * is done separately by each of these calls. */
+		mapped_virtual_address = imx_dma_buffer_map(
+			memory_data->imx_dma_buffer,
+			IMX_DMA_BUFFER_MAPPING_FLAG_READ | IMX_DMA_BUFFER_MAPPING_FLAG_WRITE | IMX_DMA_BUFFER_MAPPING_FLAG_MANUAL_SYNC,
+			&error
+		);
+
+		if (mapped_virtual_address != NULL)
+		{
+			g_atomic_pointer_set(&(memory_data->persistent_mapping), mapped_virtual_address);
+
+			GST_LOG_OBJECT(
+				memory->allocator,
+				"created persistent mapping for imxdmabuffer %p with FD %d, mapped virtual address: %p",
+				(gpointer)(memory_data->imx_dma_buffer),
+				imx_dma_buffer_get_fd(memory_data->imx_dma_buffer),
+				(gpointer)mapped_virtual_address
+			);
+		}
+		else
+		{
+			/* This can happen with imported read-only DMA-BUFs. Do not
+			 * retry in subsequent calls, and use regular mappings instead. */
+			memory_data->persistent_mapping_failed = TRUE;
+
+			GST_DEBUG_OBJECT(
+				memory->allocator,
+				"could not create persistent mapping for imxdmabuffer %p with FD %d: %s (%d); using regular mappings instead",
+				(gpointer)(memory_data->imx_dma_buffer),
+				imx_dma_buffer_get_fd(memory_data->imx_dma_buffer),
+				strerror(error), error
+			);
+		}
+	}
+
+	mapped_virtual_address = memory_data->persistent_mapping;
+
+	g_mutex_unlock(&(memory_data->persistent_mapping_mutex));
+
+	return mapped_virtual_address;
+}
+
+
 static gpointer gst_imx_dmabuf_allocator_mem_map_full(GstMemory *memory, GstMapInfo *info, G_GNUC_UNUSED gsize maxsize)
 {
+	GstImxDmaBufAllocator *self = GST_IMX_DMABUF_ALLOCATOR(memory->allocator);
+	GstImxDmaBufMemoryData *memory_data;
 	ImxDmaBuffer *imx_dma_buffer;
 	unsigned int flags = 0;
-	uint8_t *mapped_virtual_address;
+	uint8_t *mapped_virtual_address = NULL;
+	gboolean reused_persistent_mapping = FALSE;
 	int error;
 
-	imx_dma_buffer = get_dma_buffer_from_memory(memory);
-	g_assert(imx_dma_buffer != NULL);
+	memory_data = get_memory_data(memory);
+	g_assert(memory_data != NULL);
+	imx_dma_buffer = memory_data->imx_dma_buffer;
+
+	/* user_data[0] records whether this mapping uses the persistent
+	 * mapping, since the persistent-mappings property may have been
+	 * changed by the time unmap_full is called. */
+	info->user_data[0] = GINT_TO_POINTER(FALSE);
+
+	if (g_atomic_int_get(&(self->priv->persistent_mappings)) || (g_atomic_pointer_get(&(memory_data->persistent_mapping)) != NULL))
+	{
+		mapped_virtual_address = gst_imx_dmabuf_allocator_get_persistent_mapping(memory, memory_data, &reused_persistent_mapping);
+		if (mapped_virtual_address != NULL)
+		{
+			/* Instead of mapping again, only begin CPU access. */
+			if (!(info->flags & GST_MAP_FLAG_IMX_MANUAL_SYNC))
+				imx_dma_buffer_start_sync_session(imx_dma_buffer);
+
+			info->user_data[0] = GINT_TO_POINTER(TRUE);
+			goto finish;
+		}
+	}
 
 	flags |= (info->flags & GST_MAP_READ) ? IMX_DMA_BUFFER_MAPPING_FLAG_READ : 0;
 	flags |= (info->flags & GST_MAP_WRITE) ? IMX_DMA_BUFFER_MAPPING_FLAG_WRITE : 0;
@@ -398,17 +873,29 @@ static gpointer gst_imx_dmabuf_allocator_mem_map_full(GstMemory *memory, GstMapI
 	);
 
 finish:
+	g_atomic_int_inc(&(self->priv->num_map_calls));
+	if (reused_persistent_mapping)
+		g_atomic_int_inc(&(self->priv->num_avoided_map_calls));
+
 	return mapped_virtual_address;
 }
 
 
-static void gst_imx_dmabuf_allocator_mem_unmap_full(GstMemory *memory, G_GNUC_UNUSED GstMapInfo *info)
+static void gst_imx_dmabuf_allocator_mem_unmap_full(GstMemory *memory, GstMapInfo *info)
 {
 	ImxDmaBuffer *imx_dma_buffer;
 
 	imx_dma_buffer = get_dma_buffer_from_memory(memory);
 	g_assert(imx_dma_buffer != NULL);
 
+	/* Persistent mappings stay in place; only end CPU access. */
+	if (GPOINTER_TO_INT(info->user_data[0]))
+	{
+		if (!(info->flags & GST_MAP_FLAG_IMX_MANUAL_SYNC))
+			imx_dma_buffer_stop_sync_session(imx_dma_buffer);
+		return;
+	}
+
 	GST_LOG_OBJECT(
 		memory->allocator,
 		"unmapped imxdmabuffer %p with FD %d",
@@ -433,23 +920,14 @@ guintptr gst_imx_dmabuf_allocator_get_physical_address(GstImxDmaBufAllocator *al
 	g_assert(dmabuf_fd > 0);
 	g_assert(klass->get_physical_address != NULL);
 
-	imx_physical_address_t physical_address = 0;
-
-	GST_OBJECT_LOCK(self);
-
-	if (!gst_imx_dmabuf_allocator_activate(self))
-		goto finish;
-
-	physical_address = klass->get_physical_address(self, dmabuf_fd);
+	imx_physical_address_t physical_address = gst_imx_dmabuf_allocator_lookup_physical_address(self, dmabuf_fd);
 	if (physical_address == 0)
 	{
 		GST_ERROR_OBJECT(self, "could not open get physical address for DMA-BUF FD %d", dmabuf_fd);
-		goto finish;
+		return 0;
 	}
 	GST_DEBUG_OBJECT(self, "got physical address %" IMX_PHYSICAL_ADDRESS_FORMAT " for DMA-BUF FD", physical_address);
 
-finish:
-	GST_OBJECT_UNLOCK(self);
 	return physical_address;
 }
 
@@ -466,12 +944,7 @@ GstMemory* gst_imx_dmabuf_allocator_wrap_dmabuf(GstAllocator *allocator, int dma
 	g_assert(dmabuf_size > 0);
 	g_assert(klass->get_physical_address != NULL);
 
-	GST_OBJECT_LOCK(self);
-
-	if (!gst_imx_dmabuf_allocator_activate(self))
-		goto error;
-
-	physical_address = klass->get_physical_address(self, dmabuf_fd);
+	physical_address = gst_imx_dmabuf_allocator_lookup_physical_address(self, dmabuf_fd);
 	if (physical_address == 0)
 	{
 		GST_ERROR_OBJECT(self, "could not open get physical address for DMA-BUF FD %d", dmabuf_fd);
@@ -494,12 +967,7 @@ GstMemory* gst_imx_dmabuf_allocator_wrap_dmabuf(GstAllocator *allocator, int dma
 		goto error;
 	}
 
-	gst_mini_object_set_qdata(
-		GST_MINI_OBJECT_CAST(memory),
-		gst_imx_dmabuf_memory_internal_imxdmabuffer_quark,
-		(gpointer)wrapped_dma_buffer,
-		g_free
-	);
+	gst_imx_dmabuf_memory_attach_data(memory, (ImxDmaBuffer *)wrapped_dma_buffer, g_free);
 
 	GST_DEBUG_OBJECT(
 		self,
@@ -511,7 +979,6 @@ GstMemory* gst_imx_dmabuf_allocator_wrap_dmabuf(GstAllocator *allocator, int dma
 	);
 
 finish:
-	GST_OBJECT_UNLOCK(self);
 	return memory;
 
 error:
@@ -521,24 +988,104 @@ error:
 }
 
 
-gboolean gst_imx_dmabuf_allocator_is_active(GstAllocator *allocator)
+GstMemory* gst_imx_dmabuf_allocator_import_dmabuf_memory(GstAllocator *allocator, GstMemory *dmabuf_memory)
+{
+	GstImxDmaBufAllocator *self = GST_IMX_DMABUF_ALLOCATOR(allocator);
+	GstMemory *memory;
+	int dmabuf_fd, dup_dmabuf_fd;
+
+	g_assert(dmabuf_memory != NULL);
+	g_assert(gst_is_dmabuf_memory(dmabuf_memory));
+
+	dmabuf_fd = gst_dmabuf_memory_get_fd(dmabuf_memory);
+	g_assert(dmabuf_fd > 0);
+
+	/* dup() the FD to share ownership over the DMA-BUF. That
+	 * way, the wrapped memory can close its FD independently. */
+	dup_dmabuf_fd = dup(dmabuf_fd);
+	if (G_UNLIKELY(dup_dmabuf_fd < 0))
+	{
+		GST_ERROR_OBJECT(self, "could not duplicate dmabuf FD: %s (%d)", strerror(errno), errno);
+		return NULL;
+	}
+
+	memory = gst_imx_dmabuf_allocator_wrap_dmabuf(allocator, dup_dmabuf_fd, dmabuf_memory->size);
+	if (G_UNLIKELY(memory == NULL))
+	{
+		close(dup_dmabuf_fd);
+		return NULL;
+	}
+
+	memory->maxsize = dmabuf_memory->maxsize;
+	memory->align = dmabuf_memory->align;
+	memory->offset = dmabuf_memory->offset;
+
+	/* Tie the physical address cache entry to the lifetime of the
+	 * imported memory. Upstream elements typically keep their DMA-BUF
+	 * memories alive in their buffer pools, so the entry remains valid
+	 * for as long as the DMA-BUF is recycled, and is removed as soon
+	 * as upstream frees it. */
+	if (gst_mini_object_get_qdata(GST_MINI_OBJECT_CAST(dmabuf_memory), gst_imx_dmabuf_memory_cache_invalidation_quark) == NULL)
+	{
+		GstImxDmaBufPhysicalAddressCacheKey key;
+		off_t size;
+
+		if (gst_imx_dmabuf_allocator_get_cache_key(dmabuf_fd, &key, &size))
+		{
+			GstImxDmaBufCacheInvalidationData *invalidation_data = g_new0(GstImxDmaBufCacheInvalidationData, 1);
+			invalidation_data->allocator = gst_object_ref(self);
+			invalidation_data->key = key;
+
+			gst_mini_object_set_qdata(
+				GST_MINI_OBJECT_CAST(dmabuf_memory),
+				gst_imx_dmabuf_memory_cache_invalidation_quark,
+				invalidation_data,
+				gst_imx_dmabuf_allocator_invalidate_cache_entry
+			);
+		}
+	}
+
+	return memory;
+}
+
+
+void gst_imx_dmabuf_allocator_get_mapping_statistics(GstAllocator *allocator, guint64 *num_map_calls, guint64 *num_avoided_map_calls)
 {
 	GstImxDmaBufAllocator *self;
-	gboolean active;
 
 	g_assert(allocator != NULL);
 	self = GST_IMX_DMABUF_ALLOCATOR(allocator);
 
-	GST_OBJECT_LOCK(self);
-	active = self->priv->active;
-	GST_OBJECT_UNLOCK(self);
+	if (num_map_calls != NULL)
+		*num_map_calls = (guint)g_atomic_int_get(&(self->priv->num_map_calls));
+	if (num_avoided_map_calls != NULL)
+		*num_avoided_map_calls = (guint)g_atomic_int_get(&(self->priv->num_avoided_map_calls));
+}
+
+
+gboolean gst_imx_dmabuf_allocator_is_active(GstAllocator *allocator)
+{
+	GstImxDmaBufAllocator *self;
 
-	return active;
+	g_assert(allocator != NULL);
+	self = GST_IMX_DMABUF_ALLOCATOR(allocator);
+
+	return g_atomic_int_get(&(self->priv->active));
 }
 
 
 GstAllocator* gst_imx_dmabuf_allocator_new(void)
 {
+#if defined(WITH_GST_MEMFD_ALLOCATOR)
+	/* The memfd allocator is only a stand-in for machines without
+	 * i.MX kernel interfaces. Since its physical addresses are not
+	 * real, it must not be picked by accident on an actual i.MX
+	 * machine, so it needs to be explicitely requested, unless
+	 * no other DMA-BUF allocator is available. */
+	if (g_strcmp0(g_getenv("GSTREAMER_IMX_USE_MEMFD_ALLOCATOR"), "1") == 0)
+		return gst_imx_memfd_allocator_new();
+#endif
+
 #if defined(WITH_GST_DMA_HEAP_ALLOCATOR)
 	if (g_strcmp0(g_getenv("GSTREAMER_IMX_DISABLE_DMA_HEAP_ALLOCATOR"), "1") != 0)
 		return gst_imx_dma_heap_allocator_new();
@@ -549,6 +1096,10 @@ GstAllocator* gst_imx_dmabuf_allocator_new(void)
 		return gst_imx_ion_allocator_new();
 #endif
 
+#if defined(WITH_GST_MEMFD_ALLOCATOR)
+	return gst_imx_memfd_allocator_new();
+#endif
+
 	/* No DMA-BUF capable allocator enabled. In such a case, calling this is an error. */
 	g_assert_not_reached();
 	return NULL;
@@ -55,7 +55,11 @@ struct _GstImxDmaBufAllocatorClass
 {
     GstDmaBufAllocatorClass parent_class;
 
-    /* NOTE: Acquire the GstObject lock before accessing these vmethods. */
+    /* NOTE: activate is called with the GstObject lock held, and at most
+     * once successfully. The other vmethods are only called after the
+     * allocator was activated, without holding the GstObject lock, and
+     * potentially from multiple threads at the same time. They must
+     * therefore not modify the allocator's state. */
     gboolean (*activate)(GstImxDmaBufAllocator *allocator);
     guintptr (*get_physical_address)(GstImxDmaBufAllocator *allocator, int dmabuf_fd);
     ImxDmaBufferAllocator* (*get_allocator)(GstImxDmaBufAllocator *allocator);
@@ -70,6 +74,9 @@ GType gst_imx_dmabuf_allocator_get_type(void);
  * @dmabuf_fd: DMA-BUF FD to get a physical address from. Must be valid.
  *
  * Retrieves a physical address for the given DMA-BUF file descriptor.
+ * Results are cached, so repeated calls for the same DMA-BUF do not
+ * have to query the DMA-BUF device (see
+ * @gst_imx_dmabuf_allocator_import_dmabuf_memory for details).
  *
  * Returns: The physical address to the physically contiguous DMA memory
  *          block represented by the DMA-BUF FD, or 0 if retrieving the
@@ -97,6 +104,54 @@ guintptr gst_imx_dmabuf_allocator_get_physical_address(GstImxDmaBufAllocator *al
  */
 GstMemory* gst_imx_dmabuf_allocator_wrap_dmabuf(GstAllocator *allocator, int dmabuf_fd, gsize dmabuf_size);
 
+/**
+ * gst_imx_dmabuf_allocator_import_dmabuf_memory:
+ * @allocator: Allocator to use.
+ * @dmabuf_memory: DMA-BUF GstMemory to import.
+ *
+ * Imports the DMA-BUF contained in @dmabuf_memory by duplicating its FD
+ * and wrapping the duplicate with @gst_imx_dmabuf_allocator_wrap_dmabuf.
+ * The size, maxsize, align and offset values of @dmabuf_memory are copied
+ * over to the new GstMemory.
+ *
+ * Physical addresses of DMA-BUFs are cached by the allocator, since they
+ * can only be retrieved with an ioctl. When importing the same DMA-BUF
+ * again (which is common, since upstream elements usually recycle their
+ * buffers), the cached address is used. The cache entry is invalidated
+ * once @dmabuf_memory is freed. For this purpose, a qdata is attached
+ * to @dmabuf_memory.
+ *
+ * Returns: (transfer full) (nullable): GstMemory containing an ImxDmaBuffer
+ *          which wraps the DMA-BUF, or NULL in case of failure.
+ */
+GstMemory* gst_imx_dmabuf_allocator_import_dmabuf_memory(GstAllocator *allocator, GstMemory *dmabuf_memory);
+
+/**
+ * gst_imx_dmabuf_allocator_get_mapping_statistics:
+ * @allocator: Allocator to get statistics from.
+ * @num_map_calls: Pointer to a guint64 that will be set to the number of
+ *     times memories from this allocator were mapped. Can be NULL.
+ * @num_avoided_map_calls: Pointer to a guint64 that will be set to the
+ *     number of these times where an existing persistent mapping was
+ *     reused instead of mapping the memory again. Can be NULL.
+ *
+ * Retrieves statistics about mappings of memories from this allocator.
+ * The counters are 32 bits wide internally, and wrap around once they
+ * exceed G_MAXUINT.
+ *
+ * Persistent mappings are enabled by setting the "persistent-mappings"
+ * property to TRUE (or by setting the GSTREAMER_IMX_PERSISTENT_MAPPINGS
+ * environment variable to 1). A memory is then mapped the first time
+ * @gst_memory_map is called, and stays mapped until it is freed.
+ * Subsequent @gst_memory_map and @gst_memory_unmap calls only begin and
+ * end CPU access (which syncs the CPU caches) instead of mapping and
+ * unmapping the memory. If @GST_MAP_FLAG_IMX_MANUAL_SYNC is used, not
+ * even that is done. This is useful when memories are accessed by
+ * the CPU in every frame, especially when they are recycled in
+ * buffer pools.
+ */
+void gst_imx_dmabuf_allocator_get_mapping_statistics(GstAllocator *allocator, guint64 *num_map_calls, guint64 *num_avoided_map_calls);
+
 /**
  * gst_imx_dmabuf_allocator_is_active:
  * @allocator: Allocator to check.
@@ -106,6 +161,9 @@ GstMemory* gst_imx_dmabuf_allocator_wrap_dmabuf(GstAllocator *allocator, int dma
  * done exactly once during the lifetime of the allocator, and is where
  * the allocator opens a device FD etc.
  *
+ * This function does not take the object lock, so it can be
+ * called while holding it (for example in property setters).
+ *
  * @allocator must be based on #GstImxDmaBufAllocator.
  *
  * Returns: true if the allocator is active.
@@ -122,6 +180,11 @@ gboolean gst_imx_dmabuf_allocator_is_active(GstAllocator *allocator);
  * If one such allocator is available, but creating it fails, this
  * function returns NULL.
  *
+ * If the memfd allocator is enabled in the build configuration, it is
+ * chosen if the GSTREAMER_IMX_USE_MEMFD_ALLOCATOR environment variable
+ * is set to 1, or if no other DMA-BUF capable allocator is available.
+ * See #GstImxMemfdAllocator for details.
+ *
  * Returns: (transfer full) (nullable): Newly created allocator, or NULL in case of failure.
  */
 GstAllocator* gst_imx_dmabuf_allocator_new(void);
@@ -24,7 +24,16 @@
  */
 #include "config.h"
 
+#include <errno.h>
+#include <string.h>
+#ifdef GST_DMABUF_ALLOCATOR_AVAILABLE
+#include <sys/ioctl.h>
+#include <linux/dma-buf.h>
+#endif
 #include <gst/gst.h>
+#ifdef GST_DMABUF_ALLOCATOR_AVAILABLE
+#include <gst/allocators/allocators.h>
+#endif
 #include "gstimxdmabufferallocator.h"
 #include "gstimxdmabufallocator.h"
 #include "gstimxdefaultallocator.h"
@@ -98,6 +107,186 @@ ImxDmaBuffer* gst_imx_get_dma_buffer_from_buffer(GstBuffer *buffer)
 }
 
 
+typedef enum
+{
+	CPU_ACCESS_BEGIN,
+	CPU_ACCESS_END
+}
+CpuAccessStep;
+
+
+static void gst_imx_memory_sync_cpu_access(GstMemory *memory, GstMapFlags access, gsize offset, gssize size, CpuAccessStep step)
+{
+	gsize memory_size;
+
+	if (!gst_imx_is_imx_dma_buffer_memory(memory))
+		return;
+
+	if ((access & (GST_MAP_READ | GST_MAP_WRITE)) == 0)
+		return;
+
+	memory_size = memory->size;
+	if ((offset >= memory_size) || (size == 0))
+	{
+		GST_LOG("range is empty; not syncing memory %p", (gpointer)memory);
+		return;
+	}
+
+#ifdef GST_DMABUF_ALLOCATOR_AVAILABLE
+	/* With DMA-BUFs, the sync direction can be picked for each CPU access.
+	 * This lets the kernel skip cache operations that are not needed for
+	 * the given access (for example, no cache invalidation when the CPU
+	 * only writes). libimxdmabuffer's sync sessions always use the
+	 * access mode that was specified when the buffer was mapped. */
+	if (gst_is_dmabuf_memory(memory))
+	{
+		struct dma_buf_sync sync;
+		int dmabuf_fd = gst_dmabuf_memory_get_fd(memory);
+
+		sync.flags = (step == CPU_ACCESS_BEGIN) ? DMA_BUF_SYNC_START : DMA_BUF_SYNC_END;
+		sync.flags |= (access & GST_MAP_READ) ? DMA_BUF_SYNC_READ : 0;
+		sync.flags |= (access & GST_MAP_WRITE) ? DMA_BUF_SYNC_WRITE : 0;
+
+		/* ENOTTY is returned if the FD is not an actual DMA-BUF, which
+		 * is the case with the plain memfds of GstImxMemfdAllocator.
+		 * There is nothing to sync with these. */
+		if ((ioctl(dmabuf_fd, DMA_BUF_IOCTL_SYNC, &sync) < 0) && (errno != ENOTTY))
+			GST_WARNING("could not sync DMA-BUF FD %d of memory %p: %s (%d)", dmabuf_fd, (gpointer)memory, strerror(errno), errno);
+
+		return;
+	}
+#endif
+
+	{
+		ImxDmaBuffer *imx_dma_buffer = gst_imx_get_dma_buffer_from_memory(memory);
+		g_assert(imx_dma_buffer != NULL);
+
+		if (step == CPU_ACCESS_BEGIN)
+			imx_dma_buffer_start_sync_session(imx_dma_buffer);
+		else
+			imx_dma_buffer_stop_sync_session(imx_dma_buffer);
+	}
+}
+
+
+static void gst_imx_buffer_sync_cpu_access(GstBuffer *buffer, GstMapFlags access, gsize offset, gssize size, CpuAccessStep step)
+{
+	guint memory_index, num_memories;
+	gsize skip;
+
+	g_assert(buffer != NULL);
+
+	if (size == 0)
+		return;
+
+	if (!gst_buffer_find_memory(buffer, offset, (size < 0) ? (gsize)-1 : (gsize)size, &memory_index, &num_memories, &skip))
+	{
+		GST_LOG("range is outside of buffer %p; not syncing", (gpointer)buffer);
+		return;
+	}
+
+	for (; num_memories > 0; --num_memories, ++memory_index)
+	{
+		GstMemory *memory = gst_buffer_peek_memory(buffer, memory_index);
+		gsize memory_range_size = memory->size - skip;
+
+		if ((size >= 0) && ((gsize)size < memory_range_size))
+			memory_range_size = size;
+
+		gst_imx_memory_sync_cpu_access(memory, access, skip, memory_range_size, step);
+
+		if (size >= 0)
+			size -= memory_range_size;
+		skip = 0;
+	}
+}
+
+
+/**
+ * gst_imx_memory_begin_cpu_access:
+ * @memory: a #GstMemory
+ * @access: GST_MAP_READ and/or GST_MAP_WRITE, depending on what
+ *     the CPU will do with the range
+ * @offset: start of the range, relative to the start of the memory's data
+ * @size: size of the range, in bytes, or -1 to specify the rest of the memory
+ *
+ * Syncs the CPU caches before the CPU accesses the given range of the memory.
+ * Call this after mapping the memory with GST_MAP_FLAG_IMX_MANUAL_SYNC. Once
+ * the CPU is done, call gst_imx_memory_end_cpu_access() with the same
+ * arguments. Using explicit syncs instead of the implicit ones done by
+ * gst_memory_map() and gst_memory_unmap() lets the caller sync once for
+ * multiple maps (like the per-plane maps done by gst_video_frame_map()),
+ * sync only in the direction that is needed, and skip syncs entirely
+ * when nothing is accessed.
+ *
+ * The kernel interfaces for syncing (DMA-BUF sync ioctls and the
+ * libimxdmabuffer sync sessions) always sync the whole buffer, so a
+ * range that covers only part of a memory currently syncs all of it.
+ * Ranges still matter for empty ranges, which skip syncing, and for
+ * buffers with multiple memories (see gst_imx_buffer_begin_cpu_access()),
+ * where only memories that overlap the range are synced.
+ *
+ * Memories that are not backed by an ImxDmaBuffer are ignored.
+ */
+void gst_imx_memory_begin_cpu_access(GstMemory *memory, GstMapFlags access, gsize offset, gssize size)
+{
+	g_assert(memory != NULL);
+	gst_imx_memory_sync_cpu_access(memory, access, offset, size, CPU_ACCESS_BEGIN);
+}
+
+
+/**
+ * gst_imx_memory_end_cpu_access:
+ * @memory: a #GstMemory
+ * @access: GST_MAP_READ and/or GST_MAP_WRITE, depending on what
+ *     the CPU did with the range
+ * @offset: start of the range, relative to the start of the memory's data
+ * @size: size of the range, in bytes, or -1 to specify the rest of the memory
+ *
+ * Counterpart of gst_imx_memory_begin_cpu_access(). Call this once the CPU
+ * is done accessing the range, before unmapping the memory.
+ */
+void gst_imx_memory_end_cpu_access(GstMemory *memory, GstMapFlags access, gsize offset, gssize size)
+{
+	g_assert(memory != NULL);
+	gst_imx_memory_sync_cpu_access(memory, access, offset, size, CPU_ACCESS_END);
+}
+
+
+/**
+ * gst_imx_buffer_begin_cpu_access:
+ * @buffer: a #GstBuffer
+ * @access: GST_MAP_READ and/or GST_MAP_WRITE, depending on what
+ *     the CPU will do with the range
+ * @offset: start of the range, relative to the start of the buffer's data
+ * @size: size of the range, in bytes, or -1 to specify the rest of the buffer
+ *
+ * Calls gst_imx_memory_begin_cpu_access() for each memory in the buffer
+ * that overlaps the given range.
+ */
+void gst_imx_buffer_begin_cpu_access(GstBuffer *buffer, GstMapFlags access, gsize offset, gssize size)
+{
+	gst_imx_buffer_sync_cpu_access(buffer, access, offset, size, CPU_ACCESS_BEGIN);
+}
+
+
+/**
+ * gst_imx_buffer_end_cpu_access:
+ * @buffer: a #GstBuffer
+ * @access: GST_MAP_READ and/or GST_MAP_WRITE, depending on what
+ *     the CPU did with the range
+ * @offset: start of the range, relative to the start of the buffer's data
+ * @size: size of the range, in bytes, or -1 to specify the rest of the buffer
+ *
+ * Calls gst_imx_memory_end_cpu_access() for each memory in the buffer
+ * that overlaps the given range.
+ */
+void gst_imx_buffer_end_cpu_access(GstBuffer *buffer, GstMapFlags access, gsize offset, gssize size)
+{
+	gst_imx_buffer_sync_cpu_access(buffer, access, offset, size, CPU_ACCESS_END);
+}
+
+
 /**
  * gst_imx_allocator_new:
  *
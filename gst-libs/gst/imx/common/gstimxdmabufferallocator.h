@@ -35,8 +35,10 @@ G_BEGIN_DECLS
 
 /* Extra GstMemory map flag to underlying libimxdmabuffer allocators
  * to disable automatic cache sync. Needed if the allocated buffers
- * will be manually synced with imx_dma_buffer_start_sync_session()
- * and imx_dma_buffer_stop_sync_session(). */
+ * will be manually synced with gst_imx_memory_begin_cpu_access() and
+ * gst_imx_memory_end_cpu_access() (or their GstBuffer counterparts),
+ * or with imx_dma_buffer_start_sync_session() and
+ * imx_dma_buffer_stop_sync_session(). */
 #define GST_MAP_FLAG_IMX_MANUAL_SYNC (GST_MAP_FLAG_LAST + 0)
 
 
@@ -71,6 +73,11 @@ gboolean gst_imx_has_imx_dma_buffer_memory(GstBuffer *buffer);
 ImxDmaBuffer* gst_imx_get_dma_buffer_from_memory(GstMemory *memory);
 ImxDmaBuffer* gst_imx_get_dma_buffer_from_buffer(GstBuffer *buffer);
 
+void gst_imx_memory_begin_cpu_access(GstMemory *memory, GstMapFlags access, gsize offset, gssize size);
+void gst_imx_memory_end_cpu_access(GstMemory *memory, GstMapFlags access, gsize offset, gssize size);
+void gst_imx_buffer_begin_cpu_access(GstBuffer *buffer, GstMapFlags access, gsize offset, gssize size);
+void gst_imx_buffer_end_cpu_access(GstBuffer *buffer, GstMapFlags access, gsize offset, gssize size);
+
 GstAllocator* gst_imx_allocator_new(void);
 
 
@@ -0,0 +1,439 @@
+/* gstreamer-imx: GStreamer plugins for the i.MX SoCs
+ * Copyright (C) 2026  agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <string.h>
+#include <gst/gst.h>
+#include <imxdmabuffer/imxdmabuffer.h>
+#include "gstimxdmabufferslab.h"
+
+
+/**
+ * The slab allocator is not a GObject, so the debug category
+ * is set up the same way as in GstImxDmaBufferUploader.
+ */
+
+#ifndef GST_DISABLE_GST_DEBUG
+
+#define GST_CAT_DEFAULT gst_imx_dma_buffer_slab_ensure_debug_category()
+
+static GstDebugCategory* gst_imx_dma_buffer_slab_ensure_debug_category()
+{
+	static gsize cat_gonce = 0;
+
+	if (g_once_init_enter(&cat_gonce))
+	{
+		GstDebugCategory *cat = NULL;
+		GST_DEBUG_CATEGORY_INIT(cat, "imxdmabufferslab", 0, "NXP i.MX DMA buffer slab sub-allocator");
+		g_once_init_leave(&cat_gonce, (gsize)cat);
+	}
+
+	return (GstDebugCategory *)cat_gonce;
+}
+
+#endif /* GST_DISABLE_GST_DEBUG */
+
+
+/* Slices are grouped in size classes. The slot size of class N is
+ * (MIN_SLOT_SIZE << N). Each chunk contains slots of one class only. */
+#define MIN_SLOT_SIZE_SHIFT 10
+#define MIN_SLOT_SIZE (1 << MIN_SLOT_SIZE_SHIFT)
+#define NUM_SIZE_CLASSES 7
+
+#define CHUNK_SIZE (256 * 1024)
+#define CHUNK_ALIGNMENT 4096
+
+G_STATIC_ASSERT((MIN_SLOT_SIZE << (NUM_SIZE_CLASSES - 1)) == GST_IMX_DMA_BUFFER_SLAB_MAX_SLICE_SIZE);
+G_STATIC_ASSERT(GST_IMX_DMA_BUFFER_SLAB_MAX_SLICE_SIZE <= CHUNK_SIZE);
+
+
+typedef struct _SlabChunk SlabChunk;
+typedef struct _SlabSlice SlabSlice;
+
+
+struct _SlabSlice
+{
+	ImxDmaBuffer parent;
+
+	SlabChunk *chunk;
+	size_t offset;
+	size_t size;
+
+	unsigned int map_flags;
+	int mapping_refcount;
+
+	/* Only valid while the slice is not allocated. */
+	SlabSlice *next_free_slice;
+};
+
+
+struct _SlabChunk
+{
+	ImxDmaBuffer *dma_buffer;
+	/* Chunks are mapped once, when they are created, and
+	 * stay mapped until they are destroyed. */
+	uint8_t *mapped_virtual_address;
+	imx_physical_address_t physical_address;
+
+	guint size_class;
+	guint num_slots;
+	guint num_free_slots;
+	SlabSlice *first_free_slice;
+	SlabSlice *slices;
+
+	/* Link in the chunk queue of the size class. */
+	GList link;
+};
+
+
+typedef struct
+{
+	ImxDmaBufferAllocator parent;
+
+	ImxDmaBufferAllocator *backing_allocator;
+
+	/* Protects the fields below. */
+	GMutex mutex;
+	/* Chunks with free slots are at the head of their queue,
+	 * so only the head needs to be checked when allocating. */
+	GQueue chunks[NUM_SIZE_CLASSES];
+	guint num_chunks;
+	guint num_slices;
+}
+SlabAllocator;
+
+
+static SlabChunk* slab_chunk_new(SlabAllocator *slab_allocator, guint size_class, int *error)
+{
+	SlabChunk *chunk;
+	size_t slot_size = ((size_t)MIN_SLOT_SIZE) << size_class;
+	guint slot_index;
+
+	chunk = g_new0(SlabChunk, 1);
+
+	chunk->dma_buffer = imx_dma_buffer_allocate(slab_allocator->backing_allocator, CHUNK_SIZE, CHUNK_ALIGNMENT, error);
+	if (chunk->dma_buffer == NULL)
+	{
+		GST_ERROR("could not allocate chunk for slot size %zu: %s (%d)", slot_size, strerror(*error), *error);
+		goto error;
+	}
+
+	/* Slices share the chunk's mapping, so the chunk must be mapped with
+	 * read and write access. Syncing is done by the slices themselves. */
+	chunk->mapped_virtual_address = imx_dma_buffer_map(
+		chunk->dma_buffer,
+		IMX_DMA_BUFFER_MAPPING_FLAG_READ | IMX_DMA_BUFFER_MAPPING_FLAG_WRITE | IMX_DMA_BUFFER_MAPPING_FLAG_MANUAL_SYNC,
+		error
+	);
+	if (chunk->mapped_virtual_address == NULL)
+	{
+		GST_ERROR("could not map chunk for slot size %zu: %s (%d)", slot_size, strerror(*error), *error);
+		goto error;
+	}
+
+	chunk->physical_address = imx_dma_buffer_get_physical_address(chunk->dma_buffer);
+	chunk->size_class = size_class;
+	chunk->num_slots = CHUNK_SIZE / slot_size;
+	chunk->num_free_slots = chunk->num_slots;
+	chunk->slices = g_new0(SlabSlice, chunk->num_slots);
+	chunk->link.data = chunk;
+
+	/* Build the free list in reverse, so that the slots
+	 * at the start of the chunk are used first. */
+	for (slot_index = chunk->num_slots; slot_index > 0; --slot_index)
+	{
+		SlabSlice *slice = &(chunk->slices[slot_index - 1]);
+
+		slice->parent.allocator = (ImxDmaBufferAllocator *)slab_allocator;
+		slice->chunk = chunk;
+		slice->offset = (slot_index - 1) * slot_size;
+		slice->next_free_slice = chunk->first_free_slice;
+		chunk->first_free_slice = slice;
+	}
+
+	GST_DEBUG(
+		"created chunk %p with %u slot(s) of %zu byte(s); physical address: %" IMX_PHYSICAL_ADDRESS_FORMAT,
+		(gpointer)chunk,
+		chunk->num_slots,
+		slot_size,
+		chunk->physical_address
+	);
+
+	return chunk;
+
+error:
+	if (chunk->dma_buffer != NULL)
+		imx_dma_buffer_deallocate(chunk->dma_buffer);
+	g_free(chunk);
+	return NULL;
+}
+
+
+static void slab_chunk_free(SlabChunk *chunk)
+{
+	g_assert(chunk->num_free_slots == chunk->num_slots);
+
+	GST_DEBUG("destroying chunk %p", (gpointer)chunk);
+
+	imx_dma_buffer_unmap(chunk->dma_buffer);
+	imx_dma_buffer_deallocate(chunk->dma_buffer);
+
+	g_free(chunk->slices);
+	g_free(chunk);
+}
+
+
+static void slab_allocator_destroy(ImxDmaBufferAllocator *allocator)
+{
+	SlabAllocator *slab_allocator = (SlabAllocator *)allocator;
+	guint size_class;
+
+	g_assert(slab_allocator->num_slices == 0);
+
+	for (size_class = 0; size_class < NUM_SIZE_CLASSES; ++size_class)
+	{
+		GList *link;
+
+		while ((link = g_queue_pop_head_link(&(slab_allocator->chunks[size_class]))) != NULL)
+			slab_chunk_free((SlabChunk *)(link->data));
+	}
+
+	imx_dma_buffer_allocator_destroy(slab_allocator->backing_allocator);
+
+	g_mutex_clear(&(slab_allocator->mutex));
+	g_free(slab_allocator);
+}
+
+
+static ImxDmaBuffer* slab_allocator_allocate(ImxDmaBufferAllocator *allocator, size_t size, size_t alignment, int *error)
+{
+	SlabAllocator *slab_allocator = (SlabAllocator *)allocator;
+	SlabChunk *chunk;
+	SlabSlice *slice;
+	size_t min_slot_size = MAX(size, alignment);
+	guint size_class;
+
+	/* Slots are aligned to their size relative to the start of the chunk,
+	 * and chunks are aligned to CHUNK_ALIGNMENT, so alignments beyond that
+	 * cannot be guaranteed. Such allocations, and large allocations,
+	 * are passed through to the backing allocator. */
+	if ((size == 0) || (size > GST_IMX_DMA_BUFFER_SLAB_MAX_SLICE_SIZE) || (alignment > CHUNK_ALIGNMENT))
+		return imx_dma_buffer_allocate(slab_allocator->backing_allocator, size, alignment, error);
+
+	for (size_class = 0; (((size_t)MIN_SLOT_SIZE) << size_class) < min_slot_size; ++size_class);
+	g_assert(size_class < NUM_SIZE_CLASSES);
+
+	g_mutex_lock(&(slab_allocator->mutex));
+
+	chunk = (slab_allocator->chunks[size_class].head != NULL) ? slab_allocator->chunks[size_class].head->data : NULL;
+
+	if ((chunk == NULL) || (chunk->num_free_slots == 0))
+	{
+		chunk = slab_chunk_new(slab_allocator, size_class, error);
+		if (chunk == NULL)
+		{
+			g_mutex_unlock(&(slab_allocator->mutex));
+			return NULL;
+		}
+
+		g_queue_push_head_link(&(slab_allocator->chunks[size_class]), &(chunk->link));
+		slab_allocator->num_chunks++;
+	}
+
+	slice = chunk->first_free_slice;
+	chunk->first_free_slice = slice->next_free_slice;
+	chunk->num_free_slots--;
+
+	/* Full chunks go to the back, to keep chunks with free slots at the head. */
+	if (chunk->num_free_slots == 0)
+	{
+		g_queue_unlink(&(slab_allocator->chunks[size_class]), &(chunk->link));
+		g_queue_push_tail_link(&(slab_allocator->chunks[size_class]), &(chunk->link));
+	}
+
+	slab_allocator->num_slices++;
+
+	g_mutex_unlock(&(slab_allocator->mutex));
+
+	slice->size = size;
+	slice->map_flags = 0;
+	slice->mapping_refcount = 0;
+	slice->next_free_slice = NULL;
+
+	GST_LOG("allocated slice %p with %zu byte(s) at offset %zu in chunk %p", (gpointer)slice, size, slice->offset, (gpointer)chunk);
+
+	return (ImxDmaBuffer *)slice;
+}
+
+
+static void slab_allocator_deallocate(ImxDmaBufferAllocator *allocator, ImxDmaBuffer *buffer)
+{
+	SlabAllocator *slab_allocator = (SlabAllocator *)allocator;
+	SlabSlice *slice = (SlabSlice *)buffer;
+	SlabChunk *chunk = slice->chunk;
+	SlabChunk *chunk_to_free = NULL;
+	GQueue *chunk_queue = &(slab_allocator->chunks[chunk->size_class]);
+
+	GST_LOG("deallocating slice %p in chunk %p", (gpointer)slice, (gpointer)chunk);
+
+	g_mutex_lock(&(slab_allocator->mutex));
+
+	slice->next_free_slice = chunk->first_free_slice;
+	chunk->first_free_slice = slice;
+	chunk->num_free_slots++;
+	slab_allocator->num_slices--;
+
+	if ((chunk->num_free_slots == chunk->num_slots) && (g_queue_get_length(chunk_queue) > 1))
+	{
+		/* Keep one chunk per size class around even if it is empty, to
+		 * avoid reallocating chunks when slices are allocated and freed
+		 * in quick succession. Other empty chunks are freed. */
+		g_queue_unlink(chunk_queue, &(chunk->link));
+		slab_allocator->num_chunks--;
+		chunk_to_free = chunk;
+	}
+	else if (chunk->num_free_slots == 1)
+	{
+		/* The chunk was full until now, so move it back to the head. */
+		g_queue_unlink(chunk_queue, &(chunk->link));
+		g_queue_push_head_link(chunk_queue, &(chunk->link));
+	}
+
+	g_mutex_unlock(&(slab_allocator->mutex));
+
+	/* Unmapping and deallocating may take a while, so
+	 * do this without holding the mutex. */
+	if (chunk_to_free != NULL)
+		slab_chunk_free(chunk_to_free);
+}
+
+
+static uint8_t* slab_allocator_map(G_GNUC_UNUSED ImxDmaBufferAllocator *allocator, ImxDmaBuffer *buffer, unsigned int flags, G_GNUC_UNUSED int *error)
+{
+	SlabSlice *slice = (SlabSlice *)buffer;
+
+	if (flags == 0)
+		flags = IMX_DMA_BUFFER_MAPPING_FLAG_READ | IMX_DMA_BUFFER_MAPPING_FLAG_WRITE;
+
+	/* The chunk is already mapped, so there is nothing to map here.
+	 * Like the libimxdmabuffer allocators, sync only in the first
+	 * of nested map calls, and use the flags of that call. */
+	if (slice->mapping_refcount == 0)
+	{
+		slice->map_flags = flags;
+		if (!(flags & IMX_DMA_BUFFER_MAPPING_FLAG_MANUAL_SYNC))
+			imx_dma_buffer_start_sync_session(slice->chunk->dma_buffer);
+	}
+
+	slice->mapping_refcount++;
+
+	return slice->chunk->mapped_virtual_address + slice->offset;
+}
+
+
+static void slab_allocator_unmap(G_GNUC_UNUSED ImxDmaBufferAllocator *allocator, ImxDmaBuffer *buffer)
+{
+	SlabSlice *slice = (SlabSlice *)buffer;
+
+	if (slice->mapping_refcount == 0)
+		return;
+
+	slice->mapping_refcount--;
+	if ((slice->mapping_refcount == 0) && !(slice->map_flags & IMX_DMA_BUFFER_MAPPING_FLAG_MANUAL_SYNC))
+		imx_dma_buffer_stop_sync_session(slice->chunk->dma_buffer);
+}
+
+
+static imx_physical_address_t slab_allocator_get_physical_address(G_GNUC_UNUSED ImxDmaBufferAllocator *allocator, ImxDmaBuffer *buffer)
+{
+	SlabSlice *slice = (SlabSlice *)buffer;
+	return slice->chunk->physical_address + slice->offset;
+}
+
+
+static int slab_allocator_get_fd(G_GNUC_UNUSED ImxDmaBufferAllocator *allocator, G_GNUC_UNUSED ImxDmaBuffer *buffer)
+{
+	/* Slices are only parts of a chunk, so they have no FD of their own. */
+	return -1;
+}
+
+
+static size_t slab_allocator_get_size(G_GNUC_UNUSED ImxDmaBufferAllocator *allocator, ImxDmaBuffer *buffer)
+{
+	return ((SlabSlice *)buffer)->size;
+}
+
+
+static void slab_allocator_start_sync_session(G_GNUC_UNUSED ImxDmaBufferAllocator *allocator, ImxDmaBuffer *buffer)
+{
+	imx_dma_buffer_start_sync_session(((SlabSlice *)buffer)->chunk->dma_buffer);
+}
+
+
+static void slab_allocator_stop_sync_session(G_GNUC_UNUSED ImxDmaBufferAllocator *allocator, ImxDmaBuffer *buffer)
+{
+	imx_dma_buffer_stop_sync_session(((SlabSlice *)buffer)->chunk->dma_buffer);
+}
+
+
+
+
+ImxDmaBufferAllocator* gst_imx_dma_buffer_slab_allocator_new(ImxDmaBufferAllocator *backing_allocator)
+{
+	SlabAllocator *slab_allocator;
+	guint size_class;
+
+	g_assert(backing_allocator != NULL);
+
+	slab_allocator = g_new0(SlabAllocator, 1);
+
+	slab_allocator->parent.destroy = slab_allocator_destroy;
+	slab_allocator->parent.allocate = slab_allocator_allocate;
+	slab_allocator->parent.deallocate = slab_allocator_deallocate;
+	slab_allocator->parent.map = slab_allocator_map;
+	slab_allocator->parent.unmap = slab_allocator_unmap;
+	slab_allocator->parent.get_physical_address = slab_allocator_get_physical_address;
+	slab_allocator->parent.get_fd = slab_allocator_get_fd;
+	slab_allocator->parent.get_size = slab_allocator_get_size;
+	slab_allocator->parent.start_sync_session = slab_allocator_start_sync_session;
+	slab_allocator->parent.stop_sync_session = slab_allocator_stop_sync_session;
+
+	slab_allocator->backing_allocator = backing_allocator;
+
+	g_mutex_init(&(slab_allocator->mutex));
+	for (size_class = 0; size_class < NUM_SIZE_CLASSES; ++size_class)
+		g_queue_init(&(slab_allocator->chunks[size_class]));
+
+	GST_DEBUG("created slab allocator %p with backing allocator %p", (gpointer)slab_allocator, (gpointer)backing_allocator);
+
+	return (ImxDmaBufferAllocator *)slab_allocator;
+}
+
+
+void gst_imx_dma_buffer_slab_allocator_get_statistics(ImxDmaBufferAllocator *allocator, guint *num_chunks, guint *num_slices)
+{
+	SlabAllocator *slab_allocator = (SlabAllocator *)allocator;
+
+	g_assert(allocator != NULL);
+
+	g_mutex_lock(&(slab_allocator->mutex));
+	if (num_chunks != NULL)
+		*num_chunks = slab_allocator->num_chunks;
+	if (num_slices != NULL)
+		*num_slices = slab_allocator->num_slices;
+	g_mutex_unlock(&(slab_allocator->mutex));
+}
@@ -0,0 +1,80 @@
+/* gstreamer-imx: GStreamer plugins for the i.MX SoCs
+ * Copyright (C) 2026  agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef GST_IMX_DMA_BUFFER_SLAB_H
+#define GST_IMX_DMA_BUFFER_SLAB_H
+
+#include <gst/gst.h>
+#include <imxdmabuffer/imxdmabuffer.h>
+
+
+G_BEGIN_DECLS
+
+
+/* Internal header; not installed. */
+
+
+/* Allocations up to this size are carved out of slab chunks.
+ * Larger ones are passed on to the backing allocator. */
+#define GST_IMX_DMA_BUFFER_SLAB_MAX_SLICE_SIZE (64 * 1024)
+
+
+/**
+ * gst_imx_dma_buffer_slab_allocator_new:
+ * @backing_allocator: libimxdmabuffer allocator to allocate chunks with.
+ *
+ * Creates a libimxdmabuffer allocator that carves small ImxDmaBuffer
+ * instances (up to GST_IMX_DMA_BUFFER_SLAB_MAX_SLICE_SIZE bytes) out of
+ * larger physically contiguous chunks that are allocated with
+ * @backing_allocator. This reduces the number of allocations that the
+ * kernel has to perform, and avoids wasting memory when allocating many
+ * buffers that are much smaller than the granularity of the kernel's
+ * contiguous memory allocator. Larger allocations are passed through
+ * to @backing_allocator.
+ *
+ * Slices have their own physical address and size. Mapping a slice does
+ * not actually map anything, since chunks stay mapped for as long as they
+ * exist. Slices do not have an FD of their own, so imx_dma_buffer_get_fd()
+ * returns -1 for them. Since this does not work with DMA-BUF allocators,
+ * @backing_allocator must not be a DMA-BUF based allocator.
+ *
+ * The returned allocator takes ownership over @backing_allocator, and
+ * destroys it when it is itself destroyed. All buffers must have been
+ * deallocated by then.
+ *
+ * Returns: The new allocator.
+ */
+ImxDmaBufferAllocator* gst_imx_dma_buffer_slab_allocator_new(ImxDmaBufferAllocator *backing_allocator);
+
+/**
+ * gst_imx_dma_buffer_slab_allocator_get_statistics:
+ * @allocator: Slab allocator to get statistics from.
+ * @num_chunks: Pointer to a guint that will be set to the current number of chunks. Can be NULL.
+ * @num_slices: Pointer to a guint that will be set to the current number of slices. Can be NULL.
+ *
+ * Retrieves the number of existing chunks and slices. Each chunk
+ * corresponds to one allocation by the backing allocator, so the
+ * difference shows how many allocations were saved.
+ */
+void gst_imx_dma_buffer_slab_allocator_get_statistics(ImxDmaBufferAllocator *allocator, guint *num_chunks, guint *num_slices);
+
+
+G_END_DECLS
+
+
+#endif /* GST_IMX_DMA_BUFFER_SLAB_H */
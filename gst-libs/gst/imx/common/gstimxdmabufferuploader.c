@@ -18,11 +18,11 @@
 
 #include "config.h"
 
-#include <unistd.h>
 #include <gst/gst.h>
 #include <gst/allocators/allocators.h>
 #include "gstimxdmabufferuploader.h"
 #include "gstimxdmabufferallocator.h"
+#include "gstimxmemoryrecycler.h"
 #ifdef GST_DMABUF_ALLOCATOR_AVAILABLE
 #include "gstimxdmabufallocator.h"
 #endif
@@ -65,6 +65,25 @@ static GstDebugCategory* gst_imx_dma_buffer_uploader_ensure_debug_category()
 
 
 
+/* The raw buffer upload method copies data into memory blocks from a
+ * GstImxMemoryRecycler instead of allocating new ImxDmaBuffer memory for
+ * each upload. Memory block sizes are rounded up to "buckets", so blocks
+ * of slightly different sizes can be reused for each other. Only blocks
+ * with the same bucket size are reused. */
+
+static gsize raw_buffer_get_bucket_size(gsize size)
+{
+	/* Round up to 1/8th of the largest power of two that is
+	 * less than or equal to size (but at least to a page).
+	 * This wastes at most ~12.5% of memory, while still making
+	 * it possible for similarly sized blocks to be reused. */
+	gsize granularity = MAX(((gsize)1 << (g_bit_storage(size) - 1)) / 8, 4096);
+	return (size + granularity - 1) / granularity * granularity;
+}
+
+
+
+
 struct _GstImxDmaBufferUploader
 {
 	GstObject parent;
@@ -74,6 +93,8 @@ struct _GstImxDmaBufferUploader
 	GstImxDmaBufferUploadMethodContext **upload_method_contexts;
 
 	GstAllocator *imx_dma_buffer_allocator;
+
+	GstImxMemoryRecycler *raw_buffer_memory_recycler;
 };
 
 
@@ -130,20 +151,29 @@ static GstFlowReturn raw_buffer_upload_method_perform(GstImxDmaBufferUploadMetho
 	struct RawBufferUploadMethodContext *self = (struct RawBufferUploadMethodContext *)upload_method_context;
 	GstFlowReturn flow_ret = GST_FLOW_OK;
 	GstMapInfo in_map_info, out_map_info;
+	gsize bucket_size;
 
 	gst_memory_map(input_memory, &in_map_info, GST_MAP_READ);
 
-	*output_memory = gst_allocator_alloc(self->parent.uploader->imx_dma_buffer_allocator, in_map_info.size, NULL);
+	bucket_size = raw_buffer_get_bucket_size(in_map_info.size);
+	*output_memory = gst_imx_memory_recycler_acquire(self->parent.uploader->raw_buffer_memory_recycler, self->parent.uploader->imx_dma_buffer_allocator, bucket_size, bucket_size, NULL);
 	if (G_UNLIKELY((*output_memory) == NULL))
 	{
 		GST_ERROR_OBJECT(self->parent.uploader, "could not allocate imxdmabuffer memory");
 		goto error;
 	}
 
-	gst_memory_map(*output_memory, &out_map_info, GST_MAP_WRITE);
+	gst_memory_resize(*output_memory, 0, in_map_info.size);
+
+	/* Sync explicitely to tell the kernel that the CPU only writes
+	 * to the memory, so it can skip invalidating the CPU caches. */
+	gst_memory_map(*output_memory, &out_map_info, GST_MAP_WRITE | GST_MAP_FLAG_IMX_MANUAL_SYNC);
+	gst_imx_memory_begin_cpu_access(*output_memory, GST_MAP_WRITE, 0, in_map_info.size);
 
 	memcpy(out_map_info.data, in_map_info.data, in_map_info.size);
 
+	gst_imx_memory_end_cpu_access(*output_memory, GST_MAP_WRITE, 0, in_map_info.size);
+
 	GST_LOG_OBJECT(self->parent.uploader, "copied %" G_GSIZE_FORMAT " byte(s) from memory %p to memory %p", in_map_info.size, (gpointer)input_memory, (gpointer)(*output_memory));
 
 finish:
@@ -226,8 +256,6 @@ static void dmabuf_upload_method_destroy(GstImxDmaBufferUploadMethodContext *upl
 
 static GstFlowReturn dmabuf_upload_method_perform(GstImxDmaBufferUploadMethodContext *upload_method_context, GstMemory *input_memory, GstMemory **output_memory)
 {
-	int dmabuf_fd, dup_dmabuf_fd;
-	gsize size;
 	struct DmabufUploadMethodContext *self = (struct DmabufUploadMethodContext *)upload_method_context;
 
 	if (!gst_is_dmabuf_memory(input_memory))
@@ -237,34 +265,26 @@ static GstFlowReturn dmabuf_upload_method_perform(GstImxDmaBufferUploadMethodCon
 	 * Instead, we dup() the DMA-BUF FD so we can share ownership over it
 	 * and close() our FD when we are done with it. Then, we wrap the FD
 	 * in an GstImxDmaBufAllocator-allocated GstMemory. In other words,
-	 * the FD is wrapped in a custom ImxDmaBuffer. This is how we "upload". */
-
-	size = input_memory->size;
-	dmabuf_fd = gst_dmabuf_memory_get_fd(input_memory);
-	g_assert(dmabuf_fd > 0);
-
-	dup_dmabuf_fd = dup(dmabuf_fd);
-	if (G_UNLIKELY(dup_dmabuf_fd < 0))
-	{
-		GST_ERROR_OBJECT(self->parent.uploader, "could not duplicate dmabuf FD: %s (%d)", strerror(errno), errno);
-			return GST_FLOW_ERROR;
-	}
+	 * the FD is wrapped in a custom ImxDmaBuffer. This is how we "upload".
+	 * The allocator caches the DMA-BUF's physical address, so importing
+	 * recycled upstream DMA-BUFs does not require an ioctl every time. */
 
 	GST_LOG_OBJECT(
 		self->parent.uploader,
-		"wrapping duplicated DMA-BUF FD as part of the upload process; original FD: %d duplicated FD: %d size: %" G_GSIZE_FORMAT " maxsize: %" G_GSIZE_FORMAT " align: %" G_GSIZE_FORMAT " offset: %" G_GSIZE_FORMAT,
-		dmabuf_fd,
-		dup_dmabuf_fd,
-		size,
+		"importing DMA-BUF memory as part of the upload process; FD: %d size: %" G_GSIZE_FORMAT " maxsize: %" G_GSIZE_FORMAT " align: %" G_GSIZE_FORMAT " offset: %" G_GSIZE_FORMAT,
+		gst_dmabuf_memory_get_fd(input_memory),
+		input_memory->size,
 		input_memory->maxsize,
 		input_memory->align,
 		input_memory->offset
 	);
 
-	*output_memory = gst_imx_dmabuf_allocator_wrap_dmabuf(self->parent.uploader->imx_dma_buffer_allocator, dup_dmabuf_fd, size);
-	(*output_memory)->maxsize = input_memory->maxsize;
-	(*output_memory)->align = input_memory->align;
-	(*output_memory)->offset = input_memory->offset;
+	*output_memory = gst_imx_dmabuf_allocator_import_dmabuf_memory(self->parent.uploader->imx_dma_buffer_allocator, input_memory);
+	if (G_UNLIKELY((*output_memory) == NULL))
+	{
+		GST_ERROR_OBJECT(self->parent.uploader, "could not import DMA-BUF memory");
+		return GST_FLOW_ERROR;
+	}
 
 	return GST_FLOW_OK;
 }
@@ -317,6 +337,7 @@ static void gst_imx_dma_buffer_uploader_init(GstImxDmaBufferUploader *uploader)
 {
 	uploader->upload_method_contexts = NULL;
 	uploader->imx_dma_buffer_allocator = NULL;
+	uploader->raw_buffer_memory_recycler = NULL;
 }
 
 
@@ -326,6 +347,21 @@ static void gst_imx_dma_buffer_uploader_finalize(GObject *object)
 
 	gst_imx_dma_buffer_uploader_destroy_upload_method_contexts(self);
 
+	if (self->raw_buffer_memory_recycler != NULL)
+	{
+		guint64 num_allocations, num_reuses;
+
+		gst_imx_memory_recycler_get_statistics(self->raw_buffer_memory_recycler, &num_allocations, &num_reuses, NULL);
+		GST_DEBUG_OBJECT(
+			self,
+			"raw buffer memory pool statistics: %" G_GUINT64_FORMAT " allocation(s), %" G_GUINT64_FORMAT " reuse(s)",
+			num_allocations,
+			num_reuses
+		);
+
+		gst_imx_memory_recycler_shutdown(self->raw_buffer_memory_recycler);
+	}
+
 	gst_object_unref(GST_OBJECT(self->imx_dma_buffer_allocator));
 
 	GST_DEBUG_OBJECT(self, "destroyed GstImxDmaBufferUploader instance %" GST_PTR_FORMAT, (gpointer)self);
@@ -344,6 +380,7 @@ GstImxDmaBufferUploader* gst_imx_dma_buffer_uploader_new(GstAllocator *imx_dma_b
 
 	uploader = g_object_new(gst_imx_dma_buffer_uploader_get_type(), NULL);
 	uploader->imx_dma_buffer_allocator = gst_object_ref(imx_dma_buffer_allocator);
+	uploader->raw_buffer_memory_recycler = gst_imx_memory_recycler_new(GST_IMX_DMA_BUFFER_UPLOADER_DEFAULT_MAX_POOLED_MEMORY_SIZE);
 
 	GST_DEBUG_OBJECT(
 		uploader,
@@ -428,8 +465,6 @@ GstFlowReturn gst_imx_dma_buffer_uploader_perform(GstImxDmaBufferUploader *uploa
 		}
 	}
 
-	// TODO: Use a buffer pool and reuse memory blocks as much as possible
-
 	*output_buffer = gst_buffer_new();
 
 	for (memory_idx = 0; memory_idx < (gint)gst_buffer_n_memory(input_buffer); ++memory_idx)
@@ -491,6 +526,24 @@ GstAllocator* gst_imx_dma_buffer_uploader_get_allocator(GstImxDmaBufferUploader
 }
 
 
+void gst_imx_dma_buffer_uploader_set_max_pooled_memory_size(GstImxDmaBufferUploader *uploader, gsize max_size)
+{
+	g_assert(uploader != NULL);
+
+	gst_imx_memory_recycler_set_max_idle_size(uploader->raw_buffer_memory_recycler, max_size);
+
+	GST_DEBUG_OBJECT(uploader, "set max pooled memory size to %" G_GSIZE_FORMAT " byte(s)", max_size);
+}
+
+
+void gst_imx_dma_buffer_uploader_get_pooled_memory_statistics(GstImxDmaBufferUploader *uploader, guint64 *num_allocations, guint64 *num_reuses, gsize *idle_size)
+{
+	g_assert(uploader != NULL);
+
+	gst_imx_memory_recycler_get_statistics(uploader->raw_buffer_memory_recycler, num_allocations, num_reuses, idle_size);
+}
+
+
 static void gst_imx_dma_buffer_uploader_destroy_upload_method_contexts(GstImxDmaBufferUploader *uploader)
 {
 	gint i;
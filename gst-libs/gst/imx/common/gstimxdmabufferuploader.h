@@ -83,6 +83,15 @@ typedef struct _GstImxDmaBufferUploadMethodType GstImxDmaBufferUploadMethodType;
 
 
 
+/**
+ * GST_IMX_DMA_BUFFER_UPLOADER_DEFAULT_MAX_POOLED_MEMORY_SIZE:
+ *
+ * Default maximum size of the idle memory blocks that are kept around
+ * for reuse by the raw upload method, in bytes.
+ */
+#define GST_IMX_DMA_BUFFER_UPLOADER_DEFAULT_MAX_POOLED_MEMORY_SIZE (32 * 1024 * 1024)
+
+
 GType gst_imx_dma_buffer_uploader_get_type(void);
 
 
@@ -129,6 +138,39 @@ GstAllocator* gst_imx_dma_buffer_uploader_get_allocator(GstImxDmaBufferUploader
  */
 GstFlowReturn gst_imx_dma_buffer_uploader_perform(GstImxDmaBufferUploader *uploader, GstBuffer *input_buffer, GstBuffer **output_buffer);
 
+/**
+ * gst_imx_dma_buffer_uploader_set_max_pooled_memory_size:
+ * @uploader: Uploader instance to configure.
+ * @max_size: Maximum total size of idle pooled memory blocks, in bytes.
+ *
+ * When input memory has to be copied (this is the case when it is neither
+ * ImxDmaBuffer nor DMA-BUF memory), the uploader copies the data into memory
+ * blocks that come from an internal pool. Once these blocks are no longer
+ * used, they return to the pool, so subsequent uploads can reuse them instead
+ * of allocating new DMA memory. This sets how many bytes worth of idle blocks
+ * the pool may keep around. If the limit is exceeded, the least recently
+ * used idle blocks are freed. Setting this to 0 disables reuse.
+ *
+ * The default value is @GST_IMX_DMA_BUFFER_UPLOADER_DEFAULT_MAX_POOLED_MEMORY_SIZE.
+ */
+void gst_imx_dma_buffer_uploader_set_max_pooled_memory_size(GstImxDmaBufferUploader *uploader, gsize max_size);
+
+/**
+ * gst_imx_dma_buffer_uploader_get_pooled_memory_statistics:
+ * @uploader: Uploader instance to get statistics from.
+ * @num_allocations: (out) (optional): Number of memory blocks that had to
+ *     be newly allocated. Can be NULL.
+ * @num_reuses: (out) (optional): Number of times an idle memory block
+ *     from the pool was reused. Can be NULL.
+ * @idle_size: (out) (optional): Current total size of the idle memory
+ *     blocks in the pool, in bytes. Can be NULL.
+ *
+ * Retrieves statistics about the pool described in
+ * @gst_imx_dma_buffer_uploader_set_max_pooled_memory_size.
+ * This function is thread safe.
+ */
+void gst_imx_dma_buffer_uploader_get_pooled_memory_statistics(GstImxDmaBufferUploader *uploader, guint64 *num_allocations, guint64 *num_reuses, gsize *idle_size);
+
 
 G_END_DECLS
 
@@ -0,0 +1,720 @@
+/* gstreamer-imx: GStreamer plugins for the i.MX SoCs
+ * Copyright (C) 2026  agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/**
+ * SECTION:gstimxmemfdallocator
+ * @title: GstImxMemfdAllocator
+ * @short_description: ImxDmabuffer-backed allocator using memfd and udmabuf, for running on non-i.MX machines
+ * @see_also: #GstMemory, #GstImxDmaBufAllocator
+ */
+
+/* memfd_create() and the file sealing
+ * constants are GNU extensions. */
+#define _GNU_SOURCE
+
+#include "config.h"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/ioctl.h>
+#include <sys/vfs.h>
+#include <fcntl.h>
+#ifdef HAVE_LINUX_UDMABUF_H
+#include <linux/udmabuf.h>
+#include <linux/dma-buf.h>
+#endif
+#include <gst/gst.h>
+#include <imxdmabuffer/imxdmabuffer.h>
+#include "gstimxmemfdallocator.h"
+#include "gstimxdmabufallocator.h"
+
+
+GST_DEBUG_CATEGORY_STATIC(imx_memfd_allocator_debug);
+#define GST_CAT_DEFAULT imx_memfd_allocator_debug
+
+
+#ifndef DMA_BUF_MAGIC
+#define DMA_BUF_MAGIC 0x444d4142
+#endif
+
+
+enum
+{
+	PROP_0,
+	PROP_USE_UDMABUF
+};
+
+
+#define DEFAULT_USE_UDMABUF TRUE
+
+#define UDMABUF_DEVICE_NODE "/dev/udmabuf"
+
+/* The synthetic physical addresses start at this value. It is nonzero,
+ * since a physical address of 0 means "no physical address". */
+#define SYNTHETIC_PHYSICAL_ADDRESS_BASE ((imx_physical_address_t)0x10000000)
+
+
+/* libimxdmabuffer allocator implementation. libimxdmabuffer does not
+ * have a memfd based allocator, so this one is implemented here. */
+
+typedef struct
+{
+	ImxDmaBufferAllocator parent;
+
+	/* FD of the opened /dev/udmabuf device node,
+	 * or -1 if udmabuf is not used. */
+	int udmabuf_device_fd;
+
+	/* Protects the fields below. */
+	GMutex mutex;
+	/* Maps the inodes of the DMA-BUF FDs to the corresponding
+	 * MemfdDmaBuffer instances. The DMA-BUF FDs that are passed to
+	 * gst_imx_memfd_allocator_get_physical_address() may be duplicates
+	 * of the original FDs, so the FD values cannot be used as keys. */
+	GHashTable *buffers_by_inode;
+	imx_physical_address_t next_physical_address;
+}
+MemfdImxDmaBufferAllocator;
+
+
+typedef struct
+{
+	ImxDmaBuffer parent;
+
+	int memfd;
+	/* If udmabuf is not used, this is the same as memfd. */
+	int dmabuf_fd;
+	guint64 inode;
+	size_t size;
+	imx_physical_address_t physical_address;
+
+	uint8_t *mapped_virtual_address;
+	unsigned int map_flags;
+	int mapping_refcount;
+}
+MemfdDmaBuffer;
+
+
+static void memfd_imx_dma_buffer_sync(MemfdImxDmaBufferAllocator *memfd_allocator, MemfdDmaBuffer *memfd_buffer, gboolean start)
+{
+#ifdef HAVE_LINUX_UDMABUF_H
+	struct dma_buf_sync sync;
+
+	/* Plain memfds are regular cached system memory,
+	 * so syncing is only needed with udmabuf. */
+	if (memfd_allocator->udmabuf_device_fd < 0)
+		return;
+
+	sync.flags = start ? DMA_BUF_SYNC_START : DMA_BUF_SYNC_END;
+	if (memfd_buffer->map_flags & IMX_DMA_BUFFER_MAPPING_FLAG_READ)
+		sync.flags |= DMA_BUF_SYNC_READ;
+	if (memfd_buffer->map_flags & IMX_DMA_BUFFER_MAPPING_FLAG_WRITE)
+		sync.flags |= DMA_BUF_SYNC_WRITE;
+
+	if (ioctl(memfd_buffer->dmabuf_fd, DMA_BUF_IOCTL_SYNC, &sync) < 0)
+		GST_WARNING("could not %s sync session for DMA-BUF FD %d: %s (%d)", start ? "start" : "stop", memfd_buffer->dmabuf_fd, strerror(errno), errno);
+#else
+	(void)memfd_allocator;
+	(void)memfd_buffer;
+	(void)start;
+#endif
+}
+
+
+static void memfd_imx_dma_buffer_allocator_destroy(ImxDmaBufferAllocator *allocator)
+{
+	MemfdImxDmaBufferAllocator *memfd_allocator = (MemfdImxDmaBufferAllocator *)allocator;
+
+	g_assert(g_hash_table_size(memfd_allocator->buffers_by_inode) == 0);
+
+	if (memfd_allocator->udmabuf_device_fd >= 0)
+		close(memfd_allocator->udmabuf_device_fd);
+
+	g_hash_table_unref(memfd_allocator->buffers_by_inode);
+	g_mutex_clear(&(memfd_allocator->mutex));
+
+	g_free(memfd_allocator);
+}
+
+
+/* Returns a live buffer whose synthetic address range overlaps with
+ * [address, address + size), or NULL if there is none. Must be
+ * called with the mutex locked. */
+static MemfdDmaBuffer* memfd_imx_dma_buffer_allocator_find_overlapping_buffer_locked(MemfdImxDmaBufferAllocator *memfd_allocator, imx_physical_address_t address, size_t size, size_t page_size)
+{
+	GHashTableIter iter;
+	gpointer value;
+
+	g_hash_table_iter_init(&iter, memfd_allocator->buffers_by_inode);
+	while (g_hash_table_iter_next(&iter, NULL, &value))
+	{
+		MemfdDmaBuffer *memfd_buffer = (MemfdDmaBuffer *)value;
+		size_t buffer_size = (memfd_buffer->size + page_size - 1) / page_size * page_size;
+
+		if ((address < (memfd_buffer->physical_address + buffer_size)) && (memfd_buffer->physical_address < (address + size)))
+			return memfd_buffer;
+	}
+
+	return NULL;
+}
+
+
+/* Picks a synthetic physical address for a new buffer. Addresses are
+ * handed out in ascending order. Once the address space is exhausted,
+ * this starts over at SYNTHETIC_PHYSICAL_ADDRESS_BASE. Buffers with low
+ * addresses may still be alive at that point, so addresses that overlap
+ * with live buffers are skipped. Returns 0 if no free address range
+ * is left. Must be called with the mutex locked. */
+static imx_physical_address_t memfd_imx_dma_buffer_allocator_pick_physical_address_locked(MemfdImxDmaBufferAllocator *memfd_allocator, size_t aligned_size, size_t address_alignment, size_t page_size)
+{
+	imx_physical_address_t start = memfd_allocator->next_physical_address;
+	gboolean started_over = FALSE;
+
+	while (TRUE)
+	{
+		imx_physical_address_t address = (start + address_alignment - 1) / address_alignment * address_alignment;
+		MemfdDmaBuffer *overlapping_buffer;
+
+		if ((address < start) || ((imx_physical_address_t)(address + aligned_size) < address))
+		{
+			/* If we already started over once, then
+			 * there is no free address range left. */
+			if (started_over)
+				return 0;
+
+			start = SYNTHETIC_PHYSICAL_ADDRESS_BASE;
+			started_over = TRUE;
+			continue;
+		}
+
+		overlapping_buffer = memfd_imx_dma_buffer_allocator_find_overlapping_buffer_locked(memfd_allocator, address, aligned_size, page_size);
+		if (overlapping_buffer == NULL)
+		{
+			/* Leave one page between buffers, which makes it easier to spot
+			 * out-of-bounds accesses when looking at physical addresses.
+			 * If this reaches the end of the address space, the next
+			 * allocation starts over. */
+			memfd_allocator->next_physical_address = address + aligned_size + page_size;
+			if (memfd_allocator->next_physical_address < address)
+				memfd_allocator->next_physical_address = SYNTHETIC_PHYSICAL_ADDRESS_BASE;
+
+			return address;
+		}
+
+		/* Continue the search right after the overlapping buffer. If that
+		 * is past the end of the address space, the overflow check at the
+		 * beginning of the loop takes care of starting over. */
+		start = overlapping_buffer->physical_address + (overlapping_buffer->size + page_size - 1) / page_size * page_size + page_size;
+		if (start < overlapping_buffer->physical_address)
+			start = (imx_physical_address_t)(-1);
+	}
+}
+
+
+static ImxDmaBuffer* memfd_imx_dma_buffer_allocator_allocate(ImxDmaBufferAllocator *allocator, size_t size, size_t alignment, int *error)
+{
+	MemfdImxDmaBufferAllocator *memfd_allocator = (MemfdImxDmaBufferAllocator *)allocator;
+	MemfdDmaBuffer *memfd_buffer;
+	size_t page_size = sysconf(_SC_PAGESIZE);
+	size_t address_alignment = MAX(alignment, page_size);
+	size_t aligned_size;
+	struct stat stat_buf;
+	imx_physical_address_t physical_address;
+
+	/* udmabuf only accepts page aligned sizes. */
+	aligned_size = (size + page_size - 1) / page_size * page_size;
+
+	memfd_buffer = g_new0(MemfdDmaBuffer, 1);
+	memfd_buffer->parent.allocator = allocator;
+	memfd_buffer->memfd = -1;
+	memfd_buffer->dmabuf_fd = -1;
+	memfd_buffer->size = size;
+
+	memfd_buffer->memfd = memfd_create("gstimxmemfdallocator", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+	if (memfd_buffer->memfd < 0)
+		goto error;
+
+	if (ftruncate(memfd_buffer->memfd, aligned_size) < 0)
+		goto error;
+
+	if (memfd_allocator->udmabuf_device_fd >= 0)
+	{
+#ifdef HAVE_LINUX_UDMABUF_H
+		struct udmabuf_create create;
+
+		/* udmabuf requires the memfd to be sealed against shrinking,
+		 * since it pins the pages of the memfd. */
+		if (fcntl(memfd_buffer->memfd, F_ADD_SEALS, F_SEAL_SHRINK) < 0)
+			goto error;
+
+		memset(&create, 0, sizeof(create));
+		create.memfd = memfd_buffer->memfd;
+		create.flags = UDMABUF_FLAGS_CLOEXEC;
+		create.offset = 0;
+		create.size = aligned_size;
+
+		memfd_buffer->dmabuf_fd = ioctl(memfd_allocator->udmabuf_device_fd, UDMABUF_CREATE, &create);
+		if (memfd_buffer->dmabuf_fd < 0)
+			goto error;
+#else
+		g_assert_not_reached();
+#endif
+	}
+	else
+		memfd_buffer->dmabuf_fd = memfd_buffer->memfd;
+
+	if (fstat(memfd_buffer->dmabuf_fd, &stat_buf) < 0)
+		goto error;
+	memfd_buffer->inode = stat_buf.st_ino;
+
+	g_mutex_lock(&(memfd_allocator->mutex));
+
+	/* The synthetic addresses are never dereferenced, so the only thing
+	 * that matters is that they are nonzero and unique among the live
+	 * buffers. */
+	physical_address = memfd_imx_dma_buffer_allocator_pick_physical_address_locked(memfd_allocator, aligned_size, address_alignment, page_size);
+	if (physical_address == 0)
+	{
+		g_mutex_unlock(&(memfd_allocator->mutex));
+		GST_ERROR("no free synthetic physical address range left for %zu byte(s)", aligned_size);
+		errno = ENOMEM;
+		goto error;
+	}
+
+	memfd_buffer->physical_address = physical_address;
+
+	g_hash_table_insert(memfd_allocator->buffers_by_inode, &(memfd_buffer->inode), memfd_buffer);
+
+	g_mutex_unlock(&(memfd_allocator->mutex));
+
+	return (ImxDmaBuffer *)memfd_buffer;
+
+error:
+	if (error != NULL)
+		*error = errno;
+
+	if ((memfd_buffer->dmabuf_fd >= 0) && (memfd_buffer->dmabuf_fd != memfd_buffer->memfd))
+		close(memfd_buffer->dmabuf_fd);
+	if (memfd_buffer->memfd >= 0)
+		close(memfd_buffer->memfd);
+	g_free(memfd_buffer);
+
+	return NULL;
+}
+
+
+static void memfd_imx_dma_buffer_allocator_deallocate(ImxDmaBufferAllocator *allocator, ImxDmaBuffer *buffer)
+{
+	MemfdImxDmaBufferAllocator *memfd_allocator = (MemfdImxDmaBufferAllocator *)allocator;
+	MemfdDmaBuffer *memfd_buffer = (MemfdDmaBuffer *)buffer;
+
+	g_mutex_lock(&(memfd_allocator->mutex));
+	g_hash_table_remove(memfd_allocator->buffers_by_inode, &(memfd_buffer->inode));
+	g_mutex_unlock(&(memfd_allocator->mutex));
+
+	if (memfd_buffer->mapped_virtual_address != NULL)
+		munmap(memfd_buffer->mapped_virtual_address, memfd_buffer->size);
+
+	if (memfd_buffer->dmabuf_fd != memfd_buffer->memfd)
+		close(memfd_buffer->dmabuf_fd);
+	close(memfd_buffer->memfd);
+
+	g_free(memfd_buffer);
+}
+
+
+static uint8_t* memfd_imx_dma_buffer_allocator_map(ImxDmaBufferAllocator *allocator, ImxDmaBuffer *buffer, unsigned int flags, int *error)
+{
+	MemfdImxDmaBufferAllocator *memfd_allocator = (MemfdImxDmaBufferAllocator *)allocator;
+	MemfdDmaBuffer *memfd_buffer = (MemfdDmaBuffer *)buffer;
+	void *mapped_virtual_address;
+
+	if (flags == 0)
+		flags = IMX_DMA_BUFFER_MAPPING_FLAG_READ | IMX_DMA_BUFFER_MAPPING_FLAG_WRITE;
+
+	/* Like the libimxdmabuffer allocators, map the buffer only
+	 * once, and just increment a refcount in subsequent calls. */
+	if (memfd_buffer->mapped_virtual_address != NULL)
+	{
+		memfd_buffer->mapping_refcount++;
+		return memfd_buffer->mapped_virtual_address;
+	}
+
+	/* Always map with read and write access. Otherwise, a subsequent
+	 * map call that requests write access would have to remap. */
+	mapped_virtual_address = mmap(NULL, memfd_buffer->size, PROT_READ | PROT_WRITE, MAP_SHARED, memfd_buffer->dmabuf_fd, 0);
+	if (mapped_virtual_address == MAP_FAILED)
+	{
+		if (error != NULL)
+			*error = errno;
+		return NULL;
+	}
+
+	memfd_buffer->mapped_virtual_address = mapped_virtual_address;
+	memfd_buffer->map_flags = flags;
+	memfd_buffer->mapping_refcount = 1;
+
+	if (!(flags & IMX_DMA_BUFFER_MAPPING_FLAG_MANUAL_SYNC))
+		memfd_imx_dma_buffer_sync(memfd_allocator, memfd_buffer, TRUE);
+
+	return memfd_buffer->mapped_virtual_address;
+}
+
+
+static void memfd_imx_dma_buffer_allocator_unmap(ImxDmaBufferAllocator *allocator, ImxDmaBuffer *buffer)
+{
+	MemfdImxDmaBufferAllocator *memfd_allocator = (MemfdImxDmaBufferAllocator *)allocator;
+	MemfdDmaBuffer *memfd_buffer = (MemfdDmaBuffer *)buffer;
+
+	if (memfd_buffer->mapped_virtual_address == NULL)
+		return;
+
+	memfd_buffer->mapping_refcount--;
+	if (memfd_buffer->mapping_refcount > 0)
+		return;
+
+	if (!(memfd_buffer->map_flags & IMX_DMA_BUFFER_MAPPING_FLAG_MANUAL_SYNC))
+		memfd_imx_dma_buffer_sync(memfd_allocator, memfd_buffer, FALSE);
+
+	munmap(memfd_buffer->mapped_virtual_address, memfd_buffer->size);
+	memfd_buffer->mapped_virtual_address = NULL;
+}
+
+
+static imx_physical_address_t memfd_imx_dma_buffer_allocator_get_physical_address(G_GNUC_UNUSED ImxDmaBufferAllocator *allocator, ImxDmaBuffer *buffer)
+{
+	return ((MemfdDmaBuffer *)buffer)->physical_address;
+}
+
+
+static int memfd_imx_dma_buffer_allocator_get_fd(G_GNUC_UNUSED ImxDmaBufferAllocator *allocator, ImxDmaBuffer *buffer)
+{
+	return ((MemfdDmaBuffer *)buffer)->dmabuf_fd;
+}
+
+
+static size_t memfd_imx_dma_buffer_allocator_get_size(G_GNUC_UNUSED ImxDmaBufferAllocator *allocator, ImxDmaBuffer *buffer)
+{
+	return ((MemfdDmaBuffer *)buffer)->size;
+}
+
+
+static void memfd_imx_dma_buffer_allocator_start_sync_session(ImxDmaBufferAllocator *allocator, ImxDmaBuffer *buffer)
+{
+	memfd_imx_dma_buffer_sync((MemfdImxDmaBufferAllocator *)allocator, (MemfdDmaBuffer *)buffer, TRUE);
+}
+
+
+static void memfd_imx_dma_buffer_allocator_stop_sync_session(ImxDmaBufferAllocator *allocator, ImxDmaBuffer *buffer)
+{
+	memfd_imx_dma_buffer_sync((MemfdImxDmaBufferAllocator *)allocator, (MemfdDmaBuffer *)buffer, FALSE);
+}
+
+
+/* Checks if udmabuf can be used. Besides opening the device node, this
+ * creates a test DMA-BUF to check that DMA-BUFs have unique inodes. Older
+ * kernels use one anonymous inode for all DMA-BUFs, in which case the
+ * DMA-BUF FDs that are passed to get_physical_address cannot be mapped
+ * back to their buffers. Returns the device node FD, or -1. */
+static int memfd_imx_dma_buffer_allocator_open_udmabuf(void)
+{
+#ifdef HAVE_LINUX_UDMABUF_H
+	int udmabuf_device_fd;
+	int memfd = -1;
+	int test_dmabuf_fd = -1;
+	size_t page_size = sysconf(_SC_PAGESIZE);
+	struct udmabuf_create create;
+	struct statfs statfs_buf;
+
+	udmabuf_device_fd = open(UDMABUF_DEVICE_NODE, O_RDWR | O_CLOEXEC);
+	if (udmabuf_device_fd < 0)
+	{
+		GST_INFO("could not open %s: %s (%d); using plain memfds", UDMABUF_DEVICE_NODE, strerror(errno), errno);
+		return -1;
+	}
+
+	memfd = memfd_create("gstimxmemfdallocator-probe", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+	if ((memfd < 0) || (ftruncate(memfd, page_size) < 0) || (fcntl(memfd, F_ADD_SEALS, F_SEAL_SHRINK) < 0))
+	{
+		GST_INFO("could not create test memfd: %s (%d); using plain memfds", strerror(errno), errno);
+		goto error;
+	}
+
+	memset(&create, 0, sizeof(create));
+	create.memfd = memfd;
+	create.flags = UDMABUF_FLAGS_CLOEXEC;
+	create.offset = 0;
+	create.size = page_size;
+
+	test_dmabuf_fd = ioctl(udmabuf_device_fd, UDMABUF_CREATE, &create);
+	if (test_dmabuf_fd < 0)
+	{
+		GST_INFO("could not create test udmabuf: %s (%d); using plain memfds", strerror(errno), errno);
+		goto error;
+	}
+
+	if ((fstatfs(test_dmabuf_fd, &statfs_buf) < 0) || (statfs_buf.f_type != DMA_BUF_MAGIC))
+	{
+		GST_INFO("DMA-BUFs do not have unique inodes with this kernel; using plain memfds");
+		goto error;
+	}
+
+	close(test_dmabuf_fd);
+	close(memfd);
+
+	return udmabuf_device_fd;
+
+error:
+	if (test_dmabuf_fd >= 0)
+		close(test_dmabuf_fd);
+	if (memfd >= 0)
+		close(memfd);
+	close(udmabuf_device_fd);
+	return -1;
+#else
+	GST_INFO("built without udmabuf support; using plain memfds");
+	return -1;
+#endif
+}
+
+
+static ImxDmaBufferAllocator* memfd_imx_dma_buffer_allocator_new(gboolean use_udmabuf)
+{
+	MemfdImxDmaBufferAllocator *memfd_allocator = g_new0(MemfdImxDmaBufferAllocator, 1);
+
+	memfd_allocator->parent.destroy = memfd_imx_dma_buffer_allocator_destroy;
+	memfd_allocator->parent.allocate = memfd_imx_dma_buffer_allocator_allocate;
+	memfd_allocator->parent.deallocate = memfd_imx_dma_buffer_allocator_deallocate;
+	memfd_allocator->parent.map = memfd_imx_dma_buffer_allocator_map;
+	memfd_allocator->parent.unmap = memfd_imx_dma_buffer_allocator_unmap;
+	memfd_allocator->parent.get_physical_address = memfd_imx_dma_buffer_allocator_get_physical_address;
+	memfd_allocator->parent.get_fd = memfd_imx_dma_buffer_allocator_get_fd;
+	memfd_allocator->parent.get_size = memfd_imx_dma_buffer_allocator_get_size;
+	memfd_allocator->parent.start_sync_session = memfd_imx_dma_buffer_allocator_start_sync_session;
+	memfd_allocator->parent.stop_sync_session = memfd_imx_dma_buffer_allocator_stop_sync_session;
+
+	memfd_allocator->udmabuf_device_fd = use_udmabuf ? memfd_imx_dma_buffer_allocator_open_udmabuf() : -1;
+
+	g_mutex_init(&(memfd_allocator->mutex));
+	memfd_allocator->buffers_by_inode = g_hash_table_new(g_int64_hash, g_int64_equal);
+	memfd_allocator->next_physical_address = SYNTHETIC_PHYSICAL_ADDRESS_BASE;
+
+	return (ImxDmaBufferAllocator *)memfd_allocator;
+}
+
+
+
+
+struct _GstImxMemfdAllocator
+{
+	GstImxDmaBufAllocator parent;
+
+	ImxDmaBufferAllocator *imxdmabuffer_allocator;
+
+	gboolean use_udmabuf;
+};
+
+
+struct _GstImxMemfdAllocatorClass
+{
+	GstImxDmaBufAllocatorClass parent_class;
+};
+
+
+G_DEFINE_TYPE(GstImxMemfdAllocator, gst_imx_memfd_allocator, GST_TYPE_IMX_DMABUF_ALLOCATOR)
+
+static void gst_imx_memfd_allocator_dispose(GObject *object);
+static void gst_imx_memfd_allocator_set_property(GObject *object, guint prop_id, GValue const *value, GParamSpec *pspec);
+static void gst_imx_memfd_allocator_get_property(GObject *object, guint prop_id, GValue *value, GParamSpec *pspec);
+
+static gboolean gst_imx_memfd_allocator_activate(GstImxDmaBufAllocator *allocator);
+static guintptr gst_imx_memfd_allocator_get_physical_address(GstImxDmaBufAllocator *allocator, int dmabuf_fd);
+static ImxDmaBufferAllocator* gst_imx_memfd_allocator_get_allocator(GstImxDmaBufAllocator *allocator);
+
+
+static void gst_imx_memfd_allocator_class_init(GstImxMemfdAllocatorClass *klass)
+{
+	GObjectClass *object_class;
+	GstImxDmaBufAllocatorClass *imx_dmabuf_allocator_class;
+
+	GST_DEBUG_CATEGORY_INIT(imx_memfd_allocator_debug, "imxmemfdallocator", 0, "stand-in DMA-BUF allocator based on memfd and udmabuf");
+
+	object_class = G_OBJECT_CLASS(klass);
+	imx_dmabuf_allocator_class = GST_IMX_DMABUF_ALLOCATOR_CLASS(klass);
+
+	object_class->dispose = GST_DEBUG_FUNCPTR(gst_imx_memfd_allocator_dispose);
+	object_class->set_property = GST_DEBUG_FUNCPTR(gst_imx_memfd_allocator_set_property);
+	object_class->get_property = GST_DEBUG_FUNCPTR(gst_imx_memfd_allocator_get_property);
+
+	imx_dmabuf_allocator_class->activate = GST_DEBUG_FUNCPTR(gst_imx_memfd_allocator_activate);
+	imx_dmabuf_allocator_class->get_physical_address = GST_DEBUG_FUNCPTR(gst_imx_memfd_allocator_get_physical_address);
+	imx_dmabuf_allocator_class->get_allocator = GST_DEBUG_FUNCPTR(gst_imx_memfd_allocator_get_allocator);
+
+	g_object_class_install_property(
+		object_class,
+		PROP_USE_UDMABUF,
+		g_param_spec_boolean(
+			"use-udmabuf",
+			"Use udmabuf",
+			"Turn memfds into DMA-BUFs with the udmabuf driver if it is available (if FALSE or if udmabuf is not available, the memfds are used as DMA-BUFs directly)",
+			DEFAULT_USE_UDMABUF,
+			G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS
+		)
+	);
+}
+
+
+static void gst_imx_memfd_allocator_init(GstImxMemfdAllocator *self)
+{
+	self->imxdmabuffer_allocator = NULL;
+	self->use_udmabuf = DEFAULT_USE_UDMABUF;
+}
+
+
+static void gst_imx_memfd_allocator_dispose(GObject *object)
+{
+	GstImxMemfdAllocator *self = GST_IMX_MEMFD_ALLOCATOR(object);
+	GST_TRACE_OBJECT(self, "finalizing memfd GstAllocator %p", (gpointer)self);
+
+	if (self->imxdmabuffer_allocator != NULL)
+	{
+		imx_dma_buffer_allocator_destroy(self->imxdmabuffer_allocator);
+		self->imxdmabuffer_allocator = NULL;
+	}
+
+	G_OBJECT_CLASS(gst_imx_memfd_allocator_parent_class)->dispose(object);
+}
+
+
+static void gst_imx_memfd_allocator_set_property(GObject *object, guint prop_id, GValue const *value, GParamSpec *pspec)
+{
+	GstImxMemfdAllocator *self = GST_IMX_MEMFD_ALLOCATOR(object);
+
+	GST_OBJECT_LOCK(object);
+	if (gst_imx_dmabuf_allocator_is_active(GST_ALLOCATOR_CAST(self)))
+	{
+		GST_OBJECT_UNLOCK(object);
+		GST_ERROR_OBJECT(self, "cannot set property; allocator already active");
+		return;
+	}
+
+	switch (prop_id)
+	{
+		case PROP_USE_UDMABUF:
+			self->use_udmabuf = g_value_get_boolean(value);
+			GST_OBJECT_UNLOCK(object);
+			break;
+
+		default:
+			GST_OBJECT_UNLOCK(object);
+			G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+			break;
+	}
+}
+
+
+static void gst_imx_memfd_allocator_get_property(GObject *object, guint prop_id, GValue *value, GParamSpec *pspec)
+{
+	GstImxMemfdAllocator *self = GST_IMX_MEMFD_ALLOCATOR(object);
+
+	switch (prop_id)
+	{
+		case PROP_USE_UDMABUF:
+			GST_OBJECT_LOCK(object);
+			g_value_set_boolean(value, self->use_udmabuf);
+			GST_OBJECT_UNLOCK(object);
+			break;
+
+		default:
+			G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+			break;
+	}
+}
+
+
+static gboolean gst_imx_memfd_allocator_activate(GstImxDmaBufAllocator *allocator)
+{
+	GstImxMemfdAllocator *self = GST_IMX_MEMFD_ALLOCATOR(allocator);
+	MemfdImxDmaBufferAllocator *memfd_allocator;
+
+	if (self->imxdmabuffer_allocator != NULL)
+		return TRUE;
+
+	self->imxdmabuffer_allocator = memfd_imx_dma_buffer_allocator_new(self->use_udmabuf);
+	memfd_allocator = (MemfdImxDmaBufferAllocator *)(self->imxdmabuffer_allocator);
+
+	GST_DEBUG_OBJECT(self, "created memfd allocator; using udmabuf: %d", memfd_allocator->udmabuf_device_fd >= 0);
+
+	return TRUE;
+}
+
+
+static guintptr gst_imx_memfd_allocator_get_physical_address(GstImxDmaBufAllocator *allocator, int dmabuf_fd)
+{
+	GstImxMemfdAllocator *self = GST_IMX_MEMFD_ALLOCATOR(allocator);
+	MemfdImxDmaBufferAllocator *memfd_allocator = (MemfdImxDmaBufferAllocator *)(self->imxdmabuffer_allocator);
+	MemfdDmaBuffer *memfd_buffer;
+	guintptr physical_address = 0;
+	struct stat stat_buf;
+	guint64 inode;
+
+	if (fstat(dmabuf_fd, &stat_buf) < 0)
+	{
+		GST_ERROR_OBJECT(self, "could not stat DMA-BUF FD %d: %s (%d)", dmabuf_fd, strerror(errno), errno);
+		return 0;
+	}
+
+	inode = stat_buf.st_ino;
+
+	g_mutex_lock(&(memfd_allocator->mutex));
+	memfd_buffer = g_hash_table_lookup(memfd_allocator->buffers_by_inode, &inode);
+	if (memfd_buffer != NULL)
+		physical_address = memfd_buffer->physical_address;
+	g_mutex_unlock(&(memfd_allocator->mutex));
+
+	/* There is no physical address that could be synthesized for
+	 * DMA-BUFs that were not allocated by this allocator. */
+	if (physical_address == 0)
+		GST_ERROR_OBJECT(self, "DMA-BUF FD %d was not allocated by this allocator; cannot get physical address", dmabuf_fd);
+
+	return physical_address;
+}
+
+
+static ImxDmaBufferAllocator* gst_imx_memfd_allocator_get_allocator(GstImxDmaBufAllocator *allocator)
+{
+	GstImxMemfdAllocator *self = GST_IMX_MEMFD_ALLOCATOR(allocator);
+	return self->imxdmabuffer_allocator;
+}
+
+
+GstAllocator* gst_imx_memfd_allocator_new(void)
+{
+	GstAllocator *imx_memfd_allocator = GST_ALLOCATOR_CAST(g_object_new(gst_imx_memfd_allocator_get_type(), NULL));
+
+	GST_DEBUG_OBJECT(imx_memfd_allocator, "created new memfd i.MX DMA allocator %s", GST_OBJECT_NAME(imx_memfd_allocator));
+
+	/* Clear floating flag */
+	gst_object_ref_sink(GST_OBJECT(imx_memfd_allocator));
+
+	return imx_memfd_allocator;
+}
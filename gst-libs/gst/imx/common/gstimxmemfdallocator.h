@@ -0,0 +1,72 @@
+/* gstreamer-imx: GStreamer plugins for the i.MX SoCs
+ * Copyright (C) 2026  agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef GST_IMX_MEMFD_ALLOCATOR_H
+#define GST_IMX_MEMFD_ALLOCATOR_H
+
+#include <gst/gst.h>
+
+
+G_BEGIN_DECLS
+
+
+#define GST_TYPE_IMX_MEMFD_ALLOCATOR             (gst_imx_memfd_allocator_get_type())
+#define GST_IMX_MEMFD_ALLOCATOR(obj)             (G_TYPE_CHECK_INSTANCE_CAST((obj), GST_TYPE_IMX_MEMFD_ALLOCATOR, GstImxMemfdAllocator))
+#define GST_IMX_MEMFD_ALLOCATOR_CLASS(klass)     (G_TYPE_CHECK_CLASS_CAST((klass), GST_TYPE_IMX_MEMFD_ALLOCATOR, GstImxMemfdAllocatorClass))
+#define GST_IMX_MEMFD_ALLOCATOR_GET_CLASS(obj)   (G_TYPE_INSTANCE_GET_CLASS((obj), GST_TYPE_IMX_MEMFD_ALLOCATOR, GstImxMemfdAllocatorClass))
+#define GST_IMX_MEMFD_ALLOCATOR_CAST(obj)        ((GstImxMemfdAllocator *)(obj))
+#define GST_IS_IMX_MEMFD_ALLOCATOR(obj)          (G_TYPE_CHECK_INSTANCE_TYPE((obj), GST_TYPE_IMX_MEMFD_ALLOCATOR))
+#define GST_IS_IMX_MEMFD_ALLOCATOR_CLASS(klass)  (G_TYPE_CHECK_CLASS_TYPE((klass), GST_TYPE_IMX_MEMFD_ALLOCATOR))
+
+
+/**
+ * GstImxMemfdAllocator:
+ *
+ * Stand-in for the dma-heap and ION allocators, intended for running and
+ * benchmarking the upload, buffer pool, and imx2d code on machines that
+ * are not i.MX SoCs (like x86 CI hosts).
+ *
+ * Buffers are allocated with memfd_create(). If the "use-udmabuf" property
+ * is TRUE and /dev/udmabuf is usable, the memfds are turned into real
+ * DMA-BUFs by the udmabuf driver. Otherwise, the memfd FDs themselves
+ * are used as DMA-BUF FDs. Either way, the memory is regular pageable
+ * system memory, so the physical addresses this allocator reports are
+ * synthetic. They are unique among the buffers of an allocator, but must
+ * never be passed to actual hardware. Only use this allocator together
+ * with CPU based processing.
+ */
+typedef struct _GstImxMemfdAllocator GstImxMemfdAllocator;
+typedef struct _GstImxMemfdAllocatorClass GstImxMemfdAllocatorClass;
+
+
+GType gst_imx_memfd_allocator_get_type(void);
+
+/**
+ * gst_imx_memfd_allocator_new:
+ *
+ * Creates a new #GstAllocator using memfd_create() (and udmabuf if available).
+ *
+ * Returns: (transfer full) (nullable): Newly created allocator, or NULL in case of failure.
+ */
+GstAllocator* gst_imx_memfd_allocator_new(void);
+
+
+G_END_DECLS
+
+
+#endif /* GST_IMX_MEMFD_ALLOCATOR_H */
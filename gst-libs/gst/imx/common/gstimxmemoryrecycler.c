@@ -0,0 +1,408 @@
+/* gstreamer-imx: GStreamer plugins for the i.MX SoCs
+ * Copyright (C) 2026  agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "config.h"
+
+#include <gst/gst.h>
+#include "gstimxmemoryrecycler.h"
+
+
+GST_DEBUG_CATEGORY_STATIC(imx_memory_recycler_debug);
+#define GST_CAT_DEFAULT imx_memory_recycler_debug
+
+
+struct _GstImxMemoryRecycler
+{
+	GstObject parent;
+
+	/*< private >*/
+
+	/* Idle memory blocks, with the most recently released one at the head. */
+	GQueue idle_memories;
+	gsize idle_memories_size;
+	gsize max_idle_memories_size;
+
+	/* If TRUE, released memory blocks are freed instead of recycled. */
+	gboolean shutting_down;
+
+	guint64 num_allocations;
+	guint64 num_reuses;
+
+	/* This mutex is used for thread-synchronized access to the fields above.
+	 * Memory blocks can be released from any thread. */
+	GMutex mutex;
+};
+
+
+struct _GstImxMemoryRecyclerClass
+{
+	GstObjectClass parent_class;
+};
+
+
+G_DEFINE_TYPE(GstImxMemoryRecycler, gst_imx_memory_recycler, GST_TYPE_OBJECT)
+
+
+/* Memory blocks allocated by the recycler have a reference
+ * to the recycler stored as qdata under this quark. */
+static GQuark memory_recycler_quark;
+
+
+static void gst_imx_memory_recycler_finalize(GObject *object);
+
+static void gst_imx_memory_recycler_free_memories(GSList *memories);
+static void gst_imx_memory_recycler_evict_locked(GstImxMemoryRecycler *recycler, GSList **evicted_memories);
+static gboolean gst_imx_memory_recycler_dispose_memory(GstMiniObject *mini_object);
+static GstMemory* gst_imx_memory_recycler_allocate_memory(GstImxMemoryRecycler *recycler, GstAllocator *allocator, gsize size, GstAllocationParams *params);
+
+
+static void gst_imx_memory_recycler_class_init(GstImxMemoryRecyclerClass *klass)
+{
+	GObjectClass *object_class;
+
+	object_class = G_OBJECT_CLASS(klass);
+	object_class->finalize = GST_DEBUG_FUNCPTR(gst_imx_memory_recycler_finalize);
+
+	memory_recycler_quark = g_quark_from_static_string("gst-imx-memory-recycler");
+
+	GST_DEBUG_CATEGORY_INIT(imx_memory_recycler_debug, "imxmemoryrecycler", 0, "NXP i.MX memory block recycler");
+}
+
+
+static void gst_imx_memory_recycler_init(GstImxMemoryRecycler *recycler)
+{
+	g_queue_init(&(recycler->idle_memories));
+	recycler->idle_memories_size = 0;
+	recycler->max_idle_memories_size = 0;
+
+	recycler->shutting_down = FALSE;
+
+	recycler->num_allocations = 0;
+	recycler->num_reuses = 0;
+
+	g_mutex_init(&(recycler->mutex));
+}
+
+
+static void gst_imx_memory_recycler_finalize(GObject *object)
+{
+	GstImxMemoryRecycler *recycler = GST_IMX_MEMORY_RECYCLER(object);
+
+	/* Idle memory blocks are freed by gst_imx_memory_recycler_shutdown().
+	 * Since each block holds a reference to the recycler, there cannot
+	 * be any blocks left by the time the recycler is finalized. */
+	g_assert(g_queue_is_empty(&(recycler->idle_memories)));
+
+	GST_DEBUG_OBJECT(recycler, "finalizing memory recycler");
+
+	g_mutex_clear(&(recycler->mutex));
+
+	G_OBJECT_CLASS(gst_imx_memory_recycler_parent_class)->finalize(object);
+}
+
+
+/* Frees the given memory blocks without recycling them.
+ * Must be called with the recycler mutex unlocked. */
+static void gst_imx_memory_recycler_free_memories(GSList *memories)
+{
+	GSList *list_entry;
+
+	for (list_entry = memories; list_entry != NULL; list_entry = list_entry->next)
+	{
+		GstMemory *memory = (GstMemory *)(list_entry->data);
+
+		/* Remove the dispose function to make sure the block
+		 * actually gets freed instead of returning to the recycler. */
+		GST_MINI_OBJECT_CAST(memory)->dispose = NULL;
+		gst_memory_unref(memory);
+	}
+
+	g_slist_free(memories);
+}
+
+
+/* Removes the least recently released idle memory blocks until the total
+ * idle size is within the limit. The removed blocks are prepended to
+ * (*evicted_memories), and must be freed with gst_imx_memory_recycler_free_memories()
+ * after the mutex is unlocked. Must be called with the recycler mutex locked. */
+static void gst_imx_memory_recycler_evict_locked(GstImxMemoryRecycler *recycler, GSList **evicted_memories)
+{
+	while (recycler->idle_memories_size > recycler->max_idle_memories_size)
+	{
+		GstMemory *memory = (GstMemory *)g_queue_pop_tail(&(recycler->idle_memories));
+
+		recycler->idle_memories_size -= memory->maxsize;
+		*evicted_memories = g_slist_prepend(*evicted_memories, memory);
+
+		GST_LOG_OBJECT(recycler, "evicting idle memory %p with %" G_GSIZE_FORMAT " byte(s)", (gpointer)memory, memory->maxsize);
+	}
+}
+
+
+static gboolean gst_imx_memory_recycler_dispose_memory(GstMiniObject *mini_object)
+{
+	GstMemory *memory = (GstMemory *)mini_object;
+	GstImxMemoryRecycler *recycler = gst_mini_object_get_qdata(mini_object, memory_recycler_quark);
+	GSList *evicted_memories = NULL;
+
+	g_mutex_lock(&(recycler->mutex));
+
+	if (recycler->shutting_down || (memory->maxsize > recycler->max_idle_memories_size))
+	{
+		g_mutex_unlock(&(recycler->mutex));
+		/* Returning TRUE lets the memory block be freed. */
+		return TRUE;
+	}
+
+	/* Resurrect the memory block and put it back into the recycler. */
+	gst_memory_ref(memory);
+	g_queue_push_head(&(recycler->idle_memories), memory);
+	recycler->idle_memories_size += memory->maxsize;
+
+	GST_LOG_OBJECT(recycler, "memory %p with %" G_GSIZE_FORMAT " byte(s) returned to recycler", (gpointer)memory, memory->maxsize);
+
+	gst_imx_memory_recycler_evict_locked(recycler, &evicted_memories);
+
+	g_mutex_unlock(&(recycler->mutex));
+
+	gst_imx_memory_recycler_free_memories(evicted_memories);
+
+	return FALSE;
+}
+
+
+/* Allocates a new memory block and sets it up so that it returns
+ * to the recycler once it is released. Must be called with the
+ * recycler mutex unlocked. */
+static GstMemory* gst_imx_memory_recycler_allocate_memory(GstImxMemoryRecycler *recycler, GstAllocator *allocator, gsize size, GstAllocationParams *params)
+{
+	GstMemory *memory;
+
+	memory = gst_allocator_alloc(allocator, size, params);
+	if (G_UNLIKELY(memory == NULL))
+		return NULL;
+
+	g_mutex_lock(&(recycler->mutex));
+	recycler->num_allocations++;
+	g_mutex_unlock(&(recycler->mutex));
+
+	/* Do not interfere with allocators that install their own dispose
+	 * function. Such blocks are simply not recycled. */
+	if (GST_MINI_OBJECT_CAST(memory)->dispose != NULL)
+	{
+		GST_DEBUG_OBJECT(recycler, "memory %p already has a dispose function; not recycling it", (gpointer)memory);
+		return memory;
+	}
+
+	gst_mini_object_set_qdata(GST_MINI_OBJECT_CAST(memory), memory_recycler_quark, gst_object_ref(GST_OBJECT(recycler)), (GDestroyNotify)gst_object_unref);
+	GST_MINI_OBJECT_CAST(memory)->dispose = gst_imx_memory_recycler_dispose_memory;
+
+	GST_LOG_OBJECT(recycler, "allocated new memory %p with %" G_GSIZE_FORMAT " byte(s)", (gpointer)memory, size);
+
+	return memory;
+}
+
+
+GstImxMemoryRecycler* gst_imx_memory_recycler_new(gsize max_idle_size)
+{
+	GstImxMemoryRecycler *recycler = (GstImxMemoryRecycler *)g_object_new(gst_imx_memory_recycler_get_type(), NULL);
+	recycler->max_idle_memories_size = max_idle_size;
+
+	/* Clear the floating flag, since the recycler
+	 * is not meant to be parented to anything. */
+	gst_object_ref_sink(GST_OBJECT(recycler));
+
+	GST_DEBUG_OBJECT(recycler, "created new memory recycler with up to %" G_GSIZE_FORMAT " byte(s) of idle memory", max_idle_size);
+
+	return recycler;
+}
+
+
+void gst_imx_memory_recycler_shutdown(GstImxMemoryRecycler *recycler)
+{
+	GSList *idle_memories = NULL;
+	GstMemory *memory;
+
+	g_assert(recycler != NULL);
+
+	g_mutex_lock(&(recycler->mutex));
+	recycler->shutting_down = TRUE;
+	while ((memory = (GstMemory *)g_queue_pop_head(&(recycler->idle_memories))) != NULL)
+		idle_memories = g_slist_prepend(idle_memories, memory);
+	recycler->idle_memories_size = 0;
+	g_mutex_unlock(&(recycler->mutex));
+
+	GST_DEBUG_OBJECT(recycler, "shutting down memory recycler; freeing %u idle memory block(s)", g_slist_length(idle_memories));
+
+	gst_imx_memory_recycler_free_memories(idle_memories);
+
+	gst_object_unref(GST_OBJECT(recycler));
+}
+
+
+void gst_imx_memory_recycler_set_max_idle_size(GstImxMemoryRecycler *recycler, gsize max_idle_size)
+{
+	GSList *evicted_memories = NULL;
+
+	g_assert(recycler != NULL);
+
+	g_mutex_lock(&(recycler->mutex));
+	recycler->max_idle_memories_size = max_idle_size;
+	gst_imx_memory_recycler_evict_locked(recycler, &evicted_memories);
+	g_mutex_unlock(&(recycler->mutex));
+
+	gst_imx_memory_recycler_free_memories(evicted_memories);
+}
+
+
+void gst_imx_memory_recycler_evict_smaller(GstImxMemoryRecycler *recycler, gsize min_size)
+{
+	GSList *evicted_memories = NULL;
+	GList *list_entry, *next_list_entry;
+
+	g_assert(recycler != NULL);
+
+	g_mutex_lock(&(recycler->mutex));
+
+	for (list_entry = recycler->idle_memories.head; list_entry != NULL; list_entry = next_list_entry)
+	{
+		GstMemory *idle_memory = (GstMemory *)(list_entry->data);
+		next_list_entry = list_entry->next;
+
+		if (idle_memory->maxsize >= min_size)
+			continue;
+
+		g_queue_delete_link(&(recycler->idle_memories), list_entry);
+		recycler->idle_memories_size -= idle_memory->maxsize;
+		evicted_memories = g_slist_prepend(evicted_memories, idle_memory);
+
+		GST_LOG_OBJECT(recycler, "evicting idle memory %p with %" G_GSIZE_FORMAT " byte(s) since it is smaller than %" G_GSIZE_FORMAT " byte(s)", (gpointer)idle_memory, idle_memory->maxsize, min_size);
+	}
+
+	g_mutex_unlock(&(recycler->mutex));
+
+	gst_imx_memory_recycler_free_memories(evicted_memories);
+}
+
+
+GstMemory* gst_imx_memory_recycler_acquire(GstImxMemoryRecycler *recycler, GstAllocator *allocator, gsize size, gsize max_reuse_size, GstAllocationParams *params)
+{
+	GstMemory *memory = NULL;
+	GList *list_entry, *best_list_entry = NULL;
+	gsize align = (params != NULL) ? params->align : 0;
+
+	g_assert(recycler != NULL);
+	g_assert(allocator != NULL);
+
+	g_mutex_lock(&(recycler->mutex));
+
+	/* Pick the smallest idle block that fits, to avoid using
+	 * large blocks for small requests when a smaller block
+	 * is available. */
+	for (list_entry = recycler->idle_memories.head; list_entry != NULL; list_entry = list_entry->next)
+	{
+		GstMemory *idle_memory = (GstMemory *)(list_entry->data);
+
+		if ((idle_memory->allocator != allocator) || (idle_memory->maxsize < size) || (idle_memory->maxsize > max_reuse_size) || ((idle_memory->align & align) != align))
+			continue;
+
+		if ((best_list_entry == NULL) || (idle_memory->maxsize < ((GstMemory *)(best_list_entry->data))->maxsize))
+			best_list_entry = list_entry;
+	}
+
+	if (best_list_entry != NULL)
+	{
+		memory = (GstMemory *)(best_list_entry->data);
+		g_queue_delete_link(&(recycler->idle_memories), best_list_entry);
+		recycler->idle_memories_size -= memory->maxsize;
+		recycler->num_reuses++;
+	}
+
+	g_mutex_unlock(&(recycler->mutex));
+
+	if (memory != NULL)
+	{
+		GST_LOG_OBJECT(recycler, "reusing idle memory %p with %" G_GSIZE_FORMAT " byte(s) for %" G_GSIZE_FORMAT " byte(s)", (gpointer)memory, memory->maxsize, size);
+		gst_memory_resize(memory, -((gssize)(memory->offset)), size);
+		return memory;
+	}
+
+	return gst_imx_memory_recycler_allocate_memory(recycler, allocator, size, params);
+}
+
+
+guint gst_imx_memory_recycler_prefill(GstImxMemoryRecycler *recycler, GstAllocator *allocator, gsize size, guint num_blocks, GstAllocationParams *params)
+{
+	guint num_added = 0;
+
+	g_assert(recycler != NULL);
+	g_assert(allocator != NULL);
+
+	while (num_added < num_blocks)
+	{
+		GstMemory *memory;
+		gboolean has_room;
+
+		g_mutex_lock(&(recycler->mutex));
+		has_room = !(recycler->shutting_down) && ((recycler->idle_memories_size + size) <= recycler->max_idle_memories_size);
+		g_mutex_unlock(&(recycler->mutex));
+
+		if (!has_room)
+			break;
+
+		memory = gst_imx_memory_recycler_allocate_memory(recycler, allocator, size, params);
+		if (G_UNLIKELY(memory == NULL))
+		{
+			GST_WARNING_OBJECT(recycler, "could not allocate memory block with %" G_GSIZE_FORMAT " byte(s) for prefilling", size);
+			break;
+		}
+
+		if (GST_MINI_OBJECT_CAST(memory)->dispose != gst_imx_memory_recycler_dispose_memory)
+		{
+			/* This allocator's blocks cannot be recycled,
+			 * so there is no point in prefilling. */
+			gst_memory_unref(memory);
+			break;
+		}
+
+		/* Releasing the block puts it into the idle queue. */
+		gst_memory_unref(memory);
+		num_added++;
+	}
+
+	GST_DEBUG_OBJECT(recycler, "prefilled %u of %u requested memory block(s) with %" G_GSIZE_FORMAT " byte(s) each", num_added, num_blocks, size);
+
+	return num_added;
+}
+
+
+void gst_imx_memory_recycler_get_statistics(GstImxMemoryRecycler *recycler, guint64 *num_allocations, guint64 *num_reuses, gsize *idle_size)
+{
+	g_assert(recycler != NULL);
+
+	g_mutex_lock(&(recycler->mutex));
+
+	if (num_allocations != NULL)
+		*num_allocations = recycler->num_allocations;
+	if (num_reuses != NULL)
+		*num_reuses = recycler->num_reuses;
+	if (idle_size != NULL)
+		*idle_size = recycler->idle_memories_size;
+
+	g_mutex_unlock(&(recycler->mutex));
+}
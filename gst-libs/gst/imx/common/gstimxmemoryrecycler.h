@@ -0,0 +1,165 @@
+/* gstreamer-imx: GStreamer plugins for the i.MX SoCs
+ * Copyright (C) 2026  agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef GST_IMX_MEMORY_RECYCLER_H
+#define GST_IMX_MEMORY_RECYCLER_H
+
+#include <gst/gst.h>
+
+
+G_BEGIN_DECLS
+
+
+#define GST_TYPE_IMX_MEMORY_RECYCLER             (gst_imx_memory_recycler_get_type())
+#define GST_IMX_MEMORY_RECYCLER(obj)             (G_TYPE_CHECK_INSTANCE_CAST((obj), GST_TYPE_IMX_MEMORY_RECYCLER, GstImxMemoryRecycler))
+#define GST_IMX_MEMORY_RECYCLER_CLASS(klass)     (G_TYPE_CHECK_CLASS_CAST((klass), GST_TYPE_IMX_MEMORY_RECYCLER, GstImxMemoryRecyclerClass))
+#define GST_IMX_MEMORY_RECYCLER_GET_CLASS(obj)   (G_TYPE_INSTANCE_GET_CLASS((obj), GST_TYPE_IMX_MEMORY_RECYCLER, GstImxMemoryRecyclerClass))
+#define GST_IS_IMX_MEMORY_RECYCLER(obj)          (G_TYPE_CHECK_INSTANCE_TYPE((obj), GST_TYPE_IMX_MEMORY_RECYCLER))
+#define GST_IS_IMX_MEMORY_RECYCLER_CLASS(klass)  (G_TYPE_CHECK_CLASS_TYPE((klass), GST_TYPE_IMX_MEMORY_RECYCLER))
+
+
+/**
+ * GstImxMemoryRecycler:
+ *
+ * Keeps memory blocks that are no longer in use around, so they can be
+ * reused instead of being freed and allocated again. Allocating DMA memory
+ * is expensive (it involves ioctl's and mmap calls), and doing that over
+ * and over causes CMA fragmentation over time.
+ *
+ * Memory blocks are acquired with @gst_imx_memory_recycler_acquire. Blocks
+ * allocated by the recycler get a mini object dispose function that puts
+ * them back into the recycler once their refcount reaches zero (the same
+ * mechanism GstBufferPool uses for buffers). This means that it does not
+ * matter who drops the last reference to a block or when this happens.
+ * Blocks whose allocator installs its own dispose function are not recycled.
+ *
+ * The total size of idle blocks is limited. If a released block would
+ * exceed that limit, the least recently released blocks are freed.
+ *
+ * Memory blocks can outlive the owner of the recycler (downstream may still
+ * hold on to them), which is why the recycler is a GstObject. Each block holds
+ * a reference to it. Once the owner is done with the recycler, it calls
+ * @gst_imx_memory_recycler_shutdown, which frees the idle blocks and makes
+ * sure blocks that are still in use are freed instead of recycled once they
+ * are released.
+ */
+typedef struct _GstImxMemoryRecycler GstImxMemoryRecycler;
+typedef struct _GstImxMemoryRecyclerClass GstImxMemoryRecyclerClass;
+
+
+GType gst_imx_memory_recycler_get_type(void);
+
+
+/**
+ * gst_imx_memory_recycler_new:
+ * @max_idle_size: Maximum total size of idle memory blocks, in bytes.
+ *
+ * Creates a new recycler. If @max_idle_size is 0, blocks are never recycled.
+ *
+ * Returns: (transfer full): New recycler.
+ */
+GstImxMemoryRecycler* gst_imx_memory_recycler_new(gsize max_idle_size);
+
+/**
+ * gst_imx_memory_recycler_shutdown:
+ * @recycler: Recycler to shut down.
+ *
+ * Frees all idle memory blocks, makes sure that blocks that are still in use
+ * are freed once they are released, and drops the caller's reference.
+ */
+void gst_imx_memory_recycler_shutdown(GstImxMemoryRecycler *recycler);
+
+/**
+ * gst_imx_memory_recycler_set_max_idle_size:
+ * @recycler: Recycler to configure.
+ * @max_idle_size: Maximum total size of idle memory blocks, in bytes.
+ *
+ * Sets a new limit for the total size of idle memory blocks. If the idle
+ * blocks currently exceed the new limit, the least recently released ones
+ * are freed. This function is thread safe.
+ */
+void gst_imx_memory_recycler_set_max_idle_size(GstImxMemoryRecycler *recycler, gsize max_idle_size);
+
+/**
+ * gst_imx_memory_recycler_evict_smaller:
+ * @recycler: Recycler to evict idle memory blocks from.
+ * @min_size: Idle blocks with a maximum size below this are freed, in bytes.
+ *
+ * Frees idle memory blocks that are too small for the given size. This is
+ * useful when the sizes of the requested blocks grow (for example after a
+ * resolution change), since such blocks would otherwise stay around next to
+ * the newly allocated larger ones without ever being reused. This function
+ * is thread safe.
+ */
+void gst_imx_memory_recycler_evict_smaller(GstImxMemoryRecycler *recycler, gsize min_size);
+
+/**
+ * gst_imx_memory_recycler_acquire:
+ * @recycler: Recycler to acquire a memory block from.
+ * @allocator: Allocator to allocate a new block with.
+ * @size: Size of the memory block, in bytes.
+ * @max_reuse_size: Largest idle block that may be reused for this request, in bytes.
+ * @params: (allow-none): Allocation parameters to pass to @allocator.
+ *
+ * Picks the smallest idle memory block that was allocated by @allocator,
+ * whose maximum size lies within @size and @max_reuse_size, and that
+ * satisfies the alignment in @params. If no idle block fits, a new one
+ * with @size bytes is allocated. Reused blocks are resized to @size.
+ * This function is thread safe.
+ *
+ * Returns: (transfer full): Memory block, or NULL if allocation failed.
+ */
+GstMemory* gst_imx_memory_recycler_acquire(GstImxMemoryRecycler *recycler, GstAllocator *allocator, gsize size, gsize max_reuse_size, GstAllocationParams *params);
+
+/**
+ * gst_imx_memory_recycler_prefill:
+ * @recycler: Recycler to fill.
+ * @allocator: Allocator to allocate the blocks with.
+ * @size: Size of each memory block, in bytes.
+ * @num_blocks: Number of memory blocks to allocate.
+ * @params: (allow-none): Allocation parameters to pass to @allocator.
+ *
+ * Allocates memory blocks up front and places them in the recycler as idle
+ * blocks, so that subsequent @gst_imx_memory_recycler_acquire calls do not
+ * have to allocate. This stops early once the idle blocks would exceed the
+ * limit set by @gst_imx_memory_recycler_new or by
+ * @gst_imx_memory_recycler_set_max_idle_size.
+ *
+ * Returns: The number of blocks that were added.
+ */
+guint gst_imx_memory_recycler_prefill(GstImxMemoryRecycler *recycler, GstAllocator *allocator, gsize size, guint num_blocks, GstAllocationParams *params);
+
+/**
+ * gst_imx_memory_recycler_get_statistics:
+ * @recycler: Recycler to get statistics from.
+ * @num_allocations: (out) (optional): Number of memory blocks that had to
+ *     be newly allocated. Can be NULL.
+ * @num_reuses: (out) (optional): Number of times an idle memory block
+ *     was reused. Can be NULL.
+ * @idle_size: (out) (optional): Current total size of the idle memory
+ *     blocks, in bytes. Can be NULL.
+ *
+ * Retrieves usage statistics. This function is thread safe.
+ */
+void gst_imx_memory_recycler_get_statistics(GstImxMemoryRecycler *recycler, guint64 *num_allocations, guint64 *num_reuses, gsize *idle_size);
+
+
+G_END_DECLS
+
+
+#endif /* GST_IMX_MEMORY_RECYCLER_H */
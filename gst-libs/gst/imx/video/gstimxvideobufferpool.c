@@ -3,6 +3,7 @@
 #include <gst/video/video.h>
 #include "gst/imx/common/gstimxdmabufferallocator.h"
 #include "gstimxvideobufferpool.h"
+#include "gstimxvideoworkerpool.h"
 
 
 GST_DEBUG_CATEGORY_STATIC(imx_video_buffer_pool_debug);
@@ -20,6 +21,17 @@ struct _GstImxVideoBufferPool
 	gboolean both_pools_same;
 	gboolean video_meta_supported;
 
+	/* TRUE if downstream cannot handle video metas, but the blitter
+	 * can still write directly into output buffers, because only the
+	 * padding rows at the end of the frame differ. The output buffers
+	 * are then trimmed down to the size downstream expects. */
+	gboolean trim_output_buffers;
+
+	/* Number of frames that were transferred without and with a
+	 * frame copy. Protected by the object lock. */
+	guint64 num_zero_copy_transfers;
+	guint64 num_copied_transfers;
+
 	GstVideoInfo intermediate_video_info;
 	GstVideoInfo output_video_info;
 };
@@ -54,6 +66,10 @@ static void gst_imx_video_buffer_pool_init(GstImxVideoBufferPool *self)
 	self->output_video_buffer_pool = NULL;
 
 	self->both_pools_same = FALSE;
+	self->trim_output_buffers = FALSE;
+
+	self->num_zero_copy_transfers = 0;
+	self->num_copied_transfers = 0;
 }
 
 
@@ -61,6 +77,13 @@ static void gst_imx_video_buffer_pool_dispose(GObject *object)
 {
 	GstImxVideoBufferPool *self = GST_IMX_VIDEO_BUFFER_POOL(object);
 
+	GST_DEBUG_OBJECT(
+		self,
+		"transferred %" G_GUINT64_FORMAT " frame(s) without copying and %" G_GUINT64_FORMAT " frame(s) by copying",
+		self->num_zero_copy_transfers,
+		self->num_copied_transfers
+	);
+
 	if (self->internal_dma_buffer_pool != NULL)
 	{
 		if (!self->both_pools_same)
@@ -100,6 +123,7 @@ GstImxVideoBufferPool* gst_imx_video_buffer_pool_new(
 	GstCaps *negotiated_caps;
 	GstVideoInfo negotiated_video_info;
 	gboolean intermediate_buffers_are_tightly_packed;
+	gboolean intermediate_layout_matches_output;
 	guint buffer_size;
 	guint video_meta_index;
 	guint i;
@@ -151,6 +175,24 @@ GstImxVideoBufferPool* gst_imx_video_buffer_pool_new(
 	intermediate_buffers_are_tightly_packed = gst_video_info_is_equal(&negotiated_video_info, intermediate_video_info);
 	GST_DEBUG_OBJECT(self, "intermediate frames are tighly packed: %d", intermediate_buffers_are_tightly_packed);
 
+	/* Even if the intermediate frames are not tightly packed, the blitter
+	 * may still be able to write directly into buffers that downstream
+	 * can use. This is the case if the stride and plane offset values are
+	 * the same, and only the number of padding rows at the bottom of the
+	 * frame differs (which happens when the stride values are already
+	 * aligned, and only the total row count needs to be aligned). Such
+	 * buffers are allocated with the intermediate frame size, which
+	 * accommodates the padding rows, and are then trimmed to the size
+	 * of a tightly packed frame before they are pushed downstream. */
+	intermediate_layout_matches_output = (GST_VIDEO_INFO_N_PLANES(&negotiated_video_info) == GST_VIDEO_INFO_N_PLANES(intermediate_video_info))
+	                                  && (GST_VIDEO_INFO_SIZE(&negotiated_video_info) <= GST_VIDEO_INFO_SIZE(intermediate_video_info));
+	for (i = 0; intermediate_layout_matches_output && (i < GST_VIDEO_INFO_N_PLANES(&negotiated_video_info)); ++i)
+	{
+		intermediate_layout_matches_output = (GST_VIDEO_INFO_PLANE_STRIDE(&negotiated_video_info, i) == GST_VIDEO_INFO_PLANE_STRIDE(intermediate_video_info, i))
+		                                  && (GST_VIDEO_INFO_PLANE_OFFSET(&negotiated_video_info, i) == GST_VIDEO_INFO_PLANE_OFFSET(intermediate_video_info, i));
+	}
+	GST_DEBUG_OBJECT(self, "intermediate frame layout matches that of output frames: %d", intermediate_layout_matches_output);
+
 	self->video_meta_supported = gst_query_find_allocation_meta(query, GST_VIDEO_META_API_TYPE, &video_meta_index);
 	GST_DEBUG_OBJECT(self, "video meta supported by downstream: %d", self->video_meta_supported);
 
@@ -204,7 +246,7 @@ GstImxVideoBufferPool* gst_imx_video_buffer_pool_new(
 
 	/* Now set up the output video buffer pool. */
 
-	if (self->video_meta_supported || intermediate_buffers_are_tightly_packed)
+	if (self->video_meta_supported || intermediate_buffers_are_tightly_packed || intermediate_layout_matches_output)
 	{
 		/* No need to have a separate pool; just use the internal DMA
 		 * buffer pool as the output video buffer pool. */
@@ -217,8 +259,11 @@ GstImxVideoBufferPool* gst_imx_video_buffer_pool_new(
 		output_allocator = dma_buffer_allocator;
 
 		self->both_pools_same = TRUE;
+		self->trim_output_buffers = !self->video_meta_supported && !intermediate_buffers_are_tightly_packed;
 
 		GST_DEBUG_OBJECT(self, "internal DMA buffer pool can directly be used as the output video buffer pool");
+		if (self->trim_output_buffers)
+			GST_DEBUG_OBJECT(self, "output buffers will be trimmed to remove the padding rows at the bottom of frames");
 	}
 	else
 	{
@@ -380,43 +425,65 @@ gboolean gst_imx_video_buffer_pool_transfer_to_output_buffer(GstImxVideoBufferPo
 			}
 		}
 
+		GST_OBJECT_LOCK(imx_video_buffer_pool);
+		imx_video_buffer_pool->num_zero_copy_transfers++;
+		GST_OBJECT_UNLOCK(imx_video_buffer_pool);
+
 		GST_LOG_OBJECT(
 			imx_video_buffer_pool,
 			"both buffer pools are the same -> no need to transfer anything, intermediate and output buffer are the same, just unref intermediate buffer"
 		);
 
 		gst_buffer_unref(intermediate_buffer);
+
+		/* Cut off the padding rows that downstream does not know about.
+		 * This is done after unref'ing the intermediate buffer, since
+		 * it is the same as the output buffer, and the output buffer
+		 * must be writable for resizing it. The buffer pool restores
+		 * the full size once the buffer is returned to it. */
+		if (imx_video_buffer_pool->trim_output_buffers)
+			gst_buffer_set_size(output_buffer, GST_VIDEO_INFO_SIZE(&(imx_video_buffer_pool->output_video_info)));
+
 		return TRUE;
 	}
 
 	intermediate_video_frame_mapped = FALSE;
 	output_video_frame_mapped = FALSE;
 
+	/* The frames are mapped with GST_MAP_FLAG_IMX_MANUAL_SYNC, and synced
+	 * explicitely below. Otherwise, the per-plane maps that are done by
+	 * gst_video_frame_map() may sync the caches once for each plane.
+	 * Note that GST_MAP_FLAG_IMX_MANUAL_SYNC has the same value as
+	 * GST_VIDEO_FRAME_MAP_FLAG_NO_REF, so the frames do not ref their
+	 * buffers. This is fine, since both buffers outlive the frames. */
+
 	if (!gst_video_frame_map(
 		&intermediate_video_frame,
 		&(imx_video_buffer_pool->intermediate_video_info),
 		intermediate_buffer,
-		GST_MAP_READ
+		GST_MAP_READ | GST_MAP_FLAG_IMX_MANUAL_SYNC
 	))
 	{
 		GST_ERROR_OBJECT(imx_video_buffer_pool, "could not map intermediate video frame");
 		goto error;
 	}
 	intermediate_video_frame_mapped = TRUE;
+	gst_imx_buffer_begin_cpu_access(intermediate_buffer, GST_MAP_READ, 0, -1);
 
 	if (!gst_video_frame_map(
 		&output_video_frame,
 		&(imx_video_buffer_pool->output_video_info),
 		output_buffer,
-		GST_MAP_WRITE
+		GST_MAP_WRITE | GST_MAP_FLAG_IMX_MANUAL_SYNC
 	))
 	{
 		GST_ERROR_OBJECT(imx_video_buffer_pool, "could not map output video frame");
 		goto error;
 	}
 	output_video_frame_mapped = TRUE;
+	gst_imx_buffer_begin_cpu_access(output_buffer, GST_MAP_WRITE, 0, -1);
 
-	if (!gst_video_frame_copy(&output_video_frame, &intermediate_video_frame))
+	if (!gst_imx_video_worker_pool_copy_frame(NULL, &output_video_frame, &intermediate_video_frame))
 	{
 		GST_ERROR_OBJECT(imx_video_buffer_pool, "could not copy pixels from intermediate buffer into output buffer");
 		goto error;
@@ -427,11 +494,21 @@ gboolean gst_imx_video_buffer_pool_transfer_to_output_buffer(GstImxVideoBufferPo
 		"copied pixels from intermediate buffer into output buffer"
 	);
 
+	GST_OBJECT_LOCK(imx_video_buffer_pool);
+	imx_video_buffer_pool->num_copied_transfers++;
+	GST_OBJECT_UNLOCK(imx_video_buffer_pool);
+
 finish:
 	if (output_video_frame_mapped)
+	{
+		gst_imx_buffer_end_cpu_access(output_buffer, GST_MAP_WRITE, 0, -1);
 		gst_video_frame_unmap(&output_video_frame);
+	}
 	if (intermediate_video_frame_mapped)
+	{
+		gst_imx_buffer_end_cpu_access(intermediate_buffer, GST_MAP_READ, 0, -1);
 		gst_video_frame_unmap(&intermediate_video_frame);
+	}
 
 	gst_buffer_unref(intermediate_buffer);
 
@@ -457,6 +534,19 @@ gboolean gst_imx_video_buffer_pool_video_meta_supported(GstImxVideoBufferPool *i
 }
 
 
+void gst_imx_video_buffer_pool_get_transfer_statistics(GstImxVideoBufferPool *imx_video_buffer_pool, guint64 *num_zero_copy_transfers, guint64 *num_copied_transfers)
+{
+	g_assert(imx_video_buffer_pool != NULL);
+
+	GST_OBJECT_LOCK(imx_video_buffer_pool);
+	if (num_zero_copy_transfers != NULL)
+		*num_zero_copy_transfers = imx_video_buffer_pool->num_zero_copy_transfers;
+	if (num_copied_transfers != NULL)
+		*num_copied_transfers = imx_video_buffer_pool->num_copied_transfers;
+	GST_OBJECT_UNLOCK(imx_video_buffer_pool);
+}
+
+
 GstVideoInfo const * gst_imx_video_buffer_pool_get_intermediate_video_info(GstImxVideoBufferPool *imx_video_buffer_pool)
 {
 	g_assert(imx_video_buffer_pool != NULL);
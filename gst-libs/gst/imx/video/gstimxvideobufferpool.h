@@ -66,6 +66,13 @@ G_BEGIN_DECLS
  * that allocates DMA buffers). That's because in such a case, frame copies are unnecessary,
  * so a separate pool for output buffers is not needed.
  *
+ * The same is true if the stride and plane offset values are tightly packed, and the
+ * only difference is that the intermediate frames have extra padding rows at the bottom
+ * (because the blitter requires the total row count to be aligned). Then, the DMA buffers
+ * are allocated with the size of the intermediate frames, the blitter writes directly
+ * into them, and gst_imx_video_buffer_pool_transfer_to_output_buffer() trims the buffers
+ * to the size of tightly packed frames.
+ *
  * The GstImxVideoBufferPool is created in the decide_allocation vmethods of the elements
  * (or in the allocation query handler in case the element is not based on a subclass that
  * has such a vmethod). The output video buffer pool is added to that query, while the
@@ -117,6 +124,22 @@ gboolean gst_imx_video_buffer_pool_transfer_to_output_buffer(GstImxVideoBufferPo
 gboolean gst_imx_video_buffer_pool_are_both_pools_same(GstImxVideoBufferPool *imx_video_buffer_pool);
 gboolean gst_imx_video_buffer_pool_video_meta_supported(GstImxVideoBufferPool *imx_video_buffer_pool);
 
+/**
+ * gst_imx_video_buffer_pool_get_transfer_statistics:
+ * @imx_video_buffer_pool: Video buffer pool to get the statistics from.
+ * @num_zero_copy_transfers: Pointer to a guint64 that gets the number of
+ *     gst_imx_video_buffer_pool_transfer_to_output_buffer() calls that did
+ *     not have to copy the frame. Can be NULL.
+ * @num_copied_transfers: Pointer to a guint64 that gets the number of
+ *     gst_imx_video_buffer_pool_transfer_to_output_buffer() calls that had
+ *     to copy the frame with the CPU. Can be NULL.
+ *
+ * Retrieves statistics about how often frames had to be copied. This is
+ * useful for finding out whether or not the pipeline needs CPU frame copies
+ * because downstream cannot handle video metas. This function is thread safe.
+ */
+void gst_imx_video_buffer_pool_get_transfer_statistics(GstImxVideoBufferPool *imx_video_buffer_pool, guint64 *num_zero_copy_transfers, guint64 *num_copied_transfers);
+
 GstVideoInfo const * gst_imx_video_buffer_pool_get_intermediate_video_info(GstImxVideoBufferPool *imx_video_buffer_pool);
 GstVideoInfo const * gst_imx_video_buffer_pool_get_output_video_info(GstImxVideoBufferPool *imx_video_buffer_pool);
 
@@ -20,6 +20,7 @@
 #include <gst/video/video.h>
 #include "gst/imx/common/gstimxdmabufferallocator.h"
 #include "gst/imx/video/gstimxvideoutils.h"
+#include "gst/imx/video/gstimxvideoworkerpool.h"
 #include "gstimxvideouploader.h"
 
 
@@ -229,19 +230,25 @@ GstFlowReturn gst_imx_video_uploader_perform(GstImxVideoUploader *uploader, GstB
 		}
 		input_buffer_frame_mapped = TRUE;
 
+		/* Sync explicitely instead of once per plane map. Since
+		 * GST_MAP_FLAG_IMX_MANUAL_SYNC has the same value as
+		 * GST_VIDEO_FRAME_MAP_FLAG_NO_REF, the frame does not ref
+		 * the output buffer, so the frame must be unmapped before
+		 * the output buffer is unref'd in the error path. */
 		if (!gst_video_frame_map(
 			&uploaded_buffer_frame,
 			&(uploader->aligned_input_video_info),
 			*output_buffer,
-			GST_MAP_WRITE
+			GST_MAP_WRITE | GST_MAP_FLAG_IMX_MANUAL_SYNC
 		))
 		{
 			GST_ERROR_OBJECT(uploader, "could not map input video frame");
 			goto error;
 		}
 		uploaded_buffer_frame_mapped = TRUE;
+		gst_imx_buffer_begin_cpu_access(*output_buffer, GST_MAP_WRITE, 0, -1);
 
-		if (!gst_video_frame_copy(&uploaded_buffer_frame, &input_buffer_frame))
+		if (!gst_imx_video_worker_pool_copy_frame(NULL, &uploaded_buffer_frame, &input_buffer_frame))
 		{
 			GST_ERROR_OBJECT(uploader, "could not copy pixels from input buffer into output buffer");
 			goto error;
@@ -252,6 +259,7 @@ GstFlowReturn gst_imx_video_uploader_perform(GstImxVideoUploader *uploader, GstB
 			"copied pixels from input buffer into output buffer"
 		);
 
+		gst_imx_buffer_end_cpu_access(*output_buffer, GST_MAP_WRITE, 0, -1);
 		gst_video_frame_unmap(&uploaded_buffer_frame);
 		uploaded_buffer_frame_mapped = FALSE;
 
@@ -316,8 +324,6 @@ GstFlowReturn gst_imx_video_uploader_perform(GstImxVideoUploader *uploader, GstB
 finish:
 	if (input_buffer_frame_mapped)
 		gst_video_frame_unmap(&input_buffer_frame);
-	if (uploaded_buffer_frame_mapped)
-		gst_video_frame_unmap(&uploaded_buffer_frame);
 
 	return flow_ret;
 
@@ -325,6 +331,13 @@ error:
 	if (flow_ret == GST_FLOW_OK)
 		flow_ret = GST_FLOW_ERROR;
 
+	if (uploaded_buffer_frame_mapped)
+	{
+		gst_imx_buffer_end_cpu_access(*output_buffer, GST_MAP_WRITE, 0, -1);
+		gst_video_frame_unmap(&uploaded_buffer_frame);
+		uploaded_buffer_frame_mapped = FALSE;
+	}
+
 	gst_buffer_replace(output_buffer, NULL);
 
 	goto finish;
@@ -45,13 +45,20 @@ G_BEGIN_DECLS
  * are already aligned according to the alignment requirements specified
  * by the @gst_imx_video_uploader_new arguments. If a frame is not aligned,
  * the internal uploader is not used. Instead, a custom frame copy is
- * made using @GstVideoFrame and @gst_video_frame_copy to create a copy
- * of the frame that is properly aligned. GstBuffer instances created for
- * this custom frame copy use the same allocator that the internal uploader
- * uses (that is, the allocator pased to @gst_imx_video_uploader_new).
+ * made using @GstVideoFrame and @gst_imx_video_worker_pool_copy_frame to
+ * create a copy of the frame that is properly aligned. GstBuffer instances
+ * created for this custom frame copy use the same allocator that the internal
+ * uploader uses (that is, the allocator pased to @gst_imx_video_uploader_new).
  * For these custom copies, there is also an intenal buffer pool to be able
  * to reuse these buffers.
  *
+ * These custom copies are always done by the CPU, even if the input frame
+ * is in physically contiguous memory. The alignment requirements are those
+ * of the 2D hardware that consumes the uploaded frames, and a frame that
+ * does not fulfill them cannot be read by that hardware, so it cannot do
+ * the stride and plane offset conversion either. To reduce the load, the
+ * copy is split into row bands that are processed by multiple threads.
+ *
  * The API is mostly designed as a drop-in replacement for @GstImxDmaBufferUploader.
  * If an element has been using that one, this video uploader can easily be
  * used instead. The only two differences are the extra alignment information
@@ -0,0 +1,464 @@
+/* gstreamer-imx: GStreamer plugins for the i.MX SoCs
+ * Copyright (C) 2026  agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <string.h>
+#include <gst/gst.h>
+#include <gst/video/video.h>
+#include "gstimxvideoworkerpool.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define GST_IMX_VIDEO_USE_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define GST_IMX_VIDEO_USE_NEON
+#endif
+
+
+/**
+ * The worker pool is not a GObject, and its functions may be called
+ * from anywhere, so the debug category is set up the same way as in
+ * GstImxDmaBufferUploader.
+ */
+
+#ifndef GST_DISABLE_GST_DEBUG
+
+#define GST_CAT_DEFAULT gst_imx_video_worker_pool_ensure_debug_category()
+
+static GstDebugCategory* gst_imx_video_worker_pool_ensure_debug_category()
+{
+	static gsize cat_gonce = 0;
+
+	if (g_once_init_enter(&cat_gonce))
+	{
+		GstDebugCategory *cat = NULL;
+		GST_DEBUG_CATEGORY_INIT(cat, "imxvideoworkerpool", 0, "NXP i.MX video worker thread pool");
+		g_once_init_leave(&cat_gonce, (gsize)cat);
+	}
+
+	return (GstDebugCategory *)cat_gonce;
+}
+
+#endif /* GST_DISABLE_GST_DEBUG */
+
+
+/* Bands with fewer rows than this are not worth handing to another
+ * thread, since the synchronization then costs more than the copy. */
+#define MIN_NUM_ROWS_PER_BAND 16
+
+/* Rows shorter than this are copied with plain memcpy(), since
+ * the setup of the SIMD copy loop is not worth it for them. */
+#define MIN_SIMD_ROW_COPY_LENGTH 256
+
+#define NUM_WORKER_THREADS_ENV_VAR "GST_IMX_VIDEO_WORKER_THREADS"
+
+
+struct _GstImxVideoWorkerPool
+{
+	/* NULL as long as num_threads never was greater than 1. Once
+	 * created, the thread pool is kept until the worker pool is freed,
+	 * since other threads may be using it. Both fields are accessed
+	 * atomically; the mutex serializes changes to the thread count. */
+	GThreadPool *thread_pool;
+	guint num_threads;
+	GMutex mutex;
+};
+
+
+/* State of one gst_imx_video_worker_pool_run() call. It lives on
+ * the stack of the calling thread, so multiple threads can use
+ * the same pool at the same time. */
+typedef struct
+{
+	GMutex mutex;
+	GCond cond;
+	guint num_pending_bands;
+
+	GstImxVideoWorkerPoolBandFunc band_func;
+	guint num_bands;
+	gpointer user_data;
+}
+GstImxVideoWorkerPoolRun;
+
+
+typedef struct
+{
+	GstImxVideoWorkerPoolRun *run;
+	guint band_index;
+}
+GstImxVideoWorkerPoolTask;
+
+
+typedef struct
+{
+	GstVideoFrame *dest;
+	GstVideoFrame const *src;
+}
+GstImxVideoWorkerPoolCopyFrameParams;
+
+
+static void gst_imx_video_worker_pool_finish_task(GstImxVideoWorkerPoolTask *task)
+{
+	GstImxVideoWorkerPoolRun *run = task->run;
+
+	run->band_func(task->band_index, run->num_bands, run->user_data);
+
+	g_mutex_lock(&(run->mutex));
+	run->num_pending_bands--;
+	if (run->num_pending_bands == 0)
+		g_cond_signal(&(run->cond));
+	g_mutex_unlock(&(run->mutex));
+}
+
+
+static void gst_imx_video_worker_pool_thread_func(gpointer data, G_GNUC_UNUSED gpointer user_data)
+{
+	gst_imx_video_worker_pool_finish_task((GstImxVideoWorkerPoolTask *)data);
+}
+
+
+static gpointer gst_imx_video_worker_pool_create_default(G_GNUC_UNUSED gpointer data)
+{
+	guint num_threads = 0;
+	gchar const *env_value = g_getenv(NUM_WORKER_THREADS_ENV_VAR);
+
+	if (env_value != NULL)
+	{
+		num_threads = (guint)g_ascii_strtoull(env_value, NULL, 10);
+		GST_DEBUG("%s environment variable set to \"%s\"", NUM_WORKER_THREADS_ENV_VAR, env_value);
+	}
+
+	return gst_imx_video_worker_pool_new(num_threads);
+}
+
+
+/* Copies one row (or a contiguous band of rows). The destination is
+ * typically DMA memory that is mapped as write-combined or uncached,
+ * so the copy is done in 64 byte blocks that are written in order.
+ * This keeps the CPU's write-combine buffers full. With SSE2, the stores
+ * are additionally non-temporal, since the copied pixels are read by
+ * hardware, not by the CPU, and should not evict other data from the
+ * cache. The tail that does not fill a whole block is copied with
+ * memcpy(). */
+static inline void gst_imx_video_worker_pool_copy_row(guint8 *dest, guint8 const *src, gsize length)
+{
+#if defined(GST_IMX_VIDEO_USE_SSE2)
+	if (length >= MIN_SIMD_ROW_COPY_LENGTH)
+	{
+		/* _mm_stream_si128() requires 16-byte aligned destinations. */
+		gsize head_length = (16 - ((guintptr)dest & 15)) & 15;
+
+		memcpy(dest, src, head_length);
+		dest += head_length;
+		src += head_length;
+		length -= head_length;
+
+		for (; length >= 64; length -= 64, dest += 64, src += 64)
+		{
+			__m128i v0 = _mm_loadu_si128((__m128i const *)(src +  0));
+			__m128i v1 = _mm_loadu_si128((__m128i const *)(src + 16));
+			__m128i v2 = _mm_loadu_si128((__m128i const *)(src + 32));
+			__m128i v3 = _mm_loadu_si128((__m128i const *)(src + 48));
+			_mm_stream_si128((__m128i *)(dest +  0), v0);
+			_mm_stream_si128((__m128i *)(dest + 16), v1);
+			_mm_stream_si128((__m128i *)(dest + 32), v2);
+			_mm_stream_si128((__m128i *)(dest + 48), v3);
+		}
+	}
+#elif defined(GST_IMX_VIDEO_USE_NEON)
+	if (length >= MIN_SIMD_ROW_COPY_LENGTH)
+	{
+		for (; length >= 64; length -= 64, dest += 64, src += 64)
+		{
+			uint8x16_t v0 = vld1q_u8(src +  0);
+			uint8x16_t v1 = vld1q_u8(src + 16);
+			uint8x16_t v2 = vld1q_u8(src + 32);
+			uint8x16_t v3 = vld1q_u8(src + 48);
+			vst1q_u8(dest +  0, v0);
+			vst1q_u8(dest + 16, v1);
+			vst1q_u8(dest + 32, v2);
+			vst1q_u8(dest + 48, v3);
+		}
+	}
+#endif
+
+	memcpy(dest, src, length);
+}
+
+
+static void gst_imx_video_worker_pool_copy_frame_band(guint band_index, guint num_bands, gpointer user_data)
+{
+	GstImxVideoWorkerPoolCopyFrameParams *params = (GstImxVideoWorkerPoolCopyFrameParams *)user_data;
+	GstVideoFrame *dest = params->dest;
+	GstVideoFrame const *src = params->src;
+	guint plane_index;
+
+	for (plane_index = 0; plane_index < GST_VIDEO_FRAME_N_PLANES(dest); ++plane_index)
+	{
+		guint8 const *src_pixels = GST_VIDEO_FRAME_PLANE_DATA(src, plane_index);
+		guint8 *dest_pixels = GST_VIDEO_FRAME_PLANE_DATA(dest, plane_index);
+		gint src_stride = GST_VIDEO_FRAME_PLANE_STRIDE(src, plane_index);
+		gint dest_stride = GST_VIDEO_FRAME_PLANE_STRIDE(dest, plane_index);
+		guint row_length, num_rows, first_row, end_row, row;
+
+		/* Compute the number of bytes per row the same way
+		 * gst_video_frame_copy_plane() does. For formats where
+		 * the pixel stride is 0 (packed formats like v210),
+		 * the smaller one of the strides is used instead. */
+		row_length = GST_VIDEO_FRAME_COMP_WIDTH(dest, plane_index) * GST_VIDEO_FRAME_COMP_PSTRIDE(dest, plane_index);
+		if (row_length == 0)
+			row_length = MIN(src_stride, dest_stride);
+		num_rows = GST_VIDEO_FRAME_COMP_HEIGHT(dest, plane_index);
+
+		first_row = (guint)((guint64)num_rows * band_index / num_bands);
+		end_row = (guint)((guint64)num_rows * (band_index + 1) / num_bands);
+
+		src_pixels += (gsize)first_row * src_stride;
+		dest_pixels += (gsize)first_row * dest_stride;
+
+		/* If there is no padding between rows, the entire
+		 * band can be copied in one go. */
+		if ((src_stride == dest_stride) && ((guint)dest_stride == row_length))
+		{
+			gst_imx_video_worker_pool_copy_row(dest_pixels, src_pixels, (gsize)(end_row - first_row) * row_length);
+			continue;
+		}
+
+		for (row = first_row; row < end_row; ++row)
+		{
+			gst_imx_video_worker_pool_copy_row(dest_pixels, src_pixels, row_length);
+			src_pixels += src_stride;
+			dest_pixels += dest_stride;
+		}
+	}
+
+#if defined(GST_IMX_VIDEO_USE_SSE2)
+	/* Non-temporal stores are weakly ordered. Make sure they are
+	 * visible before the band is reported as finished. */
+	_mm_sfence();
+#endif
+}
+
+
+
+
+GstImxVideoWorkerPool* gst_imx_video_worker_pool_new(guint num_threads)
+{
+	GstImxVideoWorkerPool *worker_pool;
+
+	worker_pool = g_new0(GstImxVideoWorkerPool, 1);
+	g_mutex_init(&(worker_pool->mutex));
+	worker_pool->num_threads = 1;
+
+	if (!gst_imx_video_worker_pool_set_num_threads(worker_pool, num_threads))
+	{
+		g_mutex_clear(&(worker_pool->mutex));
+		g_free(worker_pool);
+		return NULL;
+	}
+
+	GST_DEBUG("created worker pool %p with %u thread(s)", (gpointer)worker_pool, worker_pool->num_threads);
+
+	return worker_pool;
+}
+
+
+void gst_imx_video_worker_pool_free(GstImxVideoWorkerPool *worker_pool)
+{
+	g_assert(worker_pool != NULL);
+
+	if (worker_pool->thread_pool != NULL)
+		g_thread_pool_free(worker_pool->thread_pool, FALSE, TRUE);
+
+	g_mutex_clear(&(worker_pool->mutex));
+
+	GST_DEBUG("freed worker pool %p", (gpointer)worker_pool);
+
+	g_free(worker_pool);
+}
+
+
+GstImxVideoWorkerPool* gst_imx_video_worker_pool_get_default(void)
+{
+	static GOnce default_pool_once = G_ONCE_INIT;
+	g_once(&default_pool_once, gst_imx_video_worker_pool_create_default, NULL);
+	return (GstImxVideoWorkerPool *)(default_pool_once.retval);
+}
+
+
+gboolean gst_imx_video_worker_pool_set_num_threads(GstImxVideoWorkerPool *worker_pool, guint num_threads)
+{
+	gboolean ret = TRUE;
+	GError *error = NULL;
+
+	g_assert(worker_pool != NULL);
+
+	if (num_threads == 0)
+		num_threads = g_get_num_processors();
+
+	g_mutex_lock(&(worker_pool->mutex));
+
+	/* The calling thread processes one band itself,
+	 * so one thread less is needed in the pool. */
+	if (num_threads > 1)
+	{
+		if (worker_pool->thread_pool == NULL)
+		{
+			GThreadPool *thread_pool = g_thread_pool_new(
+				gst_imx_video_worker_pool_thread_func,
+				NULL,
+				num_threads - 1,
+				TRUE,
+				&error
+			);
+
+			if (thread_pool == NULL)
+				goto error;
+
+			g_atomic_pointer_set(&(worker_pool->thread_pool), thread_pool);
+		}
+		else if (!g_thread_pool_set_max_threads(worker_pool->thread_pool, num_threads - 1, &error))
+			goto error;
+	}
+
+	/* When reducing the number of threads to 1, the existing thread
+	 * pool is not touched. It is simply not used anymore, since
+	 * gst_imx_video_worker_pool_run() then processes all bands
+	 * in the calling thread. */
+
+	GST_DEBUG("worker pool %p now uses %u thread(s)", (gpointer)worker_pool, num_threads);
+	g_atomic_int_set(&(worker_pool->num_threads), num_threads);
+
+finish:
+	g_mutex_unlock(&(worker_pool->mutex));
+	return ret;
+
+error:
+	GST_ERROR("could not set up thread pool with %u thread(s): %s", num_threads - 1, error->message);
+	g_error_free(error);
+	ret = FALSE;
+	goto finish;
+}
+
+
+guint gst_imx_video_worker_pool_get_num_threads(GstImxVideoWorkerPool *worker_pool)
+{
+	g_assert(worker_pool != NULL);
+	return g_atomic_int_get(&(worker_pool->num_threads));
+}
+
+
+void gst_imx_video_worker_pool_run(GstImxVideoWorkerPool *worker_pool, guint num_bands, GstImxVideoWorkerPoolBandFunc band_func, gpointer user_data)
+{
+	GstImxVideoWorkerPoolRun run;
+	GstImxVideoWorkerPoolTask *tasks;
+	GThreadPool *thread_pool;
+	guint band_index;
+
+	g_assert(worker_pool != NULL);
+	g_assert(band_func != NULL);
+
+	if (num_bands == 0)
+		return;
+
+	thread_pool = g_atomic_pointer_get(&(worker_pool->thread_pool));
+
+	if ((num_bands == 1) || (thread_pool == NULL) || (g_atomic_int_get(&(worker_pool->num_threads)) <= 1))
+	{
+		for (band_index = 0; band_index < num_bands; ++band_index)
+			band_func(band_index, num_bands, user_data);
+		return;
+	}
+
+	g_mutex_init(&(run.mutex));
+	g_cond_init(&(run.cond));
+	run.num_pending_bands = num_bands;
+	run.band_func = band_func;
+	run.num_bands = num_bands;
+	run.user_data = user_data;
+
+	tasks = g_newa(GstImxVideoWorkerPoolTask, num_bands);
+
+	for (band_index = 0; band_index < num_bands; ++band_index)
+	{
+		tasks[band_index].run = &run;
+		tasks[band_index].band_index = band_index;
+	}
+
+	/* Band 0 is processed by the calling thread, so it does
+	 * not just sit idle while waiting for the workers. */
+	for (band_index = 1; band_index < num_bands; ++band_index)
+	{
+		GError *error = NULL;
+
+		if (!g_thread_pool_push(thread_pool, &(tasks[band_index]), &error))
+		{
+			GST_WARNING("could not push band %u to thread pool: %s; processing it in the calling thread", band_index, error->message);
+			g_error_free(error);
+			gst_imx_video_worker_pool_finish_task(&(tasks[band_index]));
+		}
+	}
+
+	gst_imx_video_worker_pool_finish_task(&(tasks[0]));
+
+	g_mutex_lock(&(run.mutex));
+	while (run.num_pending_bands > 0)
+		g_cond_wait(&(run.cond), &(run.mutex));
+	g_mutex_unlock(&(run.mutex));
+
+	g_cond_clear(&(run.cond));
+	g_mutex_clear(&(run.mutex));
+}
+
+
+gboolean gst_imx_video_worker_pool_copy_frame(GstImxVideoWorkerPool *worker_pool, GstVideoFrame *dest, GstVideoFrame const *src)
+{
+	GstImxVideoWorkerPoolCopyFrameParams params;
+	GstVideoFormatInfo const *format_info;
+	guint num_bands;
+
+	g_assert(dest != NULL);
+	g_assert(src != NULL);
+
+	if (worker_pool == NULL)
+		worker_pool = gst_imx_video_worker_pool_get_default();
+
+	if ((GST_VIDEO_FRAME_FORMAT(dest) != GST_VIDEO_FRAME_FORMAT(src))
+	 || (GST_VIDEO_FRAME_WIDTH(dest) != GST_VIDEO_FRAME_WIDTH(src))
+	 || (GST_VIDEO_FRAME_HEIGHT(dest) != GST_VIDEO_FRAME_HEIGHT(src)))
+		return FALSE;
+
+	format_info = dest->info.finfo;
+
+	num_bands = (worker_pool != NULL) ? gst_imx_video_worker_pool_get_num_threads(worker_pool) : 1;
+	num_bands = MIN(num_bands, (guint)GST_VIDEO_FRAME_HEIGHT(dest) / MIN_NUM_ROWS_PER_BAND);
+
+	/* Tiled formats cannot be split into row bands, and palettized
+	 * formats need their palette copied, so these are left to
+	 * gst_video_frame_copy(). The same goes for frames that are
+	 * too small to be worth splitting. */
+	if ((num_bands <= 1) || GST_VIDEO_FORMAT_INFO_IS_TILED(format_info) || GST_VIDEO_FORMAT_INFO_HAS_PALETTE(format_info))
+		return gst_video_frame_copy(dest, src);
+
+	params.dest = dest;
+	params.src = src;
+
+	gst_imx_video_worker_pool_run(worker_pool, num_bands, gst_imx_video_worker_pool_copy_frame_band, &params);
+
+	return TRUE;
+}
@@ -0,0 +1,165 @@
+/* gstreamer-imx: GStreamer plugins for the i.MX SoCs
+ * Copyright (C) 2026  agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef GST_IMX_VIDEO_WORKER_POOL_H
+#define GST_IMX_VIDEO_WORKER_POOL_H
+
+#include <gst/gst.h>
+#include <gst/video/video.h>
+
+
+G_BEGIN_DECLS
+
+
+/**
+ * GstImxVideoWorkerPool:
+ *
+ * Pool of worker threads for splitting CPU based frame processing into
+ * row bands that are processed in parallel.
+ *
+ * This is intended for the cases where elements have to fall back to the
+ * CPU, like frame copies that are necessary because of stride and plane
+ * alignment requirements. On multi-core SoCs, splitting such work into
+ * bands considerably reduces the latency of these fallbacks.
+ *
+ * The calling thread processes one of the bands itself, so a pool with N
+ * threads has N-1 worker threads. A pool with 1 thread does not create
+ * any worker threads and processes everything in the calling thread.
+ *
+ * A pool can be used by multiple threads at the same time.
+ *
+ * Most code should use the default pool that is returned by
+ * @gst_imx_video_worker_pool_get_default.
+ */
+typedef struct _GstImxVideoWorkerPool GstImxVideoWorkerPool;
+
+/**
+ * GstImxVideoWorkerPoolBandFunc:
+ * @band_index: Index of the band to process, in the 0 .. (@num_bands - 1) range.
+ * @num_bands: Total number of bands.
+ * @user_data: User defined pointer that was passed to @gst_imx_video_worker_pool_run.
+ *
+ * Function that processes one band. It is called once for each band,
+ * from different threads, so it must not modify shared state without
+ * synchronization.
+ */
+typedef void (*GstImxVideoWorkerPoolBandFunc)(guint band_index, guint num_bands, gpointer user_data);
+
+/**
+ * gst_imx_video_worker_pool_new:
+ * @num_threads: Number of threads to use, including the calling thread.
+ *     If this is 0, the number of CPU cores is used.
+ *
+ * Creates a new worker pool. Destroy it with @gst_imx_video_worker_pool_free.
+ *
+ * Returns: Pointer to the new worker pool, or NULL in case of an error.
+ */
+GstImxVideoWorkerPool* gst_imx_video_worker_pool_new(guint num_threads);
+
+/**
+ * gst_imx_video_worker_pool_free:
+ * @worker_pool: Worker pool to destroy.
+ *
+ * Destroys the given worker pool. This waits for all worker threads to
+ * finish. This must not be called for the pool that is returned by
+ * @gst_imx_video_worker_pool_get_default.
+ */
+void gst_imx_video_worker_pool_free(GstImxVideoWorkerPool *worker_pool);
+
+/**
+ * gst_imx_video_worker_pool_get_default:
+ *
+ * Returns the process wide default worker pool, creating it if necessary.
+ *
+ * Initially, the number of threads in the default pool is the number of
+ * CPU cores, unless the GST_IMX_VIDEO_WORKER_THREADS environment variable
+ * is set to a nonzero number, in which case that number is used. Setting
+ * that variable to 1 disables multi-threaded processing. Applications can
+ * change the number of threads later with
+ * @gst_imx_video_worker_pool_set_num_threads.
+ *
+ * Returns: (transfer none) The default worker pool. It exists until
+ *     the process ends, and must not be freed.
+ */
+GstImxVideoWorkerPool* gst_imx_video_worker_pool_get_default(void);
+
+/**
+ * gst_imx_video_worker_pool_set_num_threads:
+ * @worker_pool: Worker pool to set the number of threads of.
+ * @num_threads: Number of threads to use, including the calling thread.
+ *     If this is 0, the number of CPU cores is used.
+ *
+ * Changes the number of threads of the given worker pool. This can be
+ * called at any time, also while other threads are using the pool.
+ * Operations that are already running continue to use the previous
+ * number of bands. Setting the number to 1 disables multi-threaded
+ * processing with this pool.
+ *
+ * Returns: TRUE if the number of threads was changed, FALSE if the
+ *     worker threads could not be created.
+ */
+gboolean gst_imx_video_worker_pool_set_num_threads(GstImxVideoWorkerPool *worker_pool, guint num_threads);
+
+/**
+ * gst_imx_video_worker_pool_get_num_threads:
+ * @worker_pool: Worker pool to get the number of threads of.
+ *
+ * Returns: Number of threads that process bands, including the calling thread.
+ */
+guint gst_imx_video_worker_pool_get_num_threads(GstImxVideoWorkerPool *worker_pool);
+
+/**
+ * gst_imx_video_worker_pool_run:
+ * @worker_pool: Worker pool to use.
+ * @num_bands: Number of bands to split the work into. This is
+ *     typically the value of @gst_imx_video_worker_pool_get_num_threads.
+ * @band_func: Function to call for each band.
+ * @user_data: User defined pointer to pass to @band_func.
+ *
+ * Calls @band_func once for each band, and distributes these calls across
+ * the worker threads and the calling thread. Only returns once all bands
+ * have been processed.
+ */
+void gst_imx_video_worker_pool_run(GstImxVideoWorkerPool *worker_pool, guint num_bands, GstImxVideoWorkerPoolBandFunc band_func, gpointer user_data);
+
+/**
+ * gst_imx_video_worker_pool_copy_frame:
+ * @worker_pool: Worker pool to use. If this is NULL, the default pool is used.
+ * @dest: Mapped video frame to copy pixels into.
+ * @src: Mapped video frame to copy pixels from.
+ *
+ * Multi-threaded variant of @gst_video_frame_copy. The rows of each plane
+ * are split into bands, which are then copied in parallel. Small frames
+ * are split into fewer bands (or not at all) to keep the synchronization
+ * overhead from outweighing the gains. Tiled formats are copied with
+ * @gst_video_frame_copy in the calling thread.
+ *
+ * Rows are copied with SSE2 or NEON if available. With SSE2, non-temporal
+ * stores are used, since the destination typically is write-combined DMA
+ * memory that is not read by the CPU afterwards.
+ *
+ * Returns: TRUE if the frame was copied, FALSE if @dest and @src do not
+ *     have the same format and dimensions (just like @gst_video_frame_copy).
+ */
+gboolean gst_imx_video_worker_pool_copy_frame(GstImxVideoWorkerPool *worker_pool, GstVideoFrame *dest, GstVideoFrame const *src);
+
+
+G_END_DECLS
+
+
+#endif /* GST_IMX_VIDEO_WORKER_POOL_H */
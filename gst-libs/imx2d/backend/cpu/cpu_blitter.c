@@ -0,0 +1,1911 @@
+/* gstreamer-imx: GStreamer plugins for the i.MX SoCs
+ * Copyright (C) 2026  agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "imx2d/imx2d_priv.h"
+#include "cpu_blitter.h"
+
+/* The SIMD code paths treat 4 bytes of an RGBA pixel as one 32-bit
+ * lane, with the first byte in the least significant bits, so they
+ * are only used on little endian machines. (SSE2 is always little
+ * endian; with NEON, big endian setups exist, but are very rare.) */
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define IMX2D_CPU_USE_SSE2
+#elif (defined(__ARM_NEON) || defined(__ARM_NEON__)) && !defined(__ARM_BIG_ENDIAN)
+#include <arm_neon.h>
+#define IMX2D_CPU_USE_NEON
+#endif
+
+
+static Imx2dPixelFormat const supported_source_pixel_formats[] =
+{
+	IMX_2D_PIXEL_FORMAT_RGB565,
+	IMX_2D_PIXEL_FORMAT_BGR565,
+	IMX_2D_PIXEL_FORMAT_RGB888,
+	IMX_2D_PIXEL_FORMAT_BGR888,
+	IMX_2D_PIXEL_FORMAT_RGBX8888,
+	IMX_2D_PIXEL_FORMAT_RGBA8888,
+	IMX_2D_PIXEL_FORMAT_BGRX8888,
+	IMX_2D_PIXEL_FORMAT_BGRA8888,
+	IMX_2D_PIXEL_FORMAT_XRGB8888,
+	IMX_2D_PIXEL_FORMAT_ARGB8888,
+	IMX_2D_PIXEL_FORMAT_XBGR8888,
+	IMX_2D_PIXEL_FORMAT_ABGR8888,
+	IMX_2D_PIXEL_FORMAT_GRAY8,
+
+	IMX_2D_PIXEL_FORMAT_PACKED_YUV422_UYVY,
+	IMX_2D_PIXEL_FORMAT_PACKED_YUV422_YUYV,
+	IMX_2D_PIXEL_FORMAT_PACKED_YUV422_YVYU,
+	IMX_2D_PIXEL_FORMAT_PACKED_YUV422_VYUY,
+	IMX_2D_PIXEL_FORMAT_PACKED_YUV444,
+
+	IMX_2D_PIXEL_FORMAT_SEMI_PLANAR_NV12,
+	IMX_2D_PIXEL_FORMAT_SEMI_PLANAR_NV21,
+	IMX_2D_PIXEL_FORMAT_SEMI_PLANAR_NV16,
+	IMX_2D_PIXEL_FORMAT_SEMI_PLANAR_NV61,
+
+	IMX_2D_PIXEL_FORMAT_FULLY_PLANAR_YV12,
+	IMX_2D_PIXEL_FORMAT_FULLY_PLANAR_I420,
+	IMX_2D_PIXEL_FORMAT_FULLY_PLANAR_Y42B,
+	IMX_2D_PIXEL_FORMAT_FULLY_PLANAR_Y444
+};
+
+
+
+
+/* Surface mapping */
+
+
+typedef struct _Imx2dCpuSurfaceMapping Imx2dCpuSurfaceMapping;
+
+
+/* Pointers to the first pixel of each plane of a surface,
+ * plus the information necessary for unmapping it again.
+ * Planes that share a DMA buffer only map it once. */
+struct _Imx2dCpuSurfaceMapping
+{
+	Imx2dSurfaceDesc const *desc;
+	Imx2dPixelFormatInfo const *fmt_info;
+	uint8_t *planes[3];
+
+	ImxDmaBuffer *mapped_dma_buffers[3];
+	int num_mapped_dma_buffers;
+};
+
+
+static void unmap_surface(Imx2dCpuSurfaceMapping *mapping)
+{
+	int i;
+
+	for (i = 0; i < mapping->num_mapped_dma_buffers; ++i)
+		imx_dma_buffer_unmap(mapping->mapped_dma_buffers[i]);
+
+	mapping->num_mapped_dma_buffers = 0;
+}
+
+
+static BOOL map_surface(Imx2dCpuSurfaceMapping *mapping, Imx2dSurface *surface, unsigned int flags)
+{
+	int plane_nr, i;
+	uint8_t *mapped_bases[3];
+
+	memset(mapping, 0, sizeof(Imx2dCpuSurfaceMapping));
+
+	mapping->desc = imx_2d_surface_get_desc(surface);
+	mapping->fmt_info = imx_2d_get_pixel_format_info(mapping->desc->format);
+	assert(mapping->fmt_info != NULL);
+
+	if (mapping->fmt_info->is_tiled)
+	{
+		IMX_2D_LOG(ERROR, "CPU blitter does not support tiled format %s", imx_2d_pixel_format_to_string(mapping->desc->format));
+		return FALSE;
+	}
+
+	for (plane_nr = 0; plane_nr < mapping->fmt_info->num_planes; ++plane_nr)
+	{
+		ImxDmaBuffer *dma_buffer = imx_2d_surface_get_dma_buffer(surface, plane_nr);
+		uint8_t *mapped_base = NULL;
+
+		if (dma_buffer == NULL)
+		{
+			IMX_2D_LOG(ERROR, "surface has no DMA buffer for plane #%d", plane_nr);
+			goto error;
+		}
+
+		for (i = 0; i < mapping->num_mapped_dma_buffers; ++i)
+		{
+			if (mapping->mapped_dma_buffers[i] == dma_buffer)
+			{
+				mapped_base = mapped_bases[i];
+				break;
+			}
+		}
+
+		if (mapped_base == NULL)
+		{
+			int error = 0;
+
+			mapped_base = imx_dma_buffer_map(dma_buffer, flags, &error);
+			if (mapped_base == NULL)
+			{
+				IMX_2D_LOG(ERROR, "could not map DMA buffer of plane #%d: %s (%d)", plane_nr, strerror(error), error);
+				goto error;
+			}
+
+			mapping->mapped_dma_buffers[mapping->num_mapped_dma_buffers] = dma_buffer;
+			mapped_bases[mapping->num_mapped_dma_buffers] = mapped_base;
+			mapping->num_mapped_dma_buffers++;
+		}
+
+		mapping->planes[plane_nr] = mapped_base + imx_2d_surface_get_dma_buffer_offset(surface, plane_nr);
+	}
+
+	return TRUE;
+
+error:
+	unmap_surface(mapping);
+	return FALSE;
+}
+
+
+
+
+/* Vectorized kernels
+ *
+ * Scanlines are arrays of pixels with 4 bytes per pixel, in R-G-B-A
+ * order. All format conversions go through these scanlines.
+ * The kernels below have SSE2 and NEON versions, with scalar code
+ * handling the remaining pixels as well as other architectures. */
+
+
+/* Fills count 32-bit pixels at dest with value. dest need not be
+ * aligned. value is stored in native byte order, like memcpy would. */
+static void fill_32bit_pixels(uint8_t *dest, uint32_t value, int count)
+{
+	int i = 0;
+
+#if defined(IMX2D_CPU_USE_SSE2)
+	__m128i v = _mm_set1_epi32((int)value);
+	for (; i + 4 <= count; i += 4)
+		_mm_storeu_si128((__m128i *)(dest + i * 4), v);
+#elif defined(IMX2D_CPU_USE_NEON)
+	uint8x16_t v = vreinterpretq_u8_u32(vdupq_n_u32(value));
+	for (; i + 4 <= count; i += 4)
+		vst1q_u8(dest + i * 4, v);
+#endif
+
+	for (; i < count; ++i)
+		memcpy(dest + i * 4, &value, 4);
+}
+
+
+/* Reorders the bytes of count 32-bit pixels. Byte #k of each
+ * dest pixel is set to byte #perm[k] of the source pixel. If
+ * perm[k] is negative, byte #k is set to 255 instead. */
+static void swizzle_32bit_pixels(uint8_t *dest, uint8_t const *src, int count, int const perm[4])
+{
+	int i = 0, k;
+
+	if ((perm[0] == 0) && (perm[1] == 1) && (perm[2] == 2) && (perm[3] == 3))
+	{
+		memcpy(dest, src, count * 4);
+		return;
+	}
+
+#if defined(IMX2D_CPU_USE_SSE2)
+	{
+		__m128i byte_mask = _mm_set1_epi32(0xFF);
+		__m128i right_shifts[4], left_shifts[4];
+		__m128i constant_bytes = _mm_setzero_si128();
+
+		for (k = 0; k < 4; ++k)
+		{
+			right_shifts[k] = _mm_cvtsi32_si128((perm[k] >= 0) ? (perm[k] * 8) : 0);
+			left_shifts[k] = _mm_cvtsi32_si128(k * 8);
+			if (perm[k] < 0)
+				constant_bytes = _mm_or_si128(constant_bytes, _mm_set1_epi32((int)(0xFFu << (k * 8))));
+		}
+
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128i in_pixels = _mm_loadu_si128((__m128i const *)(src + i * 4));
+			__m128i out_pixels = constant_bytes;
+
+			for (k = 0; k < 4; ++k)
+			{
+				__m128i channel;
+
+				if (perm[k] < 0)
+					continue;
+
+				channel = _mm_and_si128(_mm_srl_epi32(in_pixels, right_shifts[k]), byte_mask);
+				out_pixels = _mm_or_si128(out_pixels, _mm_sll_epi32(channel, left_shifts[k]));
+			}
+
+			_mm_storeu_si128((__m128i *)(dest + i * 4), out_pixels);
+		}
+	}
+#elif defined(IMX2D_CPU_USE_NEON)
+	for (; i + 16 <= count; i += 16)
+	{
+		uint8x16x4_t in_pixels = vld4q_u8(src + i * 4);
+		uint8x16x4_t out_pixels;
+
+		for (k = 0; k < 4; ++k)
+			out_pixels.val[k] = (perm[k] >= 0) ? in_pixels.val[perm[k]] : vdupq_n_u8(0xFF);
+
+		vst4q_u8(dest + i * 4, out_pixels);
+	}
+#endif
+
+	for (; i < count; ++i)
+	{
+		uint8_t const *in_pixel = src + i * 4;
+		uint8_t *out_pixel = dest + i * 4;
+
+		for (k = 0; k < 4; ++k)
+			out_pixel[k] = (perm[k] >= 0) ? in_pixel[perm[k]] : 0xFF;
+	}
+}
+
+
+/* Computes x/255, rounded, for x in the 0..65025 range. */
+inline static int div255(int x)
+{
+	x += 128;
+	return (x + (x >> 8)) >> 8;
+}
+
+
+#if defined(IMX2D_CPU_USE_SSE2)
+inline static __m128i div255_sse2(__m128i x)
+{
+	x = _mm_add_epi16(x, _mm_set1_epi16(128));
+	return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+
+/* Blends 2 pixels, each channel in one 16-bit lane. */
+inline static __m128i blend_2_pixels_sse2(__m128i src, __m128i dest, __m128i global_alpha, __m128i alpha_lanes)
+{
+	__m128i alpha, inv_alpha;
+
+	/* Broadcast the alpha lane of each pixel to all of its lanes,
+	 * and modulate it with the global alpha. */
+	alpha = _mm_shufflelo_epi16(src, _MM_SHUFFLE(3, 3, 3, 3));
+	alpha = _mm_shufflehi_epi16(alpha, _MM_SHUFFLE(3, 3, 3, 3));
+	alpha = div255_sse2(_mm_mullo_epi16(alpha, global_alpha));
+	inv_alpha = _mm_sub_epi16(_mm_set1_epi16(255), alpha);
+
+	/* Using 255 as the source alpha value produces the usual
+	 * "over" result for the alpha channel: a + d * (1 - a). */
+	src = _mm_or_si128(src, alpha_lanes);
+
+	return div255_sse2(_mm_add_epi16(_mm_mullo_epi16(src, alpha), _mm_mullo_epi16(dest, inv_alpha)));
+}
+#elif defined(IMX2D_CPU_USE_NEON)
+inline static uint8x16_t div255_neon(uint16x8_t x_lo, uint16x8_t x_hi)
+{
+	uint16x8_t c128 = vdupq_n_u16(128);
+	x_lo = vaddq_u16(x_lo, c128);
+	x_hi = vaddq_u16(x_hi, c128);
+	return vcombine_u8(
+		vshrn_n_u16(vaddq_u16(x_lo, vshrq_n_u16(x_lo, 8)), 8),
+		vshrn_n_u16(vaddq_u16(x_hi, vshrq_n_u16(x_hi, 8)), 8)
+	);
+}
+
+
+inline static uint8x16_t blend_channel_neon(uint8x16_t src, uint8x16_t dest, uint8x16_t alpha, uint8x16_t inv_alpha)
+{
+	uint16x8_t lo = vmlal_u8(vmull_u8(vget_low_u8(src), vget_low_u8(alpha)), vget_low_u8(dest), vget_low_u8(inv_alpha));
+	uint16x8_t hi = vmlal_u8(vmull_u8(vget_high_u8(src), vget_high_u8(alpha)), vget_high_u8(dest), vget_high_u8(inv_alpha));
+	return div255_neon(lo, hi);
+}
+#endif
+
+
+/* Blends count pixels from the src scanline over the ones in
+ * the dest scanline. The alpha value of each source pixel is
+ * modulated with global_alpha. The result is written to dest. */
+static void blend_pixels(uint8_t *dest, uint8_t const *src, int count, int global_alpha)
+{
+	int i = 0;
+
+#if defined(IMX2D_CPU_USE_SSE2)
+	{
+		__m128i zero = _mm_setzero_si128();
+		__m128i global_alpha_v = _mm_set1_epi16(global_alpha);
+		__m128i alpha_lanes = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128i src_pixels = _mm_loadu_si128((__m128i const *)(src + i * 4));
+			__m128i dest_pixels = _mm_loadu_si128((__m128i const *)(dest + i * 4));
+
+			__m128i result_lo = blend_2_pixels_sse2(
+				_mm_unpacklo_epi8(src_pixels, zero),
+				_mm_unpacklo_epi8(dest_pixels, zero),
+				global_alpha_v, alpha_lanes
+			);
+			__m128i result_hi = blend_2_pixels_sse2(
+				_mm_unpackhi_epi8(src_pixels, zero),
+				_mm_unpackhi_epi8(dest_pixels, zero),
+				global_alpha_v, alpha_lanes
+			);
+
+			_mm_storeu_si128((__m128i *)(dest + i * 4), _mm_packus_epi16(result_lo, result_hi));
+		}
+	}
+#elif defined(IMX2D_CPU_USE_NEON)
+	{
+		uint8x16_t global_alpha_v = vdupq_n_u8(global_alpha);
+		uint8x16_t opaque = vdupq_n_u8(255);
+
+		for (; i + 16 <= count; i += 16)
+		{
+			uint8x16x4_t src_pixels = vld4q_u8(src + i * 4);
+			uint8x16x4_t dest_pixels = vld4q_u8(dest + i * 4);
+			uint8x16_t alpha, inv_alpha;
+
+			alpha = div255_neon(
+				vmull_u8(vget_low_u8(src_pixels.val[3]), vget_low_u8(global_alpha_v)),
+				vmull_u8(vget_high_u8(src_pixels.val[3]), vget_high_u8(global_alpha_v))
+			);
+			inv_alpha = vmvnq_u8(alpha);
+
+			dest_pixels.val[0] = blend_channel_neon(src_pixels.val[0], dest_pixels.val[0], alpha, inv_alpha);
+			dest_pixels.val[1] = blend_channel_neon(src_pixels.val[1], dest_pixels.val[1], alpha, inv_alpha);
+			dest_pixels.val[2] = blend_channel_neon(src_pixels.val[2], dest_pixels.val[2], alpha, inv_alpha);
+			dest_pixels.val[3] = blend_channel_neon(opaque, dest_pixels.val[3], alpha, inv_alpha);
+
+			vst4q_u8(dest + i * 4, dest_pixels);
+		}
+	}
+#endif
+
+	for (; i < count; ++i)
+	{
+		uint8_t const *src_pixel = src + i * 4;
+		uint8_t *dest_pixel = dest + i * 4;
+		int alpha = div255(src_pixel[3] * global_alpha);
+		int inv_alpha = 255 - alpha;
+
+		dest_pixel[0] = div255(src_pixel[0] * alpha + dest_pixel[0] * inv_alpha);
+		dest_pixel[1] = div255(src_pixel[1] * alpha + dest_pixel[1] * inv_alpha);
+		dest_pixel[2] = div255(src_pixel[2] * alpha + dest_pixel[2] * inv_alpha);
+		dest_pixel[3] = div255(255 * alpha + dest_pixel[3] * inv_alpha);
+	}
+}
+
+
+
+
+/* Pixel format conversion */
+
+
+inline static uint8_t clamp_to_uint8(int value)
+{
+	return (value < 0) ? 0 : (value > 255) ? 255 : value;
+}
+
+
+/* YUV <-> RGB conversions use BT.601 limited range coefficients
+ * in 8.8 fixed point format, the same as the 2D hardware does by default. */
+
+inline static void yuv_to_rgba(int y, int u, int v, uint8_t *rgba)
+{
+	int c = (y - 16) * 298 + 128;
+	int d = u - 128;
+	int e = v - 128;
+
+	rgba[0] = clamp_to_uint8((c + 409 * e) >> 8);
+	rgba[1] = clamp_to_uint8((c - 100 * d - 208 * e) >> 8);
+	rgba[2] = clamp_to_uint8((c + 516 * d) >> 8);
+	rgba[3] = 255;
+}
+
+
+inline static uint8_t rgba_to_y(uint8_t const *rgba)
+{
+	return ((66 * rgba[0] + 129 * rgba[1] + 25 * rgba[2] + 128) >> 8) + 16;
+}
+
+
+inline static uint8_t rgba_to_u(uint8_t const *rgba)
+{
+	return ((-38 * rgba[0] - 74 * rgba[1] + 112 * rgba[2] + 128) >> 8) + 128;
+}
+
+
+inline static uint8_t rgba_to_v(uint8_t const *rgba)
+{
+	return ((112 * rgba[0] - 94 * rgba[1] - 18 * rgba[2] + 128) >> 8) + 128;
+}
+
+
+static BOOL format_has_alpha(Imx2dPixelFormat format)
+{
+	switch (format)
+	{
+		case IMX_2D_PIXEL_FORMAT_RGBA8888:
+		case IMX_2D_PIXEL_FORMAT_BGRA8888:
+		case IMX_2D_PIXEL_FORMAT_ARGB8888:
+		case IMX_2D_PIXEL_FORMAT_ABGR8888:
+			return TRUE;
+		default:
+			return FALSE;
+	}
+}
+
+
+/* Gets the byte positions of the R, G, B, A channels in pixels
+ * of 32-bit RGB formats. X formats get -1 as the A position.
+ * Returns FALSE if format is not a 32-bit RGB format. */
+static BOOL get_32bit_channel_positions(Imx2dPixelFormat format, int positions[4])
+{
+#define SET_POSITIONS(R, G, B, A) \
+	do { positions[0] = (R); positions[1] = (G); positions[2] = (B); positions[3] = (A); } while (0)
+
+	switch (format)
+	{
+		case IMX_2D_PIXEL_FORMAT_RGBX8888: SET_POSITIONS(0, 1, 2, -1); break;
+		case IMX_2D_PIXEL_FORMAT_RGBA8888: SET_POSITIONS(0, 1, 2, 3); break;
+		case IMX_2D_PIXEL_FORMAT_BGRX8888: SET_POSITIONS(2, 1, 0, -1); break;
+		case IMX_2D_PIXEL_FORMAT_BGRA8888: SET_POSITIONS(2, 1, 0, 3); break;
+		case IMX_2D_PIXEL_FORMAT_XRGB8888: SET_POSITIONS(1, 2, 3, -1); break;
+		case IMX_2D_PIXEL_FORMAT_ARGB8888: SET_POSITIONS(1, 2, 3, 0); break;
+		case IMX_2D_PIXEL_FORMAT_XBGR8888: SET_POSITIONS(3, 2, 1, -1); break;
+		case IMX_2D_PIXEL_FORMAT_ABGR8888: SET_POSITIONS(3, 2, 1, 0); break;
+		default: return FALSE;
+	}
+
+	return TRUE;
+
+#undef SET_POSITIONS
+}
+
+
+/* Gets the byte offsets of Y0, U, Y1, V inside a 4-byte
+ * macropixel of the packed YUV 4:2:2 formats. */
+static void get_packed_yuv422_offsets(Imx2dPixelFormat format, int *y0, int *u, int *y1, int *v)
+{
+	switch (format)
+	{
+		case IMX_2D_PIXEL_FORMAT_PACKED_YUV422_UYVY: *u = 0; *y0 = 1; *v = 2; *y1 = 3; break;
+		case IMX_2D_PIXEL_FORMAT_PACKED_YUV422_YUYV: *y0 = 0; *u = 1; *y1 = 2; *v = 3; break;
+		case IMX_2D_PIXEL_FORMAT_PACKED_YUV422_YVYU: *y0 = 0; *v = 1; *y1 = 2; *u = 3; break;
+		case IMX_2D_PIXEL_FORMAT_PACKED_YUV422_VYUY: *v = 0; *y0 = 1; *u = 2; *y1 = 3; break;
+		default: assert(FALSE);
+	}
+}
+
+
+/* Gets the planes and byte offsets of U and V samples in
+ * semi planar and fully planar formats. Also gets the byte
+ * distance between consecutive U and V samples. */
+static void get_planar_chroma_layout(Imx2dPixelFormat format, int *u_plane, int *u_offset, int *v_plane, int *v_offset, int *step)
+{
+	switch (format)
+	{
+		case IMX_2D_PIXEL_FORMAT_SEMI_PLANAR_NV12:
+		case IMX_2D_PIXEL_FORMAT_SEMI_PLANAR_NV16:
+			*u_plane = *v_plane = 1; *u_offset = 0; *v_offset = 1; *step = 2;
+			break;
+
+		case IMX_2D_PIXEL_FORMAT_SEMI_PLANAR_NV21:
+		case IMX_2D_PIXEL_FORMAT_SEMI_PLANAR_NV61:
+			*u_plane = *v_plane = 1; *u_offset = 1; *v_offset = 0; *step = 2;
+			break;
+
+		case IMX_2D_PIXEL_FORMAT_FULLY_PLANAR_I420:
+		case IMX_2D_PIXEL_FORMAT_FULLY_PLANAR_Y42B:
+		case IMX_2D_PIXEL_FORMAT_FULLY_PLANAR_Y444:
+			*u_plane = 1; *v_plane = 2; *u_offset = *v_offset = 0; *step = 1;
+			break;
+
+		case IMX_2D_PIXEL_FORMAT_FULLY_PLANAR_YV12:
+			*u_plane = 2; *v_plane = 1; *u_offset = *v_offset = 0; *step = 1;
+			break;
+
+		default:
+			assert(FALSE);
+	}
+}
+
+
+/* Reads count pixels starting at (x,y) from the mapped surface
+ * and converts them to R-G-B-A scanline pixels. */
+static void read_pixels(Imx2dCpuSurfaceMapping const *mapping, int x, int y, int count, uint8_t *rgba)
+{
+	Imx2dSurfaceDesc const *desc = mapping->desc;
+	Imx2dPixelFormatInfo const *fmt_info = mapping->fmt_info;
+	uint8_t const *row = mapping->planes[0] + y * desc->plane_strides[0];
+	int positions[4];
+	int i;
+
+	if (get_32bit_channel_positions(desc->format, positions))
+	{
+		swizzle_32bit_pixels(rgba, row + x * 4, count, positions);
+		return;
+	}
+
+	switch (desc->format)
+	{
+		case IMX_2D_PIXEL_FORMAT_RGB565:
+		case IMX_2D_PIXEL_FORMAT_BGR565:
+		{
+			int r_index = (desc->format == IMX_2D_PIXEL_FORMAT_RGB565) ? 0 : 2;
+			for (i = 0; i < count; ++i, rgba += 4)
+			{
+				uint16_t value;
+				int c;
+				memcpy(&value, row + (x + i) * 2, 2);
+				c = (value >> 11) & 0x1F; rgba[r_index] = (c << 3) | (c >> 2);
+				c = (value >> 5) & 0x3F;  rgba[1] = (c << 2) | (c >> 4);
+				c = value & 0x1F;         rgba[2 - r_index] = (c << 3) | (c >> 2);
+				rgba[3] = 255;
+			}
+			break;
+		}
+
+		case IMX_2D_PIXEL_FORMAT_RGB888:
+		case IMX_2D_PIXEL_FORMAT_BGR888:
+		{
+			int r_index = (desc->format == IMX_2D_PIXEL_FORMAT_RGB888) ? 0 : 2;
+			uint8_t const *src = row + x * 3;
+			for (i = 0; i < count; ++i, rgba += 4, src += 3)
+			{
+				rgba[0] = src[r_index];
+				rgba[1] = src[1];
+				rgba[2] = src[2 - r_index];
+				rgba[3] = 255;
+			}
+			break;
+		}
+
+		case IMX_2D_PIXEL_FORMAT_GRAY8:
+		{
+			uint8_t const *src = row + x;
+			for (i = 0; i < count; ++i, rgba += 4)
+			{
+				rgba[0] = rgba[1] = rgba[2] = src[i];
+				rgba[3] = 255;
+			}
+			break;
+		}
+
+		case IMX_2D_PIXEL_FORMAT_PACKED_YUV422_UYVY:
+		case IMX_2D_PIXEL_FORMAT_PACKED_YUV422_YUYV:
+		case IMX_2D_PIXEL_FORMAT_PACKED_YUV422_YVYU:
+		case IMX_2D_PIXEL_FORMAT_PACKED_YUV422_VYUY:
+		{
+			int y0, u, y1, v;
+			get_packed_yuv422_offsets(desc->format, &y0, &u, &y1, &v);
+			for (i = 0; i < count; ++i, rgba += 4)
+			{
+				int px = x + i;
+				uint8_t const *macropixel = row + (px / 2) * 4;
+				yuv_to_rgba(macropixel[(px & 1) ? y1 : y0], macropixel[u], macropixel[v], rgba);
+			}
+			break;
+		}
+
+		case IMX_2D_PIXEL_FORMAT_PACKED_YUV444:
+		{
+			uint8_t const *src = row + x * 3;
+			for (i = 0; i < count; ++i, rgba += 4, src += 3)
+				yuv_to_rgba(src[0], src[1], src[2], rgba);
+			break;
+		}
+
+		case IMX_2D_PIXEL_FORMAT_SEMI_PLANAR_NV12:
+		case IMX_2D_PIXEL_FORMAT_SEMI_PLANAR_NV21:
+		case IMX_2D_PIXEL_FORMAT_SEMI_PLANAR_NV16:
+		case IMX_2D_PIXEL_FORMAT_SEMI_PLANAR_NV61:
+		case IMX_2D_PIXEL_FORMAT_FULLY_PLANAR_YV12:
+		case IMX_2D_PIXEL_FORMAT_FULLY_PLANAR_I420:
+		case IMX_2D_PIXEL_FORMAT_FULLY_PLANAR_Y42B:
+		case IMX_2D_PIXEL_FORMAT_FULLY_PLANAR_Y444:
+		{
+			int u_plane, u_offset, v_plane, v_offset, step;
+			int chroma_y = y / fmt_info->y_subsampling;
+			uint8_t const *u_row, *v_row;
+
+			get_planar_chroma_layout(desc->format, &u_plane, &u_offset, &v_plane, &v_offset, &step);
+			u_row = mapping->planes[u_plane] + chroma_y * desc->plane_strides[u_plane] + u_offset;
+			v_row = mapping->planes[v_plane] + chroma_y * desc->plane_strides[v_plane] + v_offset;
+
+			for (i = 0; i < count; ++i, rgba += 4)
+			{
+				int px = x + i;
+				int chroma_x = (px / fmt_info->x_subsampling) * step;
+				yuv_to_rgba(row[px], u_row[chroma_x], v_row[chroma_x], rgba);
+			}
+			break;
+		}
+
+		default:
+			assert(FALSE);
+	}
+}
+
+
+/* Stores a chroma value. If the pixels that share the chroma
+ * sample are only partially overwritten, the old and new values
+ * are averaged, since the old value still applies to the rest. */
+inline static void store_chroma(uint8_t *dest, uint8_t value, BOOL fully_covered)
+{
+	*dest = fully_covered ? value : ((*dest + value + 1) >> 1);
+}
+
+
+/* Converts count R-G-B-A scanline pixels and writes them to
+ * the mapped surface, starting at (x,y). region is the entire
+ * region that is being written to; the pixels must lie inside it.
+ *
+ * With subsampled chroma, the chroma samples are taken from the
+ * first pixel of each chroma block inside the region (that is, its
+ * top left corner unless the region starts in the middle of the
+ * block); the other pixels only update luma. If the region covers
+ * only part of a chroma block, the chroma sample is averaged with
+ * the existing one instead of being overwritten, since it is shared
+ * with pixels outside of the region. */
+static void write_pixels(Imx2dCpuSurfaceMapping const *mapping, Imx2dRegion const *region, int x, int y, int count, uint8_t const *rgba)
+{
+	Imx2dSurfaceDesc const *desc = mapping->desc;
+	Imx2dPixelFormatInfo const *fmt_info = mapping->fmt_info;
+	uint8_t *row = mapping->planes[0] + y * desc->plane_strides[0];
+	int positions[4];
+	int i;
+
+	if (get_32bit_channel_positions(desc->format, positions))
+	{
+		/* Invert the channel positions to get the
+		 * permutation from scanline to format. */
+		int perm[4] = { -1, -1, -1, -1 };
+		for (i = 0; i < 4; ++i)
+		{
+			if (positions[i] >= 0)
+				perm[positions[i]] = i;
+		}
+
+		swizzle_32bit_pixels(row + x * 4, rgba, count, perm);
+		return;
+	}
+
+	switch (desc->format)
+	{
+		case IMX_2D_PIXEL_FORMAT_RGB565:
+		case IMX_2D_PIXEL_FORMAT_BGR565:
+		{
+			int r_index = (desc->format == IMX_2D_PIXEL_FORMAT_RGB565) ? 0 : 2;
+			for (i = 0; i < count; ++i, rgba += 4)
+			{
+				uint16_t value = ((rgba[r_index] >> 3) << 11) | ((rgba[1] >> 2) << 5) | (rgba[2 - r_index] >> 3);
+				memcpy(row + (x + i) * 2, &value, 2);
+			}
+			break;
+		}
+
+		case IMX_2D_PIXEL_FORMAT_RGB888:
+		case IMX_2D_PIXEL_FORMAT_BGR888:
+		{
+			int r_index = (desc->format == IMX_2D_PIXEL_FORMAT_RGB888) ? 0 : 2;
+			uint8_t *dest = row + x * 3;
+			for (i = 0; i < count; ++i, rgba += 4, dest += 3)
+			{
+				dest[r_index] = rgba[0];
+				dest[1] = rgba[1];
+				dest[2 - r_index] = rgba[2];
+			}
+			break;
+		}
+
+		case IMX_2D_PIXEL_FORMAT_GRAY8:
+		{
+			/* Grayscale is full range, unlike the luma of the YUV formats. */
+			uint8_t *dest = row + x;
+			for (i = 0; i < count; ++i, rgba += 4)
+				dest[i] = (77 * rgba[0] + 150 * rgba[1] + 29 * rgba[2] + 128) >> 8;
+			break;
+		}
+
+		case IMX_2D_PIXEL_FORMAT_PACKED_YUV422_UYVY:
+		case IMX_2D_PIXEL_FORMAT_PACKED_YUV422_YUYV:
+		case IMX_2D_PIXEL_FORMAT_PACKED_YUV422_YVYU:
+		case IMX_2D_PIXEL_FORMAT_PACKED_YUV422_VYUY:
+		{
+			int y0, u, y1, v;
+			get_packed_yuv422_offsets(desc->format, &y0, &u, &y1, &v);
+			for (i = 0; i < count; ++i, rgba += 4)
+			{
+				int px = x + i;
+				uint8_t *macropixel = row + (px / 2) * 4;
+				macropixel[(px & 1) ? y1 : y0] = rgba_to_y(rgba);
+				if (((px & 1) == 0) || (i == 0))
+				{
+					int block_x1 = px & ~1;
+					int block_x2 = MIN(block_x1 + 2, desc->width);
+					BOOL fully_covered = (block_x1 >= x) && (block_x2 <= (x + count));
+					store_chroma(&(macropixel[u]), rgba_to_u(rgba), fully_covered);
+					store_chroma(&(macropixel[v]), rgba_to_v(rgba), fully_covered);
+				}
+			}
+			break;
+		}
+
+		case IMX_2D_PIXEL_FORMAT_PACKED_YUV444:
+		{
+			uint8_t *dest = row + x * 3;
+			for (i = 0; i < count; ++i, rgba += 4, dest += 3)
+			{
+				dest[0] = rgba_to_y(rgba);
+				dest[1] = rgba_to_u(rgba);
+				dest[2] = rgba_to_v(rgba);
+			}
+			break;
+		}
+
+		case IMX_2D_PIXEL_FORMAT_SEMI_PLANAR_NV12:
+		case IMX_2D_PIXEL_FORMAT_SEMI_PLANAR_NV21:
+		case IMX_2D_PIXEL_FORMAT_SEMI_PLANAR_NV16:
+		case IMX_2D_PIXEL_FORMAT_SEMI_PLANAR_NV61:
+		case IMX_2D_PIXEL_FORMAT_FULLY_PLANAR_YV12:
+		case IMX_2D_PIXEL_FORMAT_FULLY_PLANAR_I420:
+		case IMX_2D_PIXEL_FORMAT_FULLY_PLANAR_Y42B:
+		case IMX_2D_PIXEL_FORMAT_FULLY_PLANAR_Y444:
+		{
+			int u_plane, u_offset, v_plane, v_offset, step;
+			int x_subsampling = fmt_info->x_subsampling;
+			int y_subsampling = fmt_info->y_subsampling;
+			int block_y1 = y - (y % y_subsampling);
+			int block_y2 = MIN(block_y1 + y_subsampling, desc->height);
+			/* Chroma is written by the first row of each chroma block
+			 * that lies inside the region. The rows below it in the
+			 * same block only update luma. */
+			BOOL write_chroma = (y == block_y1) || (y == region->y1);
+			BOOL rows_fully_covered = (block_y1 >= region->y1) && (block_y2 <= region->y2);
+			int chroma_y = y / y_subsampling;
+			uint8_t *u_row, *v_row;
+
+			get_planar_chroma_layout(desc->format, &u_plane, &u_offset, &v_plane, &v_offset, &step);
+			u_row = mapping->planes[u_plane] + chroma_y * desc->plane_strides[u_plane] + u_offset;
+			v_row = mapping->planes[v_plane] + chroma_y * desc->plane_strides[v_plane] + v_offset;
+
+			for (i = 0; i < count; ++i, rgba += 4)
+			{
+				int px = x + i;
+				row[px] = rgba_to_y(rgba);
+				if (write_chroma && (((px % x_subsampling) == 0) || (i == 0)))
+				{
+					int block_x1 = px - (px % x_subsampling);
+					int block_x2 = MIN(block_x1 + x_subsampling, desc->width);
+					BOOL fully_covered = rows_fully_covered && (block_x1 >= x) && (block_x2 <= (x + count));
+					int chroma_x = (px / x_subsampling) * step;
+					store_chroma(&(u_row[chroma_x]), rgba_to_u(rgba), fully_covered);
+					store_chroma(&(v_row[chroma_x]), rgba_to_v(rgba), fully_covered);
+				}
+			}
+			break;
+		}
+
+		default:
+			assert(FALSE);
+	}
+}
+
+
+
+
+typedef struct _Imx2dCpuOperation Imx2dCpuOperation;
+typedef struct _Imx2dCpuBatch Imx2dCpuBatch;
+typedef struct _Imx2dCpuScanlines Imx2dCpuScanlines;
+typedef struct _Imx2dCpuBlitter Imx2dCpuBlitter;
+
+
+typedef enum
+{
+	IMX_2D_CPU_OPERATION_TYPE_BLIT,
+	IMX_2D_CPU_OPERATION_TYPE_FILL
+}
+Imx2dCpuOperationType;
+
+
+/* A recorded blit or fill. Operations are not performed right away;
+ * they are recorded, and run once the sequence is finished or
+ * submitted. Everything is copied, including the source surface
+ * structure, since the caller is free to modify its surfaces and
+ * regions once the sequence is submitted. Only the DMA buffers
+ * must stay valid until the submission is completed. */
+struct _Imx2dCpuOperation
+{
+	Imx2dCpuOperationType type;
+
+	Imx2dSurface source;
+	Imx2dRegion source_region;
+	Imx2dRegion dest_region;
+	Imx2dRegion expanded_dest_region;
+	BOOL has_expanded_dest_region;
+	Imx2dRotation rotation;
+	int dest_surface_alpha;
+	/* For blits, this is the margin fill color (with the premultiplied
+	 * margin alpha in the top byte). For fills, this is the fill color. */
+	uint32_t fill_color;
+};
+
+
+/* The operations of one sequence, together with a copy
+ * of the destination surface they are performed on. */
+struct _Imx2dCpuBatch
+{
+	Imx2dSurface dest;
+
+	Imx2dCpuOperation *operations;
+	int num_operations;
+	int operations_capacity;
+
+	Imx2dCpuBatch *next;
+};
+
+
+/* Scanline buffers, each with room for the blitter's
+ * scanline_capacity pixels. Every band has its own set. */
+struct _Imx2dCpuScanlines
+{
+	uint8_t *source;
+	uint8_t *blit;
+	uint8_t *dest;
+};
+
+
+struct _Imx2dCpuBlitter
+{
+	Imx2dBlitter parent;
+
+	/* Optional function for processing bands of rows in parallel.
+	 * See imx_2d_backend_cpu_blitter_set_band_runner(). */
+	Imx2dCpuBlitterRunBandsFunc run_bands_func;
+	int max_num_bands;
+	void *run_bands_user_data;
+
+	/* The batch of the ongoing sequence. NULL if no
+	 * sequence was started. */
+	Imx2dCpuBatch *current_batch;
+
+	/* Submitted batches are run in a worker thread, one after the
+	 * other. The thread is created when the first batch is submitted.
+	 * Batches that were run are put in the free_batches list to be
+	 * reused by later sequences. batch_running is TRUE while the
+	 * worker thread runs a batch that is no longer in the queue.
+	 * submission_failed is set if any batch failed since the last
+	 * wait / poll. All of these fields are protected by the mutex. */
+	pthread_t worker_thread;
+	BOOL worker_thread_created;
+	pthread_mutex_t mutex;
+	pthread_cond_t batch_queued_cond;
+	pthread_cond_t batch_done_cond;
+	Imx2dCpuBatch *queued_batches_head;
+	Imx2dCpuBatch *queued_batches_tail;
+	Imx2dCpuBatch *free_batches;
+	BOOL batch_running;
+	BOOL submission_failed;
+	BOOL shutting_down;
+
+	/* The fields below are only accessed by whoever runs a batch.
+	 * This is either the worker thread or, in imx_2d_blitter_finish(),
+	 * the calling thread, but never both at the same time, since
+	 * finish() waits for the worker thread to become idle first. */
+
+	/* The destination surface is mapped while a batch is run.
+	 * dest_region is the region of that surface. */
+	Imx2dCpuSurfaceMapping dest_mapping;
+	Imx2dRegion const *dest_region;
+
+	/* One set of scanline buffers per band, plus the source coordinate
+	 * lookup table for scaling, which is shared by all bands. */
+	Imx2dCpuScanlines *scanlines;
+	int num_scanlines;
+	int *coordinate_table;
+	int scanline_capacity;
+};
+
+
+/* Bands with fewer rows than this are not worth handing to another
+ * thread, since the synchronization then costs more than the blit. */
+#define MIN_NUM_ROWS_PER_BAND 16
+
+
+static void imx_2d_backend_cpu_blitter_destroy(Imx2dBlitter *blitter);
+
+static int imx_2d_backend_cpu_blitter_start(Imx2dBlitter *blitter);
+static int imx_2d_backend_cpu_blitter_finish(Imx2dBlitter *blitter);
+
+static int imx_2d_backend_cpu_blitter_submit(Imx2dBlitter *blitter);
+static int imx_2d_backend_cpu_blitter_wait(Imx2dBlitter *blitter);
+static Imx2dCompletionStatus imx_2d_backend_cpu_blitter_poll(Imx2dBlitter *blitter);
+
+static int imx_2d_backend_cpu_blitter_do_blit(Imx2dBlitter *blitter, Imx2dInternalBlitParams *internal_blit_params);
+static int imx_2d_backend_cpu_blitter_fill_region(Imx2dBlitter *blitter, Imx2dInternalFillRegionParams *internal_fill_region_params);
+
+static Imx2dHardwareCapabilities const * imx_2d_backend_cpu_blitter_get_hardware_capabilities(Imx2dBlitter *blitter);
+
+
+static Imx2dBlitterClass imx_2d_backend_cpu_blitter_class =
+{
+	imx_2d_backend_cpu_blitter_destroy,
+
+	imx_2d_backend_cpu_blitter_start,
+	imx_2d_backend_cpu_blitter_finish,
+
+	imx_2d_backend_cpu_blitter_submit,
+	imx_2d_backend_cpu_blitter_wait,
+	imx_2d_backend_cpu_blitter_poll,
+
+	imx_2d_backend_cpu_blitter_do_blit,
+	NULL,
+	imx_2d_backend_cpu_blitter_fill_region,
+
+	imx_2d_backend_cpu_blitter_get_hardware_capabilities
+};
+
+
+
+
+static BOOL resize_scanlines(Imx2dCpuScanlines *scanlines, int num_pixels)
+{
+	uint8_t *source, *blit, *dest;
+
+	source = realloc(scanlines->source, num_pixels * 4);
+	if (source != NULL)
+		scanlines->source = source;
+
+	blit = realloc(scanlines->blit, num_pixels * 4);
+	if (blit != NULL)
+		scanlines->blit = blit;
+
+	dest = realloc(scanlines->dest, num_pixels * 4);
+	if (dest != NULL)
+		scanlines->dest = dest;
+
+	return (source != NULL) && (blit != NULL) && (dest != NULL);
+}
+
+
+/* Makes sure that there are num_sets scanline sets with room for
+ * num_pixels pixels each, and a large enough coordinate table. */
+static BOOL ensure_scanline_capacity(Imx2dCpuBlitter *cpu_blitter, int num_pixels, int num_sets)
+{
+	int i;
+
+	if (num_pixels > cpu_blitter->scanline_capacity)
+	{
+		int *coordinate_table = realloc(cpu_blitter->coordinate_table, num_pixels * sizeof(int));
+		if (coordinate_table == NULL)
+			goto error;
+		cpu_blitter->coordinate_table = coordinate_table;
+
+		for (i = 0; i < cpu_blitter->num_scanlines; ++i)
+		{
+			if (!resize_scanlines(&(cpu_blitter->scanlines[i]), num_pixels))
+				goto error;
+		}
+
+		IMX_2D_LOG(DEBUG, "resized scanline buffers from %d to %d pixel(s)", cpu_blitter->scanline_capacity, num_pixels);
+		cpu_blitter->scanline_capacity = num_pixels;
+	}
+
+	if (num_sets > cpu_blitter->num_scanlines)
+	{
+		Imx2dCpuScanlines *scanlines = realloc(cpu_blitter->scanlines, num_sets * sizeof(Imx2dCpuScanlines));
+		if (scanlines == NULL)
+			goto error;
+		cpu_blitter->scanlines = scanlines;
+
+		for (i = cpu_blitter->num_scanlines; i < num_sets; ++i)
+		{
+			memset(&(scanlines[i]), 0, sizeof(Imx2dCpuScanlines));
+
+			if (!resize_scanlines(&(scanlines[i]), cpu_blitter->scanline_capacity))
+			{
+				free(scanlines[i].source);
+				free(scanlines[i].blit);
+				free(scanlines[i].dest);
+				goto error;
+			}
+
+			cpu_blitter->num_scanlines++;
+		}
+
+		IMX_2D_LOG(DEBUG, "now using %d scanline buffer set(s)", num_sets);
+	}
+
+	return TRUE;
+
+error:
+	IMX_2D_LOG(ERROR, "could not allocate %d scanline buffer set(s) for %d pixel(s)", num_sets, num_pixels);
+	return FALSE;
+}
+
+
+/* Writes count scanline pixels to the destination surface at (x,y).
+ * region is the entire destination region that is being written to
+ * (see write_pixels()). If blend is TRUE, the pixels are blended
+ * over the existing ones, using the dest scanline as scratch space. */
+static void write_scanline_to_dest(Imx2dCpuBlitter *cpu_blitter, Imx2dCpuScanlines *scanlines, Imx2dRegion const *region, int x, int y, int count, uint8_t const *rgba, BOOL blend, int global_alpha)
+{
+	if (blend)
+	{
+		read_pixels(&(cpu_blitter->dest_mapping), x, y, count, scanlines->dest);
+		blend_pixels(scanlines->dest, rgba, count, global_alpha);
+		write_pixels(&(cpu_blitter->dest_mapping), region, x, y, count, scanlines->dest);
+	}
+	else
+		write_pixels(&(cpu_blitter->dest_mapping), region, x, y, count, rgba);
+}
+
+
+/* Fills a region in the destination surface with a color (in
+ * 0x00RRGGBB format). If alpha is not 255, the color is blended
+ * over the existing pixels. */
+static BOOL fill_dest_region(Imx2dCpuBlitter *cpu_blitter, Imx2dRegion const *region, uint32_t color, int alpha)
+{
+	Imx2dRegion clipped_region;
+	Imx2dCpuScanlines *scanlines;
+	uint8_t rgba[4];
+	uint32_t scanline_pixel;
+	int positions[4];
+	int width, y;
+
+	imx_2d_region_intersect(&clipped_region, region, cpu_blitter->dest_region);
+	width = clipped_region.x2 - clipped_region.x1;
+	if ((width <= 0) || (clipped_region.y2 <= clipped_region.y1))
+		return TRUE;
+
+	rgba[0] = (color >> 16) & 0xFF;
+	rgba[1] = (color >> 8) & 0xFF;
+	rgba[2] = (color >> 0) & 0xFF;
+	rgba[3] = alpha;
+
+	if ((alpha == 255) && get_32bit_channel_positions(cpu_blitter->dest_mapping.desc->format, positions))
+	{
+		/* Fast path: Convert the color to the destination
+		 * format once, and fill the rows with it directly. */
+		uint8_t dest_pixel[4] = { 0xFF, 0xFF, 0xFF, 0xFF };
+		uint32_t dest_pixel_value;
+		Imx2dCpuSurfaceMapping const *mapping = &(cpu_blitter->dest_mapping);
+		int i;
+
+		for (i = 0; i < 4; ++i)
+		{
+			if (positions[i] >= 0)
+				dest_pixel[positions[i]] = rgba[i];
+		}
+		memcpy(&dest_pixel_value, dest_pixel, 4);
+
+		for (y = clipped_region.y1; y < clipped_region.y2; ++y)
+			fill_32bit_pixels(mapping->planes[0] + y * mapping->desc->plane_strides[0] + clipped_region.x1 * 4, dest_pixel_value, width);
+
+		return TRUE;
+	}
+
+	if (!ensure_scanline_capacity(cpu_blitter, width, 1))
+		return FALSE;
+
+	scanlines = &(cpu_blitter->scanlines[0]);
+	memcpy(&scanline_pixel, rgba, 4);
+	fill_32bit_pixels(scanlines->blit, scanline_pixel, width);
+
+	for (y = clipped_region.y1; y < clipped_region.y2; ++y)
+		write_scanline_to_dest(cpu_blitter, scanlines, &clipped_region, clipped_region.x1, y, width, scanlines->blit, (alpha != 255), 255);
+
+	return TRUE;
+}
+
+
+/* Copies the pixels of a region plane by plane, without any conversion.
+ * Only possible if source and destination use the same format, and if
+ * the region coordinates are aligned to the chroma subsampling. */
+static BOOL try_copy_region_directly(Imx2dCpuBlitter *cpu_blitter, Imx2dCpuSurfaceMapping const *source_mapping, Imx2dRegion const *source_region, Imx2dRegion const *dest_region)
+{
+	Imx2dCpuSurfaceMapping const *dest_mapping = &(cpu_blitter->dest_mapping);
+	Imx2dPixelFormatInfo const *fmt_info = source_mapping->fmt_info;
+	int x_subsampling = fmt_info->x_subsampling;
+	int y_subsampling = fmt_info->y_subsampling;
+	int width = source_region->x2 - source_region->x1;
+	int height = source_region->y2 - source_region->y1;
+	int plane_nr, y;
+
+	if (source_mapping->desc->format != dest_mapping->desc->format)
+		return FALSE;
+
+	if (((source_region->x1 % x_subsampling) != 0) || ((dest_region->x1 % x_subsampling) != 0) || ((width % x_subsampling) != 0)
+	 || ((source_region->y1 % y_subsampling) != 0) || ((dest_region->y1 % y_subsampling) != 0) || ((height % y_subsampling) != 0))
+		return FALSE;
+
+	for (plane_nr = 0; plane_nr < fmt_info->num_planes; ++plane_nr)
+	{
+		int bytes_per_sample, plane_x_subsampling, plane_y_subsampling;
+		int source_stride = source_mapping->desc->plane_strides[plane_nr];
+		int dest_stride = dest_mapping->desc->plane_strides[plane_nr];
+		uint8_t const *source_row;
+		uint8_t *dest_row;
+		int num_row_bytes;
+
+		if (plane_nr == 0)
+		{
+			/* The first plane contains all channels in RGB and
+			 * packed YUV formats; the pixel stride covers these. */
+			bytes_per_sample = fmt_info->pixel_stride;
+			plane_x_subsampling = plane_y_subsampling = 1;
+		}
+		else
+		{
+			bytes_per_sample = fmt_info->is_semi_planar ? 2 : 1;
+			plane_x_subsampling = x_subsampling;
+			plane_y_subsampling = y_subsampling;
+		}
+
+		num_row_bytes = width / plane_x_subsampling * bytes_per_sample;
+		source_row = source_mapping->planes[plane_nr] + (source_region->y1 / plane_y_subsampling) * source_stride + (source_region->x1 / plane_x_subsampling) * bytes_per_sample;
+		dest_row = dest_mapping->planes[plane_nr] + (dest_region->y1 / plane_y_subsampling) * dest_stride + (dest_region->x1 / plane_x_subsampling) * bytes_per_sample;
+
+		for (y = 0; y < height / plane_y_subsampling; ++y)
+		{
+			memcpy(dest_row, source_row, num_row_bytes);
+			source_row += source_stride;
+			dest_row += dest_stride;
+		}
+	}
+
+	return TRUE;
+}
+
+
+/* Maps the index of a destination pixel to the corresponding
+ * source coordinate, using nearest neighbor sampling. The result
+ * is relative to the source region, and is flipped if requested. */
+inline static int map_coordinate(int dest_index, int dest_length, int source_length, BOOL flip)
+{
+	int source_index = (int)(((int64_t)dest_index * 2 + 1) * source_length / ((int64_t)dest_length * 2));
+	source_index = MIN(source_index, source_length - 1);
+	return flip ? (source_length - 1 - source_index) : source_index;
+}
+
+
+/* State of a blit_with_conversion() call that is shared by all bands. */
+typedef struct
+{
+	Imx2dCpuBlitter *cpu_blitter;
+	Imx2dCpuSurfaceMapping const *source_mapping;
+	Imx2dRegion const *source_region;
+	Imx2dRegion const *dest_region;
+	BOOL transposed, flip_x, flip_y;
+	BOOL blend;
+	int global_alpha;
+}
+Imx2dCpuConversionBlit;
+
+
+static void blit_band_with_conversion(int band_index, int num_bands, void *band_data)
+{
+	Imx2dCpuConversionBlit const *blit = (Imx2dCpuConversionBlit const *)band_data;
+	Imx2dCpuBlitter *cpu_blitter = blit->cpu_blitter;
+	Imx2dCpuSurfaceMapping const *source_mapping = blit->source_mapping;
+	Imx2dRegion const *source_region = blit->source_region;
+	Imx2dRegion const *dest_region = blit->dest_region;
+	Imx2dCpuScanlines *scanlines = &(cpu_blitter->scanlines[band_index]);
+	int source_width = source_region->x2 - source_region->x1;
+	int source_height = source_region->y2 - source_region->y1;
+	int dest_width = dest_region->x2 - dest_region->x1;
+	int dest_height = dest_region->y2 - dest_region->y1;
+	int y_subsampling = cpu_blitter->dest_mapping.fmt_info->y_subsampling;
+	int const *coordinate_table = cpu_blitter->coordinate_table;
+	uint32_t const *source_pixels = (uint32_t const *)(scanlines->source);
+	uint32_t *blit_pixels = (uint32_t *)(scanlines->blit);
+	int first_row, end_row;
+	int i, j;
+
+	/* Band boundaries are aligned to the chroma subsampling of the
+	 * destination, so that the rows which share chroma samples
+	 * are always written by the same band. */
+	first_row = (int)((int64_t)dest_height * band_index / num_bands);
+	end_row = (int)((int64_t)dest_height * (band_index + 1) / num_bands);
+	if (band_index > 0)
+		first_row = MAX(first_row - (dest_region->y1 + first_row) % y_subsampling, 0);
+	if (band_index < (num_bands - 1))
+		end_row = MAX(end_row - (dest_region->y1 + end_row) % y_subsampling, 0);
+
+	if (!blit->transposed)
+	{
+		BOOL direct_read = (source_width == dest_width) && !blit->flip_x;
+		int last_source_y = -1;
+
+		for (j = first_row; j < end_row; ++j)
+		{
+			int source_y = source_region->y1 + map_coordinate(j, dest_height, source_height, blit->flip_y);
+
+			/* When upscaling vertically, consecutive destination rows
+			 * use the same source row, so the blit scanline from the
+			 * previous row can be reused. */
+			if (source_y != last_source_y)
+			{
+				if (direct_read)
+				{
+					read_pixels(source_mapping, source_region->x1, source_y, source_width, scanlines->blit);
+				}
+				else
+				{
+					read_pixels(source_mapping, source_region->x1, source_y, source_width, scanlines->source);
+					for (i = 0; i < dest_width; ++i)
+						blit_pixels[i] = source_pixels[coordinate_table[i]];
+				}
+
+				last_source_y = source_y;
+			}
+
+			write_scanline_to_dest(cpu_blitter, scanlines, dest_region, dest_region->x1, dest_region->y1 + j, dest_width, scanlines->blit, blit->blend, blit->global_alpha);
+		}
+	}
+	else
+	{
+		for (j = first_row; j < end_row; ++j)
+		{
+			int source_x = source_region->x1 + map_coordinate(j, dest_height, source_width, blit->flip_x);
+
+			for (i = 0; i < dest_width; ++i)
+				read_pixels(source_mapping, source_x, coordinate_table[i], 1, scanlines->blit + i * 4);
+
+			write_scanline_to_dest(cpu_blitter, scanlines, dest_region, dest_region->x1, dest_region->y1 + j, dest_width, scanlines->blit, blit->blend, blit->global_alpha);
+		}
+	}
+}
+
+
+static BOOL blit_with_conversion(Imx2dCpuBlitter *cpu_blitter, Imx2dCpuSurfaceMapping const *source_mapping, Imx2dRegion const *source_region, Imx2dRegion const *dest_region, Imx2dRotation rotation, BOOL blend, int global_alpha)
+{
+	Imx2dCpuConversionBlit blit;
+	int source_width = source_region->x2 - source_region->x1;
+	int source_height = source_region->y2 - source_region->y1;
+	int dest_width = dest_region->x2 - dest_region->x1;
+	int dest_height = dest_region->y2 - dest_region->y1;
+	int num_bands = 1;
+	int i;
+
+	blit.cpu_blitter = cpu_blitter;
+	blit.source_mapping = source_mapping;
+	blit.source_region = source_region;
+	blit.dest_region = dest_region;
+	blit.blend = blend;
+	blit.global_alpha = global_alpha;
+
+	/* With transposed rotations, destination rows correspond to
+	 * source columns and vice versa. flip_x / flip_y refer to
+	 * the source X and Y axes. */
+	switch (rotation)
+	{
+		case IMX_2D_ROTATION_NONE:            blit.transposed = FALSE; blit.flip_x = FALSE; blit.flip_y = FALSE; break;
+		case IMX_2D_ROTATION_90:              blit.transposed = TRUE;  blit.flip_x = FALSE; blit.flip_y = TRUE;  break;
+		case IMX_2D_ROTATION_180:             blit.transposed = FALSE; blit.flip_x = TRUE;  blit.flip_y = TRUE;  break;
+		case IMX_2D_ROTATION_270:             blit.transposed = TRUE;  blit.flip_x = TRUE;  blit.flip_y = FALSE; break;
+		case IMX_2D_ROTATION_FLIP_HORIZONTAL: blit.transposed = FALSE; blit.flip_x = TRUE;  blit.flip_y = FALSE; break;
+		case IMX_2D_ROTATION_FLIP_VERTICAL:   blit.transposed = FALSE; blit.flip_x = FALSE; blit.flip_y = TRUE;  break;
+		case IMX_2D_ROTATION_UL_LR:           blit.transposed = TRUE;  blit.flip_x = FALSE; blit.flip_y = FALSE; break;
+		case IMX_2D_ROTATION_UR_LL:           blit.transposed = TRUE;  blit.flip_x = TRUE;  blit.flip_y = TRUE;  break;
+		default: assert(FALSE); return FALSE;
+	}
+
+	if (cpu_blitter->run_bands_func != NULL)
+		num_bands = MAX(MIN(cpu_blitter->max_num_bands, dest_height / MIN_NUM_ROWS_PER_BAND), 1);
+
+	if (!ensure_scanline_capacity(cpu_blitter, MAX(source_width, dest_width), num_bands))
+		return FALSE;
+
+	/* The coordinate table maps destination columns to source columns
+	 * (or to source rows with transposed rotations). It is only read
+	 * by the bands, so they can all share it. */
+	for (i = 0; i < dest_width; ++i)
+	{
+		if (blit.transposed)
+			cpu_blitter->coordinate_table[i] = source_region->y1 + map_coordinate(i, dest_width, source_height, blit.flip_y);
+		else
+			cpu_blitter->coordinate_table[i] = map_coordinate(i, dest_width, source_width, blit.flip_x);
+	}
+
+	if (num_bands > 1)
+		cpu_blitter->run_bands_func(num_bands, blit_band_with_conversion, &blit, cpu_blitter->run_bands_user_data);
+	else
+		blit_band_with_conversion(0, 1, &blit);
+
+	return TRUE;
+}
+
+
+/* Performs a recorded blit. The destination surface must be mapped. */
+static BOOL run_blit_operation(Imx2dCpuBlitter *cpu_blitter, Imx2dCpuOperation *operation)
+{
+	Imx2dCpuSurfaceMapping source_mapping;
+	Imx2dRegion const *source_region = &(operation->source_region);
+	Imx2dRegion const *dest_region = &(operation->dest_region);
+	BOOL blend;
+	BOOL ret;
+
+	IMX_2D_LOG(
+		TRACE,
+		"CPU blitter: regions: source: %" IMX_2D_REGION_FORMAT " dest: %" IMX_2D_REGION_FORMAT " rotation: %s alpha: %d",
+		IMX_2D_REGION_ARGS(source_region), IMX_2D_REGION_ARGS(dest_region),
+		imx_2d_rotation_to_string(operation->rotation),
+		operation->dest_surface_alpha
+	);
+
+	/* If there is an expanded_dest_region, it means that
+	 * there is a margin that must be drawn. The four margin
+	 * rectangles are the left, top, right, bottom ones. */
+	if (operation->has_expanded_dest_region)
+	{
+		Imx2dRegion const *expanded_dest_region = &(operation->expanded_dest_region);
+		int margin_alpha = (operation->fill_color >> 24) & 0xFF;
+		Imx2dRegion margin_regions[4];
+		int i;
+
+		margin_regions[0].x1 = expanded_dest_region->x1; margin_regions[0].y1 = dest_region->y1;
+		margin_regions[0].x2 = dest_region->x1;          margin_regions[0].y2 = dest_region->y2;
+
+		margin_regions[1].x1 = expanded_dest_region->x1; margin_regions[1].y1 = expanded_dest_region->y1;
+		margin_regions[1].x2 = expanded_dest_region->x2; margin_regions[1].y2 = dest_region->y1;
+
+		margin_regions[2].x1 = dest_region->x2;          margin_regions[2].y1 = dest_region->y1;
+		margin_regions[2].x2 = expanded_dest_region->x2; margin_regions[2].y2 = dest_region->y2;
+
+		margin_regions[3].x1 = expanded_dest_region->x1; margin_regions[3].y1 = dest_region->y2;
+		margin_regions[3].x2 = expanded_dest_region->x2; margin_regions[3].y2 = expanded_dest_region->y2;
+
+		for (i = 0; i < 4; ++i)
+		{
+			if (!fill_dest_region(cpu_blitter, &(margin_regions[i]), operation->fill_color, margin_alpha))
+				return FALSE;
+		}
+	}
+
+	if ((source_region->x2 <= source_region->x1) || (source_region->y2 <= source_region->y1)
+	 || (dest_region->x2 <= dest_region->x1) || (dest_region->y2 <= dest_region->y1))
+	{
+		IMX_2D_LOG(TRACE, "source and/or dest region is empty; skipping blit");
+		return TRUE;
+	}
+
+	if (!map_surface(&source_mapping, &(operation->source), IMX_DMA_BUFFER_MAPPING_FLAG_READ))
+	{
+		IMX_2D_LOG(ERROR, "could not map source surface");
+		return FALSE;
+	}
+
+	blend = (operation->dest_surface_alpha != 255) || format_has_alpha(source_mapping.desc->format);
+
+	if (!blend
+	 && (operation->rotation == IMX_2D_ROTATION_NONE)
+	 && ((source_region->x2 - source_region->x1) == (dest_region->x2 - dest_region->x1))
+	 && ((source_region->y2 - source_region->y1) == (dest_region->y2 - dest_region->y1))
+	 && try_copy_region_directly(cpu_blitter, &source_mapping, source_region, dest_region))
+	{
+		IMX_2D_LOG(TRACE, "copied pixels directly");
+		unmap_surface(&source_mapping);
+		return TRUE;
+	}
+
+	ret = blit_with_conversion(cpu_blitter, &source_mapping, source_region, dest_region, operation->rotation, blend, operation->dest_surface_alpha);
+
+	unmap_surface(&source_mapping);
+
+	return ret;
+}
+
+
+/* Runs all operations of a batch, in the order they were recorded. */
+static BOOL run_batch(Imx2dCpuBlitter *cpu_blitter, Imx2dCpuBatch *batch)
+{
+	BOOL ret = TRUE;
+	int i;
+
+	if (batch->num_operations == 0)
+		return TRUE;
+
+	if (!map_surface(&(cpu_blitter->dest_mapping), &(batch->dest), IMX_DMA_BUFFER_MAPPING_FLAG_READ | IMX_DMA_BUFFER_MAPPING_FLAG_WRITE))
+	{
+		IMX_2D_LOG(ERROR, "could not map destination surface");
+		return FALSE;
+	}
+
+	cpu_blitter->dest_region = &(batch->dest.region);
+
+	for (i = 0; ret && (i < batch->num_operations); ++i)
+	{
+		Imx2dCpuOperation *operation = &(batch->operations[i]);
+
+		switch (operation->type)
+		{
+			case IMX_2D_CPU_OPERATION_TYPE_BLIT:
+				ret = run_blit_operation(cpu_blitter, operation);
+				break;
+
+			case IMX_2D_CPU_OPERATION_TYPE_FILL:
+				/* Like the hardware backends, ignore the alpha byte of the fill color. */
+				ret = fill_dest_region(cpu_blitter, &(operation->dest_region), operation->fill_color & 0x00FFFFFF, 255);
+				break;
+
+			default:
+				assert(FALSE);
+		}
+	}
+
+	cpu_blitter->dest_region = NULL;
+	unmap_surface(&(cpu_blitter->dest_mapping));
+
+	return ret;
+}
+
+
+static void free_batches(Imx2dCpuBatch *batch)
+{
+	while (batch != NULL)
+	{
+		Imx2dCpuBatch *next = batch->next;
+		free(batch->operations);
+		free(batch);
+		batch = next;
+	}
+}
+
+
+/* Puts a batch that is no longer needed in the free list.
+ * Must be called with the mutex locked. */
+static void recycle_batch_locked(Imx2dCpuBlitter *cpu_blitter, Imx2dCpuBatch *batch)
+{
+	batch->num_operations = 0;
+	batch->next = cpu_blitter->free_batches;
+	cpu_blitter->free_batches = batch;
+}
+
+
+static void* worker_thread_func(void *data)
+{
+	Imx2dCpuBlitter *cpu_blitter = (Imx2dCpuBlitter *)data;
+
+	pthread_mutex_lock(&(cpu_blitter->mutex));
+
+	while (TRUE)
+	{
+		Imx2dCpuBatch *batch;
+		BOOL ret;
+
+		/* Batches that are still queued when shutting down are run
+		 * anyway, since the caller expects submitted operations
+		 * to be done once the blitter is destroyed. */
+		while ((cpu_blitter->queued_batches_head == NULL) && !cpu_blitter->shutting_down)
+			pthread_cond_wait(&(cpu_blitter->batch_queued_cond), &(cpu_blitter->mutex));
+
+		batch = cpu_blitter->queued_batches_head;
+		if (batch == NULL)
+			break;
+
+		cpu_blitter->queued_batches_head = batch->next;
+		if (cpu_blitter->queued_batches_head == NULL)
+			cpu_blitter->queued_batches_tail = NULL;
+		cpu_blitter->batch_running = TRUE;
+
+		pthread_mutex_unlock(&(cpu_blitter->mutex));
+		ret = run_batch(cpu_blitter, batch);
+		pthread_mutex_lock(&(cpu_blitter->mutex));
+
+		if (!ret)
+			cpu_blitter->submission_failed = TRUE;
+		cpu_blitter->batch_running = FALSE;
+		recycle_batch_locked(cpu_blitter, batch);
+
+		pthread_cond_broadcast(&(cpu_blitter->batch_done_cond));
+	}
+
+	pthread_mutex_unlock(&(cpu_blitter->mutex));
+
+	return NULL;
+}
+
+
+/* Blocks until all submitted batches were run, and returns FALSE if
+ * any of them failed since the last call. Must be called with the
+ * mutex locked. */
+static BOOL wait_for_worker_thread_locked(Imx2dCpuBlitter *cpu_blitter)
+{
+	BOOL ret;
+
+	while ((cpu_blitter->queued_batches_head != NULL) || cpu_blitter->batch_running)
+		pthread_cond_wait(&(cpu_blitter->batch_done_cond), &(cpu_blitter->mutex));
+
+	ret = !cpu_blitter->submission_failed;
+	cpu_blitter->submission_failed = FALSE;
+
+	return ret;
+}
+
+
+static Imx2dCpuOperation* add_operation(Imx2dCpuBlitter *cpu_blitter, Imx2dCpuOperationType type)
+{
+	Imx2dCpuBatch *batch = cpu_blitter->current_batch;
+	Imx2dCpuOperation *operation;
+
+	if (batch == NULL)
+	{
+		IMX_2D_LOG(ERROR, "no sequence was started");
+		return NULL;
+	}
+
+	if (batch->num_operations >= batch->operations_capacity)
+	{
+		int new_capacity = MAX(batch->operations_capacity * 2, 4);
+		Imx2dCpuOperation *operations = realloc(batch->operations, new_capacity * sizeof(Imx2dCpuOperation));
+
+		if (operations == NULL)
+		{
+			IMX_2D_LOG(ERROR, "could not allocate space for %d operation(s)", new_capacity);
+			return NULL;
+		}
+
+		batch->operations = operations;
+		batch->operations_capacity = new_capacity;
+	}
+
+	operation = &(batch->operations[batch->num_operations++]);
+	memset(operation, 0, sizeof(Imx2dCpuOperation));
+	operation->type = type;
+
+	return operation;
+}
+
+
+static void imx_2d_backend_cpu_blitter_destroy(Imx2dBlitter *blitter)
+{
+	Imx2dCpuBlitter *cpu_blitter = (Imx2dCpuBlitter *)blitter;
+	int i;
+
+	assert(blitter != NULL);
+
+	if (cpu_blitter->worker_thread_created)
+	{
+		pthread_mutex_lock(&(cpu_blitter->mutex));
+		cpu_blitter->shutting_down = TRUE;
+		pthread_cond_signal(&(cpu_blitter->batch_queued_cond));
+		pthread_mutex_unlock(&(cpu_blitter->mutex));
+
+		pthread_join(cpu_blitter->worker_thread, NULL);
+	}
+
+	free_batches(cpu_blitter->current_batch);
+	free_batches(cpu_blitter->free_batches);
+
+	pthread_cond_destroy(&(cpu_blitter->batch_done_cond));
+	pthread_cond_destroy(&(cpu_blitter->batch_queued_cond));
+	pthread_mutex_destroy(&(cpu_blitter->mutex));
+
+	for (i = 0; i < cpu_blitter->num_scanlines; ++i)
+	{
+		free(cpu_blitter->scanlines[i].source);
+		free(cpu_blitter->scanlines[i].blit);
+		free(cpu_blitter->scanlines[i].dest);
+	}
+	free(cpu_blitter->scanlines);
+	free(cpu_blitter->coordinate_table);
+
+	free(blitter);
+}
+
+
+static int imx_2d_backend_cpu_blitter_start(Imx2dBlitter *blitter)
+{
+	Imx2dCpuBlitter *cpu_blitter = (Imx2dCpuBlitter *)blitter;
+	Imx2dCpuBatch *batch = cpu_blitter->current_batch;
+
+	assert(blitter != NULL);
+	assert(blitter->dest != NULL);
+
+	/* If a sequence was started but never finished or submitted,
+	 * discard its operations and reuse its batch. */
+	if (batch == NULL)
+	{
+		pthread_mutex_lock(&(cpu_blitter->mutex));
+		batch = cpu_blitter->free_batches;
+		if (batch != NULL)
+			cpu_blitter->free_batches = batch->next;
+		pthread_mutex_unlock(&(cpu_blitter->mutex));
+	}
+
+	if (batch == NULL)
+	{
+		batch = malloc(sizeof(Imx2dCpuBatch));
+		if (batch == NULL)
+		{
+			IMX_2D_LOG(ERROR, "could not allocate batch");
+			return FALSE;
+		}
+
+		memset(batch, 0, sizeof(Imx2dCpuBatch));
+	}
+
+	batch->dest = *(blitter->dest);
+	batch->num_operations = 0;
+	batch->next = NULL;
+
+	cpu_blitter->current_batch = batch;
+
+	return TRUE;
+}
+
+
+static int imx_2d_backend_cpu_blitter_finish(Imx2dBlitter *blitter)
+{
+	Imx2dCpuBlitter *cpu_blitter = (Imx2dCpuBlitter *)blitter;
+	Imx2dCpuBatch *batch = cpu_blitter->current_batch;
+	BOOL ret;
+
+	assert(blitter != NULL);
+
+	if (batch == NULL)
+	{
+		IMX_2D_LOG(ERROR, "no sequence was started");
+		return FALSE;
+	}
+
+	cpu_blitter->current_batch = NULL;
+
+	/* There is nothing to gain from handing the batch over to the
+	 * worker thread if we have to block until it is done anyway,
+	 * so run it here. Earlier submissions have to be done first
+	 * though, since batches must be run in order. Their outcome
+	 * is reported by the next wait / poll call, so do not clear
+	 * the submission_failed flag here. */
+	pthread_mutex_lock(&(cpu_blitter->mutex));
+	while ((cpu_blitter->queued_batches_head != NULL) || cpu_blitter->batch_running)
+		pthread_cond_wait(&(cpu_blitter->batch_done_cond), &(cpu_blitter->mutex));
+	pthread_mutex_unlock(&(cpu_blitter->mutex));
+
+	ret = run_batch(cpu_blitter, batch);
+
+	pthread_mutex_lock(&(cpu_blitter->mutex));
+	recycle_batch_locked(cpu_blitter, batch);
+	pthread_mutex_unlock(&(cpu_blitter->mutex));
+
+	return ret;
+}
+
+
+static int imx_2d_backend_cpu_blitter_submit(Imx2dBlitter *blitter)
+{
+	Imx2dCpuBlitter *cpu_blitter = (Imx2dCpuBlitter *)blitter;
+	Imx2dCpuBatch *batch = cpu_blitter->current_batch;
+
+	assert(blitter != NULL);
+
+	if (batch == NULL)
+	{
+		IMX_2D_LOG(ERROR, "no sequence was started");
+		return FALSE;
+	}
+
+	cpu_blitter->current_batch = NULL;
+
+	if (!cpu_blitter->worker_thread_created)
+	{
+		int error = pthread_create(&(cpu_blitter->worker_thread), NULL, worker_thread_func, cpu_blitter);
+
+		if (error != 0)
+		{
+			IMX_2D_LOG(ERROR, "could not create worker thread: %s (%d); running batch synchronously", strerror(error), error);
+
+			pthread_mutex_lock(&(cpu_blitter->mutex));
+			if (!run_batch(cpu_blitter, batch))
+				cpu_blitter->submission_failed = TRUE;
+			recycle_batch_locked(cpu_blitter, batch);
+			pthread_mutex_unlock(&(cpu_blitter->mutex));
+
+			return TRUE;
+		}
+
+		cpu_blitter->worker_thread_created = TRUE;
+		IMX_2D_LOG(DEBUG, "created CPU blitter worker thread");
+	}
+
+	pthread_mutex_lock(&(cpu_blitter->mutex));
+
+	if (cpu_blitter->queued_batches_tail != NULL)
+		cpu_blitter->queued_batches_tail->next = batch;
+	else
+		cpu_blitter->queued_batches_head = batch;
+	cpu_blitter->queued_batches_tail = batch;
+
+	pthread_cond_signal(&(cpu_blitter->batch_queued_cond));
+
+	pthread_mutex_unlock(&(cpu_blitter->mutex));
+
+	return TRUE;
+}
+
+
+static int imx_2d_backend_cpu_blitter_wait(Imx2dBlitter *blitter)
+{
+	Imx2dCpuBlitter *cpu_blitter = (Imx2dCpuBlitter *)blitter;
+	BOOL ret;
+
+	assert(blitter != NULL);
+
+	pthread_mutex_lock(&(cpu_blitter->mutex));
+	ret = wait_for_worker_thread_locked(cpu_blitter);
+	pthread_mutex_unlock(&(cpu_blitter->mutex));
+
+	return ret;
+}
+
+
+static Imx2dCompletionStatus imx_2d_backend_cpu_blitter_poll(Imx2dBlitter *blitter)
+{
+	Imx2dCpuBlitter *cpu_blitter = (Imx2dCpuBlitter *)blitter;
+	Imx2dCompletionStatus status;
+
+	assert(blitter != NULL);
+
+	pthread_mutex_lock(&(cpu_blitter->mutex));
+
+	if ((cpu_blitter->queued_batches_head != NULL) || cpu_blitter->batch_running)
+		status = IMX_2D_COMPLETION_STATUS_PENDING;
+	else
+		status = wait_for_worker_thread_locked(cpu_blitter) ? IMX_2D_COMPLETION_STATUS_COMPLETED : IMX_2D_COMPLETION_STATUS_FAILED;
+
+	pthread_mutex_unlock(&(cpu_blitter->mutex));
+
+	return status;
+}
+
+
+static int imx_2d_backend_cpu_blitter_do_blit(Imx2dBlitter *blitter, Imx2dInternalBlitParams *internal_blit_params)
+{
+	Imx2dCpuBlitter *cpu_blitter = (Imx2dCpuBlitter *)blitter;
+	Imx2dCpuOperation *operation;
+	Imx2dRegion const *source_region;
+
+	assert(blitter != NULL);
+	assert(blitter->dest != NULL);
+	assert(internal_blit_params != NULL);
+	assert(internal_blit_params->source != NULL);
+
+	operation = add_operation(cpu_blitter, IMX_2D_CPU_OPERATION_TYPE_BLIT);
+	if (operation == NULL)
+		return FALSE;
+
+	operation->source = *(internal_blit_params->source);
+
+	/* Make sure the blit never reads outside of the source surface. */
+	source_region = (internal_blit_params->source_region != NULL) ? internal_blit_params->source_region : &(internal_blit_params->source->region);
+	imx_2d_region_intersect(&(operation->source_region), source_region, &(internal_blit_params->source->region));
+
+	operation->dest_region = (internal_blit_params->dest_region != NULL) ? *(internal_blit_params->dest_region) : blitter->dest->region;
+
+	if (internal_blit_params->expanded_dest_region != NULL)
+	{
+		operation->expanded_dest_region = *(internal_blit_params->expanded_dest_region);
+		operation->has_expanded_dest_region = TRUE;
+	}
+
+	operation->rotation = internal_blit_params->rotation;
+	operation->dest_surface_alpha = internal_blit_params->dest_surface_alpha;
+	operation->fill_color = internal_blit_params->margin_fill_color;
+
+	return TRUE;
+}
+
+
+static int imx_2d_backend_cpu_blitter_fill_region(Imx2dBlitter *blitter, Imx2dInternalFillRegionParams *internal_fill_region_params)
+{
+	Imx2dCpuBlitter *cpu_blitter = (Imx2dCpuBlitter *)blitter;
+	Imx2dCpuOperation *operation;
+
+	assert(blitter != NULL);
+	assert(blitter->dest != NULL);
+	assert(internal_fill_region_params != NULL);
+	assert(internal_fill_region_params->dest_region != NULL);
+
+	operation = add_operation(cpu_blitter, IMX_2D_CPU_OPERATION_TYPE_FILL);
+	if (operation == NULL)
+		return FALSE;
+
+	operation->dest_region = *(internal_fill_region_params->dest_region);
+	operation->fill_color = internal_fill_region_params->fill_color;
+
+	return TRUE;
+}
+
+
+static Imx2dHardwareCapabilities const * imx_2d_backend_cpu_blitter_get_hardware_capabilities(Imx2dBlitter *blitter)
+{
+	IMX_2D_UNUSED_PARAM(blitter);
+	return imx_2d_backend_cpu_get_hardware_capabilities();
+}
+
+
+
+
+Imx2dBlitter* imx_2d_backend_cpu_blitter_create(void)
+{
+	Imx2dCpuBlitter *cpu_blitter;
+
+	cpu_blitter = malloc(sizeof(Imx2dCpuBlitter));
+	assert(cpu_blitter != NULL);
+
+	memset(cpu_blitter, 0, sizeof(Imx2dCpuBlitter));
+
+	cpu_blitter->parent.blitter_class = &imx_2d_backend_cpu_blitter_class;
+
+	pthread_mutex_init(&(cpu_blitter->mutex), NULL);
+	pthread_cond_init(&(cpu_blitter->batch_queued_cond), NULL);
+	pthread_cond_init(&(cpu_blitter->batch_done_cond), NULL);
+
+	return (Imx2dBlitter *)cpu_blitter;
+}
+
+
+void imx_2d_backend_cpu_blitter_set_band_runner(Imx2dBlitter *blitter, Imx2dCpuBlitterRunBandsFunc run_bands_func, int max_num_bands, void *user_data)
+{
+	Imx2dCpuBlitter *cpu_blitter = (Imx2dCpuBlitter *)blitter;
+
+	assert(blitter != NULL);
+	assert(blitter->blitter_class == &imx_2d_backend_cpu_blitter_class);
+	assert((run_bands_func == NULL) || (max_num_bands >= 1));
+
+	cpu_blitter->run_bands_func = run_bands_func;
+	cpu_blitter->max_num_bands = max_num_bands;
+	cpu_blitter->run_bands_user_data = user_data;
+}
+
+
+static Imx2dHardwareCapabilities const capabilities = {
+	.supported_source_pixel_formats = supported_source_pixel_formats,
+	.num_supported_source_pixel_formats = sizeof(supported_source_pixel_formats) / sizeof(Imx2dPixelFormat),
+
+	/* The CPU blitter can write all the formats it can read. */
+	.supported_dest_pixel_formats = supported_source_pixel_formats,
+	.num_supported_dest_pixel_formats = sizeof(supported_source_pixel_formats) / sizeof(Imx2dPixelFormat),
+
+	.min_width = 1, .max_width = INT_MAX, .width_step_size = 1,
+	.min_height = 1, .max_height = INT_MAX, .height_step_size = 1,
+
+	/* The CPU can access pixels at any alignment, so do not
+	 * impose any; this avoids needless frame uploads. */
+	.stride_alignment = 1,
+	.total_row_count_alignment = 1,
+
+	.can_handle_multi_buffer_surfaces = 1
+};
+
+Imx2dHardwareCapabilities const * imx_2d_backend_cpu_get_hardware_capabilities(void)
+{
+	return &capabilities;
+}
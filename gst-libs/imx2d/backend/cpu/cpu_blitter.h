@@ -0,0 +1,119 @@
+/* gstreamer-imx: GStreamer plugins for the i.MX SoCs
+ * Copyright (C) 2026  agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef IMX2D_BACKEND_CPU_BLITTER_H
+#define IMX2D_BACKEND_CPU_BLITTER_H
+
+#include <imx2d/imx2d.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * imx_2d_backend_cpu_blitter_create:
+ *
+ * Creates a new @Imx2dBlitter that performs all operations on the CPU.
+ *
+ * This blitter does not use any 2D hardware. It accesses surface pixels
+ * by mapping their DMA buffers, so it does not need physically contiguous
+ * memory, and works with any DMA buffer that can be mapped (including
+ * ones that are backed by regular heap memory). It is useful as a fallback
+ * when the 2D hardware is busy or not available, and as a reference for
+ * the output of the hardware backends.
+ *
+ * Scaling uses nearest-neighbor sampling. YUV<->RGB conversions use the
+ * BT.601 limited range coefficients. When writing to a destination with
+ * subsampled chroma, chroma values are point sampled. Tiled formats are
+ * not supported.
+ *
+ * To destroy the created blitter, use @imx_2d_blitter_destroy.
+ *
+ * Returns: Pointer to a newly created CPU blitter, or NULL in case of failure.
+ */
+Imx2dBlitter* imx_2d_backend_cpu_blitter_create(void);
+
+/**
+ * Imx2dCpuBlitterBandFunc:
+ * @band_index: Index of the band to process, in the 0 .. (@num_bands - 1) range.
+ * @num_bands: Total number of bands.
+ * @band_data: Pointer to the state of the operation the band belongs to.
+ *
+ * Function that processes one band of rows of a CPU blitter operation.
+ */
+typedef void (*Imx2dCpuBlitterBandFunc)(int band_index, int num_bands, void *band_data);
+
+/**
+ * Imx2dCpuBlitterRunBandsFunc:
+ * @num_bands: Number of bands to process.
+ * @band_func: Function to call for each band.
+ * @band_data: Pointer to pass to @band_func.
+ * @user_data: User defined pointer that was passed to
+ *     @imx_2d_backend_cpu_blitter_set_band_runner.
+ *
+ * Function that calls @band_func once for each band, typically from
+ * multiple threads in parallel. It must only return once all
+ * bands have been processed.
+ */
+typedef void (*Imx2dCpuBlitterRunBandsFunc)(int num_bands, Imx2dCpuBlitterBandFunc band_func, void *band_data, void *user_data);
+
+/**
+ * imx_2d_backend_cpu_blitter_set_band_runner:
+ * @blitter: CPU blitter to set the band runner of.
+ * @run_bands_func: Function for processing bands in parallel,
+ *     or NULL to process everything in one thread.
+ * @max_num_bands: Maximum number of bands to split an operation into.
+ *     This is typically the number of threads that @run_bands_func uses.
+ * @user_data: User defined pointer to pass to @run_bands_func.
+ *
+ * Blits that involve conversion, scaling, rotation, or blending split
+ * the destination rows into up to @max_num_bands bands, and process
+ * these with @run_bands_func. imx2d itself does not create threads for
+ * this purpose; the caller supplies them through @run_bands_func, for
+ * example by using a thread pool. Small blits are split into fewer
+ * bands (or not at all), since the synchronization would then cost
+ * more than the parallelization gains.
+ *
+ * By default, no band runner is set, and all rows are processed
+ * in one thread.
+ *
+ * This must not be called while a sequence is running or while
+ * submitted sequences are not yet completed.
+ */
+void imx_2d_backend_cpu_blitter_set_band_runner(Imx2dBlitter *blitter, Imx2dCpuBlitterRunBandsFunc run_bands_func, int max_num_bands, void *user_data);
+
+/**
+ * imx_2d_backend_cpu_get_hardware_capabilities:
+ *
+ * Returns a const pointer to a static structure that contains
+ * information about the capabilities of the CPU blitter.
+ *
+ * @Returns Const pointer to the @Imx2dHardwareCapabilities structure.
+ *     This structure is static, and does not have to be freed in any way.
+ */
+Imx2dHardwareCapabilities const * imx_2d_backend_cpu_get_hardware_capabilities(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* IMX2D_BACKEND_CPU_BLITTER_H */
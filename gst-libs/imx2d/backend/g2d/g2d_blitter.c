@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
+#include <pthread.h>
 
 #include <g2d.h>
 #include <g2dExt.h>
@@ -12,6 +13,15 @@
 #include "g2d_blitter.h"
 
 
+/* g2d_multi_blit() composes several source surfaces into the dest
+ * surface in one operation. It is not present in older G2D versions,
+ * and not available when G2D is emulated on top of the DPU. */
+#if defined(IMX2D_G2D_HAS_MULTI_BLIT) && !defined(IMX2D_G2D_IMPLEMENTATION_BASED_ON_DPU)
+#define IMX2D_G2D_USE_MULTI_BLIT
+#define IMX2D_G2D_MAX_MULTI_BLIT_LAYERS 8
+#endif
+
+
 /* Disabled YVYU, since there is a bug in G2D - G2D_YUYV and G2D_YVYU
  * actually refer to the same pixel format (G2D_YUYV)
  *
@@ -279,11 +289,44 @@ static BOOL fill_g2d_surfaceEx_info(struct g2d_surfaceEx *g2d_surfaceEx, Imx2dSu
 typedef struct _Imx2dG2DBlitter Imx2dG2DBlitter;
 
 
+#ifndef IMX2D_G2D_IMPLEMENTATION_BASED_ON_DPU
+
+typedef struct _G2DHandleEntry G2DHandleEntry;
+
+
+/* Outside of the DPU emulation, G2D calls have to come from the
+ * thread that opened the handle, and this includes g2d_close().
+ * For this reason, all open G2D handles are tracked in a global
+ * list, along with the thread that owns them. */
+struct _G2DHandleEntry
+{
+	void *handle;
+	pthread_t thread;
+	/* The blitter that currently uses the handle, or NULL if
+	 * the handle is orphaned and only waits for being closed
+	 * by its owning thread. */
+	Imx2dG2DBlitter *blitter;
+	G2DHandleEntry *next;
+};
+
+#endif
+
+
 struct _Imx2dG2DBlitter
 {
 	Imx2dBlitter parent;
 
 	void *g2d_handle;
+#ifndef IMX2D_G2D_IMPLEMENTATION_BASED_ON_DPU
+	/* Entry of g2d_handle in the list of open G2D handles.
+	 * Only accessed with g2d_handle_entries_mutex locked. */
+	G2DHandleEntry *g2d_handle_entry;
+#endif
+
+	/* Set if a G2D call failed during the current sequence.
+	 * The handle is then closed at the end of the sequence,
+	 * and reopened when the next one starts. */
+	BOOL g2d_handle_broken;
 
 	struct g2d_surface fill_g2d_surface;
 	ImxDmaBuffer *fill_g2d_surface_dmabuffer;
@@ -297,7 +340,13 @@ static void imx_2d_backend_g2d_blitter_destroy(Imx2dBlitter *blitter);
 static int imx_2d_backend_g2d_blitter_start(Imx2dBlitter *blitter);
 static int imx_2d_backend_g2d_blitter_finish(Imx2dBlitter *blitter);
 
+static int imx_2d_backend_g2d_blitter_submit(Imx2dBlitter *blitter);
+static int imx_2d_backend_g2d_blitter_wait(Imx2dBlitter *blitter);
+
 static int imx_2d_backend_g2d_blitter_do_blit(Imx2dBlitter *blitter, Imx2dInternalBlitParams *internal_blit_params);
+#ifdef IMX2D_G2D_USE_MULTI_BLIT
+static int imx_2d_backend_g2d_blitter_do_blits(Imx2dBlitter *blitter, int num_blits, Imx2dInternalBlitParams **internal_blit_params);
+#endif
 static int imx_2d_backend_g2d_blitter_fill_region(Imx2dBlitter *blitter, Imx2dInternalFillRegionParams *internal_fill_region_params);
 
 static Imx2dHardwareCapabilities const * imx_2d_backend_g2d_blitter_get_hardware_capabilities(Imx2dBlitter *blitter);
@@ -310,7 +359,16 @@ static Imx2dBlitterClass imx_2d_backend_g2d_blitter_class =
 	imx_2d_backend_g2d_blitter_start,
 	imx_2d_backend_g2d_blitter_finish,
 
+	imx_2d_backend_g2d_blitter_submit,
+	imx_2d_backend_g2d_blitter_wait,
+	NULL,
+
 	imx_2d_backend_g2d_blitter_do_blit,
+#ifdef IMX2D_G2D_USE_MULTI_BLIT
+	imx_2d_backend_g2d_blitter_do_blits,
+#else
+	NULL,
+#endif
 	imx_2d_backend_g2d_blitter_fill_region,
 
 	imx_2d_backend_g2d_blitter_get_hardware_capabilities
@@ -322,31 +380,237 @@ static Imx2dBlitterClass imx_2d_backend_g2d_blitter_class =
  * actually isn't a 2D GPU core. Instead, G2D is emulated via a different
  * subsystem - the DPU, which does not exist in other i.MX8 variants. The
  * DPU behaves somewhat differently than a "real" 2D GPU core. In particular,
- * it does not require all calls to come from the same thread, and its
- * implementations of the g2d_open() and g2d_close() function are slower.
- * therefore, if we are dealing with such a G2D-on-top-of-DPU implementation,
- * we call g2d_open() (and g2d_close()) only once to improve performance.
+ * it does not require all calls to come from the same thread.
+ *
+ * The G2D handle is opened once and kept open for the lifetime of the
+ * blitter, since g2d_open() and g2d_close() are expensive, and calling
+ * them for every frame causes latency spikes. If any G2D call fails, the
+ * handle is closed at the end of the sequence, and reopened by the next one.
+ *
+ * With a "real" 2D GPU core, the handle must also be closed by the thread
+ * that opened it. The handle is reopened if a sequence is started in a
+ * different thread, and blitters are typically destroyed by a thread other
+ * than the streaming thread that used them. In these cases, the handle is
+ * not closed right away. Instead, it is orphaned, and closed by its owning
+ * thread once that thread starts or finishes a sequence with any G2D
+ * blitter, or when that thread exits.
  *
  * This enhances https://github.com/Freescale/gstreamer-imx/pull/282 . */
 
 
 
 
-static void imx_2d_backend_g2d_blitter_destroy(Imx2dBlitter *blitter)
+#ifndef IMX2D_G2D_IMPLEMENTATION_BASED_ON_DPU
+
+static pthread_mutex_t g2d_handle_entries_mutex = PTHREAD_MUTEX_INITIALIZER;
+static G2DHandleEntry *g2d_handle_entries = NULL;
+
+static pthread_once_t g2d_thread_exit_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t g2d_thread_exit_key;
+
+
+static void remove_g2d_handle_entry_unlocked(G2DHandleEntry *entry)
 {
-	Imx2dG2DBlitter *g2d_blitter = (Imx2dG2DBlitter *)blitter;
+	G2DHandleEntry **entry_ptr;
 
-	assert(blitter != NULL);
+	for (entry_ptr = &g2d_handle_entries; *entry_ptr != NULL; entry_ptr = &((*entry_ptr)->next))
+	{
+		if (*entry_ptr == entry)
+		{
+			*entry_ptr = entry->next;
+			break;
+		}
+	}
 
-#ifdef IMX2D_G2D_IMPLEMENTATION_BASED_ON_DPU
-	if (g2d_blitter->g2d_handle != NULL)
+	free(entry);
+}
+
+
+/* Closes the G2D handles that are owned by the calling thread. If
+ * include_in_use is FALSE, only orphaned handles are closed. Must
+ * be called with g2d_handle_entries_mutex locked. */
+static void close_owned_g2d_handles_unlocked(BOOL include_in_use)
+{
+	pthread_t self = pthread_self();
+	G2DHandleEntry **entry_ptr = &g2d_handle_entries;
+
+	while (*entry_ptr != NULL)
+	{
+		G2DHandleEntry *entry = *entry_ptr;
+
+		if (!pthread_equal(entry->thread, self) || (!include_in_use && (entry->blitter != NULL)))
+		{
+			entry_ptr = &(entry->next);
+			continue;
+		}
+
+		IMX_2D_LOG(DEBUG, "closing %s g2d device; handle: %p", (entry->blitter != NULL) ? "in-use" : "orphaned", entry->handle);
+
+		if (g2d_close(entry->handle) != 0)
+			IMX_2D_LOG(ERROR, "closing g2d device failed");
+
+		if (entry->blitter != NULL)
+		{
+			entry->blitter->g2d_handle = NULL;
+			entry->blitter->g2d_handle_entry = NULL;
+			entry->blitter->g2d_handle_broken = FALSE;
+		}
+
+		*entry_ptr = entry->next;
+		free(entry);
+	}
+}
+
+
+static void release_orphaned_g2d_handles(void)
+{
+	pthread_mutex_lock(&g2d_handle_entries_mutex);
+	close_owned_g2d_handles_unlocked(FALSE);
+	pthread_mutex_unlock(&g2d_handle_entries_mutex);
+}
+
+
+/* Called when a thread that opened a G2D handle exits. After
+ * that, nothing can close its handles anymore, so close all
+ * of them, including those that are still in use. */
+static void on_g2d_thread_exit(void *value)
+{
+	IMX_2D_UNUSED_PARAM(value);
+
+	pthread_mutex_lock(&g2d_handle_entries_mutex);
+	close_owned_g2d_handles_unlocked(TRUE);
+	pthread_mutex_unlock(&g2d_handle_entries_mutex);
+}
+
+
+static void create_g2d_thread_exit_key(void)
+{
+	pthread_key_create(&g2d_thread_exit_key, on_g2d_thread_exit);
+}
+
+
+static BOOL is_g2d_handle_owned_by_current_thread(Imx2dG2DBlitter *g2d_blitter)
+{
+	BOOL ret;
+
+	pthread_mutex_lock(&g2d_handle_entries_mutex);
+	ret = (g2d_blitter->g2d_handle_entry == NULL) || pthread_equal(g2d_blitter->g2d_handle_entry->thread, pthread_self());
+	pthread_mutex_unlock(&g2d_handle_entries_mutex);
+
+	return ret;
+}
+
+#endif
+
+
+static BOOL open_g2d_handle(Imx2dG2DBlitter *g2d_blitter)
+{
+#ifndef IMX2D_G2D_IMPLEMENTATION_BASED_ON_DPU
+	G2DHandleEntry *entry;
+#endif
+
+	assert(g2d_blitter->g2d_handle == NULL);
+
+	if (g2d_open(&(g2d_blitter->g2d_handle)) != 0)
+	{
+		IMX_2D_LOG(ERROR, "opening g2d device failed");
+		g2d_blitter->g2d_handle = NULL;
+		return FALSE;
+	}
+
+	if (g2d_make_current(g2d_blitter->g2d_handle, G2D_HARDWARE_2D) != 0)
 	{
+		IMX_2D_LOG(ERROR, "g2d_make_current() failed");
 		if (g2d_close(g2d_blitter->g2d_handle) != 0)
 			IMX_2D_LOG(ERROR, "closing g2d device failed");
 		g2d_blitter->g2d_handle = NULL;
+		return FALSE;
+	}
+
+#ifndef IMX2D_G2D_IMPLEMENTATION_BASED_ON_DPU
+	/* Make sure the handles of this thread are closed when it exits.
+	 * The key's value only needs to be non-NULL for that to happen. */
+	pthread_once(&g2d_thread_exit_key_once, create_g2d_thread_exit_key);
+	pthread_setspecific(g2d_thread_exit_key, &g2d_handle_entries);
+
+	entry = malloc(sizeof(G2DHandleEntry));
+	assert(entry != NULL);
+
+	entry->handle = g2d_blitter->g2d_handle;
+	entry->thread = pthread_self();
+	entry->blitter = g2d_blitter;
+
+	pthread_mutex_lock(&g2d_handle_entries_mutex);
+	entry->next = g2d_handle_entries;
+	g2d_handle_entries = entry;
+	g2d_blitter->g2d_handle_entry = entry;
+	pthread_mutex_unlock(&g2d_handle_entries_mutex);
+#endif
+
+	g2d_blitter->g2d_handle_broken = FALSE;
+
+	IMX_2D_LOG(DEBUG, "opened g2d device; handle: %p", g2d_blitter->g2d_handle);
+
+	return TRUE;
+}
+
+
+static void close_g2d_handle(Imx2dG2DBlitter *g2d_blitter)
+{
+#ifdef IMX2D_G2D_IMPLEMENTATION_BASED_ON_DPU
+	if (g2d_blitter->g2d_handle == NULL)
+		return;
+
+	IMX_2D_LOG(DEBUG, "closing g2d device; handle: %p", g2d_blitter->g2d_handle);
+
+	if (g2d_close(g2d_blitter->g2d_handle) != 0)
+		IMX_2D_LOG(ERROR, "closing g2d device failed");
+#else
+	G2DHandleEntry *entry;
+
+	pthread_mutex_lock(&g2d_handle_entries_mutex);
+
+	/* The entry may already be gone if the owning
+	 * thread exited and closed the handle by itself. */
+	entry = g2d_blitter->g2d_handle_entry;
+	if (entry != NULL)
+	{
+		if (pthread_equal(entry->thread, pthread_self()))
+		{
+			IMX_2D_LOG(DEBUG, "closing g2d device; handle: %p", entry->handle);
+
+			if (g2d_close(entry->handle) != 0)
+				IMX_2D_LOG(ERROR, "closing g2d device failed");
+
+			remove_g2d_handle_entry_unlocked(entry);
+		}
+		else
+		{
+			IMX_2D_LOG(DEBUG, "g2d handle %p is owned by a different thread; orphaning it so that its owner closes it", entry->handle);
+			entry->blitter = NULL;
+		}
 	}
+
+	g2d_blitter->g2d_handle_entry = NULL;
+
+	pthread_mutex_unlock(&g2d_handle_entries_mutex);
 #endif
 
+	g2d_blitter->g2d_handle = NULL;
+	g2d_blitter->g2d_handle_broken = FALSE;
+}
+
+
+
+
+static void imx_2d_backend_g2d_blitter_destroy(Imx2dBlitter *blitter)
+{
+	Imx2dG2DBlitter *g2d_blitter = (Imx2dG2DBlitter *)blitter;
+
+	assert(blitter != NULL);
+
+	close_g2d_handle(g2d_blitter);
+
 	if (g2d_blitter->fill_g2d_surface_dmabuffer != NULL)
 	{
 		IMX_2D_LOG(DEBUG, "destroying G2D fill surface DMA buffer %p", (void *)(g2d_blitter->fill_g2d_surface_dmabuffer));
@@ -367,53 +631,111 @@ static int imx_2d_backend_g2d_blitter_start(Imx2dBlitter *blitter)
 {
 	Imx2dG2DBlitter *g2d_blitter = (Imx2dG2DBlitter *)blitter;
 
-#ifdef IMX2D_G2D_IMPLEMENTATION_BASED_ON_DPU
+	assert(blitter != NULL);
+
+#ifndef IMX2D_G2D_IMPLEMENTATION_BASED_ON_DPU
+	release_orphaned_g2d_handles();
+
+	if (!is_g2d_handle_owned_by_current_thread(g2d_blitter))
+	{
+		IMX_2D_LOG(DEBUG, "sequence started in a thread other than the one the g2d handle was opened in; reopening handle");
+		close_g2d_handle(g2d_blitter);
+	}
+#endif
+
+	if (g2d_blitter->g2d_handle == NULL)
+		return open_g2d_handle(g2d_blitter);
+	else
+		return TRUE;
+}
+
+
+static int imx_2d_backend_g2d_blitter_finish(Imx2dBlitter *blitter)
+{
+	Imx2dG2DBlitter *g2d_blitter = (Imx2dG2DBlitter *)blitter;
+	int ret = TRUE;
+
+	assert(blitter != NULL);
+
 	if (g2d_blitter->g2d_handle == NULL)
+	{
+		IMX_2D_LOG(ERROR, "no g2d handle present; cannot finish sequence");
+		return FALSE;
+	}
+
+#ifndef IMX2D_G2D_IMPLEMENTATION_BASED_ON_DPU
+	/* When G2D is emulated on top of the DPU, g2d_finish() is
+	 * called after every blit, so it is only needed here when
+	 * a "real" 2D GPU core is used. */
+	if (g2d_finish(g2d_blitter->g2d_handle) != 0)
+	{
+		IMX_2D_LOG(ERROR, "g2d_finish() failed");
+		g2d_blitter->g2d_handle_broken = TRUE;
+		ret = FALSE;
+	}
 #endif
+
+	if (g2d_blitter->g2d_handle_broken)
 	{
-		if (g2d_open(&(g2d_blitter->g2d_handle)) != 0)
-		{
-			IMX_2D_LOG(ERROR, "opening g2d device failed");
-			return FALSE;
-		}
+		IMX_2D_LOG(DEBUG, "g2d error occurred during this sequence; closing handle so it gets reopened in the next sequence");
+		close_g2d_handle(g2d_blitter);
 	}
 
-	if (g2d_make_current(g2d_blitter->g2d_handle, G2D_HARDWARE_2D) != 0)
+#ifndef IMX2D_G2D_IMPLEMENTATION_BASED_ON_DPU
+	/* Handles that were orphaned by other threads while
+	 * this sequence was running can be closed here. */
+	release_orphaned_g2d_handles();
+#endif
+
+	return ret;
+}
+
+
+static int imx_2d_backend_g2d_blitter_submit(Imx2dBlitter *blitter)
+{
+	Imx2dG2DBlitter *g2d_blitter = (Imx2dG2DBlitter *)blitter;
+
+	assert(blitter != NULL);
+
+	if (g2d_blitter->g2d_handle == NULL)
 	{
-		IMX_2D_LOG(ERROR, "g2d_make_current() failed");
-		if (g2d_close(g2d_blitter->g2d_handle) != 0)
-			IMX_2D_LOG(ERROR, "closing g2d device failed");
-		g2d_blitter->g2d_handle = NULL;
+		IMX_2D_LOG(ERROR, "no g2d handle present; cannot submit sequence");
+		return FALSE;
+	}
+
+	/* A broken handle has to be closed, which implies waiting.
+	 * Report failure; imx2d then calls wait(), which does that. */
+	if (g2d_blitter->g2d_handle_broken)
+		return FALSE;
+
+#ifndef IMX2D_G2D_IMPLEMENTATION_BASED_ON_DPU
+	/* g2d_flush() hands the queued operations over to the
+	 * GPU without waiting for them to be completed. The
+	 * actual waiting is then done by g2d_finish() in wait(). */
+	if (g2d_flush(g2d_blitter->g2d_handle) != 0)
+	{
+		IMX_2D_LOG(ERROR, "g2d_flush() failed");
+		g2d_blitter->g2d_handle_broken = TRUE;
 		return FALSE;
 	}
+#endif
 
 	return TRUE;
 }
 
 
-static int imx_2d_backend_g2d_blitter_finish(Imx2dBlitter *blitter)
+static int imx_2d_backend_g2d_blitter_wait(Imx2dBlitter *blitter)
 {
-#ifdef IMX2D_G2D_IMPLEMENTATION_BASED_ON_DPU
-	/* When G2D is emulated on top of the DPU, g2d_finish() is
-	 * called after every blit. And, we can't call g2d_close()
-	 * here, because the DPU-emulated version of that function
-	 * is slow. (It is called in destroy().) So, when the
-	 * DPU-based emulation is used, do nothing here. */
-	IMX_2D_UNUSED_PARAM(blitter);
-	return TRUE;
-#else
 	Imx2dG2DBlitter *g2d_blitter = (Imx2dG2DBlitter *)blitter;
-	int ret;
 
 	assert(blitter != NULL);
 
-	ret = (g2d_finish(g2d_blitter->g2d_handle) == 0);
-
-	if (g2d_close(g2d_blitter->g2d_handle) != 0)
-		IMX_2D_LOG(ERROR, "closing g2d device failed");
+	/* If there is no handle, then it was closed in finish() or
+	 * in an earlier wait(), which already waited for the GPU. */
+	if (g2d_blitter->g2d_handle == NULL)
+		return TRUE;
 
-	return ret;
-#endif
+	return imx_2d_backend_g2d_blitter_finish(blitter);
 }
 
 
@@ -497,6 +819,7 @@ static int imx_2d_backend_g2d_blitter_do_blit(Imx2dBlitter *blitter, Imx2dIntern
 			if (g2d_clear(g2d_blitter->g2d_handle, &(g2d_blitter->fill_g2d_surface)) != 0)
 			{
 				IMX_2D_LOG(ERROR, "could not fill margin");
+				g2d_blitter->g2d_handle_broken = TRUE;
 				return FALSE;
 			}
 
@@ -570,6 +893,7 @@ static int imx_2d_backend_g2d_blitter_do_blit(Imx2dBlitter *blitter, Imx2dIntern
 				if (g2d_clear(g2d_blitter->g2d_handle, &margin_g2d_surf) != 0)
 				{
 					IMX_2D_LOG(ERROR, "could not fill margin");
+					g2d_blitter->g2d_handle_broken = TRUE;
 					return FALSE;
 				}
 			}
@@ -580,6 +904,7 @@ static int imx_2d_backend_g2d_blitter_do_blit(Imx2dBlitter *blitter, Imx2dIntern
 				if (g2d_blit(g2d_blitter->g2d_handle, &(g2d_blitter->fill_g2d_surface), &margin_g2d_surf) != 0)
 				{
 					IMX_2D_LOG(ERROR, "could not blit fill surface - drawing margin failed");
+					g2d_blitter->g2d_handle_broken = TRUE;
 					return FALSE;
 				}
 			}
@@ -633,6 +958,7 @@ static int imx_2d_backend_g2d_blitter_do_blit(Imx2dBlitter *blitter, Imx2dIntern
 	if (g2d_ret != 0)
 	{
 		IMX_2D_LOG(ERROR, "could not blit surface");
+		g2d_blitter->g2d_handle_broken = TRUE;
 		return FALSE;
 	}
 	else
@@ -640,6 +966,130 @@ static int imx_2d_backend_g2d_blitter_do_blit(Imx2dBlitter *blitter, Imx2dIntern
 }
 
 
+#ifdef IMX2D_G2D_USE_MULTI_BLIT
+
+static BOOL can_use_multi_blit(Imx2dInternalBlitParams const *internal_blit_params)
+{
+	Imx2dPixelFormatInfo const *fmt_info;
+	enum g2d_format g2d_format;
+	Imx2dSurfaceDesc const *desc = imx_2d_surface_get_desc(internal_blit_params->source);
+
+	/* Only plain opaque blits are combined. Margins, rotation and
+	 * blending require per-blit G2D state, and tiled formats can
+	 * only be handled by g2d_blitEx(). */
+
+	if ((internal_blit_params->expanded_dest_region != NULL)
+	 || (internal_blit_params->rotation != IMX_2D_ROTATION_NONE)
+	 || (internal_blit_params->dest_surface_alpha != 255))
+		return FALSE;
+
+	fmt_info = imx_2d_get_pixel_format_info(desc->format);
+	if ((fmt_info == NULL) || fmt_info->is_tiled)
+		return FALSE;
+
+	if (!get_g2d_format(desc->format, &g2d_format) || g2d_format_has_alpha(g2d_format))
+		return FALSE;
+
+	return TRUE;
+}
+
+
+static BOOL submit_multi_blit_layers(Imx2dG2DBlitter *g2d_blitter, struct g2d_surface_pair **surface_pairs, int num_layers)
+{
+	if (num_layers == 0)
+		return TRUE;
+
+	IMX_2D_LOG(TRACE, "blitting %d layer(s) with g2d_multi_blit()", num_layers);
+
+	g2d_disable(g2d_blitter->g2d_handle, G2D_BLEND);
+	g2d_disable(g2d_blitter->g2d_handle, G2D_GLOBAL_ALPHA);
+
+	if (g2d_multi_blit(g2d_blitter->g2d_handle, surface_pairs, num_layers) != 0)
+	{
+		IMX_2D_LOG(ERROR, "could not blit %d layer(s) with g2d_multi_blit()", num_layers);
+		g2d_blitter->g2d_handle_broken = TRUE;
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+
+static int imx_2d_backend_g2d_blitter_do_blits(Imx2dBlitter *blitter, int num_blits, Imx2dInternalBlitParams **internal_blit_params)
+{
+	int i;
+	int num_layers = 0;
+	Imx2dG2DBlitter *g2d_blitter = (Imx2dG2DBlitter *)blitter;
+	struct g2d_surface g2d_dest_surf;
+	struct g2d_surface_pair surface_pairs[IMX2D_G2D_MAX_MULTI_BLIT_LAYERS];
+	struct g2d_surface_pair *surface_pair_ptrs[IMX2D_G2D_MAX_MULTI_BLIT_LAYERS];
+
+	assert(blitter != NULL);
+	assert(blitter->dest != NULL);
+	assert(internal_blit_params != NULL);
+
+	assert(g2d_blitter->g2d_handle != NULL);
+
+	if (!fill_g2d_surface_info(&g2d_dest_surf, blitter->dest))
+		return FALSE;
+
+	g2d_dest_surf.rot = G2D_ROTATION_0;
+	g2d_dest_surf.blendfunc = G2D_ZERO;
+	g2d_dest_surf.global_alpha = 0;
+	g2d_dest_surf.clrcolor = 0xFF000000;
+
+	for (i = 0; i < IMX2D_G2D_MAX_MULTI_BLIT_LAYERS; ++i)
+		surface_pair_ptrs[i] = &(surface_pairs[i]);
+
+	for (i = 0; i < num_blits; ++i)
+	{
+		struct g2d_surface_pair *surface_pair;
+		Imx2dInternalBlitParams *params = internal_blit_params[i];
+
+		if (!can_use_multi_blit(params))
+		{
+			/* The blits must be performed in order, so submit
+			 * the layers collected so far before this one. */
+			if (!submit_multi_blit_layers(g2d_blitter, surface_pair_ptrs, num_layers))
+				return FALSE;
+			num_layers = 0;
+
+			if (!imx_2d_backend_g2d_blitter_do_blit(blitter, params))
+				return FALSE;
+
+			continue;
+		}
+
+		surface_pair = &(surface_pairs[num_layers]);
+
+		if (!fill_g2d_surface_info(&(surface_pair->s), params->source))
+			return FALSE;
+		memcpy(&(surface_pair->d), &g2d_dest_surf, sizeof(struct g2d_surface));
+
+		copy_region_to_g2d_surface(&(surface_pair->s), params->source, params->source_region);
+		copy_region_to_g2d_surface(&(surface_pair->d), blitter->dest, params->dest_region);
+
+		surface_pair->s.rot = G2D_ROTATION_0;
+		surface_pair->s.blendfunc = G2D_ONE;
+		surface_pair->s.global_alpha = 0;
+		surface_pair->s.clrcolor = 0xFF000000;
+
+		num_layers++;
+
+		if (num_layers == IMX2D_G2D_MAX_MULTI_BLIT_LAYERS)
+		{
+			if (!submit_multi_blit_layers(g2d_blitter, surface_pair_ptrs, num_layers))
+				return FALSE;
+			num_layers = 0;
+		}
+	}
+
+	return submit_multi_blit_layers(g2d_blitter, surface_pair_ptrs, num_layers);
+}
+
+#endif
+
+
 static int imx_2d_backend_g2d_blitter_fill_region(Imx2dBlitter *blitter, Imx2dInternalFillRegionParams *internal_fill_region_params)
 {
 	Imx2dG2DBlitter *g2d_blitter = (Imx2dG2DBlitter *)blitter;
@@ -669,6 +1119,7 @@ static int imx_2d_backend_g2d_blitter_fill_region(Imx2dBlitter *blitter, Imx2dIn
 	if (g2d_clear(g2d_blitter->g2d_handle, &g2d_dest_surf) != 0)
 	{
 		IMX_2D_LOG(ERROR, "could not clear area");
+		g2d_blitter->g2d_handle_broken = TRUE;
 		return FALSE;
 	}
 	else
@@ -168,7 +168,12 @@ static Imx2dBlitterClass imx_2d_backend_ipu_blitter_class =
 	imx_2d_backend_ipu_blitter_start,
 	imx_2d_backend_ipu_blitter_finish,
 
+	NULL,
+	NULL,
+	NULL,
+
 	imx_2d_backend_ipu_blitter_do_blit,
+	NULL,
 	imx_2d_backend_ipu_blitter_fill_region,
 
 	imx_2d_backend_ipu_blitter_get_hardware_capabilities
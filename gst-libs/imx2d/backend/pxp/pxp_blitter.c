@@ -112,6 +112,11 @@ struct _Imx2dPxPBlitter
 	struct pxp_config_data pxp_config;
 	struct pxp_chan_handle pxp_channel;
 	BOOL pxp_channel_requested;
+
+	/* Set if an operation was started on the PxP channel and
+	 * was not waited for yet. The wait is deferred until the
+	 * channel is needed again, or until the sequence ends. */
+	BOOL pxp_operation_pending;
 };
 
 
@@ -120,6 +125,9 @@ static void imx_2d_backend_pxp_blitter_destroy(Imx2dBlitter *blitter);
 static int imx_2d_backend_pxp_blitter_start(Imx2dBlitter *blitter);
 static int imx_2d_backend_pxp_blitter_finish(Imx2dBlitter *blitter);
 
+static int imx_2d_backend_pxp_blitter_submit(Imx2dBlitter *blitter);
+static int imx_2d_backend_pxp_blitter_wait(Imx2dBlitter *blitter);
+
 static int imx_2d_backend_pxp_blitter_do_blit(Imx2dBlitter *blitter, Imx2dInternalBlitParams *internal_blit_params);
 static int imx_2d_backend_pxp_blitter_fill_region(Imx2dBlitter *blitter, Imx2dInternalFillRegionParams *internal_fill_region_params);
 
@@ -133,13 +141,63 @@ static Imx2dBlitterClass imx_2d_backend_pxp_blitter_class =
 	imx_2d_backend_pxp_blitter_start,
 	imx_2d_backend_pxp_blitter_finish,
 
+	imx_2d_backend_pxp_blitter_submit,
+	imx_2d_backend_pxp_blitter_wait,
+	NULL,
+
 	imx_2d_backend_pxp_blitter_do_blit,
+	NULL,
 	imx_2d_backend_pxp_blitter_fill_region,
 
 	imx_2d_backend_pxp_blitter_get_hardware_capabilities
 };
 
 
+static BOOL wait_for_pending_pxp_operation(Imx2dPxPBlitter *pxp_blitter)
+{
+	if (!pxp_blitter->pxp_operation_pending)
+		return TRUE;
+
+	pxp_blitter->pxp_operation_pending = FALSE;
+
+	if (ioctl(pxp_blitter->pxp_fd, PXP_IOC_WAIT4CMPLT, &(pxp_blitter->pxp_channel)) != 0)
+	{
+		IMX_2D_LOG(ERROR, "could not wait for PxP channel completion: %s", strerror(errno));
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+
+static BOOL start_pxp_operation(Imx2dPxPBlitter *pxp_blitter)
+{
+	/* The PxP channel can only run one operation at a time,
+	 * so wait for the previous one before configuring the
+	 * channel again. */
+	if (!wait_for_pending_pxp_operation(pxp_blitter))
+		return FALSE;
+
+	if (ioctl(pxp_blitter->pxp_fd, PXP_IOC_CONFIG_CHAN, &(pxp_blitter->pxp_config)) != 0)
+	{
+		IMX_2D_LOG(ERROR, "could not configure PxP channel: %s", strerror(errno));
+		return FALSE;
+	}
+
+	if (ioctl(pxp_blitter->pxp_fd, PXP_IOC_START_CHAN, &(pxp_blitter->pxp_channel.handle)) != 0)
+	{
+		IMX_2D_LOG(ERROR, "could not start PxP channel: %s", strerror(errno));
+		return FALSE;
+	}
+
+	pxp_blitter->pxp_operation_pending = TRUE;
+
+	return TRUE;
+}
+
+
+
+
 static void imx_2d_backend_pxp_blitter_destroy(Imx2dBlitter *blitter)
 {
 	Imx2dPxPBlitter *pxp_blitter = (Imx2dPxPBlitter *)blitter;
@@ -149,6 +207,7 @@ static void imx_2d_backend_pxp_blitter_destroy(Imx2dBlitter *blitter)
 	if (pxp_blitter->pxp_channel_requested)
 	{
 		assert(pxp_blitter->pxp_fd > 0);
+		wait_for_pending_pxp_operation(pxp_blitter);
 		ioctl(pxp_blitter->pxp_fd, PXP_IOC_PUT_CHAN, &(pxp_blitter->pxp_channel.handle));
 		pxp_blitter->pxp_channel_requested = FALSE;
 	}
@@ -222,11 +281,30 @@ static int imx_2d_backend_pxp_blitter_start(Imx2dBlitter *blitter)
 
 static int imx_2d_backend_pxp_blitter_finish(Imx2dBlitter *blitter)
 {
+	Imx2dPxPBlitter *pxp_blitter = (Imx2dPxPBlitter *)blitter;
+	assert(blitter != NULL);
+	return wait_for_pending_pxp_operation(pxp_blitter);
+}
+
+
+static int imx_2d_backend_pxp_blitter_submit(Imx2dBlitter *blitter)
+{
+	/* The last operation of the sequence was already started
+	 * in do_blit() / fill_region(), and the wait for it is
+	 * deferred to wait(), so there is nothing left to do here. */
 	IMX_2D_UNUSED_PARAM(blitter);
 	return TRUE;
 }
 
 
+static int imx_2d_backend_pxp_blitter_wait(Imx2dBlitter *blitter)
+{
+	Imx2dPxPBlitter *pxp_blitter = (Imx2dPxPBlitter *)blitter;
+	assert(blitter != NULL);
+	return wait_for_pending_pxp_operation(pxp_blitter);
+}
+
+
 static int imx_2d_backend_pxp_blitter_do_blit(Imx2dBlitter *blitter, Imx2dInternalBlitParams *internal_blit_params)
 {
 	Imx2dPxPBlitter *pxp_blitter = (Imx2dPxPBlitter *)blitter;
@@ -360,25 +438,7 @@ static int imx_2d_backend_pxp_blitter_do_blit(Imx2dBlitter *blitter, Imx2dIntern
 	}
 	src_param->pixel_fmt = pxp_format;
 
-	if (ioctl(pxp_blitter->pxp_fd, PXP_IOC_CONFIG_CHAN, pconf) != 0)
-	{
-		IMX_2D_LOG(ERROR, "could not configure PxP channel: %s", strerror(errno));
-		return FALSE;
-	}
-
-	if (ioctl(pxp_blitter->pxp_fd, PXP_IOC_START_CHAN, &(pxp_blitter->pxp_channel.handle)) != 0)
-	{
-		IMX_2D_LOG(ERROR, "could not start PxP channel: %s", strerror(errno));
-		return FALSE;
-	}
-
-	if (ioctl(pxp_blitter->pxp_fd, PXP_IOC_WAIT4CMPLT, &(pxp_blitter->pxp_channel)) != 0)
-	{
-		IMX_2D_LOG(ERROR, "could not wait for PxP channel completion: %s", strerror(errno));
-		return FALSE;
-	}
-
-	return TRUE;
+	return start_pxp_operation(pxp_blitter);
 }
 
 
@@ -406,25 +466,7 @@ static int imx_2d_backend_pxp_blitter_fill_region(Imx2dBlitter *blitter, Imx2dIn
 	pconf->proc_data.bgcolor = internal_fill_region_params->fill_color;
 	pconf->proc_data.fill_en = 1;
 
-	if (ioctl(pxp_blitter->pxp_fd, PXP_IOC_CONFIG_CHAN, pconf) != 0)
-	{
-		IMX_2D_LOG(ERROR, "could not configure PxP channel: %s", strerror(errno));
-		return FALSE;
-	}
-
-	if (ioctl(pxp_blitter->pxp_fd, PXP_IOC_START_CHAN, &(pxp_blitter->pxp_channel.handle)) != 0)
-	{
-		IMX_2D_LOG(ERROR, "could not start PxP channel: %s", strerror(errno));
-		return FALSE;
-	}
-
-	if (ioctl(pxp_blitter->pxp_fd, PXP_IOC_WAIT4CMPLT, &(pxp_blitter->pxp_channel)) != 0)
-	{
-		IMX_2D_LOG(ERROR, "could not wait for PxP channel completion: %s", strerror(errno));
-		return FALSE;
-	}
-
-	return TRUE;
+	return start_pxp_operation(pxp_blitter);
 }
 
 
@@ -272,27 +272,157 @@ Imx2dRegion const * imx_2d_surface_get_region(Imx2dSurface *surface)
 void imx_2d_blitter_destroy(Imx2dBlitter *blitter)
 {
 	assert((blitter != NULL) && (blitter->blitter_class != NULL) && (blitter->blitter_class->destroy != NULL));
+
+	free(blitter->prepared_blits);
+	free(blitter->pending_blit_params);
+
 	blitter->blitter_class->destroy(blitter);
 }
 
 
+/* Marks all tokens that were submitted but not yet completed as
+ * completed, with the given result. */
+static void complete_submitted_tokens(Imx2dBlitter *blitter, int success)
+{
+	if (!success)
+	{
+		/* Extend the failed range if it directly precedes the newly
+		 * failed tokens. Otherwise, start a new range. */
+		if (blitter->last_failed_token != blitter->last_completed_token)
+			blitter->last_good_token = blitter->last_completed_token;
+		blitter->last_failed_token = blitter->last_submitted_token;
+	}
+
+	blitter->last_completed_token = blitter->last_submitted_token;
+}
+
+
+/* Must only be called with tokens that are completed. */
+static int check_if_token_failed(Imx2dBlitter *blitter, Imx2dCompletionToken token)
+{
+	return (token > blitter->last_good_token) && (token <= blitter->last_failed_token);
+}
+
+
 int imx_2d_blitter_start(Imx2dBlitter *blitter, Imx2dSurface *dest)
 {
 	assert((blitter != NULL) && (blitter->blitter_class != NULL) && (blitter->blitter_class->start != NULL));
 	assert(dest != NULL);
 	blitter->dest = dest;
+	blitter->clip_region = dest->region;
 	return blitter->blitter_class->start(blitter);
 }
 
 
 int imx_2d_blitter_finish(Imx2dBlitter *blitter)
 {
-	assert((blitter != NULL) && (blitter->blitter_class != NULL) && (blitter->blitter_class->start != NULL));
-	return blitter->blitter_class->finish(blitter);
+	int ret;
+
+	assert((blitter != NULL) && (blitter->blitter_class != NULL) && (blitter->blitter_class->finish != NULL));
+
+	ret = blitter->blitter_class->finish(blitter);
+
+	/* finish() blocks until all queued operations are done,
+	 * and this includes any earlier submissions. */
+	complete_submitted_tokens(blitter, ret);
+
+	return ret;
 }
 
 
-int imx_2d_blitter_do_blit(Imx2dBlitter *blitter, Imx2dSurface *source, Imx2dBlitParams const *params)
+int imx_2d_blitter_submit(Imx2dBlitter *blitter, Imx2dCompletionToken *token)
+{
+	int ret;
+
+	assert((blitter != NULL) && (blitter->blitter_class != NULL) && (blitter->blitter_class->finish != NULL));
+	assert(token != NULL);
+
+	blitter->last_submitted_token++;
+	*token = blitter->last_submitted_token;
+
+	if (blitter->blitter_class->submit != NULL)
+	{
+		assert(blitter->blitter_class->wait != NULL);
+
+		ret = blitter->blitter_class->submit(blitter);
+		IMX_2D_LOG(TRACE, "submitted sequence with token %" PRIu64 "; success: %d", *token, ret);
+
+		if (!ret)
+		{
+			/* Wait for anything that may have been queued already
+			 * to make sure that nothing is still running once
+			 * the caller sees the failure. */
+			blitter->blitter_class->wait(blitter);
+			complete_submitted_tokens(blitter, FALSE);
+		}
+	}
+	else
+	{
+		/* The backend cannot run operations asynchronously,
+		 * so finish the sequence right away. The submission
+		 * is then immediately completed. */
+		ret = blitter->blitter_class->finish(blitter);
+		IMX_2D_LOG(TRACE, "backend has no asynchronous submission support; finished sequence with token %" PRIu64 " immediately; success: %d", *token, ret);
+		complete_submitted_tokens(blitter, ret);
+	}
+
+	return ret;
+}
+
+
+int imx_2d_blitter_wait(Imx2dBlitter *blitter, Imx2dCompletionToken token)
+{
+	int ret;
+
+	assert(blitter != NULL);
+	assert(token <= blitter->last_submitted_token);
+
+	if (token <= blitter->last_completed_token)
+		return !check_if_token_failed(blitter, token);
+
+	assert((blitter->blitter_class != NULL) && (blitter->blitter_class->wait != NULL));
+
+	IMX_2D_LOG(TRACE, "waiting for sequence with token %" PRIu64 " (last submitted token: %" PRIu64 ")", token, blitter->last_submitted_token);
+
+	/* Backends process submissions in order and can only wait
+	 * for everything that was submitted so far, so the wait
+	 * also completes any later submissions. */
+	ret = blitter->blitter_class->wait(blitter);
+	complete_submitted_tokens(blitter, ret);
+
+	return ret;
+}
+
+
+Imx2dCompletionStatus imx_2d_blitter_poll(Imx2dBlitter *blitter, Imx2dCompletionToken token)
+{
+	Imx2dCompletionStatus status;
+
+	assert(blitter != NULL);
+	assert(token <= blitter->last_submitted_token);
+
+	if (token <= blitter->last_completed_token)
+		return check_if_token_failed(blitter, token) ? IMX_2D_COMPLETION_STATUS_FAILED : IMX_2D_COMPLETION_STATUS_COMPLETED;
+
+	assert(blitter->blitter_class != NULL);
+
+	if (blitter->blitter_class->poll == NULL)
+		return IMX_2D_COMPLETION_STATUS_PENDING;
+
+	status = blitter->blitter_class->poll(blitter);
+	if (status != IMX_2D_COMPLETION_STATUS_PENDING)
+	{
+		complete_submitted_tokens(blitter, status != IMX_2D_COMPLETION_STATUS_FAILED);
+	}
+
+	return status;
+}
+
+
+/* Validates the blit parameters and clips the regions against the
+ * dest surface. The result is either nothing to do, a fill (when only
+ * the margin is visible), or a blit with the internal parameters. */
+static int prepare_blit(Imx2dBlitter *blitter, Imx2dSurface *source, Imx2dBlitParams const *params, Imx2dPreparedBlit *prepared_blit)
 {
 	static Imx2dBlitParams const default_params =
 	{
@@ -303,8 +433,20 @@ int imx_2d_blitter_do_blit(Imx2dBlitter *blitter, Imx2dSurface *source, Imx2dBli
 	};
 
 	Imx2dBlitParams const *params_in_use = (params != NULL) ? params : &default_params;
+	Imx2dRegion const *clip_region = &(blitter->clip_region);
+	Imx2dBlitParams params_with_dest_region;
 
-	assert((blitter != NULL) && (blitter->blitter_class != NULL) && (blitter->blitter_class->do_blit != NULL));
+	prepared_blit->type = IMX_2D_PREPARED_BLIT_TYPE_NONE;
+
+	/* Without a dest region, the entire dest surface is the dest region.
+	 * If a clip region is set that is smaller than the dest surface, the
+	 * blit must be clipped, so use the dest surface region explicitly. */
+	if ((params_in_use->dest_region == NULL) && !imx_2d_region_check_if_equal(clip_region, &(blitter->dest->region)))
+	{
+		params_with_dest_region = *params_in_use;
+		params_with_dest_region.dest_region = &(blitter->dest->region);
+		params_in_use = &params_with_dest_region;
+	}
 
 	if (params_in_use->alpha == 0)
 	{
@@ -332,7 +474,6 @@ int imx_2d_blitter_do_blit(Imx2dBlitter *blitter, Imx2dSurface *source, Imx2dBli
 		Imx2dRegionInclusion dest_region_inclusion = IMX_2D_REGION_INCLUSION_FULL;
 		Imx2dRegion const *expanded_dest_region_to_use = NULL;
 		Imx2dRegion full_expanded_dest_region;
-		Imx2dRegion clipped_expanded_dest_region;
 		uint32_t margin_fill_color = 0x00000000;
 
 		/* Get the margin and look at its alpha value. If it is 0,
@@ -395,7 +536,7 @@ int imx_2d_blitter_do_blit(Imx2dBlitter *blitter, Imx2dSurface *source, Imx2dBli
 
 			expanded_dest_region_inclusion = imx_2d_region_check_inclusion(
 				&full_expanded_dest_region,
-				&(blitter->dest->region)
+				clip_region
 			);
 
 			IMX_2D_LOG(TRACE, "margin defined; expanded dest region: %" IMX_2D_REGION_FORMAT, IMX_2D_REGION_ARGS(&full_expanded_dest_region));
@@ -408,7 +549,7 @@ int imx_2d_blitter_do_blit(Imx2dBlitter *blitter, Imx2dSurface *source, Imx2dBli
 					 * dest surface, then we can exit right away, since then,
 					 * neither the margin nor the actual dest region can
 					 * possibly be visible, so there is nothing to blit. */
-					IMX_2D_LOG(TRACE, "expanded dest region is fully outside of the dest surface bounds; skipping blitter operation");
+					IMX_2D_LOG(TRACE, "expanded dest region is fully outside of the clip region bounds; skipping blitter operation");
 					return TRUE;
 				}
 
@@ -418,9 +559,10 @@ int imx_2d_blitter_do_blit(Imx2dBlitter *blitter, Imx2dSurface *source, Imx2dBli
 					 * surface, this implies that the original dest region is too.
 					 * Therefore, set dest_region_inclusion to "full" to let
 					 * the rest of the code know that no more checks are needed. */
-					IMX_2D_LOG(TRACE, "expanded dest region is fully inside of the dest surface bounds");
+					IMX_2D_LOG(TRACE, "expanded dest region is fully inside of the clip region bounds");
 					dest_region_inclusion = IMX_2D_REGION_INCLUSION_FULL;
-					expanded_dest_region_to_use = &full_expanded_dest_region;
+					prepared_blit->expanded_dest_region = full_expanded_dest_region;
+					expanded_dest_region_to_use = &(prepared_blit->expanded_dest_region);
 					break;
 				}
 
@@ -429,19 +571,19 @@ int imx_2d_blitter_do_blit(Imx2dBlitter *blitter, Imx2dSurface *source, Imx2dBli
 					 * dest region, and also clip the expanded dest region against
 					 * the dest surface. */
 
-					IMX_2D_LOG(TRACE, "expanded dest region is partially inside of the dest surface bounds");
+					IMX_2D_LOG(TRACE, "expanded dest region is partially inside of the clip region bounds");
 
 					dest_region_inclusion = imx_2d_region_check_inclusion(
 						params_in_use->dest_region,
-						&(blitter->dest->region)
+						clip_region
 					);
 
 					imx_2d_region_intersect(
-						&clipped_expanded_dest_region,
+						&(prepared_blit->expanded_dest_region),
 						&full_expanded_dest_region,
-						&(blitter->dest->region)
+						clip_region
 					);
-					expanded_dest_region_to_use = &clipped_expanded_dest_region;
+					expanded_dest_region_to_use = &(prepared_blit->expanded_dest_region);
 
 					break;
 
@@ -454,7 +596,7 @@ int imx_2d_blitter_do_blit(Imx2dBlitter *blitter, Imx2dSurface *source, Imx2dBli
 			IMX_2D_LOG(TRACE, "no margin defined");
 			dest_region_inclusion = imx_2d_region_check_inclusion(
 				params_in_use->dest_region,
-				&(blitter->dest->region)
+				clip_region
 			);
 		}
 
@@ -469,26 +611,23 @@ int imx_2d_blitter_do_blit(Imx2dBlitter *blitter, Imx2dSurface *source, Imx2dBli
 			case IMX_2D_REGION_INCLUSION_NONE:
 				if (margin != NULL)
 				{
-					Imx2dInternalFillRegionParams params =
-					{
-						expanded_dest_region_to_use,
-						margin_fill_color
-					};
+					IMX_2D_LOG(TRACE, "dest region is fully outside of the clip region bounds, but margin is visible; skipping blitter operation, filling margin");
 
-					IMX_2D_LOG(TRACE, "dest region is fully outside of the dest surface bounds, but margin is visible; skipping blitter operation, filling margin");
-
-					return blitter->blitter_class->fill_region(blitter, &params);
+					prepared_blit->type = IMX_2D_PREPARED_BLIT_TYPE_FILL;
+					prepared_blit->fill_params.dest_region = expanded_dest_region_to_use;
+					prepared_blit->fill_params.fill_color = margin_fill_color;
+					return TRUE;
 				}
 				else
 				{
-					IMX_2D_LOG(TRACE, "dest region is fully outside of the dest surface bounds; skipping blitter operation");
+					IMX_2D_LOG(TRACE, "dest region is fully outside of the clip region bounds; skipping blitter operation");
 					return TRUE;
 				}
 				break;
 
 			case IMX_2D_REGION_INCLUSION_FULL:
 			{
-				Imx2dInternalBlitParams params =
+				Imx2dInternalBlitParams internal_blit_params =
 				{
 					source, params_in_use->source_region,
 					params_in_use->dest_region,
@@ -500,8 +639,10 @@ int imx_2d_blitter_do_blit(Imx2dBlitter *blitter, Imx2dSurface *source, Imx2dBli
 
 				/* We can blit with zero adjustments, since the dest
 				 * region is fully inside the dest surface. */
-				IMX_2D_LOG(TRACE, "dest region is fully inside of the dest surface bounds");
-				return blitter->blitter_class->do_blit(blitter, &params);
+				IMX_2D_LOG(TRACE, "dest region is fully inside of the clip region bounds");
+				prepared_blit->type = IMX_2D_PREPARED_BLIT_TYPE_BLIT;
+				prepared_blit->blit_params = internal_blit_params;
+				return TRUE;
 			}
 
 			case IMX_2D_REGION_INCLUSION_PARTIAL:
@@ -513,8 +654,8 @@ int imx_2d_blitter_do_blit(Imx2dBlitter *blitter, Imx2dSurface *source, Imx2dBli
 
 				Imx2dRegion const *source_region = (params_in_use->source_region != NULL) ? params_in_use->source_region : &(source->region);
 				Imx2dRegion const *dest_region = params_in_use->dest_region;
-				Imx2dRegion clipped_source_region;
-				Imx2dRegion clipped_dest_region;
+				Imx2dRegion *clipped_source_region = &(prepared_blit->clipped_source_region);
+				Imx2dRegion *clipped_dest_region = &(prepared_blit->clipped_dest_region);
 
 				int source_region_width = source_region->x2 - source_region->x1;
 				int source_region_height = source_region->y2 - source_region->y1;
@@ -522,126 +663,128 @@ int imx_2d_blitter_do_blit(Imx2dBlitter *blitter, Imx2dSurface *source, Imx2dBli
 				int dest_region_height = dest_region->y2 - dest_region->y1;
 
 				imx_2d_region_intersect(
-					&clipped_dest_region,
+					clipped_dest_region,
 					dest_region,
-					&(blitter->dest->region)
+					clip_region
 				);
 
-				memcpy(&clipped_source_region, source_region, sizeof(Imx2dRegion));
+				memcpy(clipped_source_region, source_region, sizeof(Imx2dRegion));
 
 				switch (params_in_use->rotation)
 				{
 					case IMX_2D_ROTATION_NONE:
-						if (dest_region->x1 < 0)
-							clipped_source_region.x1 += source_region_width * (-dest_region->x1) / dest_region_width;
-						if (dest_region->y1 < 0)
-							clipped_source_region.y1 += source_region_height * (-dest_region->y1) / dest_region_height;
-						if (dest_region->x2 > blitter->dest->region.x2)
-							clipped_source_region.x2 -= source_region_width * (dest_region->x2 - blitter->dest->region.x2) / dest_region_width;
-						if (dest_region->y2 > blitter->dest->region.y2)
-							clipped_source_region.y2 -= source_region_height * (dest_region->y2 - blitter->dest->region.y2) / dest_region_height;
+						if (dest_region->x1 < clip_region->x1)
+							clipped_source_region->x1 += source_region_width * (clip_region->x1 - dest_region->x1) / dest_region_width;
+						if (dest_region->y1 < clip_region->y1)
+							clipped_source_region->y1 += source_region_height * (clip_region->y1 - dest_region->y1) / dest_region_height;
+						if (dest_region->x2 > clip_region->x2)
+							clipped_source_region->x2 -= source_region_width * (dest_region->x2 - clip_region->x2) / dest_region_width;
+						if (dest_region->y2 > clip_region->y2)
+							clipped_source_region->y2 -= source_region_height * (dest_region->y2 - clip_region->y2) / dest_region_height;
 						break;
 
 					case IMX_2D_ROTATION_90:
-						if (dest_region->x1 < 0)
-							clipped_source_region.y2 -= source_region_height * (-dest_region->x1) / dest_region_width;
-						if (dest_region->y1 < 0)
-							clipped_source_region.x1 += source_region_width * (-dest_region->y1) / dest_region_height;
-						if (dest_region->x2 > blitter->dest->region.x2)
-							clipped_source_region.y1 += source_region_height * (dest_region->x2 - blitter->dest->region.x2) / dest_region_width;
-						if (dest_region->y2 > blitter->dest->region.y2)
-							clipped_source_region.x2 -= source_region_width * (dest_region->y2 - blitter->dest->region.y2) / dest_region_height;
+						if (dest_region->x1 < clip_region->x1)
+							clipped_source_region->y2 -= source_region_height * (clip_region->x1 - dest_region->x1) / dest_region_width;
+						if (dest_region->y1 < clip_region->y1)
+							clipped_source_region->x1 += source_region_width * (clip_region->y1 - dest_region->y1) / dest_region_height;
+						if (dest_region->x2 > clip_region->x2)
+							clipped_source_region->y1 += source_region_height * (dest_region->x2 - clip_region->x2) / dest_region_width;
+						if (dest_region->y2 > clip_region->y2)
+							clipped_source_region->x2 -= source_region_width * (dest_region->y2 - clip_region->y2) / dest_region_height;
 						break;
 
 					case IMX_2D_ROTATION_180:
-						if (dest_region->x1 < 0)
-							clipped_source_region.x2 -= source_region_width * (-dest_region->x1) / dest_region_width;
-						if (dest_region->y1 < 0)
-							clipped_source_region.y2 -= source_region_height * (-dest_region->y1) / dest_region_height;
-						if (dest_region->x2 > blitter->dest->region.x2)
-							clipped_source_region.x1 += source_region_width * (dest_region->x2 - blitter->dest->region.x2) / dest_region_width;
-						if (dest_region->y2 > blitter->dest->region.y2)
-							clipped_source_region.y1 += source_region_height * (dest_region->y2 - blitter->dest->region.y2) / dest_region_height;
+						if (dest_region->x1 < clip_region->x1)
+							clipped_source_region->x2 -= source_region_width * (clip_region->x1 - dest_region->x1) / dest_region_width;
+						if (dest_region->y1 < clip_region->y1)
+							clipped_source_region->y2 -= source_region_height * (clip_region->y1 - dest_region->y1) / dest_region_height;
+						if (dest_region->x2 > clip_region->x2)
+							clipped_source_region->x1 += source_region_width * (dest_region->x2 - clip_region->x2) / dest_region_width;
+						if (dest_region->y2 > clip_region->y2)
+							clipped_source_region->y1 += source_region_height * (dest_region->y2 - clip_region->y2) / dest_region_height;
 						break;
 
 					case IMX_2D_ROTATION_270:
-						if (dest_region->x1 < 0)
-							clipped_source_region.y1 += source_region_height * (-dest_region->x1) / dest_region_width;
-						if (dest_region->y1 < 0)
-							clipped_source_region.x2 -= source_region_width * (-dest_region->y1) / dest_region_height;
-						if (dest_region->x2 > blitter->dest->region.x2)
-							clipped_source_region.y2 -= source_region_height * (dest_region->x2 - blitter->dest->region.x2) / dest_region_width;
-						if (dest_region->y2 > blitter->dest->region.y2)
-							clipped_source_region.x1 += source_region_width * (dest_region->y2 - blitter->dest->region.y2) / dest_region_height;
+						if (dest_region->x1 < clip_region->x1)
+							clipped_source_region->y1 += source_region_height * (clip_region->x1 - dest_region->x1) / dest_region_width;
+						if (dest_region->y1 < clip_region->y1)
+							clipped_source_region->x2 -= source_region_width * (clip_region->y1 - dest_region->y1) / dest_region_height;
+						if (dest_region->x2 > clip_region->x2)
+							clipped_source_region->y2 -= source_region_height * (dest_region->x2 - clip_region->x2) / dest_region_width;
+						if (dest_region->y2 > clip_region->y2)
+							clipped_source_region->x1 += source_region_width * (dest_region->y2 - clip_region->y2) / dest_region_height;
 						break;
 
 					case IMX_2D_ROTATION_FLIP_HORIZONTAL:
-						if (dest_region->x1 < 0)
-							clipped_source_region.x2 -= source_region_width * (-dest_region->x1) / dest_region_width;
-						if (dest_region->y1 < 0)
-							clipped_source_region.y1 += source_region_height * (-dest_region->y1) / dest_region_height;
-						if (dest_region->x2 > blitter->dest->region.x2)
-							clipped_source_region.x1 += source_region_width * (dest_region->x2 - blitter->dest->region.x2) / dest_region_width;
-						if (dest_region->y2 > blitter->dest->region.y2)
-							clipped_source_region.y2 -= source_region_height * (dest_region->y2 - blitter->dest->region.y2) / dest_region_height;
+						if (dest_region->x1 < clip_region->x1)
+							clipped_source_region->x2 -= source_region_width * (clip_region->x1 - dest_region->x1) / dest_region_width;
+						if (dest_region->y1 < clip_region->y1)
+							clipped_source_region->y1 += source_region_height * (clip_region->y1 - dest_region->y1) / dest_region_height;
+						if (dest_region->x2 > clip_region->x2)
+							clipped_source_region->x1 += source_region_width * (dest_region->x2 - clip_region->x2) / dest_region_width;
+						if (dest_region->y2 > clip_region->y2)
+							clipped_source_region->y2 -= source_region_height * (dest_region->y2 - clip_region->y2) / dest_region_height;
 						break;
 
 					case IMX_2D_ROTATION_FLIP_VERTICAL:
-						if (dest_region->x1 < 0)
-							clipped_source_region.x1 += source_region_width * (-dest_region->x1) / dest_region_width;
-						if (dest_region->y1 < 0)
-							clipped_source_region.y2 -= source_region_height * (-dest_region->y1) / dest_region_height;
-						if (dest_region->x2 > blitter->dest->region.x2)
-							clipped_source_region.x2 -= source_region_width * (dest_region->x2 - blitter->dest->region.x2) / dest_region_width;
-						if (dest_region->y2 > blitter->dest->region.y2)
-							clipped_source_region.y1 += source_region_height * (dest_region->y2 - blitter->dest->region.y2) / dest_region_height;
+						if (dest_region->x1 < clip_region->x1)
+							clipped_source_region->x1 += source_region_width * (clip_region->x1 - dest_region->x1) / dest_region_width;
+						if (dest_region->y1 < clip_region->y1)
+							clipped_source_region->y2 -= source_region_height * (clip_region->y1 - dest_region->y1) / dest_region_height;
+						if (dest_region->x2 > clip_region->x2)
+							clipped_source_region->x2 -= source_region_width * (dest_region->x2 - clip_region->x2) / dest_region_width;
+						if (dest_region->y2 > clip_region->y2)
+							clipped_source_region->y1 += source_region_height * (dest_region->y2 - clip_region->y2) / dest_region_height;
 						break;
 
 					case IMX_2D_ROTATION_UL_LR:
-						if (dest_region->x1 < 0)
-							clipped_source_region.y1 += source_region_height * (-dest_region->x1) / dest_region_width;
-						if (dest_region->y1 < 0)
-							clipped_source_region.x1 += source_region_width * (-dest_region->y1) / dest_region_height;
-						if (dest_region->x2 > blitter->dest->region.x2)
-							clipped_source_region.y2 -= source_region_height * (dest_region->x2 - blitter->dest->region.x2) / dest_region_width;
-						if (dest_region->y2 > blitter->dest->region.y2)
-							clipped_source_region.x2 -= source_region_width * (dest_region->y2 - blitter->dest->region.y2) / dest_region_height;
+						if (dest_region->x1 < clip_region->x1)
+							clipped_source_region->y1 += source_region_height * (clip_region->x1 - dest_region->x1) / dest_region_width;
+						if (dest_region->y1 < clip_region->y1)
+							clipped_source_region->x1 += source_region_width * (clip_region->y1 - dest_region->y1) / dest_region_height;
+						if (dest_region->x2 > clip_region->x2)
+							clipped_source_region->y2 -= source_region_height * (dest_region->x2 - clip_region->x2) / dest_region_width;
+						if (dest_region->y2 > clip_region->y2)
+							clipped_source_region->x2 -= source_region_width * (dest_region->y2 - clip_region->y2) / dest_region_height;
 						break;
 
 					case IMX_2D_ROTATION_UR_LL:
-						if (dest_region->x1 < 0)
-							clipped_source_region.y2 -= source_region_height * (-dest_region->x1) / dest_region_width;
-						if (dest_region->y1 < 0)
-							clipped_source_region.x2 -= source_region_width * (-dest_region->y1) / dest_region_height;
-						if (dest_region->x2 > blitter->dest->region.x2)
-							clipped_source_region.y1 += source_region_height * (dest_region->x2 - blitter->dest->region.x2) / dest_region_width;
-						if (dest_region->y2 > blitter->dest->region.y2)
-							clipped_source_region.x1 += source_region_width * (dest_region->y2 - blitter->dest->region.y2) / dest_region_height;
+						if (dest_region->x1 < clip_region->x1)
+							clipped_source_region->y2 -= source_region_height * (clip_region->x1 - dest_region->x1) / dest_region_width;
+						if (dest_region->y1 < clip_region->y1)
+							clipped_source_region->x2 -= source_region_width * (clip_region->y1 - dest_region->y1) / dest_region_height;
+						if (dest_region->x2 > clip_region->x2)
+							clipped_source_region->y1 += source_region_height * (dest_region->x2 - clip_region->x2) / dest_region_width;
+						if (dest_region->y2 > clip_region->y2)
+							clipped_source_region->x1 += source_region_width * (dest_region->y2 - clip_region->y2) / dest_region_height;
 						break;
 
 					default:
 						assert(FALSE);
 				}
 
-				IMX_2D_LOG(TRACE, "dest region is partially inside of the dest surface bounds");
+				IMX_2D_LOG(TRACE, "dest region is partially inside of the clip region bounds");
 				IMX_2D_LOG(
 					TRACE,
 					"clipped source region: %" IMX_2D_REGION_FORMAT " clipped dest region: %" IMX_2D_REGION_FORMAT,
-					IMX_2D_REGION_ARGS(&clipped_source_region),
-					IMX_2D_REGION_ARGS(&clipped_dest_region)
+					IMX_2D_REGION_ARGS(clipped_source_region),
+					IMX_2D_REGION_ARGS(clipped_dest_region)
 				);
 
 				{
-					Imx2dInternalBlitParams params =
+					Imx2dInternalBlitParams internal_blit_params =
 					{
-						source, &clipped_source_region,
-						&clipped_dest_region,
+						source, clipped_source_region,
+						clipped_dest_region,
 						params_in_use->rotation,
 						expanded_dest_region_to_use,
 						params_in_use->alpha,
 						margin_fill_color
 					};
-					return blitter->blitter_class->do_blit(blitter, &params);
+					prepared_blit->type = IMX_2D_PREPARED_BLIT_TYPE_BLIT;
+					prepared_blit->blit_params = internal_blit_params;
+					return TRUE;
 				}
 			}
 
@@ -660,10 +803,10 @@ int imx_2d_blitter_do_blit(Imx2dBlitter *blitter, Imx2dSurface *source, Imx2dBli
 		 * of the dest region is implied. No need to calculate
 		 * inclusions, intersections etc. */
 
-		Imx2dInternalBlitParams params =
+		Imx2dInternalBlitParams internal_blit_params =
 		{
 			source, params_in_use->source_region,
-			&(blitter->dest->region),
+			clip_region,
 			params_in_use->rotation,
 			NULL,
 			params_in_use->alpha,
@@ -671,19 +814,173 @@ int imx_2d_blitter_do_blit(Imx2dBlitter *blitter, Imx2dSurface *source, Imx2dBli
 			0x00000000
 		};
 
-		return blitter->blitter_class->do_blit(blitter, &params);
+		prepared_blit->type = IMX_2D_PREPARED_BLIT_TYPE_BLIT;
+		prepared_blit->blit_params = internal_blit_params;
+		return TRUE;
+	}
+}
+
+
+static int execute_prepared_blit(Imx2dBlitter *blitter, Imx2dPreparedBlit *prepared_blit)
+{
+	switch (prepared_blit->type)
+	{
+		case IMX_2D_PREPARED_BLIT_TYPE_NONE:
+			return TRUE;
+
+		case IMX_2D_PREPARED_BLIT_TYPE_FILL:
+			return blitter->blitter_class->fill_region(blitter, &(prepared_blit->fill_params));
+
+		case IMX_2D_PREPARED_BLIT_TYPE_BLIT:
+			return blitter->blitter_class->do_blit(blitter, &(prepared_blit->blit_params));
+
+		default:
+			assert(FALSE);
+			return FALSE;
 	}
 }
 
 
+static int ensure_prepared_blits_capacity(Imx2dBlitter *blitter, int num_blits)
+{
+	Imx2dPreparedBlit *prepared_blits;
+	Imx2dInternalBlitParams **pending_blit_params;
+
+	if (num_blits <= blitter->prepared_blits_capacity)
+		return TRUE;
+
+	prepared_blits = realloc(blitter->prepared_blits, num_blits * sizeof(Imx2dPreparedBlit));
+	if (prepared_blits == NULL)
+		goto error;
+	blitter->prepared_blits = prepared_blits;
+
+	pending_blit_params = realloc(blitter->pending_blit_params, num_blits * sizeof(Imx2dInternalBlitParams *));
+	if (pending_blit_params == NULL)
+		goto error;
+	blitter->pending_blit_params = pending_blit_params;
+
+	blitter->prepared_blits_capacity = num_blits;
+
+	return TRUE;
+
+error:
+	IMX_2D_LOG(ERROR, "could not allocate memory for %d batched blits", num_blits);
+	return FALSE;
+}
+
+
+int imx_2d_blitter_do_blit(Imx2dBlitter *blitter, Imx2dSurface *source, Imx2dBlitParams const *params)
+{
+	Imx2dPreparedBlit prepared_blit;
+
+	assert((blitter != NULL) && (blitter->blitter_class != NULL) && (blitter->blitter_class->do_blit != NULL));
+
+	if (!prepare_blit(blitter, source, params, &prepared_blit))
+		return FALSE;
+
+	return execute_prepared_blit(blitter, &prepared_blit);
+}
+
+
+int imx_2d_blitter_do_blits(Imx2dBlitter *blitter, int num_blits, Imx2dSurface **sources, Imx2dBlitParams const *params)
+{
+	int i;
+	int num_pending_blits = 0;
+
+	assert((blitter != NULL) && (blitter->blitter_class != NULL) && (blitter->blitter_class->do_blit != NULL));
+	assert(num_blits >= 0);
+	assert((num_blits == 0) || (sources != NULL));
+
+	/* Without a backend specific batch implementation, there is
+	 * nothing to gain from preparing all blits first, so just
+	 * perform them one by one. */
+	if (blitter->blitter_class->do_blits == NULL)
+	{
+		for (i = 0; i < num_blits; ++i)
+		{
+			if (!imx_2d_blitter_do_blit(blitter, sources[i], (params != NULL) ? &(params[i]) : NULL))
+				return FALSE;
+		}
+
+		return TRUE;
+	}
+
+	if (!ensure_prepared_blits_capacity(blitter, num_blits))
+		return FALSE;
+
+	/* Consecutive blits are collected and passed to the backend in
+	 * one do_blits() call. Fills must not be reordered relative to
+	 * the blits, so pending blits are flushed before each fill. */
+	for (i = 0; i < num_blits; ++i)
+	{
+		Imx2dPreparedBlit *prepared_blit = &(blitter->prepared_blits[i]);
+
+		if (!prepare_blit(blitter, sources[i], (params != NULL) ? &(params[i]) : NULL, prepared_blit))
+			return FALSE;
+
+		switch (prepared_blit->type)
+		{
+			case IMX_2D_PREPARED_BLIT_TYPE_NONE:
+				break;
+
+			case IMX_2D_PREPARED_BLIT_TYPE_FILL:
+				IMX_2D_LOG(TRACE, "fill required; flushing %d pending blit(s) first", num_pending_blits);
+				if ((num_pending_blits > 0) && !blitter->blitter_class->do_blits(blitter, num_pending_blits, blitter->pending_blit_params))
+					return FALSE;
+				num_pending_blits = 0;
+
+				if (!execute_prepared_blit(blitter, prepared_blit))
+					return FALSE;
+				break;
+
+			case IMX_2D_PREPARED_BLIT_TYPE_BLIT:
+				blitter->pending_blit_params[num_pending_blits++] = &(prepared_blit->blit_params);
+				break;
+
+			default:
+				assert(FALSE);
+		}
+	}
+
+	if (num_pending_blits > 0)
+		return blitter->blitter_class->do_blits(blitter, num_pending_blits, blitter->pending_blit_params);
+	else
+		return TRUE;
+}
+
+
 int imx_2d_blitter_fill_region(Imx2dBlitter *blitter, Imx2dRegion const *dest_region, uint32_t fill_color)
 {
+	Imx2dRegion clipped_dest_region;
+
 	assert((blitter != NULL) && (blitter->blitter_class != NULL) && (blitter->blitter_class->fill_region != NULL));
 
+	if (dest_region == NULL)
+	{
+		dest_region = &(blitter->clip_region);
+	}
+	else
+	{
+		switch (imx_2d_region_check_inclusion(dest_region, &(blitter->clip_region)))
+		{
+			case IMX_2D_REGION_INCLUSION_NONE:
+				IMX_2D_LOG(TRACE, "fill region is fully outside of the clip region; skipping fill operation");
+				return TRUE;
+
+			case IMX_2D_REGION_INCLUSION_PARTIAL:
+				imx_2d_region_intersect(&clipped_dest_region, dest_region, &(blitter->clip_region));
+				dest_region = &clipped_dest_region;
+				break;
+
+			default:
+				break;
+		}
+	}
+
 	{
 		Imx2dInternalFillRegionParams params =
 		{
-			(dest_region != NULL) ? dest_region : &(blitter->dest->region),
+			dest_region,
 			fill_color
 		};
 
@@ -692,6 +989,31 @@ int imx_2d_blitter_fill_region(Imx2dBlitter *blitter, Imx2dRegion const *dest_re
 }
 
 
+int imx_2d_blitter_set_clip_region(Imx2dBlitter *blitter, Imx2dRegion const *clip_region)
+{
+	assert(blitter != NULL);
+	assert(blitter->dest != NULL);
+
+	if (clip_region == NULL)
+	{
+		blitter->clip_region = blitter->dest->region;
+		return TRUE;
+	}
+
+	if (imx_2d_region_check_inclusion(clip_region, &(blitter->dest->region)) == IMX_2D_REGION_INCLUSION_NONE)
+	{
+		IMX_2D_LOG(ERROR, "clip region %" IMX_2D_REGION_FORMAT " is fully outside of the dest surface", IMX_2D_REGION_ARGS(clip_region));
+		return FALSE;
+	}
+
+	imx_2d_region_intersect(&(blitter->clip_region), clip_region, &(blitter->dest->region));
+
+	IMX_2D_LOG(TRACE, "set clip region to %" IMX_2D_REGION_FORMAT, IMX_2D_REGION_ARGS(&(blitter->clip_region)));
+
+	return TRUE;
+}
+
+
 Imx2dHardwareCapabilities const * imx_2d_blitter_get_hardware_capabilities(Imx2dBlitter *blitter)
 {
 	assert((blitter != NULL) && (blitter->blitter_class != NULL) && (blitter->blitter_class->get_hardware_capabilities != NULL));
@@ -632,6 +632,40 @@ typedef struct _Imx2dBlitMargin Imx2dBlitMargin;
 typedef struct _Imx2dBlitParams Imx2dBlitParams;
 
 
+/**
+ * Imx2dCompletionToken:
+ *
+ * Token that identifies a sequence of blitter operations that was
+ * submitted with @imx_2d_blitter_submit. It is passed to
+ * @imx_2d_blitter_wait and @imx_2d_blitter_poll to wait for / check
+ * the completion of that sequence.
+ *
+ * Tokens are monotonically increasing per blitter. Since blitters
+ * execute submitted sequences in order, the completion of a sequence
+ * implies the completion of all sequences submitted before it.
+ * The value 0 is never used for an actual submission, and is
+ * always considered to be completed.
+ */
+typedef uint64_t Imx2dCompletionToken;
+
+
+/**
+ * Imx2dCompletionStatus:
+ * @IMX_2D_COMPLETION_STATUS_PENDING: The submitted operations may still be running.
+ * @IMX_2D_COMPLETION_STATUS_COMPLETED: The submitted operations are done.
+ * @IMX_2D_COMPLETION_STATUS_FAILED: The submitted operations failed.
+ *
+ * Status of a submitted sequence, as returned by @imx_2d_blitter_poll.
+ */
+typedef enum
+{
+	IMX_2D_COMPLETION_STATUS_PENDING = 0,
+	IMX_2D_COMPLETION_STATUS_COMPLETED,
+	IMX_2D_COMPLETION_STATUS_FAILED
+}
+Imx2dCompletionStatus;
+
+
 /**
  * Imx2dBlitter:
  *
@@ -727,7 +761,7 @@ void imx_2d_blitter_destroy(Imx2dBlitter *blitter);
  * Starts a sequence of blitter operations.
  *
  * This must be called before any @imx_2d_blitter_do_blit,
- * @imx_2d_blitter_fill_region or @imx_2d_blitter_finish calls.
+ * @imx_2d_blitter_do_blits, @imx_2d_blitter_fill_region or @imx_2d_blitter_finish calls.
  *
  * If this is called again after a sequence was already started,
  * this function does nothing and returns nonzero.
@@ -746,8 +780,13 @@ void imx_2d_blitter_destroy(Imx2dBlitter *blitter);
  *
  * - @imx_2d_blitter_start
  * - @imx_2d_blitter_finish
+ * - @imx_2d_blitter_submit
+ * - @imx_2d_blitter_wait
+ * - @imx_2d_blitter_poll
  * - @imx_2d_blitter_do_blit
+ * - @imx_2d_blitter_do_blits
  * - @imx_2d_blitter_fill_region
+ * - @imx_2d_blitter_set_clip_region
  *
  * This limitation is present in some underlying APIs such as G2D.
  *
@@ -774,6 +813,77 @@ int imx_2d_blitter_start(Imx2dBlitter *blitter, Imx2dSurface *dest);
  */
 int imx_2d_blitter_finish(Imx2dBlitter *blitter);
 
+/**
+ * imx_2d_blitter_submit:
+ * @blitter: Blitter to use.
+ * @token: Pointer to a token that will be set to identify the
+ *     submitted sequence. Must not be NULL.
+ *
+ * Ends the current sequence like @imx_2d_blitter_finish does, except
+ * that it does not block until the queued operations are done. Instead,
+ * the operations are handed over to the hardware, and @token is set
+ * to a value that identifies this submission. The caller can then do
+ * other work (including starting a new sequence) and later call
+ * @imx_2d_blitter_wait or @imx_2d_blitter_poll with that token.
+ *
+ * The destination surface and all source surfaces that were used
+ * in the submitted sequence (as well as their DMA buffers) must
+ * continue to exist until the submission is completed.
+ *
+ * Blitters whose underlying API cannot run operations asynchronously
+ * perform all work right in this call. The token is then immediately
+ * completed.
+ *
+ * A sequence must have been started with @imx_2d_blitter_start
+ * prior to this call, otherwise it will fail.
+ *
+ * See @imx_2d_blitter_start for an important note about calling
+ * this from a particular thread.
+ *
+ * Returns: Nonzero if the call succeeds, zero on failure.
+ */
+int imx_2d_blitter_submit(Imx2dBlitter *blitter, Imx2dCompletionToken *token);
+
+/**
+ * imx_2d_blitter_wait:
+ * @blitter: Blitter to use.
+ * @token: Token of the submission to wait for.
+ *
+ * Blocks until the submission identified by @token is completed.
+ * If it already is completed, this returns immediately.
+ *
+ * Blitters wait for all outstanding submissions at once, and only get
+ * one result for all of them. If that result is a failure, all of the
+ * submissions that completed in that wait are considered failed. The
+ * blitter remembers the most recent consecutive range of failed tokens;
+ * tokens that failed before an earlier successful completion are only
+ * reported as failed as long as no newer failure happened.
+ *
+ * See @imx_2d_blitter_start for an important note about calling
+ * this from a particular thread.
+ *
+ * Returns: Nonzero if the submitted operations completed successfully,
+ *     zero if they failed.
+ */
+int imx_2d_blitter_wait(Imx2dBlitter *blitter, Imx2dCompletionToken token);
+
+/**
+ * imx_2d_blitter_poll:
+ * @blitter: Blitter to use.
+ * @token: Token of the submission to check.
+ *
+ * Checks if the submission identified by @token is completed,
+ * without blocking. Not all blitters can determine this without
+ * blocking; these report @IMX_2D_COMPLETION_STATUS_PENDING until
+ * @imx_2d_blitter_wait is called.
+ *
+ * See @imx_2d_blitter_start for an important note about calling
+ * this from a particular thread.
+ *
+ * Returns: Completion status of the submission.
+ */
+Imx2dCompletionStatus imx_2d_blitter_poll(Imx2dBlitter *blitter, Imx2dCompletionToken token);
+
 /**
  * imx_2d_blitter_do_blit:
  * @blitter: Blitter to use.
@@ -819,6 +929,38 @@ int imx_2d_blitter_finish(Imx2dBlitter *blitter);
  */
 int imx_2d_blitter_do_blit(Imx2dBlitter *blitter, Imx2dSurface *source, Imx2dBlitParams const *params);
 
+/**
+ * imx_2d_blitter_do_blits:
+ * @blitter: Blitter to use.
+ * @num_blits: Number of blits to perform.
+ * @sources: Array of @num_blits surfaces to blit pixels from.
+ * @params: Optional array of @num_blits blitter parameters.
+ *     NULL sets default ones for all blits.
+ *
+ * Performs multiple blits, in the order given by the arrays. The
+ * result is the same as calling @imx_2d_blitter_do_blit for each
+ * entry in @sources and @params, but some blitters can submit such
+ * batches to the hardware more efficiently. For example, the G2D
+ * blitter can combine several blits into one multi-layer blit.
+ * Blitters that do not have such a mechanism perform the blits
+ * one by one.
+ *
+ * The same rules as in @imx_2d_blitter_do_blit apply to each blit.
+ * In particular, the source surfaces must exist until the sequence
+ * is ended. The region and margin structures that @params refer to
+ * only need to exist until this function returns.
+ *
+ * If one of the blits fails, this function returns right away, and
+ * the remaining blits are not performed. Blits before the failed
+ * one may or may not have been performed in that case.
+ *
+ * See @imx_2d_blitter_start for an important note about calling
+ * this from a particular thread.
+ *
+ * Returns: Nonzero if the call succeeds, zero on failure.
+ */
+int imx_2d_blitter_do_blits(Imx2dBlitter *blitter, int num_blits, Imx2dSurface **sources, Imx2dBlitParams const *params);
+
 /**
  * imx_2d_blitter_fill_region:
  * @blitter: Blitter to use.
@@ -827,10 +969,12 @@ int imx_2d_blitter_do_blit(Imx2dBlitter *blitter, Imx2dSurface *source, Imx2dBli
  *
  * This fills the @dest_region in the destination surface with
  * pixels whose color is set to @fill_color. Should @dest_region
- * extend past the boundaries of the destination surface, it will
- * be clipped. If @dest_region is fully outside of the surface,
- * this function does nothing and just returns nonzero. If
- * @dest_region is NULL, the entire surface is filled.
+ * extend past the boundaries of the clip region (see
+ * @imx_2d_blitter_set_clip_region), it will be clipped. If
+ * @dest_region is fully outside of the clip region, this function
+ * does nothing and just returns nonzero. If @dest_region is NULL,
+ * the entire clip region is filled. By default, the clip region
+ * is the entire destination surface.
  *
  * The @fill_color is specified as a 32-bit unsigned integer.
  * the layout being 0x00RRGGBB, that is, the LSB is the byte
@@ -843,6 +987,32 @@ int imx_2d_blitter_do_blit(Imx2dBlitter *blitter, Imx2dSurface *source, Imx2dBli
  */
 int imx_2d_blitter_fill_region(Imx2dBlitter *blitter, Imx2dRegion const *dest_region, uint32_t fill_color);
 
+/**
+ * imx_2d_blitter_set_clip_region:
+ * @blitter: Blitter to use.
+ * @clip_region: Region in the destination surface to restrict
+ *     blits and fills to, or NULL to use the entire surface.
+ *
+ * Restricts all subsequent blits and fills in the current sequence
+ * to @clip_region. Pixels outside of it are left untouched. Blits
+ * are clipped by adjusting their source region accordingly, just
+ * like blits whose destination region extends past the boundaries
+ * of the destination surface. Margins are clipped as well.
+ *
+ * This is useful for redrawing only the parts of a frame that
+ * changed. Note that with scaling, the source region adjustment
+ * is subject to rounding, so the clipped pixels may be slightly
+ * different from the ones produced by an unclipped blit.
+ *
+ * @clip_region is itself clipped to the destination surface.
+ * It must not be fully outside of it. When a new sequence is
+ * started with @imx_2d_blitter_start, the clip region is reset
+ * to the entire destination surface.
+ *
+ * Returns: Nonzero if the call succeeds, zero on failure.
+ */
+int imx_2d_blitter_set_clip_region(Imx2dBlitter *blitter, Imx2dRegion const *clip_region);
+
 /**
  * imx_2d_blitter_get_hardware_capabilities:
  * @blitter: Blitter to get hardware capabilities from.
@@ -58,6 +58,7 @@ extern Imx2dLoggingFunc imx_2d_cur_logging_fn;
 typedef struct _Imx2dSurfaceClass Imx2dSurfaceClass;
 typedef struct _Imx2dInternalBlitParams Imx2dInternalBlitParams;
 typedef struct _Imx2dInternalFillRegionParams Imx2dInternalFillRegionParams;
+typedef struct _Imx2dPreparedBlit Imx2dPreparedBlit;
 
 
 struct _Imx2dSurface
@@ -73,6 +74,31 @@ struct _Imx2dBlitter
 {
 	Imx2dBlitterClass *blitter_class;
 	Imx2dSurface *dest;
+
+	/* Blits and fills are clipped against this region. It is set
+	 * to the dest surface region when a sequence is started, and
+	 * can be narrowed with imx_2d_blitter_set_clip_region(). It
+	 * is always fully inside the dest surface region. */
+	Imx2dRegion clip_region;
+
+	/* Bookkeeping for imx_2d_blitter_submit() / _wait() / _poll().
+	 * Token values up to and including last_completed_token
+	 * are done. Backends can only report one result for all the
+	 * tokens that complete together, so a failure marks all of
+	 * them as failed. The most recent range of failed tokens is
+	 * (last_good_token, last_failed_token]; tokens outside of it
+	 * completed successfully. */
+	Imx2dCompletionToken last_submitted_token;
+	Imx2dCompletionToken last_completed_token;
+	Imx2dCompletionToken last_good_token;
+	Imx2dCompletionToken last_failed_token;
+
+	/* Scratch arrays for imx_2d_blitter_do_blits(). These are
+	 * only allocated if the backend implements do_blits(), and
+	 * grow as needed. They are freed by imx_2d_blitter_destroy(). */
+	Imx2dPreparedBlit *prepared_blits;
+	Imx2dInternalBlitParams **pending_blit_params;
+	int prepared_blits_capacity;
 };
 
 
@@ -101,6 +127,30 @@ struct _Imx2dInternalFillRegionParams
 };
 
 
+typedef enum
+{
+	IMX_2D_PREPARED_BLIT_TYPE_NONE,
+	IMX_2D_PREPARED_BLIT_TYPE_FILL,
+	IMX_2D_PREPARED_BLIT_TYPE_BLIT
+}
+Imx2dPreparedBlitType;
+
+
+/* A blit whose parameters were validated and clipped against the
+ * dest surface. The region pointers in blit_params and fill_params
+ * may point to the region fields of this same structure, so it
+ * must not be copied once it has been prepared. */
+struct _Imx2dPreparedBlit
+{
+	Imx2dPreparedBlitType type;
+	Imx2dInternalBlitParams blit_params;
+	Imx2dInternalFillRegionParams fill_params;
+	Imx2dRegion clipped_source_region;
+	Imx2dRegion clipped_dest_region;
+	Imx2dRegion expanded_dest_region;
+};
+
+
 struct _Imx2dBlitterClass
 {
 	void (*destroy)(Imx2dBlitter *blitter);
@@ -108,7 +158,22 @@ struct _Imx2dBlitterClass
 	int (*start)(Imx2dBlitter *blitter);
 	int (*finish)(Imx2dBlitter *blitter);
 
+	/* Optional asynchronous completion vfuncs. submit() ends the
+	 * sequence without blocking. wait() blocks until everything
+	 * that was submitted so far is done. poll() checks that without
+	 * blocking; if it is NULL, submissions are considered pending
+	 * until wait() is called. If submit() is NULL, imx2d calls
+	 * finish() instead, and the submission is completed right away.
+	 * Backends that set submit() must also set wait(). */
+	int (*submit)(Imx2dBlitter *blitter);
+	int (*wait)(Imx2dBlitter *blitter);
+	Imx2dCompletionStatus (*poll)(Imx2dBlitter *blitter);
+
 	int (*do_blit)(Imx2dBlitter *blitter, Imx2dInternalBlitParams *internal_blit_params);
+	/* Optional batch version of do_blit(). The blits must be performed
+	 * in the given order. If this is NULL, imx_2d_blitter_do_blits()
+	 * calls do_blit() for each blit instead. */
+	int (*do_blits)(Imx2dBlitter *blitter, int num_blits, Imx2dInternalBlitParams **internal_blit_params);
 	int (*fill_region)(Imx2dBlitter *blitter, Imx2dInternalFillRegionParams *internal_fill_region_params);
 
 	Imx2dHardwareCapabilities const * (*get_hardware_capabilities)(Imx2dBlitter *blitter);
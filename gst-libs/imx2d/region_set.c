@@ -0,0 +1,325 @@
+/* gstreamer-imx: GStreamer plugins for the i.MX SoCs
+ * Copyright (C) 2026  agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include "imx2d.h"
+#include "imx2d_priv.h"
+#include "region_set.h"
+
+
+typedef struct
+{
+	Imx2dRegion *regions;
+	int num_regions;
+	int capacity;
+}
+Imx2dRegionArray;
+
+
+struct _Imx2dRegionSet
+{
+	/* The non-overlapping regions that make up the set. */
+	Imx2dRegionArray regions;
+
+	/* Scratch arrays that are reused by the set operations
+	 * to avoid allocating memory every time. */
+	Imx2dRegionArray scratch;
+	Imx2dRegionArray pieces;
+};
+
+
+
+
+inline static BOOL region_is_empty(Imx2dRegion const *region)
+{
+	return (region->x1 >= region->x2) || (region->y1 >= region->y2);
+}
+
+
+inline static BOOL regions_overlap(Imx2dRegion const *first_region, Imx2dRegion const *second_region)
+{
+	return (first_region->x1 < second_region->x2) && (second_region->x1 < first_region->x2)
+	    && (first_region->y1 < second_region->y2) && (second_region->y1 < first_region->y2);
+}
+
+
+static BOOL region_array_append(Imx2dRegionArray *array, Imx2dRegion const *region)
+{
+	if (array->num_regions == array->capacity)
+	{
+		int new_capacity = (array->capacity == 0) ? 16 : (array->capacity * 2);
+		Imx2dRegion *new_regions = realloc(array->regions, new_capacity * sizeof(Imx2dRegion));
+
+		if (new_regions == NULL)
+		{
+			IMX_2D_LOG(ERROR, "could not allocate memory for %d regions", new_capacity);
+			return FALSE;
+		}
+
+		array->regions = new_regions;
+		array->capacity = new_capacity;
+	}
+
+	array->regions[array->num_regions++] = *region;
+
+	return TRUE;
+}
+
+
+inline static void region_array_swap(Imx2dRegionArray *first_array, Imx2dRegionArray *second_array)
+{
+	Imx2dRegionArray tmp = *first_array;
+	*first_array = *second_array;
+	*second_array = tmp;
+}
+
+
+/* Subtracts subtrahend from all regions in array. Every region that
+ * overlaps the subtrahend is replaced by the (up to four) parts of it
+ * that lie outside of the subtrahend: a band above and below it, and
+ * a band to its left and right. The result is assembled in scratch,
+ * which is then swapped with array. */
+static BOOL region_array_subtract(Imx2dRegionArray *array, Imx2dRegion const *subtrahend, Imx2dRegionArray *scratch)
+{
+	int i;
+
+	if (region_is_empty(subtrahend))
+		return TRUE;
+
+	scratch->num_regions = 0;
+
+	for (i = 0; i < array->num_regions; ++i)
+	{
+		Imx2dRegion const *region = &(array->regions[i]);
+		Imx2dRegion piece;
+		int middle_y1, middle_y2;
+
+		if (!regions_overlap(region, subtrahend))
+		{
+			if (!region_array_append(scratch, region))
+				return FALSE;
+			continue;
+		}
+
+		middle_y1 = MAX(region->y1, subtrahend->y1);
+		middle_y2 = MIN(region->y2, subtrahend->y2);
+
+		if (region->y1 < subtrahend->y1)
+		{
+			piece.x1 = region->x1;
+			piece.y1 = region->y1;
+			piece.x2 = region->x2;
+			piece.y2 = subtrahend->y1;
+			if (!region_array_append(scratch, &piece))
+				return FALSE;
+		}
+
+		if (region->x1 < subtrahend->x1)
+		{
+			piece.x1 = region->x1;
+			piece.y1 = middle_y1;
+			piece.x2 = subtrahend->x1;
+			piece.y2 = middle_y2;
+			if (!region_array_append(scratch, &piece))
+				return FALSE;
+		}
+
+		if (region->x2 > subtrahend->x2)
+		{
+			piece.x1 = subtrahend->x2;
+			piece.y1 = middle_y1;
+			piece.x2 = region->x2;
+			piece.y2 = middle_y2;
+			if (!region_array_append(scratch, &piece))
+				return FALSE;
+		}
+
+		if (region->y2 > subtrahend->y2)
+		{
+			piece.x1 = region->x1;
+			piece.y1 = subtrahend->y2;
+			piece.x2 = region->x2;
+			piece.y2 = region->y2;
+			if (!region_array_append(scratch, &piece))
+				return FALSE;
+		}
+	}
+
+	region_array_swap(array, scratch);
+
+	return TRUE;
+}
+
+
+/* Fills region_set->pieces with the parts of region
+ * that are not covered by any region in the set. */
+static BOOL compute_uncovered_pieces(Imx2dRegionSet *region_set, Imx2dRegion const *region)
+{
+	int i;
+
+	region_set->pieces.num_regions = 0;
+
+	if (region_is_empty(region))
+		return TRUE;
+
+	if (!region_array_append(&(region_set->pieces), region))
+		return FALSE;
+
+	for (i = 0; (i < region_set->regions.num_regions) && (region_set->pieces.num_regions > 0); ++i)
+	{
+		if (!region_array_subtract(&(region_set->pieces), &(region_set->regions.regions[i]), &(region_set->scratch)))
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+
+
+
+Imx2dRegionSet* imx_2d_region_set_create(void)
+{
+	Imx2dRegionSet *region_set = malloc(sizeof(Imx2dRegionSet));
+	if (region_set == NULL)
+	{
+		IMX_2D_LOG(ERROR, "could not allocate memory for region set");
+		return NULL;
+	}
+
+	memset(region_set, 0, sizeof(Imx2dRegionSet));
+
+	return region_set;
+}
+
+
+void imx_2d_region_set_destroy(Imx2dRegionSet *region_set)
+{
+	assert(region_set != NULL);
+
+	free(region_set->regions.regions);
+	free(region_set->scratch.regions);
+	free(region_set->pieces.regions);
+	free(region_set);
+}
+
+
+void imx_2d_region_set_clear(Imx2dRegionSet *region_set)
+{
+	assert(region_set != NULL);
+	region_set->regions.num_regions = 0;
+}
+
+
+int imx_2d_region_set_add_region(Imx2dRegionSet *region_set, Imx2dRegion const *region)
+{
+	int i;
+
+	assert(region_set != NULL);
+	assert(region != NULL);
+
+	if (!compute_uncovered_pieces(region_set, region))
+		return FALSE;
+
+	for (i = 0; i < region_set->pieces.num_regions; ++i)
+	{
+		if (!region_array_append(&(region_set->regions), &(region_set->pieces.regions[i])))
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+
+int imx_2d_region_set_subtract_region(Imx2dRegionSet *region_set, Imx2dRegion const *region)
+{
+	assert(region_set != NULL);
+	assert(region != NULL);
+
+	return region_array_subtract(&(region_set->regions), region, &(region_set->scratch));
+}
+
+
+int imx_2d_region_set_subtract_region_set(Imx2dRegionSet *region_set, Imx2dRegionSet const *other_region_set)
+{
+	int i;
+
+	assert(region_set != NULL);
+	assert(other_region_set != NULL);
+	assert(region_set != other_region_set);
+
+	for (i = 0; (i < other_region_set->regions.num_regions) && (region_set->regions.num_regions > 0); ++i)
+	{
+		if (!region_array_subtract(&(region_set->regions), &(other_region_set->regions.regions[i]), &(region_set->scratch)))
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+
+Imx2dRegionInclusion imx_2d_region_set_check_inclusion(Imx2dRegionSet *region_set, Imx2dRegion const *region)
+{
+	int i;
+	long long uncovered_area = 0;
+	long long region_area;
+
+	assert(region_set != NULL);
+	assert(region != NULL);
+
+	if (!compute_uncovered_pieces(region_set, region))
+		return IMX_2D_REGION_INCLUSION_PARTIAL;
+
+	if (region_set->pieces.num_regions == 0)
+		return IMX_2D_REGION_INCLUSION_FULL;
+
+	/* The pieces do not overlap, so if their combined area equals
+	 * that of the region, then no part of the region is covered. */
+	for (i = 0; i < region_set->pieces.num_regions; ++i)
+	{
+		Imx2dRegion const *piece = &(region_set->pieces.regions[i]);
+		uncovered_area += (long long)(piece->x2 - piece->x1) * (piece->y2 - piece->y1);
+	}
+
+	region_area = (long long)(region->x2 - region->x1) * (region->y2 - region->y1);
+
+	return (uncovered_area == region_area) ? IMX_2D_REGION_INCLUSION_NONE : IMX_2D_REGION_INCLUSION_PARTIAL;
+}
+
+
+int imx_2d_region_set_is_empty(Imx2dRegionSet const *region_set)
+{
+	assert(region_set != NULL);
+	return region_set->regions.num_regions == 0;
+}
+
+
+int imx_2d_region_set_get_num_regions(Imx2dRegionSet const *region_set)
+{
+	assert(region_set != NULL);
+	return region_set->regions.num_regions;
+}
+
+
+Imx2dRegion const * imx_2d_region_set_get_region(Imx2dRegionSet const *region_set, int index)
+{
+	assert(region_set != NULL);
+	assert((index >= 0) && (index < region_set->regions.num_regions));
+	return &(region_set->regions.regions[index]);
+}
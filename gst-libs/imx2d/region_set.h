@@ -0,0 +1,171 @@
+/* gstreamer-imx: GStreamer plugins for the i.MX SoCs
+ * Copyright (C) 2026  agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the Free
+ * Software Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef IMX_2D_REGION_SET_H
+#define IMX_2D_REGION_SET_H
+
+#include "imx2d.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * Imx2dRegionSet:
+ *
+ * A set of pixels, stored as a list of non-overlapping rectangular
+ * @Imx2dRegion instances. Union and subtraction operations are
+ * supported. This is useful for computing which parts of a surface
+ * are covered by a number of (possibly overlapping) regions, for
+ * example to find out which areas of an output frame are not
+ * covered by any opaque input frame.
+ *
+ * The regions in a set never overlap each other, and never have
+ * a width or height of zero. Their number and layout depend on the
+ * order of operations; two sets that contain the same pixels can
+ * consist of different regions.
+ */
+typedef struct _Imx2dRegionSet Imx2dRegionSet;
+
+/**
+ * imx_2d_region_set_create:
+ *
+ * Creates a new, empty region set.
+ *
+ * Returns: Pointer to the new region set, or NULL if
+ *          memory could not be allocated.
+ */
+Imx2dRegionSet* imx_2d_region_set_create(void);
+
+/**
+ * imx_2d_region_set_destroy:
+ * @region_set: Region set to destroy.
+ *
+ * Destroys the given region set. The pointer to the set
+ * is invalid after this call and must not be used anymore.
+ */
+void imx_2d_region_set_destroy(Imx2dRegionSet *region_set);
+
+/**
+ * imx_2d_region_set_clear:
+ * @region_set: Region set to clear.
+ *
+ * Removes all regions from the set. Allocated memory is kept
+ * for reuse, so clearing and refilling a set is cheap.
+ */
+void imx_2d_region_set_clear(Imx2dRegionSet *region_set);
+
+/**
+ * imx_2d_region_set_add_region:
+ * @region_set: Region set to add a region to.
+ * @region: Region to add.
+ *
+ * Adds the pixels of @region to the set (union operation).
+ * Only the parts of @region that are not yet in the set are
+ * added, so the regions in the set still do not overlap.
+ * If @region has a width or height of zero, nothing is done.
+ *
+ * Returns: Nonzero if the call succeeds, zero on failure.
+ */
+int imx_2d_region_set_add_region(Imx2dRegionSet *region_set, Imx2dRegion const *region);
+
+/**
+ * imx_2d_region_set_subtract_region:
+ * @region_set: Region set to subtract a region from.
+ * @region: Region to subtract.
+ *
+ * Removes the pixels of @region from the set. Regions in the
+ * set that partially overlap @region are split into up to
+ * four smaller regions.
+ *
+ * Returns: Nonzero if the call succeeds, zero on failure.
+ */
+int imx_2d_region_set_subtract_region(Imx2dRegionSet *region_set, Imx2dRegion const *region);
+
+/**
+ * imx_2d_region_set_subtract_region_set:
+ * @region_set: Region set to subtract regions from.
+ * @other_region_set: Region set whose regions shall be subtracted.
+ *
+ * Removes the pixels of all regions in @other_region_set from
+ * @region_set. The two sets must not be the same one.
+ *
+ * Returns: Nonzero if the call succeeds, zero on failure.
+ */
+int imx_2d_region_set_subtract_region_set(Imx2dRegionSet *region_set, Imx2dRegionSet const *other_region_set);
+
+/**
+ * imx_2d_region_set_check_inclusion:
+ * @region_set: Region set to use in the check.
+ * @region: Region to use in the check.
+ *
+ * Checks if and to what degree the set includes @region. This is
+ * the region set counterpart of @imx_2d_region_check_inclusion.
+ * A @region with a width or height of zero is considered to be
+ * fully included.
+ *
+ * This uses internal scratch memory of the set, which is why
+ * @region_set is not const.
+ *
+ * Returns: Result of the check. If memory could not be allocated,
+ *          @IMX_2D_REGION_INCLUSION_PARTIAL is returned, since it
+ *          is the safe choice for callers that skip work if the
+ *          result is @IMX_2D_REGION_INCLUSION_FULL or
+ *          @IMX_2D_REGION_INCLUSION_NONE.
+ */
+Imx2dRegionInclusion imx_2d_region_set_check_inclusion(Imx2dRegionSet *region_set, Imx2dRegion const *region);
+
+/**
+ * imx_2d_region_set_is_empty:
+ * @region_set: Region set to check.
+ *
+ * Returns: Nonzero if the set contains no regions.
+ */
+int imx_2d_region_set_is_empty(Imx2dRegionSet const *region_set);
+
+/**
+ * imx_2d_region_set_get_num_regions:
+ * @region_set: Region set to get the number of regions from.
+ *
+ * Returns: Number of regions in the set.
+ */
+int imx_2d_region_set_get_num_regions(Imx2dRegionSet const *region_set);
+
+/**
+ * imx_2d_region_set_get_region:
+ * @region_set: Region set to get a region from.
+ * @index: Index of the region to get. Must be in the range
+ *     0 .. (num-regions - 1), where num-regions is the return
+ *     value of @imx_2d_region_set_get_num_regions.
+ *
+ * The returned pointer is valid until the set is modified
+ * or destroyed.
+ *
+ * Returns: Const pointer to the region.
+ */
+Imx2dRegion const * imx_2d_region_set_get_region(Imx2dRegionSet const *region_set, int index);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* IMX_2D_REGION_SET_H */
@@ -1458,6 +1458,16 @@ static void gst_imx_v4l2_amphion_dec_cleanup_decoding_resources(GstImxV4L2Amphio
 
 	if (self->video_buffer_pool != NULL)
 	{
+		guint64 num_zero_copy_transfers, num_copied_transfers;
+
+		gst_imx_video_buffer_pool_get_transfer_statistics(self->video_buffer_pool, &num_zero_copy_transfers, &num_copied_transfers);
+		GST_INFO_OBJECT(
+			self,
+			"output frame transfers: %" G_GUINT64_FORMAT " without copy, %" G_GUINT64_FORMAT " copied with the CPU",
+			num_zero_copy_transfers,
+			num_copied_transfers
+		);
+
 		gst_object_unref(GST_OBJECT(self->video_buffer_pool));
 		self->video_buffer_pool = NULL;
 	}
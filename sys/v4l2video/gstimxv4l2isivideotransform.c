@@ -1271,11 +1271,18 @@ static GstFlowReturn gst_imx_v4l2_isi_video_transform_prepare_output_buffer(GstB
 				GstMapInfo map_info;
 				guint8 const *src_pixels;
 				guint8 *dest_pixels;
+				gsize num_written_bytes;
 
 				memory = gst_buffer_peek_memory(uploaded_input_buffer, plane_index);
 				g_assert(memory != NULL);
 
-				gst_memory_map(memory, &map_info, GST_MAP_WRITE);
+				/* Only the rows of the frame are written, not the
+				 * padding rows that may follow, so only sync these. */
+				num_written_bytes = (gsize)(height - 1) * GST_VIDEO_INFO_PLANE_STRIDE(video_info, plane_index)
+				                  + width * GST_VIDEO_FRAME_COMP_PSTRIDE(&video_frame, plane_index);
+
+				gst_memory_map(memory, &map_info, GST_MAP_WRITE | GST_MAP_FLAG_IMX_MANUAL_SYNC);
+				gst_imx_memory_begin_cpu_access(memory, GST_MAP_WRITE, 0, num_written_bytes);
 
 				src_pixels = GST_VIDEO_FRAME_PLANE_DATA(&video_frame, plane_index);
 				dest_pixels = map_info.data;
@@ -1289,6 +1296,7 @@ static GstFlowReturn gst_imx_v4l2_isi_video_transform_prepare_output_buffer(GstB
 					);
 				}
 
+				gst_imx_memory_end_cpu_access(memory, GST_MAP_WRITE, 0, num_written_bytes);
 				gst_memory_unmap(memory, &map_info);
 			}
 